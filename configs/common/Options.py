@@ -348,6 +348,29 @@ def addCommonOptions(parser):
     parser.add_option("-F", "--fast-forward", action="store", type="string",
         default=None,
         help="Number of instructions to fast forward before switching")
+    parser.add_option("--sampling", action="store", type="string",
+        default=None,
+        help="""SMARTS-style sampling as <interval,warmup,unit> in
+                instructions. Every interval instructions, run warmup and
+                then measure unit instructions on --cpu-type, and warm the
+                caches, TLBs and branch predictors with an atomic CPU in
+                between.""")
+    parser.add_option("--sampling-procs", action="store", type="int",
+        default=0,
+        help="""Measure the units of --sampling in up to N forked
+                simulators running in parallel.""")
+    parser.add_option("--fast-forward-backdoors", action="store_true",
+        default=False,
+        help="""Let the atomic CPUs of --fast-forward and --sampling access
+                memory without caches through back doors. Back-door stores
+                are not snooped, so this breaks LL/SC and MONITOR/MWAIT
+                between CPUs; only use it with a single CPU or with
+                workloads that do not share memory.""")
+    parser.add_option("--fast-forward-block-cache", action="store_true",
+        default=False,
+        help="""Let the atomic CPUs of --fast-forward and --sampling
+                replay decoded basic blocks. Requires
+                --fast-forward-backdoors.""")
     parser.add_option("-S", "--simpoint", action="store_true", default=False,
         help="""Use workload simpoints as an instruction offset for
                 --checkpoint-restore or --take-checkpoint.""")
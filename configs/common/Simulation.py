@@ -40,6 +40,7 @@
 from __future__ import print_function
 from __future__ import absolute_import
 
+import math
 import six
 import sys
 from os import getcwd
@@ -83,7 +84,7 @@ def setCPUClass(options):
         if options.restore_with_cpu != options.cpu_type:
             CPUClass = TmpClass
             TmpClass, test_mem_mode = getCPUClass(options.restore_with_cpu)
-    elif options.fast_forward:
+    elif options.fast_forward or options.sampling:
         CPUClass = TmpClass
         TmpClass = AtomicSimpleCPU
         test_mem_mode = 'atomic'
@@ -431,6 +432,136 @@ def repeatSwitch(testsys, repeat_switch_cpu_list, maxtick, switch_freq):
             exit_event = m5.simulate(maxtick - m5.curTick())
             return exit_event
 
+def parseSamplingOptions(options):
+    """Returns the interval, detailed warmup and unit of --sampling."""
+    try:
+        interval, warmup, unit = [int(x) for x in options.sampling.split(',')]
+    except ValueError:
+        fatal("--sampling takes <interval,warmup,unit> in instructions")
+    if unit <= 0 or warmup < 0 or interval <= warmup + unit:
+        fatal("--sampling needs interval > warmup + unit and unit > 0")
+    return interval, warmup, unit
+
+def runInsts(cpus, insts, maxtick):
+    """Simulate until every cpu has committed another insts instructions.
+
+    Returns the last exit event and the tick at which each cpu got
+    there, or None instead of the ticks if something else ended the
+    simulation first. A cpu that is done keeps running until the last
+    one is.
+    """
+    for i, cpu in enumerate(cpus):
+        cpu.scheduleInstStop(0, insts, "sampling phase done %d" % i)
+    done = {}
+    while len(done) < len(cpus):
+        exit_event = m5.simulate(maxtick - m5.curTick())
+        cause = exit_event.getCause()
+        if not cause.startswith("sampling phase done "):
+            return exit_event, None
+        done[int(cause.split()[-1])] = m5.curTick()
+    return exit_event, [done[i] for i in range(len(cpus))]
+
+def printCPI(name, cpis):
+    """Print the mean of a list of unit CPIs with its 95% confidence."""
+    n = len(cpis)
+    if n > 1:
+        mean = sum(cpis) / n
+        stddev = math.sqrt(sum((c - mean) ** 2 for c in cpis) / (n - 1))
+        cov = stddev / mean
+        print("%s: %f +/- %f (95%% confidence)" %
+              (name, mean, 1.96 * stddev / math.sqrt(n)))
+        print("Coefficient of variation: %f, units needed for +/-3%%: %d" %
+              (cov, int(math.ceil((1.96 * cov / 0.03) ** 2))))
+    elif n == 1:
+        print("%s: %f (too few units for a confidence interval)" %
+              (name, cpis[0]))
+
+def sampledRun(testsys, warm_cpu_list, maxtick, interval, warmup, unit,
+               procs=0):
+    """SMARTS-style systematic sampling.
+
+    Alternate between functional warming on the atomic CPUs, which
+    keeps the caches, TLBs and branch predictors warm, and short
+    detailed windows on the switch CPUs. Every interval instructions a
+    window runs warmup instructions to fill the pipeline and then
+    measures the next unit instructions. The stats of each measured
+    unit are dumped on their own, and the CPI of the units is reported
+    with a 95% confidence interval.
+
+    Every phase lasts until each CPU has committed its instructions.
+    With several CPUs, the CPI of each one is reported, along with
+    their mean as the aggregate CPI.
+
+    If procs is non-zero, the detailed windows run in up to procs
+    forked simulators while the parent keeps warming, and their CPIs
+    are collected with m5.joinRegions(). The stats of each window are
+    added to those of the parent, and are also in the output directory
+    of the child that measured it.
+    """
+    detail_cpu_list = [(new_cpu, old_cpu)
+                       for old_cpu, new_cpu in warm_cpu_list]
+    warm_cpus = [old_cpu for old_cpu, _ in warm_cpu_list]
+    detail_cpus = [new_cpu for _, new_cpu in warm_cpu_list]
+    for cpu in detail_cpus:
+        if not isinstance(cpu.clk_domain, SrcClockDomain):
+            fatal("--sampling needs the CPUs in a SrcClockDomain")
+    periods = [cpu.clk_domain.clock[0].getValue() for cpu in detail_cpus]
+
+    def detailedUnit():
+        """Returns the CPI of each CPU in the next unit and the last exit
+        event."""
+        m5.switchCpus(testsys, warm_cpu_list, verbose=False)
+
+        if warmup:
+            exit_event, ticks = runInsts(detail_cpus, warmup, maxtick)
+            if ticks is None:
+                return None, exit_event
+
+        m5.stats.reset()
+        start_tick = m5.curTick()
+        exit_event, ticks = runInsts(detail_cpus, unit, maxtick)
+        if ticks is None:
+            return None, exit_event
+        m5.stats.dump()
+        return [float(tick - start_tick) / period / unit
+                for tick, period in zip(ticks, periods)], exit_event
+
+    print("starting sampling loop")
+    cpis = []
+    while True:
+        exit_event, ticks = runInsts(warm_cpus, interval - warmup - unit,
+                                     maxtick)
+        if ticks is None:
+            break
+
+        if procs:
+            cpis += [cpi for _, cpi in m5.joinRegions(procs - 1)
+                     if cpi is not None]
+            m5.forkRegion(lambda: detailedUnit()[0])
+
+            # Warm through the window that the child measures
+            exit_event, ticks = runInsts(warm_cpus, warmup + unit, maxtick)
+            if ticks is None:
+                break
+        else:
+            cpi, exit_event = detailedUnit()
+            if cpi is None:
+                break
+            cpis.append(cpi)
+            m5.switchCpus(testsys, detail_cpu_list, verbose=False)
+
+    cpis += [cpi for _, cpi in m5.joinRegions() if cpi is not None]
+
+    print("Sampled %d units of %d instructions" % (len(cpis), unit))
+    if len(detail_cpus) > 1:
+        for i, cpu in enumerate(detail_cpus):
+            printCPI("%s CPI" % cpu.get_name(), [c[i] for c in cpis])
+        printCPI("Aggregate CPI", [sum(c) / len(c) for c in cpis])
+    else:
+        printCPI("CPI", [c[0] for c in cpis])
+
+    return exit_event
+
 def run(options, root, testsys, cpu_class):
     if options.checkpoint_dir:
         cptdir = options.checkpoint_dir
@@ -451,6 +582,19 @@ def run(options, root, testsys, cpu_class):
     if options.repeat_switch and options.take_checkpoints:
         fatal("Can't specify both --repeat-switch and --take-checkpoints")
 
+    if options.sampling:
+        if options.standard_switch or options.repeat_switch:
+            fatal("Can't specify --sampling with --standard-switch or "
+                  "--repeat-switch")
+        if options.take_checkpoints or options.take_simpoint_checkpoints:
+            fatal("Can't specify --sampling when taking checkpoints")
+        if not cpu_class or testsys.cpu[0].memory_mode() != 'atomic':
+            fatal("--sampling needs an atomic CPU to warm with and a "
+                  "different --cpu-type to measure with")
+        sampling = parseSamplingOptions(options)
+        if options.sampling_procs and not m5.listenersDisabled():
+            fatal("--sampling-procs needs --listener-mode=off")
+
     # Setup global stat filtering.
     stat_root_simobjs = []
     for stat_root_str in options.stats_root:
@@ -458,6 +602,16 @@ def run(options, root, testsys, cpu_class):
     m5.stats.global_dump_roots = stat_root_simobjs
 
     np = options.num_cpus
+
+    if options.fast_forward_backdoors and np > 1:
+        warn("--fast-forward-backdoors with %d CPUs: back-door stores are "
+             "not snooped, so LL/SC and MONITOR/MWAIT between CPUs are "
+             "not reliable while fast forwarding" % np)
+
+    if options.fast_forward_block_cache and \
+            not options.fast_forward_backdoors:
+        fatal("--fast-forward-block-cache requires --fast-forward-backdoors")
+
     switch_cpus = None
 
     if options.prog_interval:
@@ -475,6 +629,15 @@ def run(options, root, testsys, cpu_class):
         for i in range(np):
             if options.fast_forward:
                 testsys.cpu[i].max_insts_any_thread = int(options.fast_forward)
+            # Let the fast-forwarding CPUs access memory directly where
+            # there are no caches that need to see their accesses, if
+            # asked to, as other CPUs do not snoop these accesses
+            if options.fast_forward_backdoors and \
+                    (options.fast_forward or options.sampling) and \
+                    isinstance(testsys.cpu[i], AtomicSimpleCPU):
+                testsys.cpu[i].use_backdoors = True
+                testsys.cpu[i].basic_block_cache = \
+                    options.fast_forward_block_cache
             switch_cpus[i].system = testsys
             switch_cpus[i].workload = testsys.cpu[i].workload
             switch_cpus[i].clk_domain = testsys.cpu[i].clk_domain
@@ -504,6 +667,12 @@ def run(options, root, testsys, cpu_class):
         testsys.switch_cpus = switch_cpus
         switch_cpu_list = [(testsys.cpu[i], switch_cpus[i]) for i in range(np)]
 
+        # With sampling, the atomic CPUs train the branch predictors of
+        # the switch CPUs while they warm the caches
+        if options.sampling:
+            for i in range(np):
+                testsys.cpu[i].branchPred = switch_cpus[i].branchPred
+
     if options.repeat_switch:
         switch_class = getCPUClass(options.cpu_type)[0]
         if switch_class.require_caches() and \
@@ -663,7 +832,7 @@ def run(options, root, testsys, cpu_class):
         fatal("Bad maxtick (%d) specified: " \
               "Checkpoint starts starts from tick: %d", maxtick, cpt_starttick)
 
-    if options.standard_switch or cpu_class:
+    if (options.standard_switch or cpu_class) and not options.sampling:
         if options.standard_switch:
             print("Switch at instruction count:%s" %
                     str(testsys.cpu[0].max_insts_any_thread))
@@ -720,6 +889,18 @@ def run(options, root, testsys, cpu_class):
     elif options.restore_simpoint_checkpoint != None:
         restoreSimpointCheckpoint()
 
+    elif options.sampling:
+        if options.fast_forward:
+            print("Fast forwarding %s instructions" % options.fast_forward)
+            exit_event = m5.simulate()
+            if exit_event.getCause() != \
+                    "a thread reached the max instruction count":
+                fatal("Workload ended during fast forward")
+            m5.stats.reset()
+        print("**** SAMPLED SIMULATION ****")
+        exit_event = sampledRun(testsys, switch_cpu_list, maxtick, *sampling,
+                                procs=options.sampling_procs)
+
     else:
         if options.fast_forward:
             m5.stats.reset()
@@ -280,4 +280,9 @@ if options.wait_gdb:
         cpu.wait_for_remote_gdb = True
 
 root = Root(full_system = False, system = system)
+
+if options.ruby and options.ruby_eventqs > 1:
+    m5.ticks.fixGlobalFrequency()
+    root.sim_quantum = m5.ticks.fromSeconds(
+        Ruby.partition_eventqs(options, system)) - 1
 Simulation.run(options, root, system, FutureClass)
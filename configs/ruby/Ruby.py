@@ -43,7 +43,7 @@ import math
 import m5
 from m5.objects import *
 from m5.defines import buildEnv
-from m5.util import addToPath, fatal
+from m5.util import addToPath, convert, fatal
 
 addToPath('../')
 
@@ -89,6 +89,13 @@ def define_options(parser):
     parser.add_option("--recycle-latency", type="int", default=10,
                       help="Recycle latency for ruby controller input buffers")
 
+    parser.add_option("--ruby-eventqs", type="int", default=1,
+                      help="number of event queues (host threads) to spread "
+                           "the Ruby network routers and their controllers "
+                           "over. Only links between routers cross event "
+                           "queues, the simulation quantum is one tick "
+                           "shorter than their latency.")
+
     protocol = buildEnv['PROTOCOL']
     exec("from . import %s" % protocol)
     eval("%s.define_options(parser)" % protocol)
@@ -264,6 +271,62 @@ def create_directories(options, bootmem, ruby_system, system):
 
     return (dir_cntrl_nodes, None)
 
+def partition_eventqs(options, system):
+    """ Spread the routers of the network over options.ruby_eventqs
+        event queues for parallel simulation. The controllers (and
+        their sequencers), network interfaces and CPUs follow the
+        router they are attached to, and every internal link is
+        simulated on the event queue of the router driving it, so
+        messages only cross event queues on internal links.
+        Must be called once the CPUs are connected to Ruby.
+        Returns the latency (in seconds) of the shortest internal link
+        between two event queues. The simulation quantum must be
+        shorter than that.
+    """
+    ruby = system.ruby
+    network = ruby.network
+
+    def assign(obj, eventq_index):
+        for child in obj.descendants():
+            child.eventq_index = eventq_index
+
+    router_eq = {}
+    for i, router in enumerate(network.routers):
+        router_eq[id(router)] = i % options.ruby_eventqs
+        assign(router, router_eq[id(router)])
+
+    for i, ext_link in enumerate(network.ext_links):
+        eq = router_eq[id(ext_link.int_node)]
+        assign(ext_link, eq)
+        assign(ext_link.ext_node, eq)
+        if len(network.netifs) > i:
+            assign(network.netifs[i], eq)
+
+    min_latency = None
+    for int_link in network.int_links:
+        src_eq = router_eq[id(int_link.src_node)]
+        dst_eq = router_eq[id(int_link.dst_node)]
+        assign(int_link, src_eq)
+        if options.network == "garnet":
+            # Credits flow back from the destination router
+            assign(int_link.credit_link, dst_eq)
+            assign(int_link.dst_net_bridge, dst_eq)
+            assign(int_link.dst_cred_bridge, dst_eq)
+        if src_eq != dst_eq:
+            latency = int(int_link.latency)
+            if min_latency is None or latency < min_latency:
+                min_latency = latency
+
+    for i, cpu in enumerate(system.cpu):
+        cntrl = ruby._cpu_ports[i].get_parent()
+        assign(cpu, cntrl.eventq_index)
+
+    if min_latency is None:
+        fatal("No internal link crosses event queues, use more routers "
+              "or fewer event queues")
+
+    return min_latency / convert.toFrequency(options.ruby_clock)
+
 def send_evicts(options):
     # currently, 2 scenarios warrant forwarding evictions to the CPU:
     # 1. The O3 model must keep the LSQ coherent with the caches
@@ -44,10 +44,14 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <csignal>
+#include <mutex>
+#include <unordered_map>
 
 #include "base/cprintf.hh"
 #include "base/logging.hh"
+#include "base/match.hh"
 
 using namespace std;
 
@@ -81,6 +85,85 @@ allFlags()
 
 bool Flag::_globalEnable = false;
 
+namespace {
+
+/**
+ * Object expressions that flags were enabled for, and their
+ * ObjectMatch. The index of an expression is its bit in object masks.
+ */
+std::vector<std::pair<std::string, ObjectMatch>> &
+objectFilters()
+{
+    static std::vector<std::pair<std::string, ObjectMatch>> filters;
+    return filters;
+}
+
+/** The most filters a mask can tell apart. */
+const size_t MaxObjectFilters = 64;
+
+/** Serializes changes to the filters with the masks computed from them. */
+std::mutex objectFiltersLock;
+
+/** Bumped whenever a filter is added, invalidating the cached masks. */
+std::atomic<unsigned> objectFiltersGeneration(0);
+
+/** Get the bit of the filter for an expression, adding it if needed. */
+uint64_t
+objectFilterBit(const std::string &objects)
+{
+    std::lock_guard<std::mutex> lock(objectFiltersLock);
+    auto &filters = objectFilters();
+    for (size_t i = 0; i < filters.size(); ++i) {
+        if (filters[i].first == objects)
+            return uint64_t(1) << i;
+    }
+
+    fatal_if(filters.size() == MaxObjectFilters,
+             "Debug flags can't be enabled for more than %d different "
+             "sets of objects\n", MaxObjectFilters);
+    filters.emplace_back(objects, ObjectMatch(objects));
+    objectFiltersGeneration.fetch_add(1, std::memory_order_release);
+    return uint64_t(1) << (filters.size() - 1);
+}
+
+/** Masks of the objects a thread has seen since the filters changed. */
+struct ObjectMasks
+{
+    unsigned generation = 0;
+    std::unordered_map<std::string, uint64_t> masks;
+};
+
+} // anonymous namespace
+
+uint64_t
+objectFilterMask(const std::string &name)
+{
+    // Each thread keeps its own masks, so that event queues simulated
+    // in parallel don't contend for a lock on every filtered DPRINTF.
+    static thread_local ObjectMasks cache;
+
+    unsigned generation =
+        objectFiltersGeneration.load(std::memory_order_acquire);
+    if (M5_UNLIKELY(generation != cache.generation)) {
+        cache.masks.clear();
+        cache.generation = generation;
+    } else {
+        auto it = cache.masks.find(name);
+        if (it != cache.masks.end())
+            return it->second;
+    }
+
+    std::lock_guard<std::mutex> lock(objectFiltersLock);
+    const auto &filters = objectFilters();
+    uint64_t mask = 0;
+    for (size_t i = 0; i < filters.size(); ++i) {
+        if (filters[i].second.match(name))
+            mask |= uint64_t(1) << i;
+    }
+    cache.masks.emplace(name, mask);
+    return mask;
+}
+
 Flag *
 findFlag(const std::string &name)
 {
@@ -123,6 +206,46 @@ Flag::globalDisable()
         i.second->sync();
 }
 
+void
+SimpleFlag::enable()
+{
+    _filterBits = 0;
+    _status = true;
+    sync();
+}
+
+void
+SimpleFlag::disable()
+{
+    _filterBits = 0;
+    _status = false;
+    sync();
+}
+
+void
+SimpleFlag::enableFor(const std::string &objects)
+{
+    // Already on for all objects
+    if (_status && !_filterBits)
+        return;
+
+    _filterBits |= objectFilterBit(objects);
+    _status = true;
+    sync();
+}
+
+void
+DisabledFlag::enable()
+{
+    warn("Debug flag %s was compiled out of this build\n", name());
+}
+
+void
+DisabledFlag::enableFor(const std::string &objects)
+{
+    enable();
+}
+
 void
 CompoundFlag::enable()
 {
@@ -151,6 +274,29 @@ CompoundFlag::status() const
     return true;
 }
 
+void
+CompoundFlag::enableFor(const std::string &objects)
+{
+    for (auto& k : _kids)
+        k->enableFor(objects);
+}
+
+bool
+CompoundFlag::tracing(const std::string &name) const
+{
+    if (_kids.empty())
+        return false;
+
+    for (auto& k : _kids) {
+        // Compound flags only contain simple flags
+        auto *simple = static_cast<const SimpleFlag *>(k);
+        if (!simple->tracing(name))
+            return false;
+    }
+
+    return true;
+}
+
 bool
 changeFlag(const char *s, bool value)
 {
@@ -42,15 +42,25 @@
 #ifndef __BASE_DEBUG_HH__
 #define __BASE_DEBUG_HH__
 
+#include <cstdint>
 #include <initializer_list>
 #include <map>
 #include <string>
 #include <vector>
 
+#include "base/compiler.hh"
+
 namespace Debug {
 
 void breakpoint();
 
+/**
+ * The filters that select an object, as a bitmask with one bit per
+ * object expression that a flag was enabled for. Each thread caches the
+ * masks of the names it checked until a new expression is added.
+ */
+uint64_t objectFilterMask(const std::string &name);
+
 class Flag
 {
   protected:
@@ -72,6 +82,13 @@ class Flag
     virtual void disable() = 0;
     virtual bool status() const = 0;
 
+    /**
+     * Enable the flag for the objects whose names match an
+     * ObjectMatch expression only. Enabling it for more objects adds
+     * to the set; enable() enables it for all objects.
+     */
+    virtual void enableFor(const std::string &objects) = 0;
+
     operator bool() const { return status(); }
     bool operator!() const { return !status(); }
 
@@ -84,18 +101,50 @@ class SimpleFlag : public Flag
   protected:
     bool _tracing; // tracing is enabled and flag is on
     bool _status;  // flag status
+    uint64_t _filterBits; // object filters, 0 if on for all objects
 
     void sync() override { _tracing = _globalEnable && _status; }
 
   public:
     SimpleFlag(const char *name, const char *desc)
-        : Flag(name, desc), _status(false)
+        : Flag(name, desc), _tracing(false), _status(false), _filterBits(0)
     { }
 
     bool status() const override { return _tracing; }
 
-    void enable() override  { _status = true;  sync(); }
-    void disable() override { _status = false; sync(); }
+    /** Whether the flag is on for some object; the DTRACE fast path. */
+    bool tracing() const { return _tracing; }
+
+    /** Whether the flag is on for the object with the given name. */
+    bool
+    tracing(const std::string &name) const
+    {
+        return _tracing &&
+            (!_filterBits || (objectFilterMask(name) & _filterBits));
+    }
+
+    void enable() override;
+    void disable() override;
+    void enableFor(const std::string &objects) override;
+};
+
+/**
+ * A flag that was compiled out with the DISABLED_DEBUG_FLAGS build
+ * option. As its tracing checks are constant, the compiler removes
+ * the DPRINTFs that use it.
+ */
+class DisabledFlag : public SimpleFlag
+{
+  public:
+    DisabledFlag(const char *name, const char *desc)
+        : SimpleFlag(name, desc)
+    { }
+
+    bool tracing() const { return false; }
+    bool tracing(const std::string &name) const { return false; }
+
+    void enable() override;
+    void enableFor(const std::string &objects) override;
 };
 
 class CompoundFlag : public Flag
@@ -117,6 +166,10 @@ class CompoundFlag : public Flag
     void enable() override;
     void disable() override;
     bool status() const override;
+    void enableFor(const std::string &objects) override;
+
+    bool tracing() const { return status(); }
+    bool tracing(const std::string &name) const;
 };
 
 typedef std::map<std::string, Flag *> FlagsMap;
@@ -141,7 +194,7 @@ void dumpDebugFlags();
  * @{
  */
 #if TRACING_ON
-#   define DTRACE(x) (Debug::x)
+#   define DTRACE(x) (M5_UNLIKELY(Debug::x.tracing()))
 #else // !TRACING_ON
 #   define DTRACE(x) (false)
 #endif  // TRACING_ON
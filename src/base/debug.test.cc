@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "base/debug.hh"
+
+namespace Debug {
+
+SimpleFlag TestFlagA("TestFlagA", "First test flag");
+SimpleFlag TestFlagB("TestFlagB", "Second test flag");
+DisabledFlag TestFlagOff("TestFlagOff", "Compiled out test flag");
+CompoundFlag TestCompound("TestCompound", "Test flags",
+                          { &TestFlagA, &TestFlagB });
+
+} // namespace Debug
+
+class DebugFlagTest : public ::testing::Test
+{
+  protected:
+    void
+    SetUp() override
+    {
+        Debug::Flag::globalEnable();
+    }
+
+    void
+    TearDown() override
+    {
+        Debug::TestCompound.disable();
+        Debug::TestFlagOff.disable();
+        Debug::Flag::globalDisable();
+    }
+};
+
+TEST_F(DebugFlagTest, Enable)
+{
+    EXPECT_FALSE(Debug::TestFlagA.tracing());
+    EXPECT_FALSE(Debug::TestFlagA.tracing("system.cpu0"));
+
+    Debug::TestFlagA.enable();
+    EXPECT_TRUE(Debug::TestFlagA.tracing());
+    EXPECT_TRUE(Debug::TestFlagA.tracing("system.cpu0"));
+    EXPECT_TRUE(Debug::TestFlagA.status());
+
+    Debug::Flag::globalDisable();
+    EXPECT_FALSE(Debug::TestFlagA.tracing());
+    EXPECT_FALSE(Debug::TestFlagA.tracing("system.cpu0"));
+}
+
+TEST_F(DebugFlagTest, EnableForObjects)
+{
+    Debug::TestFlagA.enableFor("system.cpu1");
+    EXPECT_TRUE(Debug::TestFlagA.tracing());
+    EXPECT_FALSE(Debug::TestFlagA.tracing("system.cpu0"));
+    EXPECT_TRUE(Debug::TestFlagA.tracing("system.cpu1"));
+    EXPECT_FALSE(Debug::TestFlagB.tracing("system.cpu1"));
+
+    // Objects accumulate, and wildcards work as for --debug-ignore
+    Debug::TestFlagA.enableFor("system.*.l1d");
+    EXPECT_TRUE(Debug::TestFlagA.tracing("system.cpu1"));
+    EXPECT_TRUE(Debug::TestFlagA.tracing("system.cpu0.l1d"));
+    EXPECT_FALSE(Debug::TestFlagA.tracing("system.cpu0.l1i"));
+
+    // Another flag with the same objects shares the filter
+    Debug::TestFlagB.enableFor("system.cpu1");
+    EXPECT_TRUE(Debug::TestFlagB.tracing("system.cpu1"));
+    EXPECT_FALSE(Debug::TestFlagB.tracing("system.cpu0.l1d"));
+
+    // Enabling for all objects drops the filter
+    Debug::TestFlagA.enable();
+    EXPECT_TRUE(Debug::TestFlagA.tracing("system.cpu0"));
+
+    // Enabling for some objects doesn't restrict a flag that is on
+    Debug::TestFlagA.enableFor("system.cpu1");
+    EXPECT_TRUE(Debug::TestFlagA.tracing("system.cpu0"));
+
+    Debug::TestFlagA.disable();
+    EXPECT_FALSE(Debug::TestFlagA.tracing("system.cpu1"));
+}
+
+TEST_F(DebugFlagTest, Compound)
+{
+    Debug::TestCompound.enableFor("system.cpu2");
+    EXPECT_TRUE(Debug::TestCompound.tracing());
+    EXPECT_TRUE(Debug::TestCompound.tracing("system.cpu2"));
+    EXPECT_FALSE(Debug::TestCompound.tracing("system.cpu3"));
+    EXPECT_TRUE(Debug::TestFlagA.tracing("system.cpu2"));
+    EXPECT_TRUE(Debug::TestFlagB.tracing("system.cpu2"));
+
+    Debug::TestCompound.disable();
+    EXPECT_FALSE(Debug::TestCompound.tracing());
+    EXPECT_FALSE(Debug::TestFlagB.tracing("system.cpu2"));
+}
+
+TEST_F(DebugFlagTest, Disabled)
+{
+    Debug::TestFlagOff.enable();
+    EXPECT_FALSE(Debug::TestFlagOff.tracing());
+    EXPECT_FALSE(Debug::TestFlagOff.tracing("system"));
+    EXPECT_FALSE(Debug::TestFlagOff.status());
+
+    Debug::TestFlagOff.enableFor("system");
+    EXPECT_FALSE(Debug::TestFlagOff.tracing("system"));
+}
+
+TEST_F(DebugFlagTest, ObjectMaskCache)
+{
+    Debug::TestFlagA.enableFor("system.cpu4");
+    EXPECT_TRUE(Debug::TestFlagA.tracing("system.cpu4"));
+    EXPECT_FALSE(Debug::TestFlagA.tracing("system.cpu5"));
+
+    // Adding a filter invalidates the masks this thread cached
+    uint64_t mask = Debug::objectFilterMask("system.cpu5");
+    Debug::TestFlagB.enableFor("system.cpu5");
+    EXPECT_NE(Debug::objectFilterMask("system.cpu5"), mask);
+    EXPECT_FALSE(Debug::TestFlagB.tracing("system.cpu4"));
+    EXPECT_TRUE(Debug::TestFlagB.tracing("system.cpu5"));
+
+    // Other threads compute the same masks from their own caches
+    bool cpu4 = false, cpu5 = false;
+    std::thread other([&]() {
+        cpu4 = Debug::TestFlagA.tracing("system.cpu4");
+        cpu5 = Debug::TestFlagA.tracing("system.cpu5");
+        Debug::TestFlagA.enableFor("system.cpu5");
+    });
+    other.join();
+    EXPECT_TRUE(cpu4);
+    EXPECT_FALSE(cpu5);
+
+    // A filter added by another thread is seen here too
+    EXPECT_TRUE(Debug::TestFlagA.tracing("system.cpu5"));
+}
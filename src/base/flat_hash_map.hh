@@ -0,0 +1,571 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * An open-addressing hash map for lookup tables on the critical path of
+ * the memory system, e.g., snoop filters and routing tables.
+ *
+ * Entries are stored inline in a single power-of-two array and collisions
+ * are resolved with robin-hood linear probing: an entry that is further
+ * from its home slot than the one occupying a slot takes that slot, and
+ * the displaced entry continues probing. This keeps probe sequences short
+ * and lets a lookup stop as soon as it reaches an entry closer to its home
+ * than the key being searched for. Erasing shifts the following entries of
+ * the probe sequence back by one slot, so no tombstones are left behind
+ * and lookups do not degrade over time.
+ *
+ * The interface follows std::unordered_map, with one important
+ * difference: any insertion or erasure invalidates all iterators, pointers
+ * and references into the map, as entries are moved between slots. The
+ * hash function is expected to spread keys well; the map grows whenever
+ * a probe sequence gets longer than 254 slots.
+ */
+
+#ifndef __BASE_FLAT_HASH_MAP_HH__
+#define __BASE_FLAT_HASH_MAP_HH__
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename Key, typename T, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap
+{
+  public:
+    typedef Key key_type;
+    typedef T mapped_type;
+    typedef std::pair<const Key, T> value_type;
+    typedef std::size_t size_type;
+    typedef Hash hasher;
+    typedef KeyEqual key_equal;
+
+  private:
+    /**
+     * A slot of the table. The distance is kept next to the entry so
+     * that a probe touches a single cache line.
+     */
+    struct Slot
+    {
+        /**
+         * Distance of the entry from its home slot, plus one, or 0 if the
+         * slot is empty.
+         */
+        uint8_t distance;
+        typename std::aligned_storage<sizeof(value_type),
+                                      alignof(value_type)>::type storage;
+
+        value_type &
+        entry()
+        {
+            return *reinterpret_cast<value_type *>(&storage);
+        }
+
+        const value_type &
+        entry() const
+        {
+            return *reinterpret_cast<const value_type *>(&storage);
+        }
+    };
+
+    /** Number of slots of a new map */
+    static const size_type MinCapacity = 16;
+
+    /** Bound on the distance of an entry from its home slot, plus one */
+    static const unsigned MaxDistance = 0xff;
+
+    /** Slot index that is never valid */
+    static const size_type InvalidSlot = ~size_type(0);
+
+    /**
+     * The slots of the table, plus one extra slot with a non-zero
+     * distance to stop iterators.
+     */
+    std::unique_ptr<Slot[]> slots;
+    /** Number of slots minus one */
+    size_type mask;
+    /** Number of bits of the hash used to select the home slot */
+    unsigned bits;
+    /** Number of entries */
+    size_type numEntries;
+
+    Hash hashFn;
+    KeyEqual equalFn;
+
+  public:
+    template <bool Const>
+    class Iterator
+    {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename FlatHashMap::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef typename std::conditional<Const, const value_type *,
+                                          value_type *>::type pointer;
+        typedef typename std::conditional<Const, const value_type &,
+                                          value_type &>::type reference;
+
+      private:
+        Slot *slot;
+
+        explicit Iterator(Slot *s) : slot(s) {}
+
+        /** Skip over empty slots */
+        void
+        settle()
+        {
+            while (!slot->distance)
+                ++slot;
+        }
+
+        friend class FlatHashMap;
+
+      public:
+        Iterator() : slot(nullptr) {}
+
+        /** Allow conversion from iterator to const_iterator */
+        template <bool C = Const,
+                  typename = typename std::enable_if<C>::type>
+        Iterator(const Iterator<false> &other) : slot(other.slot) {}
+
+        reference operator*() const { return *operator->(); }
+
+        pointer
+        operator->() const
+        {
+            return &slot->entry();
+        }
+
+        Iterator &
+        operator++()
+        {
+            ++slot;
+            settle();
+            return *this;
+        }
+
+        Iterator
+        operator++(int)
+        {
+            Iterator it = *this;
+            ++*this;
+            return it;
+        }
+
+        bool operator==(const Iterator &other) const
+        {
+            return slot == other.slot;
+        }
+
+        bool operator!=(const Iterator &other) const
+        {
+            return slot != other.slot;
+        }
+
+        friend class Iterator<true>;
+    };
+
+    typedef Iterator<false> iterator;
+    typedef Iterator<true> const_iterator;
+
+    /** Create a map with room for n entries */
+    explicit FlatHashMap(size_type n = 0, const Hash &hash = Hash(),
+                         const KeyEqual &equal = KeyEqual())
+        : numEntries(0), hashFn(hash), equalFn(equal)
+    {
+        allocate(slotsFor(n));
+    }
+
+    FlatHashMap(const FlatHashMap &other)
+        : numEntries(0), hashFn(other.hashFn), equalFn(other.equalFn)
+    {
+        allocate(other.mask + 1);
+        for (size_type i = 0; i <= mask; i++) {
+            if (other.slots[i].distance) {
+                new (&slots[i].storage) value_type(other.entry(i));
+                slots[i].distance = other.slots[i].distance;
+            }
+        }
+        numEntries = other.numEntries;
+    }
+
+    FlatHashMap(FlatHashMap &&other)
+        : FlatHashMap(0, other.hashFn, other.equalFn)
+    {
+        swap(other);
+    }
+
+    FlatHashMap &
+    operator=(FlatHashMap other)
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~FlatHashMap() { destroyAll(); }
+
+    void
+    swap(FlatHashMap &other)
+    {
+        using std::swap;
+        swap(slots, other.slots);
+        swap(mask, other.mask);
+        swap(bits, other.bits);
+        swap(numEntries, other.numEntries);
+        swap(hashFn, other.hashFn);
+        swap(equalFn, other.equalFn);
+    }
+
+    iterator
+    begin()
+    {
+        iterator it(slots.get());
+        it.settle();
+        return it;
+    }
+
+    const_iterator
+    begin() const
+    {
+        const_iterator it(slots.get());
+        it.settle();
+        return it;
+    }
+
+    iterator end() { return iterator(&slots[mask + 1]); }
+    const_iterator end() const { return const_iterator(&slots[mask + 1]); }
+
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    bool empty() const { return numEntries == 0; }
+    size_type size() const { return numEntries; }
+
+    /** Number of slots, including the empty ones */
+    size_type capacity() const { return mask + 1; }
+
+    /** Remove all entries, keeping the allocated slots */
+    void
+    clear()
+    {
+        destroyAll();
+        for (size_type i = 0; i <= mask; i++)
+            slots[i].distance = 0;
+        numEntries = 0;
+    }
+
+    /** Make room for at least n entries without growing */
+    void
+    reserve(size_type n)
+    {
+        if (n > maxEntries(mask + 1))
+            rehash(slotsFor(n));
+    }
+
+    iterator
+    find(const Key &key)
+    {
+        const size_type idx = lookup(key);
+        return idx > mask ? end() : iteratorAt(idx);
+    }
+
+    const_iterator
+    find(const Key &key) const
+    {
+        const size_type idx = lookup(key);
+        return idx > mask ? end() : const_iterator(&slots[idx]);
+    }
+
+    size_type count(const Key &key) const { return lookup(key) <= mask; }
+
+    template <typename... Args>
+    std::pair<iterator, bool>
+    emplace(Args&&... args)
+    {
+        std::pair<Key, T> kv(std::forward<Args>(args)...);
+        const size_type idx = lookup(kv.first);
+        if (idx <= mask)
+            return std::make_pair(iteratorAt(idx), false);
+        return std::make_pair(iteratorAt(insertNew(kv)), true);
+    }
+
+    std::pair<iterator, bool>
+    insert(const value_type &value)
+    {
+        return emplace(value);
+    }
+
+    T &
+    operator[](const Key &key)
+    {
+        const size_type idx = lookup(key);
+        if (idx <= mask)
+            return entry(idx).second;
+        std::pair<Key, T> kv(key, T());
+        return entry(insertNew(kv)).second;
+    }
+
+    /** Erase the entry at pos, invalidating all iterators */
+    void
+    erase(const_iterator pos)
+    {
+        assert(pos != end());
+        eraseAt(pos.slot - slots.get());
+    }
+
+    size_type
+    erase(const Key &key)
+    {
+        const size_type idx = lookup(key);
+        if (idx > mask)
+            return 0;
+        eraseAt(idx);
+        return 1;
+    }
+
+  private:
+    value_type &
+    entry(size_type idx)
+    {
+        return slots[idx].entry();
+    }
+
+    const value_type &
+    entry(size_type idx) const
+    {
+        return slots[idx].entry();
+    }
+
+    iterator
+    iteratorAt(size_type idx)
+    {
+        return iterator(&slots[idx]);
+    }
+
+    /** Largest number of entries n slots may hold, at a load of 7/8 */
+    static size_type maxEntries(size_type n) { return n - n / 8; }
+
+    /** Smallest power-of-two number of slots that hold n entries */
+    static size_type
+    slotsFor(size_type n)
+    {
+        size_type slots = MinCapacity;
+        while (maxEntries(slots) < n)
+            slots *= 2;
+        return slots;
+    }
+
+    /**
+     * Home slot of a key. The hash is scrambled with a multiplicative
+     * (Fibonacci) hash and the top bits are used, as std::hash is the
+     * identity for integers and addresses have few varying low bits.
+     */
+    size_type
+    home(const Key &key) const
+    {
+        const uint64_t h = uint64_t(hashFn(key)) * 0x9e3779b97f4a7c15ULL;
+        return h >> (64 - bits);
+    }
+
+    /** Slot of key, or a value larger than mask if not found */
+    size_type
+    lookup(const Key &key) const
+    {
+        size_type idx = home(key);
+        for (unsigned dist = 1; ; dist++) {
+            const unsigned d = slots[idx].distance;
+            // An entry closer to its home (or an empty slot) means that
+            // the key would have been placed here
+            if (d < dist)
+                return mask + 1;
+            // The key can only be in a slot where d == dist, but checking
+            // that is not worth the extra branch
+            if (equalFn(entry(idx).first, key))
+                return idx;
+            idx = (idx + 1) & mask;
+        }
+    }
+
+    /**
+     * Insert an entry whose key is not in the map.
+     *
+     * @param kv Entry to insert, which is moved from.
+     * @return The slot of the new entry.
+     */
+    size_type
+    insertNew(std::pair<Key, T> &kv)
+    {
+        if (numEntries + 1 > maxEntries(mask + 1))
+            rehash((mask + 1) * 2);
+
+        size_type pos = InvalidSlot;
+        std::unique_ptr<Key> key;
+        while (!place(kv, pos)) {
+            // A probe sequence got too long and kv now holds the entry
+            // that did not fit. If that is not the new entry, remember
+            // the key of the new one, as growing moves it.
+            if (pos != InvalidSlot && !key)
+                key.reset(new Key(entry(pos).first));
+            rehash((mask + 1) * 2);
+            pos = InvalidSlot;
+        }
+        numEntries++;
+        return key ? lookup(*key) : pos;
+    }
+
+    /**
+     * Robin-hood insertion of an entry.
+     *
+     * @param carry Entry to insert, which is moved from. On failure it
+     *              holds the entry that was left without a slot.
+     * @param pos Set to the slot of the entry when it is placed.
+     * @return False if an entry would end up too far from its home slot.
+     */
+    bool
+    place(std::pair<Key, T> &carry, size_type &pos)
+    {
+        size_type idx = home(carry.first);
+        bool placed = false;
+        for (unsigned dist = 1; dist < MaxDistance; dist++) {
+            const unsigned d = slots[idx].distance;
+            if (!d) {
+                new (&slots[idx].storage) value_type(std::move(carry));
+                slots[idx].distance = dist;
+                if (!placed)
+                    pos = idx;
+                return true;
+            }
+
+            if (d < dist) {
+                // Take the slot of an entry that is closer to its home,
+                // and find a new slot for that one instead
+                std::pair<Key, T> displaced(std::move(entry(idx)));
+                entry(idx).~value_type();
+                new (&slots[idx].storage) value_type(std::move(carry));
+                carry = std::move(displaced);
+                slots[idx].distance = dist;
+                dist = d;
+                if (!placed) {
+                    pos = idx;
+                    placed = true;
+                }
+            }
+            idx = (idx + 1) & mask;
+        }
+        return false;
+    }
+
+    /** Erase the entry in slot idx, shifting its successors back */
+    void
+    eraseAt(size_type idx)
+    {
+        entry(idx).~value_type();
+        size_type next = (idx + 1) & mask;
+        while (slots[next].distance > 1) {
+            new (&slots[idx].storage) value_type(std::move(entry(next)));
+            entry(next).~value_type();
+            slots[idx].distance = slots[next].distance - 1;
+            idx = next;
+            next = (next + 1) & mask;
+        }
+        slots[idx].distance = 0;
+        numEntries--;
+    }
+
+    /** Allocate n empty slots, n being a power of two */
+    void
+    allocate(size_type n)
+    {
+        assert(n && !(n & (n - 1)));
+        slots.reset(new Slot[n + 1]);
+        for (size_type i = 0; i < n; i++)
+            slots[i].distance = 0;
+        slots[n].distance = 1;
+        mask = n - 1;
+        bits = 0;
+        while ((size_type(1) << bits) < n)
+            bits++;
+    }
+
+    void
+    destroyAll()
+    {
+        if (std::is_trivially_destructible<value_type>::value || !slots)
+            return;
+        for (size_type i = 0; i <= mask; i++) {
+            if (slots[i].distance)
+                entry(i).~value_type();
+        }
+    }
+
+    /** Move all entries to a table of n slots */
+    void
+    rehash(size_type n)
+    {
+        std::unique_ptr<Slot[]> old_slots(std::move(slots));
+        const size_type old_size = mask + 1;
+
+        allocate(n);
+        std::vector<std::pair<Key, T>> overflow;
+        for (size_type i = 0; i < old_size; i++) {
+            if (!old_slots[i].distance)
+                continue;
+            value_type &old = old_slots[i].entry();
+            std::pair<Key, T> kv(std::move(old));
+            old.~value_type();
+            size_type pos;
+            if (!place(kv, pos))
+                overflow.push_back(std::move(kv));
+        }
+
+        // Keep growing until the entries that did not fit have a slot
+        for (auto &kv : overflow) {
+            size_type pos;
+            while (!place(kv, pos))
+                rehash((mask + 1) * 2);
+        }
+    }
+};
+
+template <typename Key, typename T, typename Hash, typename KeyEqual>
+void
+swap(FlatHashMap<Key, T, Hash, KeyEqual> &a,
+     FlatHashMap<Key, T, Hash, KeyEqual> &b)
+{
+    a.swap(b);
+}
+
+#endif // __BASE_FLAT_HASH_MAP_HH__
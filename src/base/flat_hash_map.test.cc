@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "base/flat_hash_map.hh"
+
+TEST(FlatHashMapTest, Empty)
+{
+    FlatHashMap<uint64_t, int> map;
+
+    ASSERT_TRUE(map.empty());
+    ASSERT_EQ(0, map.size());
+    ASSERT_TRUE(map.begin() == map.end());
+    ASSERT_TRUE(map.find(0) == map.end());
+    ASSERT_EQ(0, map.count(0));
+    ASSERT_EQ(0, map.erase(0));
+}
+
+TEST(FlatHashMapTest, EmplaceFind)
+{
+    FlatHashMap<uint64_t, int> map;
+
+    auto res = map.emplace(0x1000, 1);
+    ASSERT_TRUE(res.second);
+    ASSERT_EQ(0x1000, res.first->first);
+    ASSERT_EQ(1, res.first->second);
+
+    // Emplacing an existing key returns the existing entry
+    res = map.emplace(0x1000, 2);
+    ASSERT_FALSE(res.second);
+    ASSERT_EQ(1, res.first->second);
+    ASSERT_EQ(1, map.size());
+
+    auto it = map.find(0x1000);
+    ASSERT_TRUE(it != map.end());
+    it->second = 3;
+    ASSERT_EQ(3, map.find(0x1000)->second);
+    ASSERT_TRUE(map.find(0x1040) == map.end());
+}
+
+TEST(FlatHashMapTest, SubscriptOperator)
+{
+    FlatHashMap<uint64_t, int> map;
+
+    ASSERT_EQ(0, map[42]);
+    ASSERT_EQ(1, map.size());
+    map[42] = 7;
+    map[43] += 2;
+    ASSERT_EQ(7, map[42]);
+    ASSERT_EQ(2, map[43]);
+    ASSERT_EQ(2, map.size());
+}
+
+TEST(FlatHashMapTest, Erase)
+{
+    FlatHashMap<uint64_t, int> map;
+    for (int i = 0; i < 100; i++)
+        map[i * 64] = i;
+
+    ASSERT_EQ(1, map.erase(10 * 64));
+    ASSERT_EQ(0, map.erase(10 * 64));
+    map.erase(map.find(20 * 64));
+    ASSERT_EQ(98, map.size());
+
+    for (int i = 0; i < 100; i++) {
+        auto it = map.find(i * 64);
+        if (i == 10 || i == 20) {
+            ASSERT_TRUE(it == map.end());
+        } else {
+            ASSERT_TRUE(it != map.end());
+            ASSERT_EQ(i, it->second);
+        }
+    }
+}
+
+/** Growing keeps all entries */
+TEST(FlatHashMapTest, Grow)
+{
+    FlatHashMap<uint64_t, uint64_t> map;
+    const auto capacity = map.capacity();
+    for (uint64_t i = 0; i < 10000; i++)
+        map.emplace(i << 6, i);
+
+    ASSERT_EQ(10000, map.size());
+    ASSERT_GT(map.capacity(), capacity);
+    ASSERT_GE(map.capacity(), map.size());
+    for (uint64_t i = 0; i < 10000; i++)
+        ASSERT_EQ(i, map.find(i << 6)->second);
+}
+
+TEST(FlatHashMapTest, Reserve)
+{
+    FlatHashMap<uint64_t, int> map;
+    map.reserve(1000);
+    const auto capacity = map.capacity();
+    for (int i = 0; i < 1000; i++)
+        map[i] = i;
+    ASSERT_EQ(capacity, map.capacity());
+}
+
+TEST(FlatHashMapTest, Iterate)
+{
+    FlatHashMap<uint64_t, int> map;
+    uint64_t key_sum = 0;
+    for (int i = 1; i <= 500; i++) {
+        map[i * 4096] = i;
+        key_sum += i * 4096;
+    }
+
+    uint64_t seen_keys = 0;
+    int seen_values = 0;
+    int entries = 0;
+    for (const auto &kv : map) {
+        seen_keys += kv.first;
+        seen_values += kv.second;
+        entries++;
+    }
+    ASSERT_EQ(500, entries);
+    ASSERT_EQ(key_sum, seen_keys);
+    ASSERT_EQ(500 * 501 / 2, seen_values);
+
+    const auto &cmap = map;
+    FlatHashMap<uint64_t, int>::const_iterator it = map.begin();
+    ASSERT_TRUE(it == cmap.begin());
+    ASSERT_EQ(500, std::distance(cmap.begin(), cmap.end()));
+}
+
+TEST(FlatHashMapTest, Clear)
+{
+    FlatHashMap<uint64_t, std::string> map;
+    for (int i = 0; i < 100; i++)
+        map[i] = std::to_string(i);
+    map.clear();
+    ASSERT_TRUE(map.empty());
+    ASSERT_TRUE(map.begin() == map.end());
+    ASSERT_TRUE(map.find(5) == map.end());
+    map[5] = "five";
+    ASSERT_EQ("five", map[5]);
+}
+
+TEST(FlatHashMapTest, CopyMove)
+{
+    FlatHashMap<uint64_t, std::string> map;
+    for (int i = 0; i < 100; i++)
+        map[i] = std::to_string(i);
+
+    FlatHashMap<uint64_t, std::string> copy(map);
+    map[0] = "zero";
+    ASSERT_EQ(100, copy.size());
+    ASSERT_EQ("0", copy[0]);
+
+    FlatHashMap<uint64_t, std::string> moved(std::move(copy));
+    ASSERT_EQ(100, moved.size());
+    ASSERT_EQ("99", moved[99]);
+    ASSERT_TRUE(copy.empty());
+
+    copy = moved;
+    ASSERT_EQ(100, copy.size());
+    ASSERT_EQ("42", copy[42]);
+}
+
+/** Non-trivial keys and values, e.g., a routing table keyed by request */
+TEST(FlatHashMapTest, SharedPtrKeys)
+{
+    FlatHashMap<std::shared_ptr<int>, std::list<int>> map;
+    std::vector<std::shared_ptr<int>> keys;
+    for (int i = 0; i < 100; i++) {
+        keys.push_back(std::make_shared<int>(i));
+        map[keys.back()].push_back(i);
+    }
+    for (int i = 0; i < 100; i += 2)
+        map.erase(keys[i]);
+
+    ASSERT_EQ(50, map.size());
+    for (int i = 0; i < 100; i++) {
+        // The map holds the only other reference to the key
+        ASSERT_EQ(i % 2 ? 2 : 1, keys[i].use_count());
+        if (i % 2)
+            ASSERT_EQ(i, map[keys[i]].front());
+    }
+    map.clear();
+    ASSERT_EQ(1, keys[1].use_count());
+}
+
+namespace {
+
+/** A terrible hash that makes every key collide with many others */
+struct CollidingHash
+{
+    size_t operator()(uint64_t key) const { return key / 200; }
+};
+
+} // anonymous namespace
+
+/** Long probe sequences make the map grow rather than fail */
+TEST(FlatHashMapTest, LongProbeSequences)
+{
+    FlatHashMap<uint64_t, uint64_t, CollidingHash> map;
+    for (uint64_t i = 0; i < 3000; i++)
+        map[i] = i;
+    ASSERT_EQ(3000, map.size());
+    for (uint64_t i = 0; i < 3000; i++)
+        ASSERT_EQ(i, map.find(i)->second);
+}
+
+/** Random operations give the same results as std::unordered_map */
+TEST(FlatHashMapTest, CompareUnorderedMap)
+{
+    std::mt19937_64 rng(1);
+    FlatHashMap<uint64_t, uint64_t> map;
+    std::unordered_map<uint64_t, uint64_t> ref;
+
+    for (int i = 0; i < 200000; i++) {
+        // Cache-line aligned keys in a small range, to exercise erasure
+        // in long runs of occupied slots
+        const uint64_t key = (rng() % 4096) << 6;
+        switch (rng() % 4) {
+          case 0:
+          case 1:
+            ASSERT_EQ(ref.emplace(key, i).second,
+                      map.emplace(key, i).second);
+            break;
+          case 2:
+            ASSERT_EQ(ref.erase(key), map.erase(key));
+            break;
+          case 3: {
+            auto it = map.find(key);
+            auto ref_it = ref.find(key);
+            ASSERT_EQ(ref_it == ref.end(), it == map.end());
+            if (it != map.end())
+                ASSERT_EQ(ref_it->second, it->second);
+            break;
+          }
+        }
+        ASSERT_EQ(ref.size(), map.size());
+    }
+
+    size_t entries = 0;
+    for (const auto &kv : map) {
+        ASSERT_EQ(ref.at(kv.first), kv.second);
+        entries++;
+    }
+    ASSERT_EQ(ref.size(), entries);
+}
+
+namespace {
+
+/**
+ * Time a mix of inserts, hits, misses and erases similar to that of a
+ * snoop filter, on a working set of the given number of cache lines.
+ */
+template <typename Map>
+double
+lookupThroughput(size_t lines)
+{
+    std::mt19937_64 rng(1);
+    const size_t ops = 5000000;
+    std::vector<uint64_t> keys(ops);
+    for (auto &key : keys)
+        key = (rng() % (2 * lines)) << 6;
+
+    Map map;
+    uint64_t hits = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; i++) {
+        auto it = map.find(keys[i]);
+        if (it == map.end()) {
+            map.emplace(keys[i], i);
+        } else {
+            hits += it->second;
+            if (i & 1)
+                map.erase(it);
+        }
+    }
+    const std::chrono::duration<double> secs =
+        std::chrono::steady_clock::now() - start;
+
+    // Keep the loop from being optimised away
+    EXPECT_NE(0, hits);
+    return ops / secs.count() / 1e6;
+}
+
+} // anonymous namespace
+
+/**
+ * Throughput comparison with std::unordered_map. This is a benchmark
+ * rather than a test, so it is disabled by default; run it with
+ * --gtest_also_run_disabled_tests.
+ */
+TEST(FlatHashMapTest, DISABLED_Throughput)
+{
+    for (size_t lines : { 1024, 16384, 262144 }) {
+        const double flat =
+            lookupThroughput<FlatHashMap<uint64_t, uint64_t>>(lines);
+        const double unordered =
+            lookupThroughput<std::unordered_map<uint64_t, uint64_t>>(
+                lines);
+        std::cout << lines << " lines: FlatHashMap " << flat
+                  << " Mops/s, std::unordered_map " << unordered
+                  << " Mops/s\n";
+    }
+}
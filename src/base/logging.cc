@@ -43,6 +43,7 @@
 #include <sstream>
 
 #include "base/hostinfo.hh"
+#include "base/trace.hh"
 
 namespace {
 
@@ -64,6 +65,10 @@ class ExitLogger : public NormalLogger
     void
     log(const Loc &loc, std::string s) override
     {
+        // Neither abort() nor exit() leave a chance to write out the
+        // debug output that is still buffered
+        Trace::flush();
+
         std::stringstream ss;
         ccprintf(ss, "Memory Usage: %ld KBytes\n", memUsage());
         NormalLogger::log(loc, s + ss.str());
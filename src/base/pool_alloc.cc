@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/pool_alloc.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+const size_t PoolAlloc::Granularity;
+const size_t PoolAlloc::MaxSize;
+const size_t PoolAlloc::SlabSize;
+
+namespace
+{
+
+const size_t NumClasses = PoolAlloc::MaxSize / PoolAlloc::Granularity;
+
+struct FreeBlock
+{
+    FreeBlock *next;
+};
+
+/** The pool of one thread */
+struct ThreadPool
+{
+    /** Blocks that may be handed out, only used by the owning thread */
+    FreeBlock *freeLists[NumClasses];
+    /** Blocks freed by other threads, taken back by the owner */
+    std::atomic<FreeBlock *> remoteFree[NumClasses];
+
+    ThreadPool()
+    {
+        for (size_t cls = 0; cls < NumClasses; ++cls) {
+            freeLists[cls] = nullptr;
+            remoteFree[cls] = nullptr;
+        }
+    }
+};
+
+/** Header at the start of every slab; the first block follows it. */
+struct SlabHeader
+{
+    ThreadPool *owner;
+};
+
+static_assert(sizeof(SlabHeader) <= PoolAlloc::Granularity,
+              "The slab header must fit in the first granule");
+
+/**
+ * The pool of the calling thread. Pools are never destroyed, as blocks
+ * may be freed by other threads after their owner has exited.
+ */
+__thread ThreadPool *localPool;
+
+ThreadPool *
+threadPool()
+{
+    if (!localPool)
+        localPool = new ThreadPool;
+    return localPool;
+}
+
+size_t
+sizeClass(size_t size)
+{
+    return (size - 1) / PoolAlloc::Granularity;
+}
+
+bool
+pooled(size_t size)
+{
+    return POOL_ALLOC_ENABLED && size != 0 && size <= PoolAlloc::MaxSize;
+}
+
+void
+refill(ThreadPool *pool, size_t cls)
+{
+    // Take back the blocks other threads have freed before carving a
+    // new slab, so a thread that allocates what others free does not
+    // grow without bound
+    pool->freeLists[cls] = pool->remoteFree[cls].exchange(
+        nullptr, std::memory_order_acquire);
+    if (pool->freeLists[cls])
+        return;
+
+    void *mem;
+    if (posix_memalign(&mem, PoolAlloc::SlabSize, PoolAlloc::SlabSize) != 0)
+        throw std::bad_alloc();
+
+    char *slab = static_cast<char *>(mem);
+    reinterpret_cast<SlabHeader *>(slab)->owner = pool;
+
+    const size_t block_size = (cls + 1) * PoolAlloc::Granularity;
+    FreeBlock *head = nullptr;
+    for (size_t off = PoolAlloc::Granularity;
+         off + block_size <= PoolAlloc::SlabSize; off += block_size) {
+        FreeBlock *block = reinterpret_cast<FreeBlock *>(slab + off);
+        block->next = head;
+        head = block;
+    }
+    pool->freeLists[cls] = head;
+}
+
+} // anonymous namespace
+
+void *
+PoolAlloc::allocate(size_t size)
+{
+    if (!pooled(size))
+        return ::operator new(size);
+
+    ThreadPool *pool = threadPool();
+    const size_t cls = sizeClass(size);
+    if (!pool->freeLists[cls])
+        refill(pool, cls);
+    FreeBlock *block = pool->freeLists[cls];
+    pool->freeLists[cls] = block->next;
+    return block;
+}
+
+void
+PoolAlloc::release(void *p, size_t size)
+{
+    if (!p)
+        return;
+
+    if (!pooled(size)) {
+        ::operator delete(p);
+        return;
+    }
+
+    FreeBlock *block = static_cast<FreeBlock *>(p);
+    const size_t cls = sizeClass(size);
+    ThreadPool *owner = reinterpret_cast<SlabHeader *>(
+        reinterpret_cast<uintptr_t>(p) & ~(uintptr_t)(SlabSize - 1))->owner;
+
+    if (owner == localPool) {
+        block->next = owner->freeLists[cls];
+        owner->freeLists[cls] = block;
+        return;
+    }
+
+    // Give the block back to the thread owning its slab
+    FreeBlock *head = owner->remoteFree[cls].load(std::memory_order_relaxed);
+    do {
+        block->next = head;
+    } while (!owner->remoteFree[cls].compare_exchange_weak(
+                 head, block, std::memory_order_release,
+                 std::memory_order_relaxed));
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Per-thread pools for small objects that are allocated and freed at a
+ * high rate, such as packets, requests, sender states, Ruby messages
+ * and dynamic instructions. Blocks are carved out of large slabs and
+ * recycled through free lists indexed by size, so in steady state no
+ * call reaches malloc or free. Free lists are per thread, so allocation
+ * and local frees take no locks.
+ *
+ * A block freed by a thread other than the one that allocated it, e.g.,
+ * when the memory system is split across event queues, goes back to
+ * the owner of its slab through a lock-free list, which the owner
+ * drains before carving a new slab. Each thread thus holds at most as
+ * many blocks as it had live at its peak. Slabs are never returned to
+ * the system.
+ *
+ * The pools are bypassed in builds with AddressSanitizer, so that it
+ * still finds use-after-free errors on pooled objects.
+ */
+
+#ifndef __BASE_POOL_ALLOC_HH__
+#define __BASE_POOL_ALLOC_HH__
+
+#include <cstddef>
+
+#if defined(__SANITIZE_ADDRESS__)
+#define POOL_ALLOC_ENABLED 0
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define POOL_ALLOC_ENABLED 0
+#endif
+#endif
+
+#ifndef POOL_ALLOC_ENABLED
+#define POOL_ALLOC_ENABLED 1
+#endif
+
+class PoolAlloc
+{
+  public:
+    /** Size granularity of the free lists; also the block alignment */
+    static const size_t Granularity = 16;
+    /** Largest size served from the free lists */
+    static const size_t MaxSize = 1024;
+    /**
+     * Size of the slabs blocks are carved from. Slabs are aligned to
+     * their size, so the slab, and thus the owner, of a block can be
+     * found from its address.
+     */
+    static const size_t SlabSize = 64 * 1024;
+
+    /** Allocate size bytes */
+    static void *allocate(size_t size);
+
+    /** Free a block returned by allocate(size), on any thread */
+    static void release(void *p, size_t size);
+};
+
+/**
+ * Standard allocator on top of PoolAlloc, e.g. for std::allocate_shared,
+ * which then puts the object and its control block in a single block.
+ */
+template <typename T>
+struct PoolAllocator
+{
+    typedef T value_type;
+
+    PoolAllocator() {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &) {}
+
+    T *
+    allocate(size_t n)
+    {
+        return static_cast<T *>(PoolAlloc::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t n) { PoolAlloc::release(p, n * sizeof(T)); }
+};
+
+template <typename T, typename U>
+bool
+operator==(const PoolAllocator<T> &, const PoolAllocator<U> &)
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool
+operator!=(const PoolAllocator<T> &, const PoolAllocator<U> &)
+{
+    return false;
+}
+
+#endif // __BASE_POOL_ALLOC_HH__
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "base/pool_alloc.hh"
+
+TEST(PoolAllocTest, ReuseSameClass)
+{
+    void *p = PoolAlloc::allocate(40);
+    ASSERT_NE(nullptr, p);
+    PoolAlloc::release(p, 40);
+
+    // Any size in the same class gets the block back
+    void *q = PoolAlloc::allocate(48);
+#if POOL_ALLOC_ENABLED
+    EXPECT_EQ(p, q);
+#endif
+    PoolAlloc::release(q, 48);
+}
+
+TEST(PoolAllocTest, DistinctLiveBlocks)
+{
+    std::set<void *> blocks;
+    for (int i = 0; i < 100; i++) {
+        void *p = PoolAlloc::allocate(24);
+        ASSERT_TRUE(blocks.insert(p).second);
+        std::memset(p, 0xa5, 24);
+    }
+    for (auto p : blocks)
+        PoolAlloc::release(p, 24);
+}
+
+TEST(PoolAllocTest, LargeAllocations)
+{
+    void *p = PoolAlloc::allocate(PoolAlloc::MaxSize + 1);
+    ASSERT_NE(nullptr, p);
+    std::memset(p, 0, PoolAlloc::MaxSize + 1);
+    PoolAlloc::release(p, PoolAlloc::MaxSize + 1);
+    PoolAlloc::release(nullptr, 16);
+}
+
+TEST(PoolAllocTest, Alignment)
+{
+    void *p = PoolAlloc::allocate(8);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p) % alignof(std::max_align_t));
+    PoolAlloc::release(p, 8);
+}
+
+TEST(PoolAllocTest, RemoteFreeReturnsToOwner)
+{
+    // Blocks freed by another thread go back to the thread that
+    // allocated them, so a thread that keeps allocating what another
+    // one frees reuses the same few slabs
+    std::set<void *> seen;
+    std::vector<void *> blocks(100);
+    for (int round = 0; round < 100; round++) {
+        for (auto &p : blocks) {
+            p = PoolAlloc::allocate(64);
+            seen.insert(p);
+        }
+        std::thread other([&blocks]() {
+            for (auto p : blocks)
+                PoolAlloc::release(p, 64);
+        });
+        other.join();
+    }
+#if POOL_ALLOC_ENABLED
+    EXPECT_LE(seen.size(), 2 * PoolAlloc::SlabSize / 64);
+#endif
+}
+
+namespace {
+
+struct Tracked
+{
+    static int live;
+    int value;
+    Tracked(int v) : value(v) { live++; }
+    ~Tracked() { live--; }
+};
+
+int Tracked::live = 0;
+
+} // anonymous namespace
+
+TEST(PoolAllocTest, AllocateShared)
+{
+    std::shared_ptr<Tracked> ptr =
+        std::allocate_shared<Tracked>(PoolAllocator<Tracked>(), 42);
+    EXPECT_EQ(42, ptr->value);
+    EXPECT_EQ(1, Tracked::live);
+
+    std::shared_ptr<Tracked> copy = ptr;
+    ptr.reset();
+    EXPECT_EQ(1, Tracked::live);
+    copy.reset();
+    EXPECT_EQ(0, Tracked::live);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * SHA-256 as specified in FIPS 180-4, for when a digest must not
+ * collide by accident, e.g., to tell whether a page of memory has
+ * changed without keeping a copy of it.
+ */
+
+#ifndef __BASE_SHA256_HH__
+#define __BASE_SHA256_HH__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+class Sha256
+{
+  public:
+    static const size_t DigestSize = 32;
+    typedef std::array<uint8_t, DigestSize> Digest;
+
+    Sha256() { reset(); }
+
+    /** Start a new digest. */
+    void reset();
+
+    /** Add len bytes of data to the digest. */
+    void update(const void *data, size_t len);
+
+    /** Finish the digest; reset() must be called before reuse. */
+    Digest digest();
+
+    /** The digest of len bytes of data. */
+    static Digest
+    hash(const void *data, size_t len)
+    {
+        Sha256 sha;
+        sha.update(data, len);
+        return sha.digest();
+    }
+
+  private:
+    static const size_t BlockSize = 64;
+
+    /** Process one block of input. */
+    void compress(const uint8_t *block);
+
+    uint32_t state[8];
+    uint8_t buffer[BlockSize];
+    size_t buffered;
+    uint64_t length;
+};
+
+#endif // __BASE_SHA256_HH__
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+
+#include "base/sha256.hh"
+
+namespace {
+
+std::string
+hex(const Sha256::Digest &digest)
+{
+    std::string out;
+    char buf[3];
+    for (auto byte : digest) {
+        std::snprintf(buf, sizeof(buf), "%02x", byte);
+        out += buf;
+    }
+    return out;
+}
+
+std::string
+hash(const std::string &data)
+{
+    return hex(Sha256::hash(data.data(), data.size()));
+}
+
+} // anonymous namespace
+
+TEST(Sha256Test, Empty)
+{
+    EXPECT_EQ("e3b0c44298fc1c149afbf4c8996fb924"
+              "27ae41e4649b934ca495991b7852b855",
+              hash(""));
+}
+
+TEST(Sha256Test, OneBlock)
+{
+    EXPECT_EQ("ba7816bf8f01cfea414140de5dae2223"
+              "b00361a396177a9cb410ff61f20015ad",
+              hash("abc"));
+}
+
+TEST(Sha256Test, TwoBlocks)
+{
+    // The padding does not fit in the block holding the end of the data
+    EXPECT_EQ("248d6a61d20638b8e5c026930c3e6039"
+              "a33ce45964ff2167f6ecedd419db06c1",
+              hash("abcdbcdecdefdefgefghfghighijhijk"
+                   "ijkljklmklmnlmnomnopnopq"));
+}
+
+TEST(Sha256Test, Incremental)
+{
+    // A million 'a's, added in pieces that straddle blocks
+    const std::string piece(999, 'a');
+    Sha256 sha;
+    for (int i = 0; i < 1001; i++)
+        sha.update(piece.data(), piece.size());
+    sha.update(piece.data(), 1);
+    EXPECT_EQ("cdc76e5c9914fb9281a1c7e284d73e67"
+              "f1809a48a497200e046d39ccc7112cd0",
+              hex(sha.digest()));
+}
+
+TEST(Sha256Test, Reset)
+{
+    Sha256 sha;
+    sha.update("xyz", 3);
+    sha.digest();
+    sha.reset();
+    sha.update("abc", 3);
+    EXPECT_EQ(hash("abc"), hex(sha.digest()));
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * A bounded queue to pass items from one thread to another, e.g., from a
+ * helper thread that decodes input ahead of the simulation.
+ *
+ * Pushing and popping are lock free as long as the queue is neither full
+ * nor empty. The blocking variants only take a lock to sleep when they
+ * have to wait for the other side.
+ */
+
+#ifndef __BASE_SPSC_QUEUE_HH__
+#define __BASE_SPSC_QUEUE_HH__
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * Single-producer single-consumer queue on top of a power-of-two ring
+ * buffer. Exactly one thread may push and exactly one thread may pop at
+ * any time. Either side may close the queue, after which pushes fail and
+ * pops only return the items that are still queued.
+ */
+template <typename T>
+class SPSCQueue
+{
+  private:
+    /**
+     * Size of a cache line. The state of each side is padded to a line
+     * to keep the two sides from false sharing.
+     */
+    static const size_t LineSize = 64;
+
+    std::vector<T> buffer;
+    const size_t mask;
+
+    /** Index of the next item to pop, written by the consumer */
+    std::atomic<size_t> head;
+    /** The consumer's copy of tail, to avoid reading it on every pop */
+    size_t tailCache;
+    char consumerPad[LineSize - 2 * sizeof(size_t)];
+
+    /** Index of the next item to push, written by the producer */
+    std::atomic<size_t> tail;
+    /** The producer's copy of head, to avoid reading it on every push */
+    size_t headCache;
+    char producerPad[LineSize - 2 * sizeof(size_t)];
+
+    std::atomic<bool> isClosed;
+    /** Number of threads sleeping on the condition variable */
+    std::atomic<int> waiters;
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    static size_t
+    roundUp(size_t n)
+    {
+        size_t size = 1;
+        while (size < n)
+            size *= 2;
+        return size;
+    }
+
+    /** Wake up the other side if it is sleeping */
+    void
+    notify()
+    {
+        // Order the index update before reading waiters; this pairs with
+        // the fence in wait()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cond.notify_all();
+        }
+    }
+
+    /** Sleep until pred() is true or the queue is closed */
+    template <typename Pred>
+    void
+    wait(Pred pred)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cond.wait(lock, [this, &pred]() {
+            return pred() || isClosed.load(std::memory_order_acquire);
+        });
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+  public:
+    /**
+     * @param capacity Minimum number of items the queue can hold; rounded
+     *                 up to a power of two.
+     */
+    explicit SPSCQueue(size_t capacity)
+        : buffer(roundUp(capacity)), mask(buffer.size() - 1),
+          head(0), tailCache(0), tail(0), headCache(0),
+          isClosed(false), waiters(0)
+    {}
+
+    SPSCQueue(const SPSCQueue &) = delete;
+    SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+    size_t capacity() const { return buffer.size(); }
+
+    /** Number of queued items; only exact when called by either side */
+    size_t
+    size() const
+    {
+        return tail.load(std::memory_order_acquire) -
+            head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    /**
+     * Push an item if there is space for it. Called by the producer.
+     *
+     * @return False if the queue is full or closed.
+     */
+    bool
+    tryPush(T &&item)
+    {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - headCache == buffer.size()) {
+            headCache = head.load(std::memory_order_acquire);
+            if (t - headCache == buffer.size())
+                return false;
+        }
+        if (isClosed.load(std::memory_order_relaxed))
+            return false;
+
+        buffer[t & mask] = std::move(item);
+        tail.store(t + 1, std::memory_order_release);
+        notify();
+        return true;
+    }
+
+    /**
+     * Pop an item if there is one. Called by the consumer.
+     *
+     * @return False if the queue is empty.
+     */
+    bool
+    tryPop(T &item)
+    {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tailCache) {
+            tailCache = tail.load(std::memory_order_acquire);
+            if (h == tailCache)
+                return false;
+        }
+
+        item = std::move(buffer[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        notify();
+        return true;
+    }
+
+    /**
+     * Push an item, waiting for space if the queue is full.
+     *
+     * @return False if the queue is closed.
+     */
+    bool
+    push(T &&item)
+    {
+        while (!tryPush(std::move(item))) {
+            if (isClosed.load(std::memory_order_acquire))
+                return false;
+            wait([this]() {
+                return tail.load(std::memory_order_relaxed) -
+                    head.load(std::memory_order_acquire) < buffer.size();
+            });
+        }
+        return true;
+    }
+
+    /**
+     * Pop an item, waiting for one if the queue is empty.
+     *
+     * @return False if the queue is empty and closed.
+     */
+    bool
+    pop(T &item)
+    {
+        while (!tryPop(item)) {
+            if (isClosed.load(std::memory_order_acquire)) {
+                // Items may have been pushed right before the queue was
+                // closed
+                return tryPop(item);
+            }
+            wait([this]() {
+                return head.load(std::memory_order_relaxed) !=
+                    tail.load(std::memory_order_acquire);
+            });
+        }
+        return true;
+    }
+
+    /** Close the queue and wake up the other side. */
+    void
+    close()
+    {
+        isClosed.store(true, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(mutex);
+        cond.notify_all();
+    }
+
+    bool closed() const { return isClosed.load(std::memory_order_acquire); }
+};
+
+#endif // __BASE_SPSC_QUEUE_HH__
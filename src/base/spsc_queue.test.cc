@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+
+#include "base/spsc_queue.hh"
+
+TEST(SPSCQueueTest, Capacity)
+{
+    SPSCQueue<int> queue(5);
+    ASSERT_EQ(8, queue.capacity());
+    ASSERT_TRUE(queue.empty());
+    ASSERT_FALSE(queue.closed());
+}
+
+TEST(SPSCQueueTest, PushPop)
+{
+    SPSCQueue<int> queue(4);
+    int item;
+    ASSERT_FALSE(queue.tryPop(item));
+
+    for (int i = 0; i < 4; i++)
+        ASSERT_TRUE(queue.tryPush(int(i)));
+    ASSERT_FALSE(queue.tryPush(4));
+    ASSERT_EQ(4, queue.size());
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(queue.tryPop(item));
+        ASSERT_EQ(i, item);
+    }
+    ASSERT_FALSE(queue.tryPop(item));
+    ASSERT_TRUE(queue.empty());
+}
+
+TEST(SPSCQueueTest, WrapAround)
+{
+    SPSCQueue<int> queue(4);
+    int item;
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(queue.tryPush(int(i)));
+        ASSERT_TRUE(queue.tryPush(int(i + 1000)));
+        ASSERT_TRUE(queue.tryPop(item));
+        ASSERT_EQ(i, item);
+        ASSERT_TRUE(queue.tryPop(item));
+        ASSERT_EQ(i + 1000, item);
+    }
+}
+
+TEST(SPSCQueueTest, MoveOnly)
+{
+    SPSCQueue<std::unique_ptr<int>> queue(2);
+    ASSERT_TRUE(queue.tryPush(std::unique_ptr<int>(new int(42))));
+    std::unique_ptr<int> item;
+    ASSERT_TRUE(queue.tryPop(item));
+    ASSERT_EQ(42, *item);
+}
+
+/** Closing keeps queued items, but rejects new ones */
+TEST(SPSCQueueTest, Close)
+{
+    SPSCQueue<int> queue(4);
+    ASSERT_TRUE(queue.push(1));
+    queue.close();
+    ASSERT_TRUE(queue.closed());
+    ASSERT_FALSE(queue.push(2));
+
+    int item;
+    ASSERT_TRUE(queue.pop(item));
+    ASSERT_EQ(1, item);
+    ASSERT_FALSE(queue.pop(item));
+}
+
+/** Closing wakes up a consumer waiting on an empty queue */
+TEST(SPSCQueueTest, CloseWakesConsumer)
+{
+    SPSCQueue<int> queue(4);
+    bool popped = true;
+    std::thread consumer([&]() {
+        int item;
+        popped = queue.pop(item);
+    });
+    queue.close();
+    consumer.join();
+    ASSERT_FALSE(popped);
+}
+
+/** Closing wakes up a producer waiting on a full queue */
+TEST(SPSCQueueTest, CloseWakesProducer)
+{
+    SPSCQueue<int> queue(1);
+    ASSERT_TRUE(queue.push(0));
+    bool pushed = true;
+    std::thread producer([&]() { pushed = queue.push(1); });
+    queue.close();
+    producer.join();
+    ASSERT_FALSE(pushed);
+}
+
+/** Items arrive in order when both sides run concurrently */
+TEST(SPSCQueueTest, Threads)
+{
+    const int num_items = 1000000;
+    SPSCQueue<int> queue(16);
+    std::thread producer([&]() {
+        for (int i = 0; i < num_items; i++)
+            queue.push(int(i));
+        queue.close();
+    });
+
+    int expected = 0;
+    int item;
+    while (queue.pop(item)) {
+        ASSERT_EQ(expected, item);
+        expected++;
+    }
+    producer.join();
+    ASSERT_EQ(num_items, expected);
+}
@@ -72,6 +72,7 @@
 #include <string>
 #include <vector>
 
+#include "base/stats/binary.hh"
 #include "base/stats/group.hh"
 #include "base/stats/info.hh"
 #include "base/stats/output.hh"
@@ -117,6 +118,12 @@ class ScalarInfoProxy : public InfoProxy<Stat, ScalarInfo>
     Counter value() const { return this->s.value(); }
     Result result() const { return this->s.result(); }
     Result total() const { return this->s.total(); }
+
+    bool
+    merge(const std::vector<double> &values)
+    {
+        return this->s.merge(values);
+    }
 };
 
 template <class Stat>
@@ -146,6 +153,12 @@ class VectorInfoProxy : public InfoProxy<Stat, VectorInfo>
     }
 
     Result total() const { return this->s.total(); }
+
+    bool
+    merge(const std::vector<double> &values)
+    {
+        return this->s.merge(values);
+    }
 };
 
 template <class Stat>
@@ -153,6 +166,12 @@ class DistInfoProxy : public InfoProxy<Stat, DistInfo>
 {
   public:
     DistInfoProxy(Stat &stat) : InfoProxy<Stat, DistInfo>(stat) {}
+
+    bool
+    merge(const std::vector<double> &values)
+    {
+        return this->s.merge(values);
+    }
 };
 
 template <class Stat>
@@ -162,6 +181,12 @@ class VectorDistInfoProxy : public InfoProxy<Stat, VectorDistInfo>
     VectorDistInfoProxy(Stat &stat) : InfoProxy<Stat, VectorDistInfo>(stat) {}
 
     size_type size() const { return this->s.size(); }
+
+    bool
+    merge(const std::vector<double> &values)
+    {
+        return this->s.merge(values);
+    }
 };
 
 template <class Stat>
@@ -171,6 +196,12 @@ class Vector2dInfoProxy : public InfoProxy<Stat, Vector2dInfo>
     Vector2dInfoProxy(Stat &stat) : InfoProxy<Stat, Vector2dInfo>(stat) {}
 
     Result total() const { return this->s.total(); }
+
+    bool
+    merge(const std::vector<double> &values)
+    {
+        return this->s.merge(values);
+    }
 };
 
 struct StorageParams
@@ -542,6 +573,12 @@ class StatStor
      * @return true if zero value
      */
     bool zero() const { return data == Counter(); }
+
+    /**
+     * Add a value collected by another simulator.
+     * @return true, counts can always be merged.
+     */
+    bool merge(Counter val) { data += val; return true; }
 };
 
 /**
@@ -642,6 +679,11 @@ class AvgStor
         lastReset = curTick();
     }
 
+    /**
+     * Averages over time can't be merged, as the other simulator
+     * averaged over different ticks.
+     */
+    bool merge(Counter val) { return false; }
 };
 
 /**
@@ -763,6 +805,12 @@ class ScalarBase : public DataWrap<Derived, ScalarInfoProxy>
 
     void reset() { data()->reset(this->info()); }
     void prepare() { data()->prepare(this->info()); }
+
+    bool
+    merge(const std::vector<double> &values)
+    {
+        return values.size() == 1 && data()->merge(values[0]);
+    }
 };
 
 class ProxyInfo : public ScalarInfo
@@ -912,6 +960,12 @@ class ValueBase : public DataWrap<Derived, ScalarInfoProxy>
     bool check() const { return proxy != NULL; }
     void prepare() { }
     void reset() { }
+
+    /**
+     * Values are computed from the state of this simulator, so there is
+     * nothing to add.
+     */
+    bool merge(const std::vector<double> &values) { return true; }
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -1152,6 +1206,18 @@ class VectorBase : public DataWrapVec<Derived, VectorInfoProxy>
         return storage != NULL;
     }
 
+    bool
+    merge(const std::vector<double> &values)
+    {
+        if (values.size() != size())
+            return false;
+        for (off_type i = 0; i < size(); ++i) {
+            if (!data(i)->merge(values[i]))
+                return false;
+        }
+        return true;
+    }
+
   public:
     VectorBase(Group *parent, const char *name, const char *desc)
         : DataWrapVec<Derived, VectorInfoProxy>(parent, name, desc),
@@ -1400,6 +1466,18 @@ class Vector2dBase : public DataWrapVec2d<Derived, Vector2dInfoProxy>
     {
         return storage != NULL;
     }
+
+    bool
+    merge(const std::vector<double> &values)
+    {
+        if (values.size() != size())
+            return false;
+        for (off_type i = 0; i < size(); ++i) {
+            if (!data(i)->merge(values[i]))
+                return false;
+        }
+        return true;
+    }
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -1539,6 +1617,33 @@ class DistStor
         data.samples = samples;
     }
 
+    /**
+     * Add the samples that another simulator collected for the same
+     * distribution.
+     * @return false if the buckets differ.
+     */
+    bool
+    merge(const DistData &data)
+    {
+        if (data.min != min_track || data.max != max_track ||
+            data.bucket_size != bucket_size || data.cvec.size() != size())
+            return false;
+
+        if (data.samples != Counter()) {
+            min_val = std::min(min_val, data.min_val);
+            max_val = std::max(max_val, data.max_val);
+        }
+        underflow += data.underflow;
+        overflow += data.overflow;
+        for (off_type i = 0; i < size(); ++i)
+            cvec[i] += data.cvec[i];
+
+        sum += data.sum;
+        squares += data.squares;
+        samples += data.samples;
+        return true;
+    }
+
     /**
      * Reset stat value to default
      */
@@ -1689,6 +1794,29 @@ class HistStor
         data.samples = samples;
     }
 
+    /**
+     * Add the samples that another simulator collected for the same
+     * histogram.
+     * @return false if the buckets differ, e.g., because only one of
+     * the histograms grew.
+     */
+    bool
+    merge(const DistData &data)
+    {
+        if (data.min != min_bucket || data.bucket_size != bucket_size ||
+            data.cvec.size() != size())
+            return false;
+
+        for (off_type i = 0; i < size(); ++i)
+            cvec[i] += data.cvec[i];
+
+        sum += data.sum;
+        logs += data.logs;
+        squares += data.squares;
+        samples += data.samples;
+        return true;
+    }
+
     /**
      * Reset stat value to default
      */
@@ -1778,6 +1906,19 @@ class SampleStor
         data.samples = samples;
     }
 
+    /**
+     * Add the samples that another simulator collected.
+     * @return true, samples can always be merged.
+     */
+    bool
+    merge(const DistData &data)
+    {
+        sum += data.sum;
+        squares += data.squares;
+        samples += data.samples;
+        return true;
+    }
+
     /**
      * Reset stat value to default
      */
@@ -1853,6 +1994,12 @@ class AvgSampleStor
         data.samples = curTick();
     }
 
+    /**
+     * Averages over time can't be merged, as the other simulator
+     * averaged over different ticks.
+     */
+    bool merge(const DistData &data) { return false; }
+
     /**
      * Reset stat value to default
      */
@@ -1955,6 +2102,14 @@ class DistBase : public DataWrap<Derived, DistInfoProxy>
      */
     void add(DistBase &d) { data()->add(d.data()); }
 
+    bool
+    merge(const std::vector<double> &values)
+    {
+        DistData dist;
+        return Binary::decodeDist(values.data(), values.size(), dist) &&
+            data()->merge(dist);
+    }
+
 };
 
 template <class Stat>
@@ -2057,6 +2212,24 @@ class VectorDistBase : public DataWrapVec<Derived, VectorDistInfoProxy>
     {
         return storage != NULL;
     }
+
+    bool
+    merge(const std::vector<double> &values)
+    {
+        if (size() == 0 || values.size() % size() != 0)
+            return false;
+        const size_t step = values.size() / size();
+        std::vector<DistData> dists(size());
+        for (off_type i = 0; i < size(); ++i) {
+            if (!Binary::decodeDist(&values[i * step], step, dists[i]))
+                return false;
+        }
+        for (off_type i = 0; i < size(); ++i) {
+            if (!data(i)->merge(dists[i]))
+                return false;
+        }
+        return true;
+    }
 };
 
 template <class Stat>
@@ -3415,11 +3588,6 @@ std::list<Info *> &statsList();
 typedef std::map<const void *, Info *> MapType;
 MapType &statsMap();
 
-typedef std::map<std::string, Info *> NameMapType;
-NameMapType &nameMap();
-
-bool validateStatName(const std::string &name);
-
 } // namespace Stats
 
 void debugDumpStats();
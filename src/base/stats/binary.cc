@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/stats/binary.hh"
+
+#include <cstring>
+#include <ostream>
+
+#include "base/logging.hh"
+#include "base/output.hh"
+#include "base/stats/info.hh"
+
+namespace Stats {
+
+namespace {
+
+const char Magic[8] = { 'g', 'e', 'm', '5', 's', 't', 'a', 't' };
+const uint32_t Version = 1;
+
+const char SchemaTag = 'S';
+const char DumpTag = 'D';
+
+} // anonymous namespace
+
+Binary::Binary(std::ostream &stream, bool desc)
+    : stream(stream), descriptions(desc), depth(0), numEntries(0),
+      diverged(false)
+{
+    stream.write(Magic, sizeof(Magic));
+    stream.write(reinterpret_cast<const char *>(&Version), sizeof(Version));
+}
+
+void
+Binary::begin()
+{
+    depth = 0;
+    numEntries = 0;
+    diverged = false;
+    values.clear();
+}
+
+void
+Binary::end()
+{
+    // A dump that stops short of the last schema needs a new one too
+    if (!diverged && numEntries != schema.size()) {
+        diverged = true;
+        pending.assign(schema.begin(), schema.begin() + numEntries);
+        pendingOffsets.assign(schemaOffsets.begin(),
+                              schemaOffsets.begin() + numEntries);
+        pendingData.assign(schemaData, 0, numEntries < schema.size() ?
+                           schemaOffsets[numEntries] : schemaData.size());
+    }
+
+    if (diverged) {
+        schema.swap(pending);
+        schemaData.swap(pendingData);
+        schemaOffsets.swap(pendingOffsets);
+
+        const uint32_t count = schema.size();
+        stream.put(SchemaTag);
+        stream.write(reinterpret_cast<const char *>(&count), sizeof(count));
+        stream.write(schemaData.data(), schemaData.size());
+    }
+
+    const uint64_t count = values.size();
+    stream.put(DumpTag);
+    stream.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    stream.write(reinterpret_cast<const char *>(values.data()),
+                 values.size() * sizeof(double));
+    stream.flush();
+}
+
+bool
+Binary::valid() const
+{
+    return stream.good();
+}
+
+void
+Binary::beginGroup(const char *name)
+{
+    // Reuse the strings of earlier dumps to avoid allocations
+    if (depth == path.size())
+        path.emplace_back(name);
+    else
+        path[depth] = name;
+    ++depth;
+}
+
+void
+Binary::endGroup()
+{
+    assert(depth > 0);
+    --depth;
+}
+
+bool
+Binary::beginStat(const Info &info, Kind kind, size_t size)
+{
+    const Entry entry = { info.id, size };
+    const size_t index = numEntries++;
+    if (!diverged) {
+        if (index < schema.size() && schema[index] == entry)
+            return false;
+
+        // Keep the part of the last schema that still matches
+        diverged = true;
+        pending.assign(schema.begin(), schema.begin() + index);
+        pendingOffsets.assign(schemaOffsets.begin(),
+                              schemaOffsets.begin() + index);
+        pendingData.assign(schemaData, 0, index < schema.size() ?
+                           schemaOffsets[index] : schemaData.size());
+    }
+
+    std::string name;
+    for (size_t i = 0; i < depth; ++i) {
+        name += path[i];
+        name += '.';
+    }
+    name += info.name;
+
+    pending.push_back(entry);
+    pendingOffsets.push_back(pendingData.size());
+    putU8(kind);
+    putString(name);
+    putString(descriptions ? info.desc : "");
+    putU32(FlagsType(info.flags));
+    putU32(size);
+    return true;
+}
+
+void
+Binary::appendDist(const DistData &data)
+{
+    const double fields[DistFields] = {
+        data.min, data.max, data.bucket_size, data.samples, data.sum,
+        data.squares, data.logs, data.min_val, data.max_val,
+        data.underflow, data.overflow,
+    };
+    values.insert(values.end(), fields, fields + DistFields);
+    values.insert(values.end(), data.cvec.begin(), data.cvec.end());
+}
+
+bool
+Binary::decodeDist(const double *values, size_t size, DistData &data)
+{
+    if (size < DistFields)
+        return false;
+
+    data.min = values[0];
+    data.max = values[1];
+    data.bucket_size = values[2];
+    data.samples = values[3];
+    data.sum = values[4];
+    data.squares = values[5];
+    data.logs = values[6];
+    data.min_val = values[7];
+    data.max_val = values[8];
+    data.underflow = values[9];
+    data.overflow = values[10];
+    data.cvec.assign(values + DistFields, values + size);
+    return true;
+}
+
+void
+Binary::putU8(uint8_t value)
+{
+    pendingData.push_back(value);
+}
+
+void
+Binary::putU32(uint32_t value)
+{
+    pendingData.append(reinterpret_cast<const char *>(&value),
+                       sizeof(value));
+}
+
+void
+Binary::putString(const std::string &value)
+{
+    putU32(value.size());
+    pendingData.append(value);
+}
+
+void
+Binary::putStrings(const std::vector<std::string> &values)
+{
+    putU32(values.size());
+    for (const auto &value : values)
+        putString(value);
+}
+
+void
+Binary::visit(const ScalarInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    beginStat(info, KindScalar, 1);
+    values.push_back(info.result());
+}
+
+void
+Binary::visit(const VectorInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    const VResult &vr = info.result();
+    if (beginStat(info, KindVector, vr.size()))
+        putStrings(info.subnames);
+    values.insert(values.end(), vr.begin(), vr.end());
+}
+
+void
+Binary::visit(const DistInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    const DistData &data = info.data;
+    if (beginStat(info, KindDist, DistFields + data.cvec.size())) {
+        putU8(data.type);
+        putU32(data.cvec.size());
+    }
+    appendDist(data);
+}
+
+void
+Binary::visit(const VectorDistInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    const size_type size = info.size();
+    const size_t buckets = size ? info.data[0].cvec.size() : 0;
+    for (size_type i = 0; i < size; ++i) {
+        panic_if(info.data[i].cvec.size() != buckets,
+                 "Distributions of %s differ in size\n", info.name);
+    }
+
+    if (beginStat(info, KindVectorDist, size * (DistFields + buckets))) {
+        putU32(size);
+        putU8(size ? info.data[0].type : Deviation);
+        putU32(buckets);
+        putStrings(info.subnames);
+    }
+    for (size_type i = 0; i < size; ++i)
+        appendDist(info.data[i]);
+}
+
+void
+Binary::visit(const Vector2dInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    if (beginStat(info, KindVector2d, info.cvec.size())) {
+        putU32(info.x);
+        putU32(info.y);
+        putStrings(info.subnames);
+        putStrings(info.y_subnames);
+    }
+    values.insert(values.end(), info.cvec.begin(), info.cvec.end());
+}
+
+void
+Binary::visit(const FormulaInfo &info)
+{
+    if (!info.flags.isSet(display))
+        return;
+
+    const VResult &vr = info.result();
+    if (beginStat(info, KindFormula, vr.size())) {
+        putStrings(info.subnames);
+        putString(info.str());
+    }
+    values.insert(values.end(), vr.begin(), vr.end());
+}
+
+void
+Binary::visit(const SparseHistInfo &info)
+{
+    warn_once("Binary stat files don't support sparse histograms.\n");
+}
+
+std::unique_ptr<Output>
+initBinary(const std::string &filename, bool desc)
+{
+    OutputStream *os = simout.create(filename, true);
+    if (!os->stream()->good())
+        fatal("Unable to open statistics file '%s' for writing\n", filename);
+
+    return std::unique_ptr<Output>(new Binary(*os->stream(), desc));
+}
+
+} // namespace Stats
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * A compact binary stats format for frequent dumps.
+ *
+ * The file starts with a magic string and a version, followed by
+ * blocks that each start with a one byte tag:
+ *
+ *  - 'S' (schema): the name, kind and metadata of every stat and the
+ *    number of values it contributes to a dump. A schema is written
+ *    before the first dump and again whenever the set of stats that is
+ *    dumped changes, e.g., when dumping a subtree.
+ *  - 'D' (dump): a count followed by the values of all stats in the
+ *    order of the last schema, as doubles.
+ *
+ * All integers and doubles are in host byte order, strings are a
+ * 32-bit length followed by the characters. A dump is therefore a
+ * single write of a flat array, with no formatting at all. The
+ * m5.stats.binary Python module reads these files.
+ */
+
+#ifndef __BASE_STATS_BINARY_HH__
+#define __BASE_STATS_BINARY_HH__
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/stats/output.hh"
+#include "base/stats/types.hh"
+
+namespace Stats {
+
+struct DistData;
+
+class Binary : public Output
+{
+  public:
+    /** Kinds of stats in a schema. */
+    enum Kind : uint8_t {
+        KindScalar,
+        KindVector,
+        KindDist,
+        KindVectorDist,
+        KindVector2d,
+        KindFormula,
+    };
+
+    /**
+     * Number of values a distribution contributes to a dump in
+     * addition to its buckets: min, max, bucket_size, samples, sum,
+     * squares, logs, min_val, max_val, underflow and overflow.
+     */
+    static const unsigned DistFields = 11;
+
+    Binary(std::ostream &stream, bool desc);
+
+    /**
+     * Decode the values that a dump holds for a distribution.
+     *
+     * @param values First value of the distribution.
+     * @param size Number of values, DistFields plus the buckets.
+     * @param data Distribution to fill in; its type is not set.
+     * @return false if there are fewer than DistFields values.
+     */
+    static bool decodeDist(const double *values, size_t size,
+                           DistData &data);
+
+    Binary() = delete;
+    Binary(const Binary &other) = delete;
+
+  public: // Output interface
+    void begin() override;
+    void end() override;
+    bool valid() const override;
+
+    void beginGroup(const char *name) override;
+    void endGroup() override;
+
+    void visit(const ScalarInfo &info) override;
+    void visit(const VectorInfo &info) override;
+    void visit(const DistInfo &info) override;
+    void visit(const VectorDistInfo &info) override;
+    void visit(const Vector2dInfo &info) override;
+    void visit(const FormulaInfo &info) override;
+    void visit(const SparseHistInfo &info) override;
+
+  protected:
+    /** What the schema records to tell a stat in a dump apart. */
+    struct Entry
+    {
+        int id;
+        size_t size;
+
+        bool
+        operator==(const Entry &other) const
+        {
+            return id == other.id && size == other.size;
+        }
+    };
+
+    /**
+     * Start a stat in the current dump.
+     *
+     * @return Whether the stat needs to be described in a new schema,
+     *         in which case the caller appends its metadata to the
+     *         schema after the common fields that are already there.
+     */
+    bool beginStat(const Info &info, Kind kind, size_t size);
+
+    /** Append the values of a distribution to the current dump. */
+    void appendDist(const DistData &data);
+
+    /** Helpers appending metadata to the pending schema. */
+    void putU8(uint8_t value);
+    void putU32(uint32_t value);
+    void putString(const std::string &value);
+    void putStrings(const std::vector<std::string> &values);
+
+    std::ostream &stream;
+    const bool descriptions;
+
+    /** Names of the groups being visited. */
+    std::vector<std::string> path;
+    size_t depth;
+
+    /** Schema of the last dump, encoded, and where each entry starts. */
+    std::vector<Entry> schema;
+    std::string schemaData;
+    std::vector<size_t> schemaOffsets;
+
+    /**
+     * The dump being built. As long as it matches the last schema
+     * only the values are recorded; from the first mismatch on, the
+     * pending schema holds a new one.
+     */
+    size_t numEntries;
+    bool diverged;
+    std::vector<Entry> pending;
+    std::string pendingData;
+    std::vector<size_t> pendingOffsets;
+    std::vector<double> values;
+};
+
+std::unique_ptr<Output> initBinary(const std::string &filename, bool desc);
+
+} // namespace Stats
+
+#endif // __BASE_STATS_BINARY_HH__
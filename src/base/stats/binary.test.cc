@@ -0,0 +1,489 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "base/stats/binary.hh"
+#include "base/stats/info.hh"
+
+using Stats::Binary;
+using Stats::DistData;
+using Stats::DistInfo;
+using Stats::FlagsType;
+using Stats::FormulaInfo;
+using Stats::Info;
+using Stats::Output;
+using Stats::Result;
+using Stats::ScalarInfo;
+using Stats::VCounter;
+using Stats::VResult;
+using Stats::Vector2dInfo;
+using Stats::VectorDistInfo;
+using Stats::VectorInfo;
+using Stats::size_type;
+
+namespace {
+
+/** Minimal stat infos with fixed values, dumped if displayed. */
+template <class Base>
+class TestInfo : public Base
+{
+  public:
+    TestInfo(const std::string &name, const std::string &desc,
+             bool display = true)
+    {
+        this->name = name;
+        this->desc = desc;
+        this->flags.set(Stats::init);
+        if (display)
+            this->flags.set(Stats::display);
+    }
+
+    bool check() const override { return true; }
+    void prepare() override {}
+    void reset() override {}
+    bool zero() const override { return false; }
+    void visit(Output &visitor) override
+    {
+        visitor.visit(static_cast<Base &>(*this));
+    }
+};
+
+class TestScalar : public TestInfo<ScalarInfo>
+{
+  public:
+    using TestInfo<ScalarInfo>::TestInfo;
+
+    Stats::Counter val = 0;
+
+    Stats::Counter value() const override { return val; }
+    Result result() const override { return val; }
+    Result total() const override { return val; }
+};
+
+template <class Base>
+class TestVectorBase : public TestInfo<Base>
+{
+  public:
+    using TestInfo<Base>::TestInfo;
+
+    VCounter vec;
+    mutable VResult rvec;
+
+    size_type size() const override { return vec.size(); }
+    const VCounter &value() const override { return vec; }
+
+    const VResult &
+    result() const override
+    {
+        rvec.assign(vec.begin(), vec.end());
+        return rvec;
+    }
+
+    Result
+    total() const override
+    {
+        Result sum = 0;
+        for (auto v : vec)
+            sum += v;
+        return sum;
+    }
+};
+
+typedef TestVectorBase<VectorInfo> TestVector;
+
+class TestFormula : public TestVectorBase<FormulaInfo>
+{
+  public:
+    using TestVectorBase<FormulaInfo>::TestVectorBase;
+
+    std::string str() const override { return "a / b"; }
+};
+
+typedef TestInfo<DistInfo> TestDist;
+
+class TestVectorDist : public TestInfo<VectorDistInfo>
+{
+  public:
+    using TestInfo<VectorDistInfo>::TestInfo;
+
+    size_type size() const override { return data.size(); }
+};
+
+class TestVector2d : public TestInfo<Vector2dInfo>
+{
+  public:
+    using TestInfo<Vector2dInfo>::TestInfo;
+
+    Result total() const override { return 0; }
+};
+
+DistData
+makeDist(Stats::Counter base, size_t buckets)
+{
+    DistData data;
+    data.type = Stats::Dist;
+    data.min = 0;
+    data.max = buckets - 1;
+    data.bucket_size = 1;
+    data.min_val = base;
+    data.max_val = base + 1;
+    data.underflow = 0;
+    data.overflow = 1;
+    data.sum = base * 2;
+    data.squares = base * base;
+    data.logs = 0;
+    data.samples = 2;
+    for (size_t i = 0; i < buckets; ++i)
+        data.cvec.push_back(base + i);
+    return data;
+}
+
+/** Decodes the output of the writer. */
+class Reader
+{
+  public:
+    explicit Reader(const std::string &data) : data(data), pos(0) {}
+
+    bool done() const { return pos == data.size(); }
+
+    template <typename T>
+    T
+    get()
+    {
+        T value;
+        EXPECT_LE(pos + sizeof(value), data.size());
+        if (pos + sizeof(value) > data.size())
+            return T();
+        std::memcpy(&value, data.data() + pos, sizeof(value));
+        pos += sizeof(value);
+        return value;
+    }
+
+    std::string
+    string()
+    {
+        const uint32_t length = get<uint32_t>();
+        EXPECT_LE(pos + length, data.size());
+        std::string value = data.substr(pos, length);
+        pos += value.size();
+        return value;
+    }
+
+    std::vector<std::string>
+    strings()
+    {
+        std::vector<std::string> values(get<uint32_t>());
+        for (auto &value : values)
+            value = string();
+        return values;
+    }
+
+    std::vector<double>
+    doubles()
+    {
+        std::vector<double> values(get<uint64_t>());
+        for (auto &value : values)
+            value = get<double>();
+        return values;
+    }
+
+    void
+    header()
+    {
+        ASSERT_EQ(data.compare(0, 8, "gem5stat"), 0);
+        pos = 8;
+        EXPECT_EQ(get<uint32_t>(), 1);
+    }
+
+    /** Decoded common fields of a schema entry. */
+    struct Entry
+    {
+        uint8_t kind;
+        std::string name;
+        std::string desc;
+        uint32_t flags;
+        uint32_t size;
+    };
+
+    Entry
+    entry()
+    {
+        Entry e;
+        e.kind = get<uint8_t>();
+        e.name = string();
+        e.desc = string();
+        e.flags = get<uint32_t>();
+        e.size = get<uint32_t>();
+        return e;
+    }
+
+  private:
+    const std::string data;
+    size_t pos;
+};
+
+class BinaryStatsTest : public ::testing::Test
+{
+  protected:
+    BinaryStatsTest()
+        : scalar("scalar", "A scalar"), hidden("hidden", "Not dumped", false),
+          vector("vector", "A vector"), formula("formula", "A formula"),
+          dist("dist", "A distribution"), vdist("vdist", "Distributions"),
+          vector2d("vector2d", "A 2d vector")
+    {
+        scalar.val = 3;
+        hidden.val = 5;
+        vector.vec = { 1, 2 };
+        vector.subnames = { "x", "y" };
+        formula.vec = { 0.5 };
+        dist.data = makeDist(10, 2);
+        vdist.data = { makeDist(20, 1), makeDist(30, 1) };
+        vdist.subnames = { "p", "q" };
+        vector2d.x = 2;
+        vector2d.y = 2;
+        vector2d.cvec = { 1, 2, 3, 4 };
+        vector2d.subnames = { "r0", "r1" };
+        vector2d.y_subnames = { "c0", "c1" };
+    }
+
+    /** Dump the stats in infos as if they were in group system. */
+    void
+    dump(Output &out, const std::vector<Info *> &infos)
+    {
+        out.begin();
+        out.beginGroup("system");
+        for (auto info : infos) {
+            info->prepare();
+            info->visit(out);
+        }
+        out.endGroup();
+        out.end();
+    }
+
+    std::vector<Info *>
+    all()
+    {
+        return { &scalar, &hidden, &vector, &formula, &dist, &vdist,
+                 &vector2d };
+    }
+
+    TestScalar scalar;
+    TestScalar hidden;
+    TestVector vector;
+    TestFormula formula;
+    TestDist dist;
+    TestVectorDist vdist;
+    TestVector2d vector2d;
+};
+
+} // anonymous namespace
+
+TEST_F(BinaryStatsTest, RoundTrip)
+{
+    std::ostringstream os;
+    Binary out(os, true);
+    dump(out, all());
+    EXPECT_TRUE(out.valid());
+
+    Reader in(os.str());
+    in.header();
+
+    ASSERT_EQ(in.get<char>(), 'S');
+    ASSERT_EQ(in.get<uint32_t>(), 6);
+
+    auto e = in.entry();
+    EXPECT_EQ(e.kind, Binary::KindScalar);
+    EXPECT_EQ(e.name, "system.scalar");
+    EXPECT_EQ(e.desc, "A scalar");
+    EXPECT_EQ(e.flags, FlagsType(Stats::init | Stats::display));
+    EXPECT_EQ(e.size, 1);
+
+    e = in.entry();
+    EXPECT_EQ(e.kind, Binary::KindVector);
+    EXPECT_EQ(e.name, "system.vector");
+    EXPECT_EQ(e.size, 2);
+    EXPECT_EQ(in.strings(), vector.subnames);
+
+    e = in.entry();
+    EXPECT_EQ(e.kind, Binary::KindFormula);
+    EXPECT_EQ(e.name, "system.formula");
+    EXPECT_EQ(e.size, 1);
+    EXPECT_EQ(in.strings().size(), 0);
+    EXPECT_EQ(in.string(), "a / b");
+
+    e = in.entry();
+    EXPECT_EQ(e.kind, Binary::KindDist);
+    EXPECT_EQ(e.name, "system.dist");
+    EXPECT_EQ(e.size, Binary::DistFields + 2);
+    EXPECT_EQ(in.get<uint8_t>(), Stats::Dist);
+    EXPECT_EQ(in.get<uint32_t>(), 2);
+
+    e = in.entry();
+    EXPECT_EQ(e.kind, Binary::KindVectorDist);
+    EXPECT_EQ(e.name, "system.vdist");
+    EXPECT_EQ(e.size, 2 * (Binary::DistFields + 1));
+    EXPECT_EQ(in.get<uint32_t>(), 2);
+    EXPECT_EQ(in.get<uint8_t>(), Stats::Dist);
+    EXPECT_EQ(in.get<uint32_t>(), 1);
+    EXPECT_EQ(in.strings(), vdist.subnames);
+
+    e = in.entry();
+    EXPECT_EQ(e.kind, Binary::KindVector2d);
+    EXPECT_EQ(e.name, "system.vector2d");
+    EXPECT_EQ(e.size, 4);
+    EXPECT_EQ(in.get<uint32_t>(), 2);
+    EXPECT_EQ(in.get<uint32_t>(), 2);
+    EXPECT_EQ(in.strings(), vector2d.subnames);
+    EXPECT_EQ(in.strings(), vector2d.y_subnames);
+
+    ASSERT_EQ(in.get<char>(), 'D');
+    const std::vector<double> expected = {
+        // scalar, vector and formula
+        3, 1, 2, 0.5,
+        // dist
+        0, 1, 1, 2, 20, 100, 0, 10, 11, 0, 1, 10, 11,
+        // vdist
+        0, 0, 1, 2, 40, 400, 0, 20, 21, 0, 1, 20,
+        0, 0, 1, 2, 60, 900, 0, 30, 31, 0, 1, 30,
+        // vector2d
+        1, 2, 3, 4,
+    };
+    EXPECT_EQ(in.doubles(), expected);
+    EXPECT_TRUE(in.done());
+}
+
+TEST_F(BinaryStatsTest, NoDescriptions)
+{
+    std::ostringstream os;
+    Binary out(os, false);
+    dump(out, { &scalar });
+
+    Reader in(os.str());
+    in.header();
+    ASSERT_EQ(in.get<char>(), 'S');
+    ASSERT_EQ(in.get<uint32_t>(), 1);
+    auto e = in.entry();
+    EXPECT_EQ(e.name, "system.scalar");
+    EXPECT_EQ(e.desc, "");
+}
+
+TEST_F(BinaryStatsTest, SchemaOnlyWhenStatsChange)
+{
+    std::ostringstream os;
+    Binary out(os, true);
+    dump(out, { &scalar, &vector });
+    const size_t first = os.str().size();
+
+    // The same stats only need their values
+    scalar.val = 4;
+    dump(out, { &scalar, &vector });
+    const std::string second = os.str().substr(first);
+    Reader in2(second);
+    ASSERT_EQ(in2.get<char>(), 'D');
+    EXPECT_EQ(in2.doubles(), std::vector<double>({ 4, 1, 2 }));
+    EXPECT_TRUE(in2.done());
+
+    // A vector that grows changes the schema
+    vector.vec.push_back(3);
+    vector.subnames.push_back("z");
+    dump(out, { &scalar, &vector });
+    const size_t third = first + second.size();
+    Reader in3(os.str().substr(third));
+    ASSERT_EQ(in3.get<char>(), 'S');
+    ASSERT_EQ(in3.get<uint32_t>(), 2);
+    EXPECT_EQ(in3.entry().name, "system.scalar");
+    auto e = in3.entry();
+    EXPECT_EQ(e.name, "system.vector");
+    EXPECT_EQ(e.size, 3);
+    EXPECT_EQ(in3.strings(), vector.subnames);
+    ASSERT_EQ(in3.get<char>(), 'D');
+    EXPECT_EQ(in3.doubles(), std::vector<double>({ 4, 1, 2, 3 }));
+    EXPECT_TRUE(in3.done());
+}
+
+TEST_F(BinaryStatsTest, SubsetDump)
+{
+    std::ostringstream os;
+    Binary out(os, true);
+    dump(out, { &scalar, &vector });
+    const size_t first = os.str().size();
+
+    // Dumping fewer stats keeps the matching prefix of the schema
+    dump(out, { &scalar });
+    Reader in(os.str().substr(first));
+    ASSERT_EQ(in.get<char>(), 'S');
+    ASSERT_EQ(in.get<uint32_t>(), 1);
+    auto e = in.entry();
+    EXPECT_EQ(e.name, "system.scalar");
+    EXPECT_EQ(e.desc, "A scalar");
+    ASSERT_EQ(in.get<char>(), 'D');
+    EXPECT_EQ(in.doubles(), std::vector<double>({ 3 }));
+    EXPECT_TRUE(in.done());
+}
+
+TEST_F(BinaryStatsTest, DecodeDist)
+{
+    std::ostringstream os;
+    Binary out(os, false);
+    dump(out, { &dist });
+
+    Reader in(os.str());
+    in.header();
+    ASSERT_EQ(in.get<char>(), 'S');
+    ASSERT_EQ(in.get<uint32_t>(), 1);
+    in.entry();
+    in.get<uint8_t>();
+    in.get<uint32_t>();
+    ASSERT_EQ(in.get<char>(), 'D');
+    const std::vector<double> values = in.doubles();
+
+    DistData data;
+    ASSERT_TRUE(Binary::decodeDist(values.data(), values.size(), data));
+    EXPECT_EQ(data.min, dist.data.min);
+    EXPECT_EQ(data.max, dist.data.max);
+    EXPECT_EQ(data.bucket_size, dist.data.bucket_size);
+    EXPECT_EQ(data.samples, dist.data.samples);
+    EXPECT_EQ(data.sum, dist.data.sum);
+    EXPECT_EQ(data.squares, dist.data.squares);
+    EXPECT_EQ(data.logs, dist.data.logs);
+    EXPECT_EQ(data.min_val, dist.data.min_val);
+    EXPECT_EQ(data.max_val, dist.data.max_val);
+    EXPECT_EQ(data.underflow, dist.data.underflow);
+    EXPECT_EQ(data.overflow, dist.data.overflow);
+    EXPECT_EQ(data.cvec, dist.data.cvec);
+
+    EXPECT_FALSE(Binary::decodeDist(values.data(), Binary::DistFields - 1,
+                                    data));
+}
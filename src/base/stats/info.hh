@@ -29,6 +29,10 @@
 #ifndef __BASE_STATS_INFO_HH__
 #define __BASE_STATS_INFO_HH__
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "base/stats/types.hh"
 #include "base/flags.hh"
 
@@ -134,6 +138,15 @@ class Info
      */
     virtual void visit(Output &visitor) = 0;
 
+    /**
+     * Add values that another simulator, e.g., a forked child,
+     * collected for the same stat. The values are laid out as in a
+     * Binary dump.
+     * @return false if the stat can't merge the values, e.g., because
+     * it averages over time or is computed from other stats.
+     */
+    virtual bool merge(const std::vector<double> &values) { return false; }
+
     /**
      * Checks if the first stat's name is alphabetically less than the second.
      * This function breaks names up at periods and considers each subname
@@ -255,6 +268,11 @@ class SparseHistInfo : public Info
     SparseHistData data;
 };
 
+typedef std::map<std::string, Info *> NameMapType;
+NameMapType &nameMap();
+
+bool validateStatName(const std::string &name);
+
 } // namespace Stats
 
 #endif // __BASE_STATS_INFO_HH__
@@ -88,6 +88,13 @@ setDebugLogger(Logger *logger)
         debug_logger = logger;
 }
 
+void
+flush()
+{
+    if (debug_logger)
+        debug_logger->flush();
+}
+
 void
 enable()
 {
@@ -168,4 +175,55 @@ OstreamLogger::logMessage(Tick when, const std::string &name,
     }
 }
 
+BinaryLogger::BinaryLogger(std::ostream &stream)
+    : writer(stream), lineBuffer(*this), lineStream(&lineBuffer)
+{
+    recorder = &writer;
+    registerExitCallback([this]() { flush(); });
+}
+
+BinaryLogger::~BinaryLogger()
+{
+    lineBuffer.flushLine();
+}
+
+void
+BinaryLogger::logMessage(Tick when, const std::string &name,
+        const std::string &flag, const std::string &message)
+{
+    if (!name.empty() && ignore.match(name))
+        return;
+
+    writer.message(when, name, flag, message);
+}
+
+void
+BinaryLogger::flush()
+{
+    lineBuffer.flushLine();
+    writer.flush();
+}
+
+int
+BinaryLogger::LineBuffer::overflow(int c)
+{
+    if (c == traits_type::eof())
+        return traits_type::not_eof(c);
+
+    line.push_back(traits_type::to_char_type(c));
+    if (c == '\n')
+        flushLine();
+    return c;
+}
+
+void
+BinaryLogger::LineBuffer::flushLine()
+{
+    if (line.empty())
+        return;
+
+    logger.writer.message(MaxTick, std::string(), std::string(), line);
+    line.clear();
+}
+
 } // namespace Trace
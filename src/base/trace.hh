@@ -32,11 +32,14 @@
 #ifndef __BASE_TRACE_HH__
 #define __BASE_TRACE_HH__
 
+#include <ostream>
+#include <streambuf>
 #include <string>
 
 #include "base/cprintf.hh"
 #include "base/debug.hh"
 #include "base/match.hh"
+#include "base/trace_record.hh"
 #include "base/types.hh"
 #include "sim/core.hh"
 
@@ -50,6 +53,13 @@ class Logger
     /** Name match for objects to ignore */
     ObjectMatch ignore;
 
+    /**
+     * Binary record writer of a logger that stores messages unformatted.
+     * Messages are passed to it directly, since formatting would cost
+     * more than writing the record.
+     */
+    RecordWriter *recorder = nullptr;
+
   public:
     /** Log a single message */
     template <typename ...Args>
@@ -67,6 +77,10 @@ class Logger
     {
         if (!name.empty() && ignore.match(name))
             return;
+        if (recorder) {
+            recorder->message(when, name, flag, fmt, args...);
+            return;
+        }
         std::ostringstream line;
         ccprintf(line, fmt, args...);
         logMessage(when, name, flag, line.str());
@@ -93,6 +107,9 @@ class Logger
     /** Add objects to ignore */
     void addIgnore(const ObjectMatch &ignore_) { ignore.add(ignore_); }
 
+    /** Write out any output that is still buffered */
+    virtual void flush() { getOstream().flush(); }
+
     virtual ~Logger() { }
 };
 
@@ -113,6 +130,48 @@ class OstreamLogger : public Logger
     std::ostream &getOstream() override { return stream; }
 };
 
+/**
+ * Logger that writes binary trace records (see base/trace_record.hh)
+ * rather than text. Messages are decoded offline with
+ * util/decode_debug_trace.py.
+ */
+class BinaryLogger : public Logger
+{
+  protected:
+    RecordWriter writer;
+
+    /** Turns text written to getOstream() into formatted records */
+    class LineBuffer : public std::streambuf
+    {
+      protected:
+        BinaryLogger &logger;
+        std::string line;
+
+        int overflow(int c) override;
+
+      public:
+        LineBuffer(BinaryLogger &logger) : logger(logger) { }
+
+        /** Record a partial last line, if any */
+        void flushLine();
+    };
+
+    LineBuffer lineBuffer;
+    std::ostream lineStream;
+
+  public:
+    BinaryLogger(std::ostream &stream);
+    ~BinaryLogger();
+
+    void logMessage(Tick when, const std::string &name,
+            const std::string &flag, const std::string &message) override;
+
+    std::ostream &getOstream() override { return lineStream; }
+
+    /** Write out all buffered records */
+    void flush() override;
+};
+
 /** Get the current global debug logger.  This takes ownership of the given
  *  logger which should be allocated using 'new' */
 Logger *getDebugLogger();
@@ -123,6 +182,12 @@ std::ostream &output();
 /** Delete the current global logger and assign a new one */
 void setDebugLogger(Logger *logger);
 
+/**
+ * Write out the buffered output of the current global logger, if any,
+ * e.g., before the simulator aborts or forks.
+ */
+void flush();
+
 /** Enable/disable debug logging */
 void enable();
 void disable();
@@ -162,9 +227,14 @@ class Named
  * be a function or functor called name() that returns a const
  * std::string & in the current scope.
  *
+ * A flag can also be enabled for some objects only (--debug-flags
+ * Flag@objects), in which case name() selects the objects that print.
+ * DPRINTFR has no object and prints if the flag is on for any object.
+ *
  * If you desire that the automatic printing not occur, use DPRINTFR
  * (R for raw)
  *
+ * \def DTRACE_OBJECT(x)
  * \def DDUMP(x, data, count)
  * \def DPRINTF(x, ...)
  * \def DPRINTFS(x, s, ...)
@@ -180,16 +250,19 @@ class Named
 
 #if TRACING_ON
 
+// Check a flag for the object in the current scope
+#define DTRACE_OBJECT(x) (DTRACE(x) && Debug::x.tracing(name()))
+
 #define DDUMP(x, data, count) do {               \
     using namespace Debug;                       \
-    if (DTRACE(x))                               \
+    if (DTRACE_OBJECT(x))                        \
         Trace::getDebugLogger()->dump(           \
             curTick(), name(), data, count, #x); \
 } while (0)
 
 #define DPRINTF(x, ...) do {                     \
     using namespace Debug;                       \
-    if (DTRACE(x)) {                             \
+    if (DTRACE_OBJECT(x)) {                      \
         Trace::getDebugLogger()->dprintf_flag(   \
             curTick(), name(), #x, __VA_ARGS__); \
     }                                            \
@@ -197,7 +270,7 @@ class Named
 
 #define DPRINTFS(x, s, ...) do {                        \
     using namespace Debug;                              \
-    if (DTRACE(x)) {                                    \
+    if (DTRACE(x) && Debug::x.tracing(s->name())) {     \
         Trace::getDebugLogger()->dprintf_flag(          \
                 curTick(), s->name(), #x, __VA_ARGS__); \
     }                                                   \
@@ -230,6 +303,7 @@ class Named
 
 #else // !TRACING_ON
 
+#define DTRACE_OBJECT(x) (false)
 #define DDUMP(x, data, count) do {} while (0)
 #define DPRINTF(x, ...) do {} while (0)
 #define DPRINTFS(x, ...) do {} while (0)
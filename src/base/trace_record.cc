@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/trace_record.hh"
+
+namespace Trace {
+
+const uint32_t RecordWriter::Version;
+
+RecordWriter::RecordWriter(std::ostream &stream)
+    : stream(stream), buffer(BufferSize), used(0), cache(CacheSize)
+{
+    static const char magic[8] = { 'g', 'e', 'm', '5', 'd', 'b', 'g', 0 };
+    write(magic, sizeof(magic));
+    reserve(sizeof(Version));
+    put(Version);
+}
+
+RecordWriter::~RecordWriter()
+{
+    flush();
+}
+
+uint32_t
+RecordWriter::lookup(const char *str, size_t len, CacheEntry &entry)
+{
+    auto ins = ids.emplace(std::string(str, len), ids.size());
+    const std::string &key = ins.first->first;
+    const uint32_t id = ins.first->second;
+
+    if (ins.second) {
+        reserve(sizeof(char) + 2 * sizeof(uint32_t));
+        put('S');
+        put(id);
+        put<uint32_t>(len);
+        write(str, len);
+    }
+
+    entry.ptr = str;
+    entry.str = &key;
+    entry.id = id;
+    return id;
+}
+
+void
+RecordWriter::write(const char *data, size_t len)
+{
+    if (len > buffer.size() - used) {
+        flush();
+        if (len > buffer.size()) {
+            stream.write(data, len);
+            return;
+        }
+    }
+    std::memcpy(&buffer[used], data, len);
+    used += len;
+}
+
+void
+RecordWriter::message(Tick when, const std::string &name,
+                      const std::string &flag, const std::string &text)
+{
+    const uint32_t name_id = intern(name.data(), name.size());
+    const uint32_t flag_id = intern(flag.data(), flag.size());
+
+    reserve(sizeof(char) + sizeof(uint64_t) + 3 * sizeof(uint32_t));
+    put('L');
+    put<uint64_t>(when);
+    put(name_id);
+    put(flag_id);
+    put<uint32_t>(text.size());
+    write(text.data(), text.size());
+}
+
+void
+RecordWriter::flush()
+{
+    stream.write(buffer.data(), used);
+    stream.flush();
+    used = 0;
+}
+
+} // namespace Trace
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * Binary records for debug tracing. Instead of formatting a DPRINTF when
+ * it fires, RecordWriter stores the ids of its format string, object name
+ * and flag together with the raw arguments. util/decode_debug_trace.py
+ * turns a record file back into the usual text.
+ *
+ * A record file starts with the magic "gem5dbg\0" and a 32-bit version.
+ * It is followed by records, each starting with a type byte. All
+ * integers are in host (little endian) byte order.
+ *
+ * 'S' id:u32 len:u32 bytes[len]
+ *     Defines string id. Every format, name and flag is defined once,
+ *     before its first use.
+ * 'M' tick:u64 name:u32 flag:u32 format:u32 nargs:u8 args[nargs]
+ *     A message whose arguments are stored raw. Each argument is a type
+ *     byte followed by its value:
+ *       'i'/'u' size:u8 value[size]   signed/unsigned integer
+ *       'b' value:u8                  bool
+ *       'c'/'C' value:u8              signed/unsigned char
+ *       'f' value:f64                 float or double
+ *       's' len:u32 bytes[len]        string
+ * 'L' tick:u64 name:u32 flag:u32 len:u32 bytes[len]
+ *     A message that was formatted when it was logged. This is used for
+ *     arguments without a raw encoding (objects with operator<<, enums,
+ *     pointers), for Logger::dump and for the logger's ostream.
+ */
+
+#ifndef __BASE_TRACE_RECORD_HH__
+#define __BASE_TRACE_RECORD_HH__
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "base/cprintf.hh"
+#include "base/types.hh"
+
+namespace Trace {
+
+/** Arguments that can be stored raw and formatted by the decoder. */
+template <typename T>
+struct RawArg
+{
+    static const bool value =
+        (std::is_arithmetic<T>::value && sizeof(T) <= sizeof(uint64_t) &&
+         !std::is_same<T, long double>::value &&
+         !std::is_same<T, wchar_t>::value &&
+         !std::is_same<T, char16_t>::value &&
+         !std::is_same<T, char32_t>::value) ||
+        std::is_same<typename std::decay<T>::type, const char *>::value ||
+        std::is_same<typename std::decay<T>::type, char *>::value ||
+        std::is_same<T, std::string>::value;
+};
+
+template <typename ...Args>
+struct RawArgs : std::true_type {};
+
+template <typename T, typename ...Args>
+struct RawArgs<T, Args...>
+    : std::integral_constant<bool, RawArg<T>::value &&
+                                   RawArgs<Args...>::value> {};
+
+class RecordWriter
+{
+  public:
+    static const uint32_t Version = 1;
+
+  private:
+    /** Output buffer size */
+    static const size_t BufferSize = 1 << 20;
+    /** Number of entries in the string id cache */
+    static const size_t CacheSize = 1 << 10;
+
+    struct CacheEntry
+    {
+        const char *ptr = nullptr;
+        const std::string *str = nullptr;
+        uint32_t id = 0;
+    };
+
+    std::ostream &stream;
+    std::vector<char> buffer;
+    size_t used;
+
+    /**
+     * Strings are cached by address, which almost always hits for the
+     * string literals used as formats and the names of SimObjects. The
+     * contents are compared as well, since the same address can hold
+     * different strings over time.
+     */
+    std::vector<CacheEntry> cache;
+    std::unordered_map<std::string, uint32_t> ids;
+
+    /** Look up, and if needed define, a string missing from the cache */
+    uint32_t lookup(const char *str, size_t len, CacheEntry &entry);
+
+    uint32_t
+    intern(const char *str, size_t len)
+    {
+        const uintptr_t addr = reinterpret_cast<uintptr_t>(str);
+        CacheEntry &entry = cache[(addr ^ (addr >> 10)) & (CacheSize - 1)];
+        if (entry.ptr == str && entry.str->size() == len &&
+            std::memcmp(str, entry.str->data(), len) == 0) {
+            return entry.id;
+        }
+        return lookup(str, len, entry);
+    }
+
+    /** Make room for at least bytes in the buffer */
+    void
+    reserve(size_t bytes)
+    {
+        if (used + bytes > buffer.size())
+            flush();
+    }
+
+    template <typename T>
+    void
+    put(const T &value)
+    {
+        std::memcpy(&buffer[used], &value, sizeof(value));
+        used += sizeof(value);
+    }
+
+    void write(const char *data, size_t len);
+
+    void
+    putString(const char *str, size_t len)
+    {
+        reserve(sizeof(char) + sizeof(uint32_t));
+        put('s');
+        put<uint32_t>(len);
+        write(str, len);
+    }
+
+    /** Largest encoding of an argument, other than strings */
+    static const size_t MaxArgSize = 2 + sizeof(uint64_t);
+
+    void
+    putArg(bool value)
+    {
+        put('b');
+        put<uint8_t>(value);
+    }
+
+    void
+    putArg(char value)
+    {
+        put(std::is_signed<char>::value ? 'c' : 'C');
+        put(value);
+    }
+
+    void
+    putArg(signed char value)
+    {
+        put('c');
+        put(value);
+    }
+
+    void
+    putArg(unsigned char value)
+    {
+        put('C');
+        put(value);
+    }
+
+    void
+    putArg(double value)
+    {
+        put('f');
+        put(value);
+    }
+
+    void putArg(float value) { putArg(static_cast<double>(value)); }
+
+    void
+    putArg(const char *str)
+    {
+        putString(str, str ? std::strlen(str) : 0);
+    }
+
+    void
+    putArg(const std::string &str)
+    {
+        putString(str.data(), str.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value>::type
+    putArg(const T &value)
+    {
+        put(std::is_signed<T>::value ? 'i' : 'u');
+        put<uint8_t>(sizeof(T));
+        put(value);
+    }
+
+    void putArgs() { }
+
+    template <typename T, typename ...Args>
+    void
+    putArgs(const T &value, const Args &...args)
+    {
+        reserve(MaxArgSize);
+        putArg(value);
+        putArgs(args...);
+    }
+
+    template <typename ...Args>
+    void
+    message(std::true_type, Tick when, const std::string &name,
+            const std::string &flag, const char *fmt, const Args &...args)
+    {
+        static_assert(sizeof...(Args) <= UINT8_MAX,
+                      "Too many arguments for a trace record");
+
+        const uint32_t name_id = intern(name.data(), name.size());
+        const uint32_t flag_id = intern(flag.data(), flag.size());
+        const uint32_t fmt_id = intern(fmt, std::strlen(fmt));
+
+        reserve(sizeof(char) + sizeof(uint64_t) + 3 * sizeof(uint32_t) +
+                sizeof(uint8_t));
+        put('M');
+        put<uint64_t>(when);
+        put(name_id);
+        put(flag_id);
+        put(fmt_id);
+        put<uint8_t>(sizeof...(Args));
+        putArgs(args...);
+    }
+
+    template <typename ...Args>
+    void
+    message(std::false_type, Tick when, const std::string &name,
+            const std::string &flag, const char *fmt, const Args &...args)
+    {
+        std::ostringstream line;
+        ccprintf(line, fmt, args...);
+        message(when, name, flag, line.str());
+    }
+
+  public:
+    /** Start a record file on stream, which must be opened binary */
+    RecordWriter(std::ostream &stream);
+    ~RecordWriter();
+
+    /** Record a message, storing its arguments raw if possible */
+    template <typename ...Args>
+    void
+    message(Tick when, const std::string &name, const std::string &flag,
+            const char *fmt, const Args &...args)
+    {
+        message(RawArgs<Args...>(), when, name, flag, fmt, args...);
+    }
+
+    /** Record an already formatted message */
+    void message(Tick when, const std::string &name, const std::string &flag,
+                 const std::string &text);
+
+    /** Write out the buffered records */
+    void flush();
+};
+
+} // namespace Trace
+
+#endif // __BASE_TRACE_RECORD_HH__
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "base/trace_record.hh"
+
+namespace {
+
+/** Reads back the fields of a record file */
+class Reader
+{
+  private:
+    std::string data;
+    size_t pos = 0;
+
+  public:
+    Reader(const std::string &data) : data(data) { }
+
+    template <typename T>
+    T
+    get()
+    {
+        T value;
+        EXPECT_LE(pos + sizeof(T), data.size());
+        std::memcpy(&value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string
+    str()
+    {
+        const uint32_t len = get<uint32_t>();
+        std::string s = data.substr(pos, len);
+        pos += len;
+        return s;
+    }
+
+    bool done() const { return pos == data.size(); }
+};
+
+struct Printable { int value; };
+
+/**
+ * Logs messages both as records and as the text cprintf makes of them,
+ * to check that util/decode_debug_trace.py decodes them to that text.
+ */
+class DecodeCheck
+{
+  private:
+    std::ostringstream records;
+    Trace::RecordWriter writer;
+    std::string expected;
+
+  public:
+    DecodeCheck() : writer(records) { }
+
+    template <typename ...Args>
+    void
+    add(const char *format, const Args &...args)
+    {
+        writer.message(MaxTick, "", "", format, args...);
+        expected += csprintf(format, args...);
+    }
+
+    /**
+     * Decode the records with the script, which is found relative to
+     * the top of the source tree, where the unit tests are run from.
+     */
+    void
+    check()
+    {
+        writer.flush();
+        char in[] = "trace-XXXXXX";
+        char out[] = "text-XXXXXX";
+        const int in_fd = mkstemp(in);
+        const int out_fd = mkstemp(out);
+        ASSERT_NE(-1, in_fd);
+        ASSERT_NE(-1, out_fd);
+        const std::string data = records.str();
+        ASSERT_EQ(data.size(), write(in_fd, data.data(), data.size()));
+        close(in_fd);
+        close(out_fd);
+
+        const std::string command =
+            csprintf("util/decode_debug_trace.py %s %s", in, out);
+        EXPECT_EQ(0, std::system(command.c_str())) << command;
+        std::ifstream text(out);
+        std::ostringstream decoded;
+        decoded << text.rdbuf();
+        unlink(in);
+        unlink(out);
+
+        // Compare line by line, so a mismatch shows the format at fault
+        std::istringstream want(expected), got(decoded.str());
+        std::string want_line, got_line;
+        while (std::getline(want, want_line)) {
+            EXPECT_TRUE(std::getline(got, got_line)) << want_line;
+            EXPECT_EQ(want_line, got_line);
+        }
+        EXPECT_FALSE(std::getline(got, got_line)) << got_line;
+    }
+};
+
+std::ostream &
+operator<<(std::ostream &os, const Printable &p)
+{
+    return os << "P" << p.value;
+}
+
+} // anonymous namespace
+
+static std::string
+header()
+{
+    return std::string("gem5dbg\0" "\1\0\0\0", 12);
+}
+
+TEST(TraceRecordTest, Header)
+{
+    std::ostringstream os;
+    {
+        Trace::RecordWriter writer(os);
+    }
+    EXPECT_EQ(header(), os.str());
+}
+
+TEST(TraceRecordTest, RawMessage)
+{
+    std::ostringstream os;
+    {
+        Trace::RecordWriter writer(os);
+        const std::string name = "system.cpu";
+        const std::string flag = "Exec";
+        for (int i = 0; i < 2; i++) {
+            writer.message(10 + i, name, flag, "%d %u %c %s %f %s\n",
+                           -5, (uint16_t)7, 'x', "lit", 1.5,
+                           std::string("str"));
+        }
+    }
+
+    const std::string out = os.str();
+    ASSERT_EQ(header(), out.substr(0, 12));
+    Reader r(out.substr(12));
+
+    // The strings are defined before the first message only
+    const char *strings[] = { "system.cpu", "Exec",
+                              "%d %u %c %s %f %s\n" };
+    for (uint32_t id = 0; id < 3; id++) {
+        EXPECT_EQ('S', r.get<char>());
+        EXPECT_EQ(id, r.get<uint32_t>());
+        EXPECT_EQ(strings[id], r.str());
+    }
+
+    for (int i = 0; i < 2; i++) {
+        EXPECT_EQ('M', r.get<char>());
+        EXPECT_EQ(10 + i, r.get<uint64_t>());
+        EXPECT_EQ(0, r.get<uint32_t>());
+        EXPECT_EQ(1, r.get<uint32_t>());
+        EXPECT_EQ(2, r.get<uint32_t>());
+        EXPECT_EQ(6, r.get<uint8_t>());
+
+        EXPECT_EQ('i', r.get<char>());
+        EXPECT_EQ(sizeof(int), r.get<uint8_t>());
+        EXPECT_EQ(-5, r.get<int>());
+
+        EXPECT_EQ('u', r.get<char>());
+        EXPECT_EQ(sizeof(uint16_t), r.get<uint8_t>());
+        EXPECT_EQ(7, r.get<uint16_t>());
+
+        const char tag = r.get<char>();
+        EXPECT_TRUE(tag == 'c' || tag == 'C');
+        EXPECT_EQ('x', r.get<char>());
+
+        EXPECT_EQ('s', r.get<char>());
+        EXPECT_EQ("lit", r.str());
+
+        EXPECT_EQ('f', r.get<char>());
+        EXPECT_EQ(1.5, r.get<double>());
+
+        EXPECT_EQ('s', r.get<char>());
+        EXPECT_EQ("str", r.str());
+    }
+    EXPECT_TRUE(r.done());
+}
+
+TEST(TraceRecordTest, FormattedMessage)
+{
+    std::ostringstream os;
+    {
+        Trace::RecordWriter writer(os);
+        writer.message(3, "obj", "", "value %s\n", Printable{4});
+    }
+
+    Reader r(os.str().substr(12));
+    EXPECT_EQ('S', r.get<char>());
+    EXPECT_EQ(0, r.get<uint32_t>());
+    EXPECT_EQ("obj", r.str());
+    EXPECT_EQ('S', r.get<char>());
+    EXPECT_EQ(1, r.get<uint32_t>());
+    EXPECT_EQ("", r.str());
+
+    EXPECT_EQ('L', r.get<char>());
+    EXPECT_EQ(3, r.get<uint64_t>());
+    EXPECT_EQ(0, r.get<uint32_t>());
+    EXPECT_EQ(1, r.get<uint32_t>());
+    EXPECT_EQ("value P4\n", r.str());
+    EXPECT_TRUE(r.done());
+}
+
+TEST(TraceRecordTest, LongString)
+{
+    // Strings larger than the buffer are written around it
+    const std::string text(3 << 20, 'a');
+    std::ostringstream os;
+    {
+        Trace::RecordWriter writer(os);
+        writer.message(1, "obj", "Flag", "%s", text);
+    }
+
+    Reader r(os.str().substr(12));
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ('S', r.get<char>());
+        r.get<uint32_t>();
+        r.str();
+    }
+    EXPECT_EQ('M', r.get<char>());
+    r.get<uint64_t>();
+    r.get<uint32_t>();
+    r.get<uint32_t>();
+    r.get<uint32_t>();
+    EXPECT_EQ(1, r.get<uint8_t>());
+    EXPECT_EQ('s', r.get<char>());
+    EXPECT_EQ(text, r.str());
+    EXPECT_TRUE(r.done());
+}
+
+TEST(TraceRecordTest, DecodeIntegers)
+{
+    const int64_t smin = std::numeric_limits<int64_t>::min();
+    const int64_t smax = std::numeric_limits<int64_t>::max();
+    const uint64_t umax = std::numeric_limits<uint64_t>::max();
+
+    DecodeCheck check;
+    check.add("%d %i %u\n", 42, -42, 42u);
+    check.add("%d %d %d\n", smin, smax, (int64_t)-1);
+    check.add("%u %u %d\n", umax, (uint64_t)1 << 63, umax);
+    check.add("%x %X %o\n", umax, smin, umax);
+    check.add("%x %x %x %x\n", (int8_t)-1, (int16_t)-2, -3, (int64_t)-4);
+    check.add("%x %o %d\n", (uint8_t)200, (uint16_t)65535, (uint32_t)-1);
+    check.add("%#x %#X %#o %#x %#o\n", 255, 255, 8, 0, 0);
+    check.add("%#10x|%#010x|%#-10x|%#08o|\n", 0xbeef, 0xbeef, 0xbeef, 8);
+    check.add("%5d|%-5d|%05d|%+d|%+d|%+5d|\n", 42, 42, 42, 42, -42, 7);
+    check.add("%020d|%-20u|%+d|%+u|\n", smin, umax, smax, umax);
+    check.add("%016x|%-16X|%16o|\n", (uint64_t)0xdead, smax, 64);
+    check.add("%*d|%-*d|%*x|\n", 6, 42, 6, 42, 3, 0x12345);
+    check.add("%.3d|%8.3d|\n", 7, 7);
+    check.add("%d %x %u %c\n", true, false, 'a', 65);
+    check.add("%d %x %o\n", 'a', (signed char)-1, (unsigned char)255);
+    check.check();
+}
+
+TEST(TraceRecordTest, DecodeFloats)
+{
+    DecodeCheck check;
+    check.add("%f %e %g\n", 1.5, 1.5, 1.5);
+    check.add("%E %G %g\n", 123456789.0, 1e-10, 1e20);
+    check.add("%.3f %.0f %.2e %.4g\n", 3.14159, 2.5, 31415.9, 2.0 / 3);
+    check.add("%10.3f|%-10.2e|%010.4f|%08g|\n", 3.14159, -1.0, 2.5, 0.5);
+    check.add("%12e|%.0e|%.1E|\n", -123.456, 5e3, 6.02e23);
+    check.add("%g %g %g\n", 0.0001, 100000.0, 1000000.0);
+    check.add("%f %g %d\n", -0.0, 1.0f / 3, 2.75);
+    check.add("%*.*f|%.*e|\n", 9, 2, 1.005, 3, 12345.678);
+
+    // The precision set by one conversion sticks to the next ones
+    check.add("%.2f %g %s\n", 1.0, 2.0 / 3, 3.0 / 7);
+    check.check();
+}
+
+TEST(TraceRecordTest, DecodeStrings)
+{
+    DecodeCheck check;
+    check.add("%s %s %s\n", "lit", std::string("str"), "");
+    check.add("%10s|%-10s|%3s|\n", "right", "left", "toolong");
+    check.add("%c%c%c %5c|%-3c|\n", 'a', 'b', 'c', 'd', 'e');
+    check.add("%s %s %s %s\n", 42, -1, 'x', true);
+    check.add("%s %s\n", (uint64_t)-1, std::numeric_limits<int64_t>::min());
+    check.add("%s %10s|\n", 1.5, 2.25);
+    check.add("100%% done, %d%%\n", 7);
+    check.add("no args\n");
+    check.add("%s\n", std::string("with\ttab and 100% sign"));
+    check.check();
+}
@@ -48,6 +48,7 @@
 
 #include <iostream>
 
+#include "base/pool_alloc.hh"
 #include "base/refcnt.hh"
 #include "cpu/minor/buffers.hh"
 #include "cpu/inst_seq.hh"
@@ -283,6 +284,22 @@ class MinorDynInst : public RefCounted
     void setMemAccPredicate(bool val) { memAccPredicate = val; }
 
     ~MinorDynInst();
+
+    /**
+     * Instructions are allocated from the pool allocator, so the
+     * pipeline does not reach malloc for each one in steady state.
+     */
+    static void *
+    operator new(size_t size)
+    {
+        return PoolAlloc::allocate(size);
+    }
+
+    static void
+    operator delete(void *p, size_t size)
+    {
+        PoolAlloc::release(p, size);
+    }
 };
 
 /** Print a summary of the instruction */
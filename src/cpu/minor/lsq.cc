@@ -68,7 +68,7 @@ LSQ::LSQRequest::LSQRequest(LSQ &port_, MinorDynInstPtr inst_, bool isLoad_,
     isTranslationDelayed(false),
     state(NotIssued)
 {
-    request = std::make_shared<Request>();
+    request = Request::create();
 }
 
 void
@@ -491,7 +491,7 @@ LSQ::SplitDataRequest::makeFragmentRequests()
             }
         }
 
-        RequestPtr fragment = std::make_shared<Request>();
+        RequestPtr fragment = Request::create();
         bool disabled_fragment = false;
 
         fragment->setContext(request->contextId());
@@ -44,6 +44,7 @@
 
 #include <array>
 
+#include "base/pool_alloc.hh"
 #include "config/the_isa.hh"
 #include "cpu/o3/cpu.hh"
 #include "cpu/o3/isa_specific.hh"
@@ -85,6 +86,22 @@ class BaseO3DynInst : public BaseDynInst<Impl>
 
     ~BaseO3DynInst();
 
+    /**
+     * Dynamic instructions are allocated from the pool allocator, so
+     * the fetch to commit loop does not reach malloc in steady state.
+     */
+    static void *
+    operator new(size_t size)
+    {
+        return PoolAlloc::allocate(size);
+    }
+
+    static void
+    operator delete(void *p, size_t size)
+    {
+        PoolAlloc::release(p, size);
+    }
+
     /** Executes the instruction.*/
     Fault execute();
 
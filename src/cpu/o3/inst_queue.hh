@@ -42,6 +42,7 @@
 #ifndef __CPU_O3_INST_QUEUE_HH__
 #define __CPU_O3_INST_QUEUE_HH__
 
+#include <deque>
 #include <list>
 #include <map>
 #include <queue>
@@ -307,11 +308,14 @@ class InstructionQueue
     // Instruction lists, ready queues, and ordering
     //////////////////////////////////////
 
-    /** List of all the instructions in the IQ (some of which may be issued). */
-    std::list<DynInstPtr> instList[Impl::MaxThreads];
+    /** List of all the instructions in the IQ (some of which may be issued).
+     *  Instructions enter at the back and leave from the front when they
+     *  commit, or from the back when they are squashed.
+     */
+    std::deque<DynInstPtr> instList[Impl::MaxThreads];
 
-    /** List of instructions that are ready to be executed. */
-    std::list<DynInstPtr> instsToExecute;
+    /** Queue of instructions that are ready to be executed. */
+    std::deque<DynInstPtr> instsToExecute;
 
     /** List of instructions waiting for their DTB translation to
      *  complete (hw page table walk in progress).
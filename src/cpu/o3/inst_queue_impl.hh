@@ -971,11 +971,8 @@ InstructionQueue<Impl>::commit(const InstSeqNum &inst, ThreadID tid)
     DPRINTF(IQ, "[tid:%i] Committing instructions older than [sn:%llu]\n",
             tid,inst);
 
-    ListIt iq_it = instList[tid].begin();
-
-    while (iq_it != instList[tid].end() &&
-           (*iq_it)->seqNum <= inst) {
-        ++iq_it;
+    while (!instList[tid].empty() &&
+           instList[tid].front()->seqNum <= inst) {
         instList[tid].pop_front();
     }
 
@@ -1210,18 +1207,18 @@ void
 InstructionQueue<Impl>::doSquash(ThreadID tid)
 {
     // Start at the tail.
-    ListIt squash_it = instList[tid].end();
-    --squash_it;
+    size_t squash_idx = instList[tid].size();
 
     DPRINTF(IQ, "[tid:%i] Squashing until sequence number %i!\n",
             tid, squashedSeqNum[tid]);
 
     // Squash any instructions younger than the squashed sequence number
     // given.
-    while (squash_it != instList[tid].end() &&
-           (*squash_it)->seqNum > squashedSeqNum[tid]) {
+    while (squash_idx != 0 &&
+           instList[tid][squash_idx - 1]->seqNum > squashedSeqNum[tid]) {
 
-        DynInstPtr squashed_inst = (*squash_it);
+        --squash_idx;
+        DynInstPtr squashed_inst = instList[tid][squash_idx];
         if (squashed_inst->isFloating()) {
             fpInstQueueWrites++;
         } else if (squashed_inst->isVector()) {
@@ -1234,7 +1231,6 @@ InstructionQueue<Impl>::doSquash(ThreadID tid)
         // hasn't already been squashed in the IQ.
         if (squashed_inst->threadNumber != tid ||
             squashed_inst->isSquashedInIQ()) {
-            --squash_it;
             continue;
         }
 
@@ -1343,7 +1339,9 @@ InstructionQueue<Impl>::doSquash(ThreadID tid)
             assert(dependGraph.empty(dest_reg->flatIndex()));
             dependGraph.clearInst(dest_reg->flatIndex());
         }
-        instList[tid].erase(squash_it--);
+        // Only the instructions skipped above follow it, so this rarely
+        // moves any.
+        instList[tid].erase(instList[tid].begin() + squash_idx);
         ++iqSquashedInstsExamined;
     }
 }
@@ -1529,7 +1527,7 @@ InstructionQueue<Impl>::dumpInsts()
     for (ThreadID tid = 0; tid < numThreads; ++tid) {
         int num = 0;
         int valid_num = 0;
-        ListIt inst_list_it = instList[tid].begin();
+        auto inst_list_it = instList[tid].begin();
 
         while (inst_list_it != instList[tid].end()) {
             cprintf("Instruction:%i\n", num);
@@ -1569,7 +1567,7 @@ InstructionQueue<Impl>::dumpInsts()
 
     int num = 0;
     int valid_num = 0;
-    ListIt inst_list_it = instsToExecute.begin();
+    auto inst_list_it = instsToExecute.begin();
 
     while (inst_list_it != instsToExecute.end())
     {
@@ -43,6 +43,7 @@
 #define __CPU_O3_LSQ_UNIT_HH__
 
 #include <algorithm>
+#include <array>
 #include <cstring>
 #include <map>
 #include <memory>
@@ -100,10 +101,16 @@ class LSQUnit
         uint32_t _size;
         /** Valid entry. */
         bool _valid;
+        /** Whether the entry is recorded in an address filter. */
+        bool _filtered;
+        /** The first and last line recorded in the address filter. */
+        Addr _firstLine;
+        Addr _lastLine;
       public:
         /** Constructs an empty store queue entry. */
         LSQEntry()
-            : inst(nullptr), req(nullptr), _size(0), _valid(false)
+            : inst(nullptr), req(nullptr), _size(0), _valid(false),
+              _filtered(false), _firstLine(0), _lastLine(0)
         {
         }
 
@@ -131,7 +138,7 @@ class LSQUnit
         void
         set(const DynInstPtr& inst)
         {
-            assert(!_valid);
+            assert(!_valid && !_filtered);
             this->inst = inst;
             _valid = true;
             _size = 0;
@@ -145,6 +152,12 @@ class LSQUnit
         uint32_t& size() { return _size; }
         const uint32_t& size() const { return _size; }
         const DynInstPtr& instruction() const { return inst; }
+        bool& filtered() { return _filtered; }
+        const bool& filtered() const { return _filtered; }
+        Addr& firstLine() { return _firstLine; }
+        const Addr& firstLine() const { return _firstLine; }
+        Addr& lastLine() { return _lastLine; }
+        const Addr& lastLine() const { return _lastLine; }
         /** @} */
     };
 
@@ -206,6 +219,95 @@ class LSQUnit
     };
     using LQEntry = LSQEntry;
 
+    /**
+     * A counting Bloom filter over the lines accessed by the entries of a
+     * queue. If none of the lines of an address range is in the filter, no
+     * entry overlaps the range and the queue need not be searched. Lines
+     * are at least as large as the dependence check granularity, so a
+     * negative answer is exact for both forwarding and violation checks.
+     */
+    class LineFilter
+    {
+      private:
+        static const unsigned NumCounters = 1024;
+
+        std::array<uint16_t, NumCounters> counters;
+
+        unsigned lineShift;
+
+        static unsigned
+        index(Addr line)
+        {
+            return (line ^ (line >> 10) ^ (line >> 20)) & (NumCounters - 1);
+        }
+
+      public:
+        LineFilter() : lineShift(0) { clear(); }
+
+        void setLineShift(unsigned shift) { lineShift = shift; }
+
+        void clear() { counters.fill(0); }
+
+        /** Record the bytes [first, last] accessed by an entry, replacing
+         *  any range recorded for it before. */
+        void
+        insert(LSQEntry &entry, Addr first, Addr last)
+        {
+            remove(entry);
+            entry.filtered() = true;
+            entry.firstLine() = first >> lineShift;
+            entry.lastLine() = last >> lineShift;
+            Addr line = entry.firstLine();
+            do {
+                ++counters[index(line)];
+            } while (line++ != entry.lastLine());
+        }
+
+        /** Forget the range recorded for an entry, if any. */
+        void
+        remove(LSQEntry &entry)
+        {
+            if (!entry.filtered())
+                return;
+            entry.filtered() = false;
+            Addr line = entry.firstLine();
+            do {
+                assert(counters[index(line)] > 0);
+                --counters[index(line)];
+            } while (line++ != entry.lastLine());
+        }
+
+        /** Could any recorded entry, other than self, overlap the bytes
+         *  [first, last]? */
+        bool
+        mayOverlap(Addr first, Addr last,
+                   const LSQEntry *self = nullptr) const
+        {
+            Addr line = first >> lineShift;
+            do {
+                unsigned idx = index(line);
+                if (counters[idx] > ownCount(self, idx))
+                    return true;
+            } while (line++ != last >> lineShift);
+            return false;
+        }
+
+      private:
+        /** The number of increments an entry made to a counter */
+        unsigned
+        ownCount(const LSQEntry *entry, unsigned idx) const
+        {
+            if (!entry || !entry->filtered())
+                return 0;
+            unsigned count = 0;
+            Addr line = entry->firstLine();
+            do {
+                count += index(line) == idx;
+            } while (line++ != entry->lastLine());
+            return count;
+        }
+    };
+
     /** Coverage of one address range with another */
     enum class AddrRangeCoverage
     {
@@ -506,6 +608,12 @@ class LSQUnit
     /** Should loads be checked for dependency issues */
     bool checkLoads;
 
+    /** Lines accessed by the loads in the LQ, for violation checks. */
+    LineFilter loadFilter;
+
+    /** Lines written by the stores in the SQ, for store forwarding. */
+    LineFilter storeFilter;
+
     /** The number of load instructions in the LQ. */
     int loads;
     /** The number of store instructions in the SQ. */
@@ -643,6 +751,12 @@ LSQUnit<Impl>::read(LSQRequest *req, int load_idx)
 
     assert(!load_inst->isExecuted());
 
+    // The effective address was just set, so record it for the violation
+    // checks of older stores and loads
+    loadFilter.insert(load_req, load_inst->effAddr,
+                      load_inst->effAddr +
+                      std::max<unsigned>(load_inst->effSize, 1) - 1);
+
     // Make sure this isn't a strictly ordered load
     // A bit of a hackish way to get strictly ordered accesses to work
     // only if they're at the head of the LSQ and are ready to commit
@@ -734,6 +848,13 @@ LSQUnit<Impl>::read(LSQRequest *req, int load_idx)
     // Check the SQ for any previous stores that might lead to forwarding
     auto store_it = load_inst->sqIt;
     assert (store_it >= storeWBIt);
+    // Every store that can forward to, or partly overlap, the load touches
+    // the bytes from just below to just above it; skip the search if no
+    // store in the SQ does
+    Addr load_s = req->mainRequest()->getVaddr();
+    Addr load_e = load_s + req->mainRequest()->getSize();
+    if (!storeFilter.mayOverlap(load_s ? load_s - 1 : 0, load_e))
+        store_it = storeWBIt;
     // End once we've reached the top of the LSQ
     while (store_it != storeWBIt) {
         // Move the index to one younger
@@ -968,6 +1089,14 @@ LSQUnit<Impl>::write(LSQRequest *req, uint8_t *data, int store_idx)
     storeQueue[store_idx].setRequest(req);
     unsigned size = req->_size;
     storeQueue[store_idx].size() = size;
+    // Only stores with data are considered for forwarding
+    if (size != 0) {
+        Addr eff_addr = storeQueue[store_idx].instruction()->effAddr;
+        storeFilter.insert(storeQueue[store_idx], eff_addr,
+                           eff_addr + size - 1);
+    } else {
+        storeFilter.remove(storeQueue[store_idx]);
+    }
     bool store_no_data =
         req->mainRequest()->getFlags() & Request::STORE_NO_DATA;
     storeQueue[store_idx].isAllZeros() = store_no_data;
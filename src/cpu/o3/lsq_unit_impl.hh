@@ -45,6 +45,7 @@
 
 #include "arch/generic/debugfaults.hh"
 #include "arch/locked_mem.hh"
+#include "base/intmath.hh"
 #include "base/str.hh"
 #include "config/the_isa.hh"
 #include "cpu/checker/cpu.hh"
@@ -232,6 +233,13 @@ LSQUnit<Impl>::init(O3CPU *cpu_ptr, IEW *iew_ptr, DerivO3CPUParams *params,
     checkLoads = params->LSQCheckLoads;
     needsTSO = params->needsTSO;
 
+    // Filter on whole cache lines, or on the dependence check blocks if
+    // those are larger
+    unsigned line_shift = std::max(depCheckShift,
+                                   (unsigned)floorLog2(cpu->cacheLineSize()));
+    loadFilter.setLineShift(line_shift);
+    storeFilter.setLineShift(line_shift);
+
     resetState();
 }
 
@@ -253,6 +261,9 @@ LSQUnit<Impl>::resetState()
 
     stalled = false;
 
+    loadFilter.clear();
+    storeFilter.clear();
+
     cacheBlockMask = ~(cpu->cacheLineSize() - 1);
 }
 
@@ -528,6 +539,14 @@ Fault
 LSQUnit<Impl>::checkViolations(typename LoadQueue::iterator& loadIt,
         const DynInstPtr& inst)
 {
+    // Nothing to do if no other load in the LQ overlaps this access
+    const LQEntry *self = inst->isLoad() ? &loadQueue[inst->lqIdx] : nullptr;
+    if (!loadFilter.mayOverlap(inst->effAddr, inst->effAddr +
+                               std::max<unsigned>(inst->effSize, 1) - 1,
+                               self)) {
+        return NoFault;
+    }
+
     Addr inst_eff_addr1 = inst->effAddr >> depCheckShift;
     Addr inst_eff_addr2 = (inst->effAddr + inst->effSize - 1) >> depCheckShift;
 
@@ -734,6 +753,7 @@ LSQUnit<Impl>::commitLoad()
     DPRINTF(LSQUnit, "Committing head load instruction, PC %s\n",
             loadQueue.front().instruction()->pcState());
 
+    loadFilter.remove(loadQueue.front());
     loadQueue.front().clear();
     loadQueue.pop_front();
 
@@ -973,6 +993,7 @@ LSQUnit<Impl>::squash(const InstSeqNum &squashed_num)
         }
         // Clear the smart pointer to make sure it is decremented.
         loadQueue.back().instruction()->setSquashed();
+        loadFilter.remove(loadQueue.back());
         loadQueue.back().clear();
 
         --loads;
@@ -1046,6 +1067,7 @@ LSQUnit<Impl>::squash(const InstSeqNum &squashed_num)
         // Must delete request now that it wasn't handed off to
         // memory.  This is quite ugly.  @todo: Figure out the proper
         // place to really handle request deletes.
+        storeFilter.remove(storeQueue.back());
         storeQueue.back().clear();
         --stores;
 
@@ -1166,6 +1188,7 @@ LSQUnit<Impl>::completeStore(typename StoreQueue::iterator store_idx)
     DynInstPtr store_inst = store_idx->instruction();
     if (store_idx == storeQueue.begin()) {
         do {
+            storeFilter.remove(storeQueue.front());
             storeQueue.front().clear();
             storeQueue.pop_front();
             --stores;
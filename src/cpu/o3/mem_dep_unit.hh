@@ -41,6 +41,7 @@
 #ifndef __CPU_O3_MEM_DEP_UNIT_HH__
 #define __CPU_O3_MEM_DEP_UNIT_HH__
 
+#include <deque>
 #include <list>
 #include <memory>
 #include <set>
@@ -249,8 +250,8 @@ class MemDepUnit
     /** A list of all instructions in the memory dependence unit. */
     std::list<DynInstPtr> instList[Impl::MaxThreads];
 
-    /** A list of all instructions that are going to be replayed. */
-    std::list<DynInstPtr> instsToReplay;
+    /** A queue of all instructions that are going to be replayed. */
+    std::deque<DynInstPtr> instsToReplay;
 
     /** The memory dependence predictor.  It is accessed upon new
      *  instructions being added to the IQ, and responds by telling
@@ -41,6 +41,7 @@
 #ifndef __CPU_O3_MEM_DEP_UNIT_IMPL_HH__
 #define __CPU_O3_MEM_DEP_UNIT_IMPL_HH__
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -502,17 +503,13 @@ void
 MemDepUnit<MemDepPred, Impl>::squash(const InstSeqNum &squashed_num,
                                      ThreadID tid)
 {
-    if (!instsToReplay.empty()) {
-        ListIt replay_it = instsToReplay.begin();
-        while (replay_it != instsToReplay.end()) {
-            if ((*replay_it)->threadNumber == tid &&
-                (*replay_it)->seqNum > squashed_num) {
-                instsToReplay.erase(replay_it++);
-            } else {
-                ++replay_it;
-            }
-        }
-    }
+    instsToReplay.erase(
+        std::remove_if(instsToReplay.begin(), instsToReplay.end(),
+                       [tid, &squashed_num](const DynInstPtr &inst) {
+                           return inst->threadNumber == tid &&
+                               inst->seqNum > squashed_num;
+                       }),
+        instsToReplay.end());
 
     ListIt squash_it = instList[tid].end();
     --squash_it;
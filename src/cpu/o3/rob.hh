@@ -46,6 +46,7 @@
 #include <vector>
 
 #include "arch/registers.hh"
+#include "base/circular_queue.hh"
 #include "base/types.hh"
 #include "config/the_isa.hh"
 #include "enums/SMTQueuePolicy.hh"
@@ -64,7 +65,7 @@ class ROB
     typedef typename Impl::DynInstPtr DynInstPtr;
 
     typedef std::pair<RegIndex, PhysRegIndex> UnmapInfo;
-    typedef typename std::list<DynInstPtr>::iterator InstIt;
+    typedef typename CircularQueue<DynInstPtr>::iterator InstIt;
 
     /** Possible ROB statuses. */
     enum Status {
@@ -276,8 +277,11 @@ class ROB
     /** Max Insts a Thread Can Have in the ROB */
     unsigned maxEntries[Impl::MaxThreads];
 
-    /** ROB List of Instructions */
-    std::list<DynInstPtr> instList[Impl::MaxThreads];
+    /** Per-thread ROB instructions, oldest first. Each thread's queue is
+     *  sized for the whole ROB, so retiring and squashing only move indices
+     *  and never allocate.
+     */
+    std::vector<CircularQueue<DynInstPtr>> instList;
 
     /** Number of instructions that can be squashed in a single cycle. */
     unsigned squashWidth;
@@ -299,7 +303,7 @@ class ROB
      *  when squashing, the instructions are marked as squashed but not
      *  immediately removed, meaning the tail iterator remains the same before
      *  and after a squash.
-     *  This will always be set to cpu->instList.end() if it is invalid.
+     *  It is only valid while the thread has not finished squashing.
      */
     InstIt squashIt[Impl::MaxThreads];
 
@@ -56,6 +56,8 @@ ROB<Impl>::ROB(O3CPU *_cpu, DerivO3CPUParams *params)
     : robPolicy(params->smtROBPolicy),
       cpu(_cpu),
       numEntries(params->numROBEntries),
+      instList(Impl::MaxThreads,
+               CircularQueue<DynInstPtr>(params->numROBEntries + 1)),
       squashWidth(params->squashWidth),
       numInstsInROB(0),
       numThreads(params->numThreads),
@@ -244,11 +246,10 @@ ROB<Impl>::retireHead(ThreadID tid)
 
     assert(numInstsInROB > 0);
 
-    // Get the head ROB instruction by copying it and remove it from the list
-    InstIt head_it = instList[tid].begin();
-
-    DynInstPtr head_inst = std::move(*head_it);
-    instList[tid].erase(head_it);
+    // Move the head ROB instruction out of its slot, so the queue does
+    // not keep a reference to it, and advance the head
+    DynInstPtr head_inst = std::move(instList[tid].front());
+    instList[tid].pop_front();
 
     assert(head_inst->readyToCommit());
 
@@ -324,7 +325,7 @@ ROB<Impl>::doSquash(ThreadID tid)
     DPRINTF(ROB, "[tid:%i] Squashing instructions until [sn:%llu].\n",
             tid, squashedSeqNum[tid]);
 
-    assert(squashIt[tid] != instList[tid].end());
+    assert(!doneSquashing[tid]);
 
     if ((*squashIt[tid])->seqNum < squashedSeqNum[tid]) {
         DPRINTF(ROB, "[tid:%i] Done squashing instructions.\n",
@@ -340,7 +341,6 @@ ROB<Impl>::doSquash(ThreadID tid)
 
     for (int numSquashed = 0;
          numSquashed < squashWidth &&
-         squashIt[tid] != instList[tid].end() &&
          (*squashIt[tid])->seqNum > squashedSeqNum[tid];
          ++numSquashed)
     {
@@ -59,6 +59,18 @@ class AtomicSimpleCPU(BaseSimpleCPU):
     width = Param.Int(1, "CPU width")
     simulate_data_stalls = Param.Bool(False, "Simulate dcache stall cycles")
     simulate_inst_stalls = Param.Bool(False, "Simulate icache stall cycles")
+    # Plain loads, stores and fetches to memory that hands out a back
+    # door (i.e., without caches in the way) are done with a memcpy.
+    # This is much faster, but these accesses are not seen by the
+    # crossbars and memories, and so are missing from their stats.
+    use_backdoors = Param.Bool(False,
+        "Access memory through back doors where possible")
+    # Straight-line code fetched through a back door is decoded once,
+    # and then replayed as a whole within a single tick, one cycle per
+    # width instructions. Fetching, translating and decoding it again
+    # is then only needed for the first instruction of each block.
+    basic_block_cache = Param.Bool(False,
+        "Replay decoded basic blocks, needs use_backdoors")
 
     def addSimPointProbe(self, interval):
         simpoint = SimPoint()
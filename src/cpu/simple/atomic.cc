@@ -41,6 +41,10 @@
 
 #include "cpu/simple/atomic.hh"
 
+#include <algorithm>
+#include <cstring>
+
+#include "arch/isa_traits.hh"
 #include "arch/locked_mem.hh"
 #include "arch/utility.hh"
 #include "base/output.hh"
@@ -80,16 +84,18 @@ AtomicSimpleCPU::AtomicSimpleCPU(AtomicSimpleCPUParams *p)
       width(p->width), locked(false),
       simulate_data_stalls(p->simulate_data_stalls),
       simulate_inst_stalls(p->simulate_inst_stalls),
+      useBackdoors(p->use_backdoors),
       icachePort(name() + ".icache_port", this),
       dcachePort(name() + ".dcache_port", this),
       dcache_access(false), dcache_latency(0),
-      ppCommit(nullptr)
+      ppCommit(nullptr),
+      blockStates(p->basic_block_cache ? numThreads : 0)
 {
     _status = Idle;
-    ifetch_req = std::make_shared<Request>();
-    data_read_req = std::make_shared<Request>();
-    data_write_req = std::make_shared<Request>();
-    data_amo_req = std::make_shared<Request>();
+    ifetch_req = Request::create();
+    data_read_req = Request::create();
+    data_write_req = Request::create();
+    data_amo_req = Request::create();
 }
 
 
@@ -148,6 +154,11 @@ AtomicSimpleCPU::drainResume()
         return;
 
     DPRINTF(SimpleCPU, "Resume\n");
+
+    // Start afresh, e.g., after restoring a checkpoint, as the decoder
+    // state doesn't match a block that was being replayed
+    for (size_t tid = 0; tid < blockStates.size(); tid++)
+        stopBlocks(tid);
     verifyMemoryMode();
 
     assert(!threadContexts.empty());
@@ -198,6 +209,9 @@ AtomicSimpleCPU::switchOut()
     assert(!tickEvent.scheduled());
     assert(_status == BaseSimpleCPU::Running || _status == Idle);
     assert(isCpuDrained());
+
+    for (size_t tid = 0; tid < blockStates.size(); tid++)
+        stopBlocks(tid);
 }
 
 
@@ -277,6 +291,69 @@ AtomicSimpleCPU::sendPacket(RequestPort &port, const PacketPtr &pkt)
     return port.sendAtomic(pkt);
 }
 
+Tick
+AtomicSimpleCPU::sendMemAccess(AtomicCPUPort &port, const PacketPtr &pkt)
+{
+    // Anything that the memory system has to act upon, i.e., locked,
+    // swapping, masked and uncacheable accesses, goes through the port
+    const RequestPtr &req = pkt->req;
+    if (!useBackdoors || req->isUncacheable() || req->isMasked() ||
+        (pkt->cmd != MemCmd::ReadReq && pkt->cmd != MemCmd::WriteReq)) {
+        return sendPacket(port, pkt);
+    }
+
+    const Addr addr = pkt->getAddr();
+    const bool is_read = pkt->isRead();
+    for (const auto &entry : port.backdoors) {
+        const MemBackdoor &backdoor = *entry.backdoor;
+        const AddrRange &range = backdoor.range();
+        if (addr < range.start() || addr + pkt->getSize() > range.end() ||
+            !(is_read ? backdoor.readable() : backdoor.writeable())) {
+            continue;
+        }
+
+        uint8_t *host_addr = backdoor.ptr() + (addr - range.start());
+        if (is_read)
+            pkt->setData(host_addr);
+        else
+            pkt->writeData(host_addr);
+        pkt->makeResponse();
+        return entry.latency;
+    }
+
+    if (port.backdoorRetry) {
+        --port.backdoorRetry;
+        return sendPacket(port, pkt);
+    }
+
+    MemBackdoorPtr backdoor = nullptr;
+    Tick latency = port.sendAtomicBackdoor(pkt, backdoor);
+    if (backdoor)
+        port.addBackdoor(backdoor, latency);
+    else
+        port.backdoorRetry = BackdoorRetryInterval;
+    return latency;
+}
+
+void
+AtomicSimpleCPU::AtomicCPUPort::addBackdoor(MemBackdoorPtr backdoor,
+                                            Tick latency)
+{
+    DPRINTF(SimpleCPU, "Using back door to %s\n",
+            backdoor->range().to_string());
+
+    backdoors.push_back(Backdoor{backdoor, latency});
+    backdoor->addInvalidationCallback(
+        [this](const MemBackdoor &invalid) {
+            DPRINTF(SimpleCPU, "Dropping back door to %s\n",
+                    invalid.range().to_string());
+            backdoors.erase(std::remove_if(backdoors.begin(), backdoors.end(),
+                [&invalid](const Backdoor &entry) {
+                    return entry.backdoor == &invalid;
+                }), backdoors.end());
+        });
+}
+
 Tick
 AtomicSimpleCPU::AtomicCPUDPort::recvAtomicSnoop(PacketPtr pkt)
 {
@@ -408,7 +485,7 @@ AtomicSimpleCPU::readMem(Addr addr, uint8_t * data, unsigned size,
             if (req->isLocalAccess()) {
                 dcache_latency += req->localAccessor(thread->getTC(), &pkt);
             } else {
-                dcache_latency += sendPacket(dcachePort, &pkt);
+                dcache_latency += sendMemAccess(dcachePort, &pkt);
             }
             dcache_access = true;
 
@@ -514,10 +591,12 @@ AtomicSimpleCPU::writeMem(uint8_t *data, unsigned size, Addr addr,
                     dcache_latency +=
                         req->localAccessor(thread->getTC(), &pkt);
                 } else {
-                    dcache_latency += sendPacket(dcachePort, &pkt);
+                    dcache_latency += sendMemAccess(dcachePort, &pkt);
 
                     // Notify other threads on this CPU of write
                     threadSnoop(&pkt, curThread);
+                    if (!blockStates.empty())
+                        blockStore(pkt.getAddr(), pkt.getSize());
                 }
                 dcache_access = true;
                 assert(!pkt.isError());
@@ -610,6 +689,8 @@ AtomicSimpleCPU::amoMem(Addr addr, uint8_t* data, unsigned size,
             dcache_latency += req->localAccessor(thread->getTC(), &pkt);
         else {
             dcache_latency += sendPacket(dcachePort, &pkt);
+            if (!blockStates.empty())
+                blockStore(pkt.getAddr(), pkt.getSize());
         }
 
         dcache_access = true;
@@ -646,10 +727,15 @@ AtomicSimpleCPU::tick()
 
     SimpleExecContext& t_info = *threadInfo[curThread];
     SimpleThread* thread = t_info.thread;
+    BlockState *bs = blockStates.empty() ? nullptr : &blockStates[curThread];
 
     Tick latency = 0;
+    int replayed = 0;
+
+    for (int i = 0; i < width || locked || (bs && bs->replaying); ++i) {
+        if (i >= width && !locked)
+            ++replayed;
 
-    for (int i = 0; i < width || locked; ++i) {
         numCycles++;
         updateCycleCounters(BaseCPU::CPU_STATE_ON);
 
@@ -670,6 +756,11 @@ AtomicSimpleCPU::tick()
 
         bool needToFetch = !isRomMicroPC(pcState.microPC()) &&
                            !curMacroStaticInst;
+        const BasicBlock::Inst *decoded = nullptr;
+        if (needToFetch && bs && bs->replaying) {
+            decoded = nextBlockInst(*bs);
+            needToFetch = !decoded;
+        }
         if (needToFetch) {
             ifetch_req->taskId(taskId());
             setupFetchRequest(ifetch_req);
@@ -694,7 +785,7 @@ AtomicSimpleCPU::tick()
                     Packet ifetch_pkt = Packet(ifetch_req, MemCmd::ReadReq);
                     ifetch_pkt.dataStatic(&inst);
 
-                    icache_latency = sendPacket(icachePort, &ifetch_pkt);
+                    icache_latency = sendMemAccess(icachePort, &ifetch_pkt);
 
                     assert(!ifetch_pkt.isError());
 
@@ -703,10 +794,20 @@ AtomicSimpleCPU::tick()
                 //}
             }
 
-            preExecute();
+            if (decoded) {
+                thread->pcState(decoded->post);
+                preExecute(decoded->inst);
+            } else {
+                preExecute();
+                if (bs && needToFetch && !t_info.stayAtPC)
+                    recordBlockInst(*bs, pcState);
+            }
 
             Tick stall_ticks = 0;
             if (curStaticInst) {
+                if (bs && BasicBlock::endsBlock(curStaticInst))
+                    bs->ending = true;
+
                 fault = curStaticInst->execute(&t_info, traceData);
 
                 // keep an instruction count
@@ -750,19 +851,195 @@ AtomicSimpleCPU::tick()
         }
         if (fault != NoFault || !t_info.stayAtPC)
             advancePC(fault);
+
+        if (bs && (fault != NoFault ||
+                   (!t_info.stayAtPC && !curMacroStaticInst &&
+                    !isRomMicroPC(thread->pcState().microPC())))) {
+            blockInstDone(*bs, fault);
+        }
     }
 
     if (tryCompleteDrain())
         return;
 
-    // instruction takes at least one cycle
-    if (latency < clockPeriod())
-        latency = clockPeriod();
+    // instruction takes at least one cycle, plus one for every width
+    // instructions replayed from a block beyond that
+    Tick min_latency = clockPeriod() * (1 + divCeil(replayed, width));
+    if (latency < min_latency)
+        latency = min_latency;
 
     if (_status != Idle)
         reschedule(tickEvent, curTick() + latency, true);
 }
 
+const BasicBlock::Inst *
+AtomicSimpleCPU::nextBlockInst(BlockState &bs)
+{
+    SimpleExecContext &t_info = *threadInfo[curThread];
+    SimpleThread *thread = t_info.thread;
+    assert(bs.next < bs.replaying->insts.size());
+    const BasicBlock::Inst &entry = bs.replaying->insts[bs.next];
+
+    // Instruction count events may end the simulation, which has to
+    // happen right after the instruction they are due at
+    const bool inst_event = !thread->comInstEventQueue.empty() &&
+        thread->comInstEventQueue.nextTick() <= (Tick)t_info.numInst;
+
+    // Interrupts and PC events change the PC state, so the block is
+    // only replayed as long as they don't happen
+    if (inst_event || !(thread->pcState() == entry.pre)) {
+        stopBlocks(curThread);
+        return nullptr;
+    }
+
+    if (++bs.next == bs.replaying->insts.size())
+        bs.ending = true;
+    return &entry;
+}
+
+void
+AtomicSimpleCPU::recordBlockInst(BlockState &bs, const TheISA::PCState &pre)
+{
+    SimpleThread *thread = threadInfo[curThread]->thread;
+    const StaticInstPtr &inst =
+        curMacroStaticInst ? curMacroStaticInst : curStaticInst;
+    const TheISA::PCState &post = thread->pcState();
+    const Addr vaddr = pre.instAddr();
+    const Addr size = post.nextInstAddr() - vaddr;
+
+    // Get the physical address from the last fetch of the instruction,
+    // only keeping instructions that are within a single page
+    const Addr page = roundDown(vaddr, TheISA::PageBytes);
+    const Addr fetch_vaddr = ifetch_req->getVaddr();
+    if (!inst || size == 0 || size > TheISA::PageBytes ||
+        roundDown(fetch_vaddr, TheISA::PageBytes) != page ||
+        roundDown(vaddr + size - 1, TheISA::PageBytes) != page) {
+        finishRecording(bs);
+        return;
+    }
+    const Addr paddr = ifetch_req->getPaddr() + (vaddr - fetch_vaddr);
+
+    BasicBlock &block = bs.recording;
+    if (!block.insts.empty()) {
+        // Interrupts and PC events may have moved the PC state, end the
+        // block and start a new one then
+        const BasicBlock::Inst &last = block.insts.back();
+        if (vaddr == last.post.nextInstAddr() &&
+            paddr - block.paddr == vaddr - block.insts[0].pre.instAddr()) {
+            block.insts.push_back(BasicBlock::Inst{pre, post, inst});
+            if (block.insts.size() == BasicBlockCache::MaxBlockInsts)
+                bs.ending = true;
+            return;
+        }
+        finishRecording(bs);
+    }
+
+    // At the start of a block, decoding the first instruction to the
+    // same one checks that the decoder is in the same state, e.g., in
+    // the same processor mode, and comparing the machine code catches
+    // self-modifying code
+    const BasicBlock *cached = bs.cache.find(paddr);
+    if (cached && cached->insts[0].inst == inst &&
+        cached->insts[0].pre == pre) {
+        const uint8_t *host = instHostPtr(paddr, cached->bytes.size());
+        if (host && memcmp(host, cached->bytes.data(),
+                           cached->bytes.size()) == 0) {
+            bs.replaying = cached;
+            bs.next = 1;
+            return;
+        }
+    }
+
+    block.paddr = paddr;
+    block.insts.push_back(BasicBlock::Inst{pre, post, inst});
+}
+
+void
+AtomicSimpleCPU::blockInstDone(BlockState &bs, const Fault &fault)
+{
+    if (fault != NoFault) {
+        stopBlocks(curThread);
+    } else if (bs.ending) {
+        bs.ending = false;
+        if (bs.replaying)
+            stopBlocks(curThread);
+        else
+            finishRecording(bs);
+    }
+}
+
+void
+AtomicSimpleCPU::finishRecording(BlockState &bs)
+{
+    BasicBlock &block = bs.recording;
+    if (block.insts.size() > 1) {
+        const BasicBlock::Inst &last = block.insts.back();
+        const Addr size =
+            last.post.nextInstAddr() - block.insts[0].pre.instAddr();
+        const uint8_t *host = instHostPtr(block.paddr, size);
+        if (host) {
+            block.bytes.assign(host, host + size);
+            bs.cache.insert(std::move(block));
+        }
+    }
+    block = BasicBlock();
+}
+
+void
+AtomicSimpleCPU::stopBlocks(ThreadID tid)
+{
+    BlockState &bs = blockStates[tid];
+    if (bs.replaying) {
+        // The decoder didn't see the replayed instructions
+        bs.replaying = nullptr;
+        threadInfo[tid]->thread->decoder.reset();
+    }
+    bs.recording = BasicBlock();
+    bs.ending = false;
+}
+
+void
+AtomicSimpleCPU::blockStore(Addr paddr, Addr size)
+{
+    const AddrRange store(paddr, paddr + size);
+    for (size_t tid = 0; tid < blockStates.size(); tid++) {
+        BlockState &bs = blockStates[tid];
+        if (bs.replaying) {
+            // The rest of the block may have been rewritten, so the
+            // decoded instructions can't be trusted anymore
+            const Addr start = bs.replaying->paddr;
+            if (store.intersects(AddrRange(start, start +
+                                           bs.replaying->bytes.size()))) {
+                stopBlocks(tid);
+                bs.cache.erase(start);
+            }
+        } else if (!bs.recording.insts.empty()) {
+            // The bytes of the block are only copied when it ends, and
+            // would then not match what was decoded
+            const BasicBlock &block = bs.recording;
+            const Addr end = block.paddr +
+                (block.insts.back().post.nextInstAddr() -
+                 block.insts[0].pre.instAddr());
+            if (store.intersects(AddrRange(block.paddr, end)))
+                stopBlocks(tid);
+        }
+    }
+}
+
+const uint8_t *
+AtomicSimpleCPU::instHostPtr(Addr paddr, Addr size) const
+{
+    for (const auto &entry : icachePort.backdoors) {
+        const MemBackdoor &backdoor = *entry.backdoor;
+        const AddrRange &range = backdoor.range();
+        if (backdoor.readable() && paddr >= range.start() &&
+            paddr + size <= range.end()) {
+            return backdoor.ptr() + (paddr - range.start());
+        }
+    }
+    return nullptr;
+}
+
 void
 AtomicSimpleCPU::regProbePoints()
 {
@@ -42,7 +42,9 @@
 #define __CPU_SIMPLE_ATOMIC_HH__
 
 #include "cpu/simple/base.hh"
+#include "cpu/simple/block_cache.hh"
 #include "cpu/simple/exec_context.hh"
+#include "mem/backdoor.hh"
 #include "mem/request.hh"
 #include "params/AtomicSimpleCPU.hh"
 #include "sim/probe/probe.hh"
@@ -64,6 +66,7 @@ class AtomicSimpleCPU : public BaseSimpleCPU
     bool locked;
     const bool simulate_data_stalls;
     const bool simulate_inst_stalls;
+    const bool useBackdoors;
 
     // main simulation loop (one cycle)
     void tick();
@@ -103,6 +106,23 @@ class AtomicSimpleCPU : public BaseSimpleCPU
 
     virtual Tick sendPacket(RequestPort &port, const PacketPtr &pkt);
 
+    /**
+     * A back door to memory obtained through one of the ports, along
+     * with the latency of the access that set it up, which is charged
+     * for all the accesses through it.
+     */
+    struct Backdoor
+    {
+        MemBackdoorPtr backdoor;
+        Tick latency;
+    };
+
+    /**
+     * Number of accesses that go through the port as usual after a
+     * request for a back door was turned down, before asking again.
+     */
+    static const unsigned BackdoorRetryInterval = 1024;
+
     /**
      * An AtomicCPUPort overrides the default behaviour of the
      * recvAtomicSnoop and ignores the packet instead of panicking. It
@@ -115,9 +135,23 @@ class AtomicSimpleCPU : public BaseSimpleCPU
       public:
 
         AtomicCPUPort(const std::string &_name, BaseSimpleCPU* _cpu)
-            : RequestPort(_name, _cpu)
+            : RequestPort(_name, _cpu), backdoorRetry(0)
         { }
 
+        /**
+         * Back doors handed out through this port. They are kept
+         * when the CPU is switched out, as the memory system will
+         * look the same to this CPU when it is switched back in, and
+         * are only dropped when the memory invalidates them.
+         */
+        std::vector<Backdoor> backdoors;
+
+        /** Accesses left before asking for a back door again. */
+        unsigned backdoorRetry;
+
+        /** Start using a back door, until it is invalidated. */
+        void addBackdoor(MemBackdoorPtr backdoor, Tick latency);
+
       protected:
 
         bool recvTimingResp(PacketPtr pkt)
@@ -180,6 +214,82 @@ class AtomicSimpleCPU : public BaseSimpleCPU
     /** Perform snoop for other cpu-local thread contexts. */
     void threadSnoop(PacketPtr pkt, ThreadID sender);
 
+    /** Basic block recording and replay of a thread. */
+    struct BlockState
+    {
+        BasicBlockCache cache;
+
+        /** Block being recorded, empty if none. */
+        BasicBlock recording;
+
+        /** Block being replayed, if any, and its next instruction. */
+        const BasicBlock *replaying;
+        size_t next;
+
+        /** The current instruction ends the block. */
+        bool ending;
+
+        BlockState() : replaying(nullptr), next(0), ending(false) {}
+    };
+
+    /** Per-thread block state, empty without a basic block cache. */
+    std::vector<BlockState> blockStates;
+
+    /**
+     * Get the next instruction of the block being replayed. Replay
+     * stops, leaving the instruction to be fetched and decoded, if it
+     * is not at the PC state the block was recorded at, or if an
+     * instruction count event is due.
+     *
+     * @return The decoded instruction, or nullptr to fetch it.
+     */
+    const BasicBlock::Inst *nextBlockInst(BlockState &bs);
+
+    /**
+     * Record an instruction that was just decoded, with the PC state
+     * it was decoded at. At the start of a block, replay the cached
+     * block instead if it is still valid.
+     */
+    void recordBlockInst(BlockState &bs, const TheISA::PCState &pre);
+
+    /** Called when done with a (macro) instruction. */
+    void blockInstDone(BlockState &bs, const Fault &fault);
+
+    /** Add the block being recorded to the cache, if worth it. */
+    void finishRecording(BlockState &bs);
+
+    /** Stop replaying and recording blocks on a thread. */
+    void stopBlocks(ThreadID tid);
+
+    /**
+     * Account for a store to memory by this CPU. Blocks are only
+     * checked against memory when their replay starts, so a block
+     * that is being replayed or recorded, and contains the bytes that
+     * were written, is dropped here.
+     *
+     * @param paddr Physical address of the store.
+     * @param size Size of the store in bytes.
+     */
+    void blockStore(Addr paddr, Addr size);
+
+    /**
+     * Get a host pointer to instruction memory through a back door.
+     *
+     * @return The pointer, or nullptr if no back door covers it.
+     */
+    const uint8_t *instHostPtr(Addr paddr, Addr size) const;
+
+    /**
+     * Perform a memory access, through a back door if one covers it
+     * and the access is a plain read or write, and through the port
+     * otherwise.
+     *
+     * @param port Port the access would be sent through
+     * @param pkt Packet of the access, turned into a response
+     * @return Latency of the access
+     */
+    Tick sendMemAccess(AtomicCPUPort &port, const PacketPtr &pkt);
+
   public:
 
     DrainState drain() override;
@@ -492,7 +492,7 @@ BaseSimpleCPU::setupFetchRequest(const RequestPtr &req)
 
 
 void
-BaseSimpleCPU::preExecute()
+BaseSimpleCPU::preExecute(const StaticInstPtr &decoded)
 {
     SimpleExecContext &t_info = *threadInfo[curThread];
     SimpleThread* thread = t_info.thread;
@@ -520,17 +520,22 @@ BaseSimpleCPU::preExecute()
 
         TheISA::Decoder *decoder = &(thread->decoder);
 
-        //Predecode, ie bundle up an ExtMachInst
-        //If more fetch data is needed, pass it in.
-        Addr fetchPC = (pcState.instAddr() & PCMask) + t_info.fetchOffset;
-        //if (decoder->needMoreBytes())
-            decoder->moreBytes(pcState, fetchPC, inst);
-        //else
-        //    decoder->process();
-
-        //Decode an instruction if one is ready. Otherwise, we'll have to
-        //fetch beyond the MachInst at the current pc.
-        instPtr = decoder->decode(pcState);
+        if (decoded) {
+            // Already decoded, e.g., from a basic block cache
+            instPtr = decoded;
+        } else {
+            //Predecode, ie bundle up an ExtMachInst
+            //If more fetch data is needed, pass it in.
+            Addr fetchPC = (pcState.instAddr() & PCMask) + t_info.fetchOffset;
+            //if (decoder->needMoreBytes())
+                decoder->moreBytes(pcState, fetchPC, inst);
+            //else
+            //    decoder->process();
+
+            //Decode an instruction if one is ready. Otherwise, we'll have
+            //to fetch beyond the MachInst at the current pc.
+            instPtr = decoder->decode(pcState);
+        }
         if (instPtr) {
             t_info.stayAtPC = false;
             thread->pcState(pcState);
@@ -131,7 +131,17 @@ class BaseSimpleCPU : public BaseCPU
   public:
     void checkForInterrupts();
     void setupFetchRequest(const RequestPtr &req);
-    void preExecute();
+
+    /**
+     * Set up the execution of the next instruction, decoding it from
+     * the fetched bytes unless it is already decoded.
+     *
+     * @param decoded The instruction, or its macroop, as decoded before
+     * at the current PC state. The PC state has to be the one left
+     * by the decoder.
+     */
+    void preExecute(
+            const StaticInstPtr &decoded = StaticInst::nullStaticInstPtr);
     void postExecute();
     void advancePC(const Fault &fault);
 
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __CPU_SIMPLE_BLOCK_CACHE_HH__
+#define __CPU_SIMPLE_BLOCK_CACHE_HH__
+
+#include <cstdint>
+#include <vector>
+
+#include "arch/types.hh"
+#include "base/flat_hash_map.hh"
+#include "base/types.hh"
+#include "cpu/static_inst.hh"
+
+/**
+ * A straight-line sequence of instructions, as decoded by a simple
+ * CPU, within a single page of instruction memory. It ends at the
+ * first instruction that may change the control flow, the translation
+ * of instruction addresses or the state of the decoder.
+ */
+struct BasicBlock
+{
+    /** An instruction of the block. */
+    struct Inst
+    {
+        /** PC state the instruction was decoded at. */
+        TheISA::PCState pre;
+        /** PC state after decoding the instruction. */
+        TheISA::PCState post;
+        /** The instruction, or its macroop. */
+        StaticInstPtr inst;
+    };
+
+    /** Physical address of the first instruction. */
+    Addr paddr;
+
+    std::vector<Inst> insts;
+
+    /** The machine code the instructions were decoded from. */
+    std::vector<uint8_t> bytes;
+
+    BasicBlock() : paddr(0) {}
+
+    /** Check if an instruction ends a basic block. */
+    static bool
+    endsBlock(const StaticInstPtr &inst)
+    {
+        return inst->isControl() || inst->isSerializing() ||
+            inst->isNonSpeculative() || inst->isSquashAfter() ||
+            inst->isSyscall() || inst->isQuiesce() ||
+            inst->isIprAccess() || inst->isHtmCmd();
+    }
+};
+
+/**
+ * Decoded basic blocks, by the physical address of their first
+ * instruction.
+ */
+class BasicBlockCache
+{
+  private:
+    FlatHashMap<Addr, BasicBlock> blocks;
+
+  public:
+    /** Number of blocks kept before the cache is flushed. */
+    static const size_t MaxBlocks = 1 << 16;
+
+    /** Longest block recorded, in instructions. */
+    static const size_t MaxBlockInsts = 64;
+
+    /**
+     * Find the block at a physical address.
+     *
+     * @return The block, or nullptr if there is none. It is valid
+     * until the next insertion.
+     */
+    const BasicBlock *
+    find(Addr paddr) const
+    {
+        auto it = blocks.find(paddr);
+        return it == blocks.end() ? nullptr : &it->second;
+    }
+
+    /** Add a block, replacing the one at the same address. */
+    void
+    insert(BasicBlock &&block)
+    {
+        if (blocks.size() >= MaxBlocks && !blocks.count(block.paddr))
+            blocks.clear();
+        Addr paddr = block.paddr;
+        blocks[paddr] = std::move(block);
+    }
+
+    /** Drop the block at a physical address, if any. */
+    void erase(Addr paddr) { blocks.erase(paddr); }
+
+    void clear() { blocks.clear(); }
+
+    size_t size() const { return blocks.size(); }
+};
+
+#endif // __CPU_SIMPLE_BLOCK_CACHE_HH__
@@ -465,7 +465,7 @@ TimingSimpleCPU::initiateMemRead(Addr addr, unsigned size,
     if (traceData)
         traceData->setMem(addr, size, flags);
 
-    RequestPtr req = std::make_shared<Request>(
+    RequestPtr req = Request::create(
         addr, size, flags, dataRequestorId(), pc, thread->contextId());
     if (!byte_enable.empty()) {
         req->setByteEnable(byte_enable);
@@ -549,7 +549,7 @@ TimingSimpleCPU::writeMem(uint8_t *data, unsigned size,
     if (traceData)
         traceData->setMem(addr, size, flags);
 
-    RequestPtr req = std::make_shared<Request>(
+    RequestPtr req = Request::create(
         addr, size, flags, dataRequestorId(), pc, thread->contextId());
     if (!byte_enable.empty()) {
         req->setByteEnable(byte_enable);
@@ -705,7 +705,7 @@ TimingSimpleCPU::fetch()
 
     if (needToFetch) {
         _status = BaseSimpleCPU::Running;
-        RequestPtr ifetch_req = std::make_shared<Request>();
+        RequestPtr ifetch_req = Request::create();
         ifetch_req->taskId(taskId());
         ifetch_req->setContext(thread->contextId());
         setupFetchRequest(ifetch_req);
@@ -1227,7 +1227,7 @@ TimingSimpleCPU::initiateHtmCmd(Request::Flags flags)
     if (traceData)
         traceData->setMem(addr, size, flags);
 
-    RequestPtr req = std::make_shared<Request>(
+    RequestPtr req = Request::create(
         addr, size, flags, dataRequestorId());
 
     req->setPC(pc);
@@ -1276,7 +1276,7 @@ TimingSimpleCPU::htmSendAbortSignal(HtmFailureFaultCause cause)
 
     // notify l1 d-cache (ruby) that core has aborted transaction
 
-    RequestPtr req = std::make_shared<Request>(
+    RequestPtr req = Request::create(
         addr, size, flags, dataRequestorId());
 
     req->setPC(pc);
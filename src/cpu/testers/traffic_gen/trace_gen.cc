@@ -70,6 +70,13 @@ TraceGen::InputStream::reset()
     init();
 }
 
+void
+TraceGen::InputStream::seek(Tick tick)
+{
+    // Only chunked traces can seek, the others are read from the start
+    trace.seek(tick);
+}
+
 bool
 TraceGen::InputStream::read(TraceElement& element)
 {
@@ -113,14 +120,20 @@ TraceGen::nextPacketTick(bool elastic, Tick delay) const
 void
 TraceGen::enter()
 {
-    // update the trace offset to the time where the state was entered.
-    tickOffset = curTick();
+    // update the trace offset to the time where the state was entered,
+    // so that the element at the start tick plays right away
+    tickOffset = curTick() - startTick;
 
     // clear everything
     currElement.clear();
 
-    // read the first element in the file and set the complete flag
-    traceComplete = !trace.read(nextElement);
+    // skip the elements before the start tick, and read the first
+    // element to play and set the complete flag
+    if (startTick != 0)
+        trace.seek(startTick);
+    do {
+        traceComplete = !trace.read(nextElement);
+    } while (!traceComplete && nextElement.tick < startTick);
 }
 
 PacketPtr
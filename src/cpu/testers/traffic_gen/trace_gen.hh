@@ -131,6 +131,14 @@ class TraceGen : public BaseGen
          */
         void init();
 
+        /**
+         * Skip ahead towards the elements at or after a tick, if the
+         * trace can seek. Elements before the tick may still follow.
+         *
+         * @param tick Trace tick to skip ahead to
+         */
+        void seek(Tick tick);
+
         /**
          * Attempt to read a trace element from the stream,
          * and also notify the caller if the end of the file
@@ -152,13 +160,16 @@ class TraceGen : public BaseGen
      * @param _duration duration of this state before transitioning
      * @param trace_file File to read the transactions from
      * @param addr_offset Positive offset to add to trace address
+     * @param start_tick Trace tick to start playing the trace at
      */
     TraceGen(SimObject &obj, RequestorID requestor_id, Tick _duration,
-             const std::string& trace_file, Addr addr_offset)
+             const std::string& trace_file, Addr addr_offset,
+             Tick start_tick)
         : BaseGen(obj, requestor_id, _duration),
           trace(trace_file),
           tickOffset(0),
           addrOffset(addr_offset),
+          startTick(start_tick),
           traceComplete(false)
     {
     }
@@ -198,6 +209,12 @@ class TraceGen : public BaseGen
      */
     Addr addrOffset;
 
+    /**
+     * Trace tick to start playing at. The elements before it are
+     * skipped, and the rest play as if the trace started there.
+     */
+    const Tick startTick;
+
     /**
      * Set to true when the trace replay for one instance of
      * state is complete.
@@ -169,11 +169,16 @@ TrafficGen::parseConfig()
                 if (mode == "TRACE") {
                     string traceFile;
                     Addr addrOffset;
+                    Tick startTick = 0;
 
+                    // the start tick is optional
                     is >> traceFile >> addrOffset;
+                    if (!(is >> startTick))
+                        startTick = 0;
                     traceFile = resolveFile(traceFile);
 
-                    states[id] = createTrace(duration, traceFile, addrOffset);
+                    states[id] = createTrace(duration, traceFile, addrOffset,
+                                             startTick);
                     DPRINTF(TrafficGen, "State: %d TraceGen\n", id);
                 } else if (mode == "IDLE") {
                     states[id] = createIdle(duration);
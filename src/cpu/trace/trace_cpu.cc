@@ -300,13 +300,11 @@ TraceCPU::ElasticDataGen::readNextWindow()
     uint32_t num_read = 0;
     while (num_read != windowSize) {
 
-        // Create a new graph node
-        GraphNode* new_node = new GraphNode;
-
-        // Read the next line to get the next record. If that fails then end of
-        // trace has been reached and traceComplete needs to be set in addition
-        // to returning false.
-        if (!trace.read(new_node)) {
+        // Get the next graph node. If that fails then end of trace has been
+        // reached and traceComplete needs to be set in addition to returning
+        // false.
+        GraphNode* new_node = trace.read();
+        if (!new_node) {
             DPRINTF(TraceCPUData, "\tTrace complete!\n");
             traceComplete = true;
             return false;
@@ -501,8 +499,8 @@ TraceCPU::ElasticDataGen::execute()
             (node_ptr->dependents).clear();
             // Update the stat for numOps simulated
             owner.updateNumOps(node_ptr->robNum);
-            // delete node
-            delete node_ptr;
+            // hand the node back to the trace for reuse
+            trace.release(node_ptr);
             // remove from graph
             depGraph.erase(graph_itr);
         }
@@ -710,8 +708,8 @@ TraceCPU::ElasticDataGen::completeMemAccess(PacketPtr pkt)
         (node_ptr->dependents).clear();
         // Update the stat for numOps completed
         owner.updateNumOps(node_ptr->robNum);
-        // delete node
-        delete node_ptr;
+        // hand the node back to the trace for reuse
+        trace.release(node_ptr);
         // remove from graph
         depGraph.erase(graph_itr);
     }
@@ -1198,16 +1196,52 @@ TraceCPU::ElasticDataGen::InputStream::InputStream(
         // when the data dependency trace was captured in the o3cpu model
         windowSize = header_msg.window_size();
     }
+
+    start();
+}
+
+TraceCPU::ElasticDataGen::InputStream::~InputStream()
+{
+    stop();
+}
+
+void
+TraceCPU::ElasticDataGen::InputStream::start()
+{
+    decoded.reset(new SPSCQueue<GraphNode *>(DecodeAhead));
+    released.reset(new SPSCQueue<GraphNode *>(DecodeAhead));
+    decodedMicroOpCount = microOpCount;
+    decoder = std::thread(&InputStream::decode, this);
+}
+
+void
+TraceCPU::ElasticDataGen::InputStream::stop()
+{
+    decoded->close();
+    decoder.join();
+
+    GraphNode* node;
+    while (decoded->tryPop(node))
+        delete node;
+    while (released->tryPop(node))
+        delete node;
 }
 
 void
 TraceCPU::ElasticDataGen::InputStream::reset()
 {
+    stop();
     trace.reset();
+
+    // Skip the header, which was read when the stream was created
+    ProtoMessage::InstDepRecordHeader header_msg;
+    trace.read(header_msg);
+    microOpCount = 0;
+    start();
 }
 
 bool
-TraceCPU::ElasticDataGen::InputStream::read(GraphNode* element)
+TraceCPU::ElasticDataGen::InputStream::readRecord(GraphNode* element)
 {
     ProtoMessage::InstDepRecord pkt_msg;
     if (trace.read(pkt_msg)) {
@@ -1269,11 +1303,11 @@ TraceCPU::ElasticDataGen::InputStream::read(GraphNode* element)
             element->pc = 0;
 
         // ROB occupancy number
-        ++microOpCount;
+        ++decodedMicroOpCount;
         if (pkt_msg.has_weight()) {
-            microOpCount += pkt_msg.weight();
+            decodedMicroOpCount += pkt_msg.weight();
         }
-        element->robNum = microOpCount;
+        element->robNum = decodedMicroOpCount;
         return true;
     }
 
@@ -1281,6 +1315,50 @@ TraceCPU::ElasticDataGen::InputStream::read(GraphNode* element)
     return false;
 }
 
+void
+TraceCPU::ElasticDataGen::InputStream::decode()
+{
+    while (true) {
+        // Reuse a node released by the simulation if there is one
+        GraphNode* node;
+        if (released->tryPop(node))
+            node->dependents.clear();
+        else
+            node = new GraphNode;
+
+        if (!readRecord(node)) {
+            delete node;
+            break;
+        }
+
+        if (!decoded->push(std::move(node))) {
+            // The stream is being stopped
+            delete node;
+            return;
+        }
+    }
+
+    decoded->close();
+}
+
+TraceCPU::ElasticDataGen::GraphNode*
+TraceCPU::ElasticDataGen::InputStream::read()
+{
+    GraphNode* node;
+    if (!decoded->pop(node))
+        return nullptr;
+
+    microOpCount = node->robNum;
+    return node;
+}
+
+void
+TraceCPU::ElasticDataGen::InputStream::release(GraphNode* node)
+{
+    if (!released->tryPush(std::move(node)))
+        delete node;
+}
+
 bool
 TraceCPU::ElasticDataGen::GraphNode::removeRegDep(NodeSeqNum reg_dep)
 {
@@ -40,11 +40,14 @@
 
 #include <array>
 #include <cstdint>
+#include <memory>
 #include <queue>
 #include <set>
-#include <unordered_map>
+#include <thread>
 
 #include "arch/registers.hh"
+#include "base/flat_hash_map.hh"
+#include "base/spsc_queue.hh"
 #include "base/statistics.hh"
 #include "cpu/base.hh"
 #include "debug/TraceCPUData.hh"
@@ -789,13 +792,24 @@ class TraceCPU : public BaseCPU
          * The InputStream encapsulates a trace file and the
          * internal buffers and populates GraphNodes based on
          * the input.
+         *
+         * Records are decoded ahead of the simulation by a helper thread,
+         * which passes complete GraphNodes to the simulation through a
+         * queue. Nodes that are done with are handed back to be reused,
+         * so that no node is allocated per instruction in steady state.
          */
         class InputStream
         {
 
           private:
 
-            /** Input file stream for the protobuf trace */
+            /** Number of decoded nodes the helper thread keeps ready */
+            static const size_t DecodeAhead = 4096;
+
+            /**
+             * Input file stream for the protobuf trace, only used by the
+             * helper thread once it is started.
+             */
             ProtoInputStream trace;
 
             /**
@@ -814,6 +828,37 @@ class TraceCPU : public BaseCPU
              * trace and used to process the dependency trace
              */
             uint32_t windowSize;
+
+            /** Nodes decoded by the helper thread, in trace order */
+            std::unique_ptr<SPSCQueue<GraphNode *>> decoded;
+
+            /** Nodes released by the simulation, to be reused */
+            std::unique_ptr<SPSCQueue<GraphNode *>> released;
+
+            /** Count of micro-ops decoded by the helper thread */
+            uint64_t decodedMicroOpCount;
+
+            /** The helper thread decoding the trace */
+            std::thread decoder;
+
+            /** Start decoding the trace from the current position. */
+            void start();
+
+            /** Stop the helper thread and free the queued nodes. */
+            void stop();
+
+            /** Main loop of the helper thread. */
+            void decode();
+
+            /**
+             * Read the next record of the trace into a node. Only called
+             * by the helper thread.
+             *
+             * @param element Trace element to populate
+             * @return True if an element could be read successfully
+             */
+            bool readRecord(GraphNode* element);
+
           public:
 
             /**
@@ -825,6 +870,8 @@ class TraceCPU : public BaseCPU
             InputStream(const std::string& filename,
                         const double time_multiplier);
 
+            ~InputStream();
+
             /**
              * Reset the stream such that it can be played once
              * again.
@@ -832,15 +879,19 @@ class TraceCPU : public BaseCPU
             void reset();
 
             /**
-             * Attempt to read a trace element from the stream,
-             * and also notify the caller if the end of the file
-             * was reached.
+             * Get the next node of the trace, waiting for the helper
+             * thread to decode it if necessary.
              *
-             * @param element Trace element to populate
-             * @param size of register dependency array stored in the element
-             * @return True if an element could be read successfully
+             * @return The node, or nullptr at the end of the trace
+             */
+            GraphNode* read();
+
+            /**
+             * Hand a node that is no longer used back to the stream.
+             *
+             * @param node Node returned by read()
              */
-            bool read(GraphNode* element);
+            void release(GraphNode* node);
 
             /** Get window size from trace */
             uint32_t getWindowSize() const { return windowSize; }
@@ -1029,7 +1080,7 @@ class TraceCPU : public BaseCPU
         HardwareResource hwResource;
 
         /** Store the depGraph of GraphNodes */
-        std::unordered_map<NodeSeqNum, GraphNode*> depGraph;
+        FlatHashMap<NodeSeqNum, GraphNode*> depGraph;
 
         /**
          * Queue of dependency-free nodes that are pending issue because
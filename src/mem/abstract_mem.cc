@@ -269,6 +269,12 @@ AbstractMemory::trackLoadLocked(PacketPtr pkt)
     // no record for this xc: need to allocate a new one
     DPRINTF(LLSC, "Adding lock record: context %d addr %#x\n",
             req->contextId(), paddr);
+
+    // stores through the back door would not clear the lock, so stop
+    // handing it out until there are no locked addresses again
+    if (lockedAddrList.empty())
+        backdoor.invalidate();
+
     lockedAddrList.push_front(LockedAddr(req));
 }
 
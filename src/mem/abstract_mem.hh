@@ -236,7 +236,28 @@ class AbstractMemory : public ClockedObject
     /**
      * Add a locked address to allow for checkpointing.
      */
-    void addLockedAddr(LockedAddr addr) { lockedAddrList.push_back(addr); }
+    void
+    addLockedAddr(LockedAddr addr)
+    {
+        if (lockedAddrList.empty())
+            backdoor.invalidate();
+        lockedAddrList.push_back(addr);
+    }
+
+    /**
+     * Hand out the back door to this memory, if there is one. Accesses
+     * through the back door bypass the tracking of locked addresses,
+     * so it is withheld while there are any, and invalidated when the
+     * first one is added.
+     *
+     * @param bd_ptr Set to the back door if it is available
+     */
+    void
+    getBackdoor(MemBackdoorPtr &bd_ptr)
+    {
+        if (backdoor.ptr() && lockedAddrList.empty())
+            bd_ptr = &backdoor;
+    }
 
     /** read the system pointer
      * Implemented for completeness with the setter
@@ -1491,7 +1491,7 @@ BaseCache::writebackBlk(CacheBlk *blk)
 
     stats.writebacks[Request::wbRequestorId]++;
 
-    RequestPtr req = std::make_shared<Request>(
+    RequestPtr req = Request::create(
         regenerateBlkAddr(blk), blkSize, 0, Request::wbRequestorId);
 
     if (blk->isSecure())
@@ -1533,7 +1533,7 @@ BaseCache::writebackBlk(CacheBlk *blk)
 PacketPtr
 BaseCache::writecleanBlk(CacheBlk *blk, Request::Flags dest, PacketId id)
 {
-    RequestPtr req = std::make_shared<Request>(
+    RequestPtr req = Request::create(
         regenerateBlkAddr(blk), blkSize, 0, Request::wbRequestorId);
 
     if (blk->isSecure()) {
@@ -1606,7 +1606,7 @@ BaseCache::writebackVisitor(CacheBlk &blk)
     if (blk.isDirty()) {
         assert(blk.isValid());
 
-        RequestPtr request = std::make_shared<Request>(
+        RequestPtr request = Request::create(
             regenerateBlkAddr(&blk), blkSize, 0, Request::funcRequestorId);
 
         request->taskId(blk.task_id);
@@ -2341,6 +2341,19 @@ BaseCache::CpuSidePort::recvAtomic(PacketPtr pkt)
     }
 }
 
+Tick
+BaseCache::CpuSidePort::recvAtomicBackdoor(PacketPtr pkt,
+                                           MemBackdoorPtr &backdoor)
+{
+    if (cache->system->bypassCaches()) {
+        // Nothing is cached, so the memory below may be accessed directly
+        return cache->memSidePort.sendAtomicBackdoor(pkt, backdoor);
+    } else {
+        // The cache has to see every access, never hand out a back door
+        return cache->recvAtomic(pkt);
+    }
+}
+
 void
 BaseCache::CpuSidePort::recvFunctional(PacketPtr pkt)
 {
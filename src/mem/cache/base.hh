@@ -294,6 +294,9 @@ class BaseCache : public ClockedObject
 
         virtual Tick recvAtomic(PacketPtr pkt) override;
 
+        virtual Tick recvAtomicBackdoor(
+                PacketPtr pkt, MemBackdoorPtr &backdoor) override;
+
         virtual void recvFunctional(PacketPtr pkt) override;
 
         virtual AddrRangeList getAddrRanges() const override;
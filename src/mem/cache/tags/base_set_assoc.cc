@@ -49,8 +49,11 @@
 
 #include "base/intmath.hh"
 
+const Addr BaseSetAssoc::InvalidKey;
+
 BaseSetAssoc::BaseSetAssoc(const Params *p)
     :BaseTags(p), allocAssoc(p->assoc), blks(p->size / p->block_size),
+     tagKeys(blks.size(), InvalidKey),
      sequentialAccess(p->sequential_access),
      replacementPolicy(p->replacement_policy)
 {
@@ -83,6 +86,7 @@ void
 BaseSetAssoc::invalidate(CacheBlk *blk)
 {
     BaseTags::invalidate(blk);
+    tagKeys[blkIndex(blk)] = InvalidKey;
 
     // Decrease the number of tags in use
     stats.tagsInUse--;
@@ -91,6 +95,27 @@ BaseSetAssoc::invalidate(CacheBlk *blk)
     replacementPolicy->invalidate(blk->replacementData);
 }
 
+CacheBlk*
+BaseSetAssoc::findBlock(Addr addr, bool is_secure) const
+{
+    const Addr key = tagKey(extractTag(addr), is_secure);
+
+    // Find possible entries that may contain the given address
+    const std::vector<ReplaceableEntry*>& entries =
+        indexingPolicy->getPossibleEntries(addr);
+
+    // Search for block
+    for (const auto& location : entries) {
+        CacheBlk* blk = static_cast<CacheBlk*>(location);
+        if (tagKeys[blkIndex(blk)] == key) {
+            return blk;
+        }
+    }
+
+    // Did not find block
+    return nullptr;
+}
+
 BaseSetAssoc *
 BaseSetAssocParams::create()
 {
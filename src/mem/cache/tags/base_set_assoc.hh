@@ -78,6 +78,28 @@ class BaseSetAssoc : public BaseTags
     /** The cache blocks. */
     std::vector<CacheBlk> blks;
 
+    /**
+     * The tag and security state of every block, indexed like blks, or
+     * InvalidKey if the block is invalid. Lookups compare these keys
+     * instead of reading the blocks, so a search does not touch a cache
+     * line per way. With a set associative indexing policy the keys of a
+     * set are contiguous.
+     */
+    std::vector<Addr> tagKeys;
+
+    /** Key of invalid blocks, which cannot be the key of any tag */
+    static const Addr InvalidKey = MaxAddr;
+
+    /** Combine a tag and its security state into a lookup key. */
+    static Addr
+    tagKey(Addr tag, bool is_secure)
+    {
+        return (tag << 1) | is_secure;
+    }
+
+    /** Get the index of a block in blks and tagKeys. */
+    size_t blkIndex(const CacheBlk *blk) const { return blk - blks.data(); }
+
     /** Whether tags and data are accessed sequentially. */
     const bool sequentialAccess;
 
@@ -111,6 +133,16 @@ class BaseSetAssoc : public BaseTags
      */
     void invalidate(CacheBlk *blk) override;
 
+    /**
+     * Finds the block in the cache without touching it, by comparing the
+     * tag keys of the possible entries.
+     *
+     * @param addr The address to find.
+     * @param is_secure True if the target memory space is secure.
+     * @return Pointer to the cache block if found.
+     */
+    CacheBlk *findBlock(Addr addr, bool is_secure) const override;
+
     /**
      * Access block and update replacement data. May not succeed, in which case
      * nullptr is returned. This has all the implications of a cache access and
@@ -168,7 +200,7 @@ class BaseSetAssoc : public BaseTags
                          std::vector<CacheBlk*>& evict_blks) override
     {
         // Get possible entries to be victimized
-        const std::vector<ReplaceableEntry*> entries =
+        const std::vector<ReplaceableEntry*>& entries =
             indexingPolicy->getPossibleEntries(addr);
 
         // Choose replacement victim from replacement candidates
@@ -191,6 +223,7 @@ class BaseSetAssoc : public BaseTags
     {
         // Insert block
         BaseTags::insertBlock(pkt, blk);
+        tagKeys[blkIndex(blk)] = tagKey(blk->tag, blk->isSecure());
 
         // Increment tag counter
         stats.tagsInUse++;
@@ -140,11 +140,15 @@ class BaseIndexingPolicy : public SimObject
      * Should be called immediately before ReplacementPolicy's findVictim()
      * not to break cache resizing.
      *
+     * This is called on every tag lookup, so the entries are not copied:
+     * the returned vector belongs to the indexing policy and is only valid
+     * until the next call.
+     *
      * @param addr The addr to a find possible entries for.
      * @return The possible entries.
      */
-    virtual std::vector<ReplaceableEntry*> getPossibleEntries(const Addr addr)
-                                                                    const = 0;
+    virtual const std::vector<ReplaceableEntry*>&
+    getPossibleEntries(const Addr addr) const = 0;
 
     /**
      * Regenerate an entry's address from its tag and assigned indexing bits.
@@ -0,0 +1,795 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "mem/chunked_store.hh"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#if defined(__linux__)
+#include <linux/userfaultfd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "base/intmath.hh"
+#include "base/logging.hh"
+#include "base/trace.hh"
+#include "debug/Checkpoint.hh"
+
+const uint64_t ChunkedStore::PageSize;
+const uint64_t ChunkedStore::ChunkSize;
+const char ChunkedStore::LazyRestore::Stop;
+const char ChunkedStore::LazyRestore::Finish;
+const char ChunkedStore::Magic[8] = { 'g', 'e', 'm', '5', 'p', 'm', 'e', 'm' };
+
+namespace
+{
+
+unsigned
+numThreads(unsigned threads)
+{
+    if (threads)
+        return threads;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * Call f(i, thread) for every i in [0, n) on a pool of threads, where
+ * thread identifies the calling thread for per-thread scratch space.
+ */
+template <class F>
+void
+parallelFor(size_t n, unsigned threads, F f)
+{
+    std::atomic<size_t> next(0);
+    auto worker = [&](unsigned thread) {
+        for (size_t i = next++; i < n; i = next++)
+            f(i, thread);
+    };
+
+    threads = std::min<size_t>(threads, n);
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(worker, t);
+    worker(0);
+    for (auto &t : pool)
+        t.join();
+}
+
+bool
+isZero(const uint8_t *data, uint64_t len)
+{
+    uint64_t acc = 0;
+    uint64_t i = 0;
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        acc |= word;
+    }
+    for (; i < len; ++i)
+        acc |= data[i];
+    return acc == 0;
+}
+
+/** Hash a page, to spot pages that have changed. */
+ChunkedStore::PageHash
+hashPage(const uint8_t *data, uint64_t len)
+{
+    return Sha256::hash(data, len);
+}
+
+/** The directory a file is in. */
+std::string
+dirName(const std::string &path)
+{
+    const size_t sep = path.rfind('/');
+    if (sep == std::string::npos)
+        return ".";
+    return sep ? path.substr(0, sep) : "/";
+}
+
+/** The canonical absolute path of an existing file or directory. */
+std::string
+absolutePath(const std::string &path)
+{
+    char *real = realpath(path.c_str(), nullptr);
+    if (!real)
+        fatal("Can't resolve checkpoint path '%s': %s\n", path,
+              strerror(errno));
+    std::string abs_path(real);
+    free(real);
+    return abs_path;
+}
+
+/** Split an absolute path into its components. */
+std::vector<std::string>
+pathComponents(const std::string &path)
+{
+    std::vector<std::string> components;
+    size_t start = 0;
+    while (start < path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos)
+            end = path.size();
+        if (end > start)
+            components.push_back(path.substr(start, end - start));
+        start = end + 1;
+    }
+    return components;
+}
+
+/**
+ * The path of a file relative to a directory, both given as canonical
+ * absolute paths.
+ */
+std::string
+relativePath(const std::string &file, const std::string &dir)
+{
+    const auto to = pathComponents(file);
+    const auto from = pathComponents(dir);
+    size_t common = 0;
+    while (common < to.size() && common < from.size() &&
+           to[common] == from[common]) {
+        ++common;
+    }
+
+    std::string rel_path;
+    for (size_t i = common; i < from.size(); ++i)
+        rel_path += "../";
+    for (size_t i = common; i < to.size(); ++i)
+        rel_path += (i > common ? "/" : "") + to[i];
+    return rel_path;
+}
+
+/** A random id for a new checkpoint file. */
+uint64_t
+newFileId()
+{
+    std::random_device rd;
+    return (uint64_t)rd() << 32 | rd();
+}
+
+void
+writeOrDie(std::FILE *file, const void *data, size_t len,
+           const std::string &path)
+{
+    if (len && std::fwrite(data, len, 1, file) != 1)
+        fatal("Write failed on physical memory checkpoint file '%s'\n", path);
+}
+
+} // anonymous namespace
+
+/**
+ * A checkpoint file mapped in memory, with its header validated.
+ */
+class ChunkedStore::File
+{
+  public:
+    File(const std::string &path, uint64_t size);
+    ~File() { munmap(const_cast<uint8_t *>(map), fileSize); }
+
+    /** Path of the parent, relative to this file, if any. */
+    std::string parent() const
+    {
+        return std::string(reinterpret_cast<const char *>(map) +
+                           sizeof(Header), header.parentLength);
+    }
+
+    uint64_t numChunks() const { return header.numChunks; }
+
+    uint64_t id() const { return header.id; }
+    uint64_t parentId() const { return header.parentId; }
+
+    /** Bitmap of the pages of a chunk that are in this file. */
+    void
+    bitmap(uint64_t chunk, uint64_t *bits) const
+    {
+        memcpy(bits, entry(chunk) + sizeof(IndexEntry),
+               BitmapWords * sizeof(uint64_t));
+    }
+
+    /**
+     * Inflate the pages of a chunk that are in this file to their
+     * place in dest, which holds the whole chunk. Other pages are left
+     * untouched.
+     *
+     * @param scratch ChunkSize bytes of scratch space.
+     */
+    void inflate(uint64_t chunk, uint8_t *dest,
+                 std::vector<uint8_t> &scratch) const;
+
+  private:
+    const uint8_t *
+    entry(uint64_t chunk) const
+    {
+        return map + header.indexOffset + chunk * EntrySize;
+    }
+
+    static const uint64_t EntrySize =
+        sizeof(IndexEntry) + BitmapWords * sizeof(uint64_t);
+
+    const std::string path;
+    const uint64_t storeSize;
+    const uint8_t *map;
+    uint64_t fileSize;
+    Header header;
+};
+
+ChunkedStore::File::File(const std::string &path, uint64_t size)
+    : path(path), storeSize(size)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        fatal("Can't open physical memory checkpoint file '%s'\n", path);
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+        fatal("Can't stat physical memory checkpoint file '%s'\n", path);
+    fileSize = st.st_size;
+    if (fileSize < sizeof(Header))
+        fatal("Physical memory checkpoint file '%s' is truncated\n", path);
+
+    void *addr = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        fatal("Can't mmap physical memory checkpoint file '%s'\n", path);
+    map = static_cast<const uint8_t *>(addr);
+
+    memcpy(&header, map, sizeof(header));
+    if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+        header.version != Version) {
+        fatal("'%s' is not a chunked physical memory checkpoint\n", path);
+    }
+    if (header.pageSize != PageSize || header.chunkSize != ChunkSize) {
+        fatal("'%s' uses %d byte pages and %d byte chunks, expected %d "
+              "and %d\n", path, header.pageSize, header.chunkSize,
+              PageSize, ChunkSize);
+    }
+    if (header.storeSize != size) {
+        fatal("Memory range size has changed! Saw %lld, expected %lld\n",
+              header.storeSize, size);
+    }
+    if (header.numChunks != divCeil(size, ChunkSize) ||
+        sizeof(header) + header.parentLength > fileSize ||
+        header.indexOffset + header.numChunks * EntrySize > fileSize) {
+        fatal("Physical memory checkpoint file '%s' is corrupt\n", path);
+    }
+}
+
+void
+ChunkedStore::File::inflate(uint64_t chunk, uint8_t *dest,
+                            std::vector<uint8_t> &scratch) const
+{
+    IndexEntry index;
+    memcpy(&index, entry(chunk), sizeof(index));
+    if (!index.compressedSize)
+        return;
+    uint64_t bits[BitmapWords];
+    bitmap(chunk, bits);
+
+    const uint64_t start = chunk * ChunkSize;
+    const uint64_t end = std::min(storeSize, start + ChunkSize);
+    uint64_t raw_size = 0;
+    uint64_t page = 0;
+    for (uint64_t addr = start; addr < end; addr += PageSize, ++page) {
+        if (bits[page / 64] & (1ULL << (page % 64)))
+            raw_size += std::min(PageSize, end - addr);
+    }
+
+    if (index.offset + index.compressedSize > fileSize)
+        fatal("Physical memory checkpoint file '%s' is corrupt\n", path);
+    scratch.resize(ChunkSize);
+    uLongf len = raw_size;
+    int ret = uncompress(scratch.data(), &len, map + index.offset,
+                         index.compressedSize);
+    if (ret != Z_OK || len != raw_size) {
+        fatal("Failed to decompress chunk %d of physical memory "
+              "checkpoint file '%s'\n", chunk, path);
+    }
+
+    // Scatter the pages; pages that are not present stay untouched.
+    uint64_t pos = 0;
+    page = 0;
+    for (uint64_t addr = start; addr < end; addr += PageSize, ++page) {
+        if (bits[page / 64] & (1ULL << (page % 64))) {
+            const uint64_t page_len = std::min(PageSize, end - addr);
+            memcpy(dest + (addr - start), scratch.data() + pos, page_len);
+            pos += page_len;
+        }
+    }
+}
+
+void
+ChunkedStore::save(const std::string &path, const uint8_t *pmem,
+                   uint64_t size, unsigned threads,
+                   const std::string &parent, PageHashes *hashes)
+{
+    const bool delta = !parent.empty();
+    const uint64_t num_chunks = divCeil(size, ChunkSize);
+    const uint64_t num_pages = divCeil(size, PageSize);
+    assert(!delta || (hashes && hashes->size() == num_pages));
+    if (hashes)
+        hashes->resize(num_pages);
+
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file)
+        fatal("Can't open physical memory checkpoint file '%s'\n", path);
+
+    // Check that the parent is a checkpoint of this store, and name it
+    // relative to the directory of the delta
+    std::string parent_path;
+    uint64_t parent_id = 0;
+    if (delta) {
+        parent_id = File(parent, size).id();
+        parent_path = relativePath(absolutePath(parent),
+                                   absolutePath(dirName(path)));
+    }
+
+    Header header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.pageSize = PageSize;
+    header.chunkSize = ChunkSize;
+    header.storeSize = size;
+    header.numChunks = num_chunks;
+    header.indexOffset = 0; // Filled in once the chunks are written
+    header.parentLength = parent_path.size();
+    header.id = newFileId();
+    header.parentId = parent_id;
+    writeOrDie(file, &header, sizeof(header), path);
+    writeOrDie(file, parent_path.data(), parent_path.size(), path);
+
+    std::vector<IndexEntry> index(num_chunks);
+    std::vector<uint64_t> bitmaps(num_chunks * BitmapWords, 0);
+
+    // Chunks are compressed a window at a time, so the memory used for
+    // compressed data is bounded, and written out in order.
+    threads = numThreads(threads);
+    const size_t window = threads * 4;
+    const uLong bound = compressBound(ChunkSize);
+    std::vector<std::vector<uint8_t>> raw(threads);
+    std::vector<std::vector<uint8_t>> deflated(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+        raw[t].resize(ChunkSize);
+        deflated[t].resize(bound);
+    }
+    std::vector<std::vector<uint8_t>> out(window);
+
+    uint64_t offset = sizeof(header) + parent_path.size();
+    uint64_t stored_pages = 0;
+    for (uint64_t first = 0; first < num_chunks; first += window) {
+        const size_t n = std::min<uint64_t>(window, num_chunks - first);
+        std::atomic<uint64_t> pages(0);
+        parallelFor(n, threads, [&](size_t i, unsigned thread) {
+            const uint64_t chunk = first + i;
+            uint64_t *bitmap = &bitmaps[chunk * BitmapWords];
+            uint8_t *buf = raw[thread].data();
+            uint64_t raw_size = 0;
+
+            const uint64_t start = chunk * ChunkSize;
+            const uint64_t end = std::min(size, start + ChunkSize);
+            uint64_t page = 0;
+            for (uint64_t addr = start; addr < end; addr += PageSize) {
+                const uint8_t *data = pmem + addr;
+                const uint64_t len = std::min(PageSize, end - addr);
+                bool present;
+                if (hashes) {
+                    PageHash &old_hash = (*hashes)[addr / PageSize];
+                    const PageHash hash = hashPage(data, len);
+                    present = delta ? hash != old_hash : !isZero(data, len);
+                    old_hash = hash;
+                } else {
+                    present = !isZero(data, len);
+                }
+                if (present) {
+                    bitmap[page / 64] |= 1ULL << (page % 64);
+                    memcpy(buf + raw_size, data, len);
+                    raw_size += len;
+                }
+                ++page;
+            }
+
+            out[i].clear();
+            if (raw_size) {
+                uLongf len = bound;
+                int ret = compress2(deflated[thread].data(), &len, buf,
+                                    raw_size, Z_BEST_SPEED);
+                if (ret != Z_OK)
+                    panic("Failed to compress memory chunk (%d)\n", ret);
+                out[i].assign(deflated[thread].data(),
+                              deflated[thread].data() + len);
+                pages += raw_size / PageSize;
+            }
+        });
+
+        for (size_t i = 0; i < n; ++i) {
+            index[first + i].offset = offset;
+            index[first + i].compressedSize = out[i].size();
+            writeOrDie(file, out[i].data(), out[i].size(), path);
+            offset += out[i].size();
+        }
+        stored_pages += pages;
+    }
+
+    header.indexOffset = offset;
+    for (uint64_t chunk = 0; chunk < num_chunks; ++chunk) {
+        writeOrDie(file, &index[chunk], sizeof(IndexEntry), path);
+        writeOrDie(file, &bitmaps[chunk * BitmapWords],
+                   BitmapWords * sizeof(uint64_t), path);
+    }
+
+    if (std::fseek(file, 0, SEEK_SET))
+        fatal("Seek failed on physical memory checkpoint file '%s'\n", path);
+    writeOrDie(file, &header, sizeof(header), path);
+    if (std::fclose(file))
+        fatal("Close failed on physical memory checkpoint file '%s'\n",
+              path);
+
+    DPRINTF(Checkpoint, "Wrote %d of %d pages (%d bytes) to %s%s%s\n",
+            stored_pages, num_pages, offset, path,
+            delta ? ", delta against " : "", parent);
+}
+
+std::vector<std::unique_ptr<ChunkedStore::File>>
+ChunkedStore::openChain(const std::string &path, uint64_t size)
+{
+    std::vector<std::unique_ptr<File>> chain;
+    std::string next = path;
+    chain.emplace_back(new File(next, size));
+    while (true) {
+        const std::string parent = chain.back()->parent();
+        if (parent.empty())
+            break;
+        if (parent[0] != '/')
+            next = dirName(next) + "/" + parent;
+        else
+            next = parent;
+        DPRINTF(Checkpoint, "Delta checkpoint has parent %s\n", next);
+
+        std::unique_ptr<File> file(new File(next, size));
+        if (file->id() != chain.back()->parentId()) {
+            fatal("Physical memory checkpoint file '%s' is not the one "
+                  "the delta checkpoint was taken against\n", next);
+        }
+        chain.push_back(std::move(file));
+    }
+    std::reverse(chain.begin(), chain.end());
+    return chain;
+}
+
+void
+ChunkedStore::restore(const std::string &path, uint8_t *pmem, uint64_t size,
+                      unsigned threads)
+{
+    threads = numThreads(threads);
+    std::vector<std::vector<uint8_t>> scratch(threads);
+    const auto chain = openChain(path, size);
+    parallelFor(divCeil(size, ChunkSize), threads,
+                [&](size_t chunk, unsigned thread) {
+        uint8_t *dest = pmem + chunk * ChunkSize;
+
+        // Clear the pages that are in no file, unless they already are
+        // zero, which keeps them from being allocated
+        uint64_t present[BitmapWords] = {};
+        for (const auto &file : chain) {
+            uint64_t bits[BitmapWords];
+            file->bitmap(chunk, bits);
+            for (uint64_t w = 0; w < BitmapWords; ++w)
+                present[w] |= bits[w];
+        }
+        const uint64_t start = chunk * ChunkSize;
+        const uint64_t end = std::min(size, start + ChunkSize);
+        uint64_t page = 0;
+        for (uint64_t addr = start; addr < end; addr += PageSize, ++page) {
+            const uint64_t len = std::min(PageSize, end - addr);
+            if (!(present[page / 64] & (1ULL << (page % 64))) &&
+                !isZero(pmem + addr, len)) {
+                memset(pmem + addr, 0, len);
+            }
+        }
+
+        for (const auto &file : chain)
+            file->inflate(chunk, dest, scratch[thread]);
+    });
+}
+
+#if defined(__linux__) && defined(__NR_userfaultfd)
+
+namespace
+{
+
+/** The lazy restores that are still serving faults. */
+std::mutex activeLock;
+std::vector<ChunkedStore::LazyRestore *> active;
+
+} // anonymous namespace
+
+ChunkedStore::LazyRestore *
+ChunkedStore::LazyRestore::create(const std::string &path, uint8_t *pmem,
+                                  uint64_t size)
+{
+    if (sysconf(_SC_PAGESIZE) != (long)PageSize ||
+        reinterpret_cast<uintptr_t>(pmem) % PageSize) {
+        return nullptr;
+    }
+
+    // Open the files first, so that a broken checkpoint is reported the
+    // same way as by an eager restore
+    auto chain = openChain(path, size);
+
+    int uffd = syscall(__NR_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+    if (uffd < 0)
+        return nullptr;
+
+    struct uffdio_api api;
+    memset(&api, 0, sizeof(api));
+    api.api = UFFD_API;
+    struct uffdio_register reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.range.start = reinterpret_cast<uintptr_t>(pmem);
+    reg.range.len = roundUp(size, PageSize);
+    reg.mode = UFFDIO_REGISTER_MODE_MISSING;
+    const uint64_t needed = (1ULL << _UFFDIO_COPY) |
+        (1ULL << _UFFDIO_ZEROPAGE) | (1ULL << _UFFDIO_WAKE);
+    if (ioctl(uffd, UFFDIO_API, &api) != 0 ||
+        ioctl(uffd, UFFDIO_REGISTER, &reg) != 0 ||
+        (reg.ioctls & needed) != needed) {
+        close(uffd);
+        return nullptr;
+    }
+
+    static std::once_flag fork_handler;
+    std::call_once(fork_handler, []() {
+        if (pthread_atfork(&LazyRestore::finishAll, nullptr, nullptr) != 0)
+            panic("Can't register the lazy restore fork handler\n");
+    });
+
+    LazyRestore *lazy = new LazyRestore(std::move(chain), pmem, size, uffd);
+    std::lock_guard<std::mutex> lock(activeLock);
+    active.push_back(lazy);
+    return lazy;
+}
+
+ChunkedStore::LazyRestore::LazyRestore(
+        std::vector<std::unique_ptr<File>> &&chain, uint8_t *pmem,
+        uint64_t size, int uffd)
+    : chain(std::move(chain)), pmem(pmem), size(size), uffd(uffd),
+      filled(divCeil(size, ChunkSize), false), chunkBuf(ChunkSize),
+      numFaults(0), numChunks(0), numOverwritten(0)
+{
+    if (pipe(stopPipe) != 0)
+        panic("Can't create a pipe: %s\n", strerror(errno));
+    helper = std::thread(&LazyRestore::serve, this);
+}
+
+ChunkedStore::LazyRestore::~LazyRestore()
+{
+    {
+        std::lock_guard<std::mutex> lock(activeLock);
+        active.erase(std::find(active.begin(), active.end(), this));
+    }
+
+    if (helper.joinable()) {
+        if (write(stopPipe[1], &Stop, 1) != 1) {
+            panic("Can't stop the lazy restore helper: %s\n",
+                  strerror(errno));
+        }
+        helper.join();
+        close(uffd);
+    }
+    close(stopPipe[0]);
+    close(stopPipe[1]);
+
+    DPRINTF(Checkpoint, "Lazy restore served %d faults and filled %d of "
+            "%d chunks\n", numFaults, numChunks, filled.size());
+}
+
+void
+ChunkedStore::LazyRestore::finish()
+{
+    if (!helper.joinable())
+        return;
+
+    if (write(stopPipe[1], &Finish, 1) != 1)
+        panic("Can't finish the lazy restore: %s\n", strerror(errno));
+    helper.join();
+
+    // Closing the userfaultfd unregisters the store, so the pages that
+    // are in no file now read as zero without a handler
+    close(uffd);
+    uffd = -1;
+
+    DPRINTF(Checkpoint, "Finished lazy restore before forking, %d pages "
+            "were overwritten\n", numOverwritten);
+}
+
+void
+ChunkedStore::LazyRestore::finishAll()
+{
+    std::lock_guard<std::mutex> lock(activeLock);
+    for (auto *lazy : active)
+        lazy->finish();
+}
+
+void
+ChunkedStore::LazyRestore::serve()
+{
+    struct pollfd fds[2];
+    fds[0].fd = uffd;
+    fds[0].events = POLLIN;
+    fds[1].fd = stopPipe[0];
+    fds[1].events = POLLIN;
+
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            panic("Lazy restore poll failed: %s\n", strerror(errno));
+        }
+        if (fds[1].revents) {
+            char cmd = Stop;
+            if (read(stopPipe[0], &cmd, 1) == 1 && cmd == Finish) {
+                for (uint64_t chunk = 0; chunk < filled.size(); ++chunk) {
+                    if (!filled[chunk])
+                        fillChunk(chunk);
+                }
+            }
+            return;
+        }
+        if (!(fds[0].revents & POLLIN))
+            continue;
+
+        struct uffd_msg msg;
+        if (read(uffd, &msg, sizeof(msg)) != sizeof(msg)) {
+            if (errno == EAGAIN || errno == EINTR)
+                continue;
+            panic("Lazy restore read failed: %s\n", strerror(errno));
+        }
+        if (msg.event == UFFD_EVENT_PAGEFAULT)
+            fault(msg.arg.pagefault.address -
+                  reinterpret_cast<uintptr_t>(pmem));
+    }
+}
+
+void
+ChunkedStore::LazyRestore::fault(uint64_t offset)
+{
+    ++numFaults;
+    const uint64_t page = offset / PageSize * PageSize;
+    const uint64_t chunk = offset / ChunkSize;
+    if (!filled[chunk])
+        fillChunk(chunk);
+
+    // The page is not in any file, or a second thread faulted on it
+    // while the chunk was filled; both leave the page ready after this.
+    struct uffdio_zeropage zero;
+    memset(&zero, 0, sizeof(zero));
+    zero.range.start = reinterpret_cast<uintptr_t>(pmem + page);
+    zero.range.len = PageSize;
+    zero.mode = UFFDIO_ZEROPAGE_MODE_DONTWAKE;
+    if (ioctl(uffd, UFFDIO_ZEROPAGE, &zero) != 0 && errno != EEXIST)
+        panic("Lazy restore zeropage failed: %s\n", strerror(errno));
+
+    struct uffdio_range wake;
+    wake.start = zero.range.start;
+    wake.len = PageSize;
+    if (ioctl(uffd, UFFDIO_WAKE, &wake) != 0)
+        panic("Lazy restore wake failed: %s\n", strerror(errno));
+}
+
+void
+ChunkedStore::LazyRestore::fillChunk(uint64_t chunk)
+{
+    ++numChunks;
+    filled[chunk] = true;
+
+    uint64_t present[BitmapWords] = {};
+    for (const auto &file : chain) {
+        uint64_t bits[BitmapWords];
+        file->bitmap(chunk, bits);
+        for (uint64_t w = 0; w < BitmapWords; ++w)
+            present[w] |= bits[w];
+        file->inflate(chunk, chunkBuf.data(), scratch);
+    }
+
+    // Copy every run of present pages with a single call
+    const uint64_t start = chunk * ChunkSize;
+    const uint64_t pages = divCeil(std::min(size - start, ChunkSize),
+                                   PageSize);
+    uint64_t page = 0;
+    while (page < pages) {
+        if (!(present[page / 64] & (1ULL << (page % 64)))) {
+            ++page;
+            continue;
+        }
+        uint64_t run = page;
+        while (run < pages && (present[run / 64] & (1ULL << (run % 64))))
+            ++run;
+
+        while (page < run) {
+            struct uffdio_copy copy;
+            memset(&copy, 0, sizeof(copy));
+            copy.dst = reinterpret_cast<uintptr_t>(pmem + start) +
+                page * PageSize;
+            copy.src = reinterpret_cast<uintptr_t>(chunkBuf.data()) +
+                page * PageSize;
+            copy.len = (run - page) * PageSize;
+            copy.mode = UFFDIO_COPY_MODE_DONTWAKE;
+            if (ioctl(uffd, UFFDIO_COPY, &copy) == 0) {
+                page = run;
+            } else if (copy.copy > 0) {
+                // Interrupted part way; carry on after the copied pages
+                page += copy.copy / PageSize;
+            } else if (errno == EEXIST) {
+                // The page was populated by other means before its
+                // chunk was filled, so it can't hold anything written by
+                // the simulation, which would have faulted; give it its
+                // contents from the checkpoint
+                memcpy(pmem + start + page * PageSize,
+                       chunkBuf.data() + page * PageSize, PageSize);
+                ++numOverwritten;
+                ++page;
+            } else {
+                panic("Lazy restore copy failed: %s\n", strerror(errno));
+            }
+        }
+    }
+
+    // Reset the buffer for the next chunk
+    memset(chunkBuf.data(), 0, chunkBuf.size());
+}
+
+#else
+
+ChunkedStore::LazyRestore *
+ChunkedStore::LazyRestore::create(const std::string &path, uint8_t *pmem,
+                                  uint64_t size)
+{
+    return nullptr;
+}
+
+ChunkedStore::LazyRestore::~LazyRestore()
+{
+}
+
+#endif
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file
+ * A checkpoint format for the backing store of PhysicalMemory that only
+ * contains the pages that matter, compressed in independent chunks.
+ *
+ * The store is cut in chunks of ChunkSize bytes. For every chunk the
+ * file holds a bitmap of the pages that are present and the deflated
+ * concatenation of those pages. In a full checkpoint the present pages
+ * are the pages that are not all zero; in a delta checkpoint they are
+ * the pages that changed since the parent checkpoint, which is restored
+ * first. The path of the parent is stored relative to the directory of
+ * the delta, so checkpoints can be moved together. Every file has a
+ * random id, which its deltas record, so a delta is never applied on
+ * top of some other file of the same name.
+ *
+ * As chunks are independent they are compressed and decompressed by a
+ * pool of threads, and a restore only writes the pages that are
+ * present or not zero yet, so untouched memory stays unallocated on
+ * the host. Where the host supports it, LazyRestore goes one step
+ * further and only inflates the chunks that the simulation touches.
+ *
+ * Layout, in host byte order:
+ *   Header
+ *   parent path (Header::parentLength bytes, no terminator)
+ *   compressed chunks
+ *   index: one IndexEntry and a page bitmap per chunk
+ */
+
+#ifndef __MEM_CHUNKED_STORE_HH__
+#define __MEM_CHUNKED_STORE_HH__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/sha256.hh"
+
+class ChunkedStore
+{
+  private:
+    class File;
+
+  public:
+    /** Granularity at which pages are stored or skipped. */
+    static const uint64_t PageSize = 4096;
+
+    /** Amount of memory covered by one compressed chunk. */
+    static const uint64_t ChunkSize = 1 << 20;
+
+    /**
+     * Hash of a page: its SHA-256 digest. A page whose hash hasn't
+     * changed is left out of a delta, so two versions of a page that
+     * collide silently restore the wrong data. Guest memory can hold
+     * anything, including inputs built to collide under a fast
+     * non-cryptographic hash, so only a collision resistant one is
+     * safe here. The digest is computed on the save threads alongside
+     * compression, which costs more.
+     */
+    typedef Sha256::Digest PageHash;
+
+    /**
+     * Hashes of the pages of a store as of its last save, used to find
+     * the pages a delta checkpoint has to contain.
+     */
+    typedef std::vector<PageHash> PageHashes;
+
+    /**
+     * Write a store to a file.
+     *
+     * @param path File to create.
+     * @param pmem Host memory of the store.
+     * @param size Size of the store in bytes.
+     * @param threads Number of compression threads; 0 for one per host
+     *                core.
+     * @param parent If not empty, write a delta against this earlier
+     *               checkpoint file of the same store. hashes must then
+     *               describe that checkpoint.
+     * @param hashes If not null, updated with the hashes of all pages.
+     */
+    static void save(const std::string &path, const uint8_t *pmem,
+                     uint64_t size, unsigned threads,
+                     const std::string &parent, PageHashes *hashes);
+
+    /**
+     * Restore a store from a file written by save(), restoring the
+     * chain of parents of a delta first. Pages that are in no file are
+     * cleared, as the memory may be backed by a shared file.
+     *
+     * @param path File to read.
+     * @param pmem Host memory of the store.
+     * @param size Size of the store in bytes; must match the file.
+     * @param threads Number of decompression threads; 0 for one per
+     *                host core.
+     */
+    static void restore(const std::string &path, uint8_t *pmem,
+                        uint64_t size, unsigned threads);
+
+    /**
+     * Restores a store on demand. The store is registered with the
+     * userfaultfd of the host, and a helper thread serves the faults:
+     * the first access to a chunk inflates the chunk from the file and
+     * its parents and fills the pages they contain, while pages that
+     * are in no file are filled with zeros on their first access. The
+     * store must stay mapped for as long as the object lives, and must
+     * not have been touched before.
+     *
+     * A forked child would inherit the store without its fault handler,
+     * so before the process forks, all chunks that have not been
+     * touched yet are restored and faults are no longer served.
+     */
+    class LazyRestore
+    {
+      public:
+        /**
+         * Start restoring a store on demand.
+         *
+         * @param path File to read.
+         * @param pmem Host memory of the store, page aligned.
+         * @param size Size of the store in bytes; must match the file.
+         * @return The restorer, or null if the host cannot fault in
+         *         memory on demand, in which case nothing is changed.
+         */
+        static LazyRestore *create(const std::string &path, uint8_t *pmem,
+                                   uint64_t size);
+
+        /** Stop serving faults; pages that were never touched stay
+         * unpopulated and read as zero. */
+        ~LazyRestore();
+
+      private:
+        LazyRestore(std::vector<std::unique_ptr<File>> &&chain,
+                    uint8_t *pmem, uint64_t size, int uffd);
+
+        /** Body of the helper thread. */
+        void serve();
+
+        /**
+         * Fill all chunks that have not been filled yet, and stop
+         * serving faults. Called before the process forks.
+         */
+        void finish();
+
+        /** Finish all lazy restores of the process; a fork handler. */
+        static void finishAll();
+
+        /** Resolve a fault at the given offset in the store. */
+        void fault(uint64_t offset);
+
+        /** Fill all pages of a chunk that are in a file. */
+        void fillChunk(uint64_t chunk);
+
+        /** Checkpoint file and its parents, oldest first. */
+        std::vector<std::unique_ptr<File>> chain;
+
+        uint8_t *pmem;
+        uint64_t size;
+
+        /**
+         * The userfaultfd and a pipe used to stop the helper, which
+         * fills the remaining chunks first if it reads Finish from it.
+         */
+        int uffd;
+        int stopPipe[2];
+
+        static const char Stop = 0;
+        static const char Finish = 1;
+
+        /** Chunks that have already been filled. */
+        std::vector<bool> filled;
+
+        /** A chunk as inflated from the files, and inflate scratch. */
+        std::vector<uint8_t> chunkBuf;
+        std::vector<uint8_t> scratch;
+
+        uint64_t numFaults;
+        uint64_t numChunks;
+
+        /** Pages that already existed when their chunk was filled. */
+        uint64_t numOverwritten;
+
+        std::thread helper;
+    };
+
+  private:
+    /**
+     * Open a checkpoint file and the chain of its parents.
+     *
+     * @return The files, oldest parent first.
+     */
+    static std::vector<std::unique_ptr<File>> openChain(
+        const std::string &path, uint64_t size);
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t pageSize;
+        uint64_t chunkSize;
+        uint64_t storeSize;
+        uint64_t numChunks;
+        uint64_t indexOffset;
+        uint64_t parentLength;
+        /** Random id of this file, and of its parent if any. */
+        uint64_t id;
+        uint64_t parentId;
+    };
+
+    struct IndexEntry
+    {
+        /** File offset of the compressed pages. */
+        uint64_t offset;
+        /** Size of the compressed pages; 0 if no page is present. */
+        uint64_t compressedSize;
+    };
+
+    static const char Magic[8];
+    static const uint32_t Version = 2;
+
+    /** Number of 64-bit words in the page bitmap of a chunk. */
+    static const uint64_t BitmapWords = ChunkSize / PageSize / 64;
+};
+
+#endif // __MEM_CHUNKED_STORE_HH__
@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mem/chunked_store.hh"
+
+namespace {
+
+const uint64_t PageSize = ChunkedStore::PageSize;
+const uint64_t ChunkSize = ChunkedStore::ChunkSize;
+
+/** Three chunks and a bit, so the last chunk and page are partial. */
+const uint64_t StoreSize = 3 * ChunkSize + 5 * PageSize + 100;
+
+class ChunkedStoreTest : public ::testing::Test
+{
+  protected:
+    void
+    SetUp() override
+    {
+        char dir[] = "chunked_store-XXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(dir));
+        tmpdir = dir;
+    }
+
+    void
+    TearDown() override
+    {
+        for (const auto &file : files)
+            unlink(file.c_str());
+        rmdir(tmpdir.c_str());
+    }
+
+    /** A file in the temporary directory, removed after the test. */
+    std::string
+    file(const std::string &name)
+    {
+        files.push_back(tmpdir + "/" + name);
+        return files.back();
+    }
+
+    /** The size of a file in bytes. */
+    static uint64_t
+    fileSize(const std::string &path)
+    {
+        struct stat st;
+        EXPECT_EQ(0, stat(path.c_str(), &st));
+        return st.st_size;
+    }
+
+    /** Restore a store into memory that starts out full of garbage. */
+    static std::vector<uint8_t>
+    restore(const std::string &path, uint64_t size=StoreSize)
+    {
+        std::vector<uint8_t> mem(size, 0xa5);
+        ChunkedStore::restore(path, mem.data(), size, 3);
+        return mem;
+    }
+
+    /** Fill a page, or the part of it that is in the store. */
+    void
+    fillPage(std::vector<uint8_t> &mem, uint64_t page)
+    {
+        const uint64_t start = page * PageSize;
+        const uint64_t end = std::min<uint64_t>(mem.size(), start + PageSize);
+        for (uint64_t addr = start; addr < end; ++addr)
+            mem[addr] = rng();
+    }
+
+    /** Fill a store with random data. */
+    void
+    fill(std::vector<uint8_t> &mem)
+    {
+        for (auto &byte : mem)
+            byte = rng();
+    }
+
+    std::mt19937 rng;
+    std::string tmpdir;
+    std::vector<std::string> files;
+};
+
+} // anonymous namespace
+
+TEST_F(ChunkedStoreTest, SaveRestore)
+{
+    std::vector<uint8_t> mem(StoreSize);
+    fill(mem);
+    const std::string path = file("full");
+    ChunkedStore::save(path, mem.data(), StoreSize, 2, "", nullptr);
+    EXPECT_EQ(mem, restore(path));
+}
+
+TEST_F(ChunkedStoreTest, AllZero)
+{
+    const std::vector<uint8_t> mem(StoreSize, 0);
+    const std::string path = file("zero");
+    ChunkedStore::save(path, mem.data(), StoreSize, 2, "", nullptr);
+
+    // No page is stored, and all pages are cleared on restore
+    EXPECT_LT(fileSize(path), PageSize);
+    EXPECT_EQ(mem, restore(path));
+}
+
+TEST_F(ChunkedStoreTest, Sparse)
+{
+    std::vector<uint8_t> mem(StoreSize, 0);
+    const uint64_t num_pages = (StoreSize + PageSize - 1) / PageSize;
+    const uint64_t pages[] = { 0, 1, 255, 256, 600, num_pages - 1 };
+    for (auto page : pages)
+        fillPage(mem, page);
+    mem[700 * PageSize + 17] = 1;
+
+    const std::string path = file("sparse");
+    ChunkedStore::PageHashes hashes;
+    ChunkedStore::save(path, mem.data(), StoreSize, 2, "", &hashes);
+    EXPECT_EQ(num_pages, hashes.size());
+    EXPECT_LT(fileSize(path), 8 * PageSize);
+    EXPECT_EQ(mem, restore(path));
+}
+
+TEST_F(ChunkedStoreTest, Delta)
+{
+    std::vector<uint8_t> mem(StoreSize);
+    fill(mem);
+    const std::string base = file("base");
+    ChunkedStore::PageHashes hashes;
+    ChunkedStore::save(base, mem.data(), StoreSize, 2, "", &hashes);
+    const std::vector<uint8_t> before = mem;
+
+    // Change a few pages, clear one, and change a single byte of another
+    fillPage(mem, 3);
+    fillPage(mem, 512);
+    std::fill(mem.begin() + 10 * PageSize, mem.begin() + 11 * PageSize, 0);
+    mem[StoreSize - 1] ^= 0xff;
+
+    const std::string delta = file("delta");
+    ChunkedStore::save(delta, mem.data(), StoreSize, 2, base, &hashes);
+    EXPECT_LT(fileSize(delta), 8 * PageSize);
+    EXPECT_EQ(mem, restore(delta));
+    EXPECT_EQ(before, restore(base));
+
+    // A delta of an unchanged store holds no pages
+    const std::string same = file("same");
+    ChunkedStore::save(same, mem.data(), StoreSize, 2, delta, &hashes);
+    EXPECT_LT(fileSize(same), PageSize);
+    EXPECT_EQ(mem, restore(same));
+}
+
+TEST_F(ChunkedStoreTest, DeltaChain)
+{
+    std::vector<uint8_t> mem(StoreSize, 0);
+    fillPage(mem, 7);
+    ChunkedStore::PageHashes hashes;
+    std::vector<std::string> paths;
+    std::vector<std::vector<uint8_t>> versions;
+    for (int i = 0; i < 5; ++i) {
+        const std::string parent = paths.empty() ? "" : paths.back();
+        paths.push_back(file("cpt" + std::to_string(i)));
+        ChunkedStore::save(paths.back(), mem.data(), StoreSize, 2, parent,
+                           &hashes);
+        versions.push_back(mem);
+
+        // Each version changes some pages and clears one of the last
+        fillPage(mem, 100 * i + 1);
+        fillPage(mem, 300 + i);
+        std::fill(mem.begin() + (300 + i - 1) * PageSize,
+                  mem.begin() + (300 + i) * PageSize, 0);
+    }
+
+    for (int i = 0; i < 5; ++i)
+        EXPECT_EQ(versions[i], restore(paths[i])) << "Version " << i;
+}
+
+TEST_F(ChunkedStoreTest, ParentMismatch)
+{
+    std::vector<uint8_t> mem(StoreSize);
+    fill(mem);
+    const std::string base = file("base");
+    ChunkedStore::PageHashes hashes;
+    ChunkedStore::save(base, mem.data(), StoreSize, 2, "", &hashes);
+    fillPage(mem, 42);
+    const std::string delta = file("delta");
+    ChunkedStore::save(delta, mem.data(), StoreSize, 2, base, &hashes);
+
+    // A new checkpoint in place of the parent must not be mistaken for it
+    ChunkedStore::save(base, mem.data(), StoreSize, 2, "", nullptr);
+    EXPECT_ANY_THROW(restore(delta));
+}
+
+TEST_F(ChunkedStoreTest, SizeMismatch)
+{
+    std::vector<uint8_t> mem(StoreSize);
+    fill(mem);
+    const std::string path = file("full");
+    ChunkedStore::PageHashes hashes;
+    ChunkedStore::save(path, mem.data(), StoreSize, 2, "", &hashes);
+    EXPECT_ANY_THROW(restore(path, StoreSize - PageSize));
+    EXPECT_ANY_THROW(restore(path, StoreSize + 1));
+
+    // Nor can a delta be taken against a store of another size
+    std::vector<uint8_t> small(StoreSize - PageSize);
+    ChunkedStore::PageHashes small_hashes(
+        (small.size() + PageSize - 1) / PageSize);
+    EXPECT_ANY_THROW(ChunkedStore::save(file("delta"), small.data(),
+                                        small.size(), 2, path,
+                                        &small_hashes));
+}
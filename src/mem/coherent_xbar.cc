@@ -605,6 +605,10 @@ CoherentXBar::recvTimingSnoopResp(PacketPtr pkt, PortID cpu_side_port_id)
     DPRINTF(CoherentXBar, "%s: src %s packet %s\n", __func__,
             src_port->name(), pkt->print());
 
+    // remove the request from the routing table before forwarding the
+    // packet, as that could add routes and invalidate the iterator
+    routeTo.erase(route_lookup);
+
     // store size and command as they might be modified when
     // forwarding the packet
     unsigned int pkt_size = pkt->hasData() ? pkt->getSize() : 0;
@@ -679,9 +683,6 @@ CoherentXBar::recvTimingSnoopResp(PacketPtr pkt, PortID cpu_side_port_id)
         respLayers[dest_port_id]->succeededTiming(packetFinishTime);
     }
 
-    // remove the request from the routing table
-    routeTo.erase(route_lookup);
-
     // stats updates
     transDist[pkt_cmd]++;
     snoops++;
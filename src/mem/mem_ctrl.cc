@@ -154,6 +154,18 @@ MemCtrl::recvAtomic(PacketPtr pkt)
     return latency;
 }
 
+Tick
+MemCtrl::recvAtomicBackdoor(PacketPtr pkt, MemBackdoorPtr &backdoor)
+{
+    Tick latency = recvAtomic(pkt);
+    if (dram && dram->getAddrRange().contains(pkt->getAddr())) {
+        dram->getBackdoor(backdoor);
+    } else if (nvm && nvm->getAddrRange().contains(pkt->getAddr())) {
+        nvm->getBackdoor(backdoor);
+    }
+    return latency;
+}
+
 bool
 MemCtrl::readQueueFull(unsigned int neededEntries) const
 {
@@ -1461,6 +1473,13 @@ MemCtrl::MemoryPort::recvAtomic(PacketPtr pkt)
     return ctrl.recvAtomic(pkt);
 }
 
+Tick
+MemCtrl::MemoryPort::recvAtomicBackdoor(
+        PacketPtr pkt, MemBackdoorPtr &backdoor)
+{
+    return ctrl.recvAtomicBackdoor(pkt, backdoor);
+}
+
 bool
 MemCtrl::MemoryPort::recvTimingReq(PacketPtr pkt)
 {
@@ -252,6 +252,8 @@ class MemCtrl : public QoS::MemCtrl
       protected:
 
         Tick recvAtomic(PacketPtr pkt);
+        Tick recvAtomicBackdoor(
+                PacketPtr pkt, MemBackdoorPtr &backdoor) override;
 
         void recvFunctional(PacketPtr pkt);
 
@@ -701,6 +703,7 @@ class MemCtrl : public QoS::MemCtrl
   protected:
 
     Tick recvAtomic(PacketPtr pkt);
+    Tick recvAtomicBackdoor(PacketPtr pkt, MemBackdoorPtr &backdoor);
     void recvFunctional(PacketPtr pkt);
     bool recvTimingReq(PacketPtr pkt);
 
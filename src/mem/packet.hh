@@ -56,6 +56,7 @@
 #include "base/compiler.hh"
 #include "base/flags.hh"
 #include "base/logging.hh"
+#include "base/pool_alloc.hh"
 #include "base/printable.hh"
 #include "base/types.hh"
 #include "mem/htm.hh"
@@ -313,8 +314,9 @@ class Packet : public Printable
         /// when the packet is destroyed?
         STATIC_DATA            = 0x00001000,
         /// The data pointer points to a value that should be freed when
-        /// the packet is destroyed. The pointer is assumed to be pointing
-        /// to an array, and delete [] is consequently called
+        /// the packet is destroyed. Unless it is the packet's inline
+        /// storage, the pointer is assumed to be pointing to an array,
+        /// and delete [] is consequently called
         DYNAMIC_DATA           = 0x00002000,
 
         /// suppress the error if this packet encounters a functional
@@ -349,6 +351,13 @@ class Packet : public Printable
     */
     PacketDataPtr data;
 
+    /// Largest payload stored in the packet itself by allocate()
+    static const unsigned InlineDataSize = 64;
+
+    /// Storage for payloads of up to InlineDataSize bytes, so that
+    /// packets of up to a cache line do not allocate their data.
+    alignas(16) uint8_t inlineData[InlineDataSize];
+
     /// The address of the request.  This address could be virtual or
     /// physical, depending on the system configuration.
     Addr addr;
@@ -433,6 +442,12 @@ class Packet : public Printable
         SenderState* predecessor;
         SenderState() : predecessor(NULL) {}
         virtual ~SenderState() {}
+
+        /** Sender states are allocated from per-thread free lists. */
+        static void *operator new(size_t size)
+        { return PoolAlloc::allocate(size); }
+        static void operator delete(void *p, size_t size)
+        { PoolAlloc::release(p, size); }
     };
 
     /**
@@ -996,6 +1011,22 @@ class Packet : public Printable
         deleteData();
     }
 
+    /**
+     * Packets are allocated from per-thread free lists, so creating
+     * and deleting one does not reach malloc in steady state.
+     */
+    static void *
+    operator new(size_t size)
+    {
+        return PoolAlloc::allocate(size);
+    }
+
+    static void
+    operator delete(void *p, size_t size)
+    {
+        PoolAlloc::release(p, size);
+    }
+
     /**
      * Take a request packet and modify it in place to be suitable for
      * returning as a response to that request.
@@ -1287,7 +1318,7 @@ class Packet : public Printable
     void
     deleteData()
     {
-        if (flags.isSet(DYNAMIC_DATA))
+        if (flags.isSet(DYNAMIC_DATA) && data != inlineData)
             delete [] data;
 
         flags.clear(STATIC_DATA|DYNAMIC_DATA);
@@ -1303,7 +1334,10 @@ class Packet : public Printable
         if (hasData() || hasRespData()) {
             assert(flags.noneSet(STATIC_DATA|DYNAMIC_DATA));
             flags.set(DYNAMIC_DATA);
-            data = new uint8_t[getSize()];
+            if (getSize() <= InlineDataSize)
+                data = inlineData;
+            else
+                data = new uint8_t[getSize()];
         }
     }
 
@@ -43,6 +43,7 @@
 #include "base/trace.hh"
 #include "debug/Drain.hh"
 #include "debug/PacketQueue.hh"
+#include "sim/sim_object.hh"
 
 PacketQueue::PacketQueue(EventManager& _em, const std::string& _label,
                          const std::string& _sendEventName,
@@ -59,6 +60,45 @@ PacketQueue::~PacketQueue()
 {
 }
 
+void
+PacketQueue::DeferredPacketList::grow()
+{
+    std::vector<DeferredPacket> new_slots(2 * slots.size());
+    for (size_t i = 0; i < count; ++i)
+        new_slots[i] = slot(i);
+    slots.swap(new_slots);
+    head = 0;
+}
+
+void
+PacketQueue::DeferredPacketList::insert(size_t idx, const DeferredPacket &dp)
+{
+    assert(idx <= count);
+    if (count == slots.size())
+        grow();
+
+    // move the packets after the insertion point back by one
+    for (size_t i = count; i > idx; --i)
+        slot(i) = slot(i - 1);
+    slot(idx) = dp;
+    ++count;
+}
+
+void
+PacketQueue::regProbePoint(SimObject &owner, const std::string &queue_name)
+{
+    const std::string &prefix = owner.name();
+    std::string point_name = queue_name;
+    if (queue_name.compare(0, prefix.size(), prefix) == 0 &&
+        queue_name.size() > prefix.size() + 1 &&
+        queue_name[prefix.size()] == '.') {
+        point_name = queue_name.substr(prefix.size() + 1);
+    }
+
+    ppInsert.reset(new ProbePointArg<InsertInfo>(owner.getProbeManager(),
+                                                 point_name));
+}
+
 void
 PacketQueue::retry()
 {
@@ -73,8 +113,8 @@ PacketQueue::checkConflict(const PacketPtr pkt, const int blk_size) const
 {
     // caller is responsible for ensuring that all packets have the
     // same alignment
-    for (const auto& p : transmitList) {
-        if (p.pkt->matchBlockAddr(pkt, blk_size))
+    for (size_t i = 0; i < transmitList.size(); ++i) {
+        if (transmitList[i].pkt->matchBlockAddr(pkt, blk_size))
             return true;
     }
     return false;
@@ -85,13 +125,13 @@ PacketQueue::trySatisfyFunctional(PacketPtr pkt)
 {
     pkt->pushLabel(label);
 
-    auto i = transmitList.begin();
+    size_t i = 0;
     bool found = false;
 
-    while (!found && i != transmitList.end()) {
+    while (!found && i != transmitList.size()) {
         // If the buffered packet contains data, and it overlaps the
         // current packet, then update data
-        found = pkt->trySatisfyFunctional(i->pkt);
+        found = pkt->trySatisfyFunctional(transmitList[i].pkt);
         ++i;
     }
 
@@ -128,24 +168,46 @@ PacketQueue::schedSendTiming(PacketPtr pkt, Tick when)
     // ourselves again before we had a chance to update waitingOnRetry
     // assert(waitingOnRetry || sendEvent.scheduled());
 
-    // this belongs in the middle somewhere, so search from the end to
-    // order by tick; however, if forceOrder is set, also make sure
-    // not to re-order in front of some existing packet with the same
-    // address
-    auto it = transmitList.end();
-    while (it != transmitList.begin()) {
-        --it;
-        if ((forceOrder && it->pkt->matchAddr(pkt)) || it->tick <= when) {
-            // emplace inserts the element before the position pointed to by
-            // the iterator, so advance it one step
-            transmitList.emplace(++it, when, pkt);
-            return;
+    // the packet goes after the last one that is sent no later than
+    // it; however, if forceOrder is set, also make sure not to
+    // re-order in front of some existing packet with the same address
+    size_t pos = transmitList.size();
+    if (pos != 0 && transmitList.back().tick > when) {
+        if (forceOrder) {
+            // the list is not necessarily sorted by tick, search from
+            // the end
+            while (pos != 0 && !transmitList[pos - 1].pkt->matchAddr(pkt) &&
+                   transmitList[pos - 1].tick > when) {
+                --pos;
+            }
+        } else {
+            // the list is sorted by tick, so find the first packet sent
+            // later than this one
+            size_t lo = 0;
+            while (lo < pos) {
+                const size_t mid = lo + (pos - lo) / 2;
+                if (transmitList[mid].tick <= when)
+                    lo = mid + 1;
+                else
+                    pos = mid;
+            }
         }
     }
-    // either the packet list is empty or this has to be inserted
-    // before every other packet
-    transmitList.emplace_front(when, pkt);
-    schedSendEvent(when);
+
+    if (pos == transmitList.size())
+        transmitList.push_back(DeferredPacket(when, pkt));
+    else
+        transmitList.insert(pos, DeferredPacket(when, pkt));
+
+    if (ppInsert) {
+        ppInsert->notify(InsertInfo{*this, pkt, when, transmitList.size(),
+                                    transmitList.size() - 1 - pos});
+    }
+
+    // the packet has to be sent before every other packet, including
+    // the case of an empty list
+    if (pos == 0)
+        schedSendEvent(when);
 }
 
 void
@@ -210,7 +272,7 @@ PacketQueue::sendDeferredPacket()
         schedSendEvent(deferredPacketReadyTime());
     } else {
         // put the packet back at the front of the list
-        transmitList.emplace_front(dp);
+        transmitList.push_front(dp);
     }
 }
 
@@ -237,6 +299,7 @@ ReqPacketQueue::ReqPacketQueue(EventManager& _em, RequestPort& _mem_side_port,
     : PacketQueue(_em, _label, name(_mem_side_port, _label)),
       memSidePort(_mem_side_port)
 {
+    regProbePoint(memSidePort.getOwner(), name(memSidePort, label));
 }
 
 bool
@@ -252,6 +315,7 @@ SnoopRespPacketQueue::SnoopRespPacketQueue(EventManager& _em,
     : PacketQueue(_em, _label, name(_mem_side_port, _label), force_order),
       memSidePort(_mem_side_port)
 {
+    regProbePoint(memSidePort.getOwner(), name(memSidePort, label));
 }
 
 bool
@@ -267,6 +331,7 @@ RespPacketQueue::RespPacketQueue(EventManager& _em,
     : PacketQueue(_em, _label, name(_cpu_side_port, _label), force_order),
       cpuSidePort(_cpu_side_port)
 {
+    regProbePoint(cpuSidePort.getOwner(), name(cpuSidePort, label));
 }
 
 bool
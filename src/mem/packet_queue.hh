@@ -49,11 +49,13 @@
  * for the flow control of the port.
  */
 
-#include <list>
+#include <memory>
+#include <vector>
 
 #include "mem/port.hh"
 #include "sim/drain.hh"
 #include "sim/eventq.hh"
+#include "sim/probe/probe.hh"
 
 /**
  * A packet queue is a class that holds deferred packets and later
@@ -61,22 +63,114 @@
  */
 class PacketQueue : public Drainable
 {
+  public:
+    /** Information about a packet added to a queue, passed to probes. */
+    struct InsertInfo
+    {
+        const PacketQueue &queue; ///< The queue the packet was added to
+        const PacketPtr pkt;      ///< The packet
+        const Tick when;          ///< The tick to send the packet at
+        const size_t size;        ///< Packets in the queue, including pkt
+        const size_t depth;       ///< Packets queued to be sent after pkt
+    };
+
   private:
     /** A deferred packet, buffered to transmit later. */
     class DeferredPacket {
       public:
         Tick tick;      ///< The tick when the packet is ready to transmit
         PacketPtr pkt;  ///< Pointer to the packet to transmit
+        DeferredPacket() : tick(0), pkt(nullptr) {}
         DeferredPacket(Tick t, PacketPtr p)
             : tick(t), pkt(p)
         {}
     };
 
-    typedef std::list<DeferredPacket> DeferredPacketList;
+    /**
+     * The deferred packets, in send order, stored in a ring buffer.
+     * The buffer grows to the largest size the queue reaches and is
+     * then reused, so queueing a packet does not allocate. Adding at
+     * either end is O(1). Adding in the middle moves the packets that
+     * are sent after the new one.
+     */
+    class DeferredPacketList
+    {
+      private:
+        /** The slots, a power of two of them */
+        std::vector<DeferredPacket> slots;
+        /** Slot of the first packet */
+        size_t head;
+        /** Number of packets */
+        size_t count;
+
+        DeferredPacket &
+        slot(size_t idx)
+        {
+            return slots[(head + idx) & (slots.size() - 1)];
+        }
+
+        const DeferredPacket &
+        slot(size_t idx) const
+        {
+            return slots[(head + idx) & (slots.size() - 1)];
+        }
+
+        /** Double the number of slots */
+        void grow();
+
+      public:
+        DeferredPacketList() : slots(16), head(0), count(0) {}
+
+        bool empty() const { return count == 0; }
+        size_t size() const { return count; }
+
+        DeferredPacket &operator[](size_t idx) { return slot(idx); }
+        const DeferredPacket &
+        operator[](size_t idx) const
+        {
+            return slot(idx);
+        }
+
+        DeferredPacket &front() { return slot(0); }
+        const DeferredPacket &front() const { return slot(0); }
+        const DeferredPacket &back() const { return slot(count - 1); }
+
+        void
+        push_front(const DeferredPacket &dp)
+        {
+            if (count == slots.size())
+                grow();
+            head = (head - 1) & (slots.size() - 1);
+            slots[head] = dp;
+            ++count;
+        }
+
+        void
+        push_back(const DeferredPacket &dp)
+        {
+            if (count == slots.size())
+                grow();
+            slot(count++) = dp;
+        }
+
+        void
+        pop_front()
+        {
+            assert(count > 0);
+            head = (head + 1) & (slots.size() - 1);
+            --count;
+        }
+
+        /** Insert a packet so that it is at position idx */
+        void insert(size_t idx, const DeferredPacket &dp);
+    };
 
     /** A list of outgoing packets. */
     DeferredPacketList transmitList;
 
+    /** Probe notified of every packet added to the queue */
+    std::unique_ptr<ProbePointArg<InsertInfo>> ppInsert;
+
     /** The manager which is used for the event queue */
     EventManager& em;
 
@@ -148,6 +242,18 @@ class PacketQueue : public Drainable
      */
     virtual ~PacketQueue();
 
+    /**
+     * Register the probe point of this queue with the object owning it.
+     * The probe is named after the queue, without the name of the
+     * owner, e.g. "cpu_side_port-RespPacketQueue". It is notified with
+     * an InsertInfo for every packet added to the queue, which shows
+     * how full the queue is and how far from its end the packet went.
+     *
+     * @param owner The object owning the port of this queue
+     * @param queue_name The full name of this queue
+     */
+    void regProbePoint(SimObject &owner, const std::string &queue_name);
+
   public:
 
     /**
@@ -72,10 +72,20 @@ using namespace std;
 PhysicalMemory::PhysicalMemory(const string& _name,
                                const vector<AbstractMemory*>& _memories,
                                bool mmap_using_noreserve,
-                               const std::string& shared_backstore) :
+                               const std::string& shared_backstore,
+                               bool chunked_checkpoints,
+                               bool delta_checkpoints,
+                               unsigned checkpoint_threads,
+                               bool lazy_restore) :
     _name(_name), size(0), mmapUsingNoReserve(mmap_using_noreserve),
-    sharedBackstore(shared_backstore)
+    sharedBackstore(shared_backstore),
+    chunkedCheckpoints(chunked_checkpoints),
+    deltaCheckpoints(delta_checkpoints),
+    checkpointThreads(checkpoint_threads), lazyRestore(lazy_restore)
 {
+    fatal_if(delta_checkpoints && !chunked_checkpoints,
+             "Delta memory checkpoints require the chunked format\n");
+
     if (mmap_using_noreserve)
         warn("Not reserving swap space. May cause SIGSEGV on actual usage\n");
 
@@ -243,6 +253,9 @@ PhysicalMemory::createBackingStore(AddrRange range,
 
 PhysicalMemory::~PhysicalMemory()
 {
+    // stop serving faults before the memory goes away
+    lazyRestores.clear();
+
     // unmap the backing store
     for (auto& s : backingStore)
         munmap((char*)s.pmem, s.range.size());
@@ -330,6 +343,9 @@ PhysicalMemory::serialize(CheckpointOut &cp) const
     unsigned int nbr_of_stores = backingStore.size();
     SERIALIZE_SCALAR(nbr_of_stores);
 
+    pageHashes.resize(nbr_of_stores);
+    lastCheckpoint.resize(nbr_of_stores);
+
     unsigned int store_id = 0;
     // store each backing store memory segment in a file
     for (auto& s : backingStore) {
@@ -345,6 +361,8 @@ PhysicalMemory::serializeStore(CheckpointOut &cp, unsigned int store_id,
     // we cannot use the address range for the name as the
     // memories that are not part of the address map can overlap
     string filename = name() + ".store" + to_string(store_id) + ".pmem";
+    if (chunkedCheckpoints)
+        filename += "c";
     long range_size = range.size();
 
     DPRINTF(Checkpoint, "Serializing physical memory %s with size %d\n",
@@ -356,6 +374,21 @@ PhysicalMemory::serializeStore(CheckpointOut &cp, unsigned int store_id,
 
     // write memory file
     string filepath = CheckpointIn::dir() + "/" + filename.c_str();
+
+    if (chunkedCheckpoints) {
+        string store_format = "chunked";
+        SERIALIZE_SCALAR(store_format);
+
+        string parent;
+        if (deltaCheckpoints)
+            parent = lastCheckpoint[store_id];
+        ChunkedStore::save(filepath, pmem, range.size(), checkpointThreads,
+                           parent,
+                           deltaCheckpoints ? &pageHashes[store_id] :
+                           nullptr);
+        lastCheckpoint[store_id] = filepath;
+        return;
+    }
     gzFile compressed_mem = gzopen(filepath.c_str(), "wb");
     if (compressed_mem == NULL)
         fatal("Can't open physical memory checkpoint file '%s'\n",
@@ -421,6 +454,42 @@ PhysicalMemory::unserializeStore(CheckpointIn &cp)
     UNSERIALIZE_SCALAR(filename);
     string filepath = cp.getCptDir() + "/" + filename;
 
+    string store_format = "gzip";
+    UNSERIALIZE_OPT_SCALAR(store_format);
+    if (store_format == "chunked") {
+        long range_size;
+        UNSERIALIZE_SCALAR(range_size);
+
+        DPRINTF(Checkpoint, "Unserializing physical memory %s with size %d\n",
+                filename, range_size);
+
+        if (range_size != backingStore[store_id].range.size())
+            fatal("Memory range size has changed! Saw %lld, expected %lld\n",
+                  range_size, backingStore[store_id].range.size());
+
+        // A shared backing store may hold stale data, which faults
+        // would not be taken for
+        if (lazyRestore && sharedBackstore.empty()) {
+            ChunkedStore::LazyRestore *lazy =
+                ChunkedStore::LazyRestore::create(
+                    filepath, backingStore[store_id].pmem,
+                    backingStore[store_id].range.size());
+            if (lazy) {
+                lazyRestores.emplace_back(lazy);
+                return;
+            }
+            warn_once("Host cannot fault in memory on demand, restoring "
+                      "physical memory eagerly\n");
+        }
+        ChunkedStore::restore(filepath, backingStore[store_id].pmem,
+                              backingStore[store_id].range.size(),
+                              checkpointThreads);
+        return;
+    } else if (store_format != "gzip") {
+        fatal("Unknown physical memory checkpoint format '%s'\n",
+              store_format);
+    }
+
     // mmap memoryfile
     gzFile compressed_mem = gzopen(filepath.c_str(), "rb");
     if (compressed_mem == NULL)
@@ -39,6 +39,7 @@
 #define __MEM_PHYSICAL_HH__
 
 #include "base/addr_range_map.hh"
+#include "mem/chunked_store.hh"
 #include "mem/packet.hh"
 
 /**
@@ -129,6 +130,31 @@ class PhysicalMemory : public Serializable
 
     const std::string sharedBackstore;
 
+    // Write memory checkpoints with ChunkedStore rather than gzip
+    const bool chunkedCheckpoints;
+
+    // Only store the pages that changed since the previous chunked
+    // checkpoint taken by this simulation
+    const bool deltaCheckpoints;
+
+    // Number of threads compressing a chunked checkpoint, 0 for one
+    // per host core
+    const unsigned checkpointThreads;
+
+    // Fill the memory from a chunked checkpoint on first access
+    // rather than when restoring
+    const bool lazyRestore;
+
+    // Restorers serving the faults of lazily restored backing stores
+    std::vector<std::unique_ptr<ChunkedStore::LazyRestore>> lazyRestores;
+
+    // Page hashes of each backing store as of the previous chunked
+    // checkpoint, used to find the pages of a delta checkpoint
+    mutable std::vector<ChunkedStore::PageHashes> pageHashes;
+
+    // File of the previous chunked checkpoint of each backing store
+    mutable std::vector<std::string> lastCheckpoint;
+
     // The physical memory used to provide the memory in the simulated
     // system
     std::vector<BackingStoreEntry> backingStore;
@@ -161,7 +187,11 @@ class PhysicalMemory : public Serializable
     PhysicalMemory(const std::string& _name,
                    const std::vector<AbstractMemory*>& _memories,
                    bool mmap_using_noreserve,
-                   const std::string& shared_backstore);
+                   const std::string& shared_backstore,
+                   bool chunked_checkpoints = false,
+                   bool delta_checkpoints = false,
+                   unsigned checkpoint_threads = 0,
+                   bool lazy_restore = false);
 
     /**
      * Unmap all the backing store we have used.
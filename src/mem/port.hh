@@ -87,6 +87,9 @@ class RequestPort: public Port, public AtomicRequestProtocol,
                PortID id=InvalidPortID);
     virtual ~RequestPort();
 
+    /** Get the object that owns this port. */
+    SimObject &getOwner() const { return owner; }
+
     /**
      * Bind this request port to a response port. This also does the
      * mirror action and binds the response port to the request port.
@@ -280,6 +283,9 @@ class ResponsePort : public Port, public AtomicResponseProtocol,
               PortID id=InvalidPortID);
     virtual ~ResponsePort();
 
+    /** Get the object that owns this port. */
+    SimObject &getOwner() const { return owner; }
+
     /**
      * Find out if the peer request port is snooping or not.
      *
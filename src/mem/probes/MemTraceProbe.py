@@ -41,7 +41,8 @@ class MemTraceProbe(BaseMemProbe):
     type = 'MemTraceProbe'
     cxx_header = "mem/probes/mem_trace.hh"
 
-    # Boolean to compress the trace or not.
+    # Boolean to compress the trace or not. Chunked traces, with a .ctr
+    # suffix, are always compressed.
     trace_compress = Param.Bool(True, "Enable trace compression")
 
     # For requests with a valid PC, include the PC in the trace
@@ -59,3 +59,14 @@ class StackDistProbe(BaseMemProbe):
     # logarithmic histogram bins and enable/disable
     log_hist_bins = Param.Unsigned('32', "Bins in logarithmic histograms")
     disable_log_hists = Param.Bool(False, "Disable logarithmic histograms")
+
+    # SHARDS-style sampling, tracking only the lines whose address hash
+    # falls under the rate and scaling their distances by its inverse
+    sample_rate = Param.Float(1.0, "Fraction of the cache lines to track")
+
+    # miss-ratio curves, with one point per bin of the logarithmic
+    # histograms, for the whole stream and for parts of it
+    regions = VectorParam.AddrRange([], "Address ranges to report "
+                                    "separate miss-ratio curves for")
+    pc_curves = Param.Unsigned(0, "Number of PCs, with the most accesses, "
+                               "to report separate miss-ratio curves for")
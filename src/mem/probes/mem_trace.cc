@@ -57,8 +57,8 @@ MemTraceProbe::MemTraceProbe(MemTraceProbeParams *p)
 
         const std::string suffix = ".gz";
         // If trace_compress has been set, check the suffix. Append
-        // accordingly.
-        if (p->trace_compress &&
+        // accordingly. Chunked traces do their own compression.
+        if (p->trace_compress && !ProtoOutputStream::isChunked(filename) &&
             filename.compare(filename.size() - suffix.size(), suffix.size(),
                              suffix) != 0)
             filename = filename + suffix;
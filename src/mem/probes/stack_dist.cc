@@ -37,6 +37,9 @@
 
 #include "mem/probes/stack_dist.hh"
 
+#include <algorithm>
+#include <functional>
+
 #include "params/StackDistProbe.hh"
 #include "sim/system.hh"
 
@@ -45,11 +48,24 @@ StackDistProbe::StackDistProbe(StackDistProbeParams *p)
       lineSize(p->line_size),
       disableLinearHists(p->disable_linear_hists),
       disableLogHists(p->disable_log_hists),
+      curveBins(p->log_hist_bins),
+      sampleThreshold(p->sample_rate * (1ULL << 32)),
+      sampleScale(1.0 / p->sample_rate),
+      regions(p->regions),
+      pcCurves(p->pc_curves),
+      regionReuse(p->regions.size()),
       calc(p->verify)
 {
     fatal_if(p->system->cacheLineSize() > p->line_size,
              "The stack distance probe must use a cache line size that is "
              "larger or equal to the system's cahce line size.");
+    fatal_if(p->sample_rate <= 0 || p->sample_rate > 1,
+             "The sample rate of the stack distance probe must be in "
+             "(0, 1].");
+
+    allReuse.bins.resize(curveBins + 1, 0);
+    for (auto &counts : regionReuse)
+        counts.bins.resize(curveBins + 1, 0);
 }
 
 void
@@ -91,6 +107,132 @@ StackDistProbe::regStats()
         .name(name() + ".infinity")
         .desc("Number of requests with infinite stack distance")
         .flags(nozero);
+
+    missRatio
+        .init(curveBins)
+        .name(name() + ".missRatio")
+        .desc("Miss ratio of fully associative LRU caches of n lines")
+        .flags(nozero);
+    for (unsigned i = 0; i < curveBins; ++i)
+        missRatio.subname(i, std::to_string(1ULL << i));
+
+    if (!regions.empty()) {
+        regionMissRatio
+            .init(regions.size(), curveBins)
+            .name(name() + ".regionMissRatio")
+            .desc("Miss ratio of fully associative LRU caches of n lines "
+                  "for each region")
+            .flags(nozero);
+        for (unsigned i = 0; i < regions.size(); ++i)
+            regionMissRatio.subname(i, regions[i].to_string());
+        for (unsigned i = 0; i < curveBins; ++i)
+            regionMissRatio.ysubname(i, std::to_string(1ULL << i));
+    }
+
+    if (pcCurves) {
+        pcMissRatio
+            .init(pcCurves, curveBins)
+            .name(name() + ".pcMissRatio")
+            .desc("Miss ratio of fully associative LRU caches of n lines "
+                  "for the PCs with the most accesses")
+            .flags(nozero);
+        for (unsigned i = 0; i < curveBins; ++i)
+            pcMissRatio.ysubname(i, std::to_string(1ULL << i));
+
+        pcs
+            .init(pcCurves)
+            .name(name() + ".pcs")
+            .desc("PC of each row of pcMissRatio")
+            .flags(nozero);
+
+        pcAccesses
+            .init(pcCurves)
+            .name(name() + ".pcAccesses")
+            .desc("Accesses of each row of pcMissRatio")
+            .flags(nozero);
+    }
+
+    // The curves are derived from counts kept outside of the stats
+    registerDumpCallback([this]() { updateCurves(); });
+    registerResetCallback([this]() { resetCurves(); });
+}
+
+void
+StackDistProbe::countReuse(ReuseCounts &counts, unsigned bin)
+{
+    if (counts.bins.empty())
+        counts.bins.resize(curveBins + 1, 0);
+    ++counts.bins[bin];
+    ++counts.accesses;
+}
+
+std::vector<double>
+StackDistProbe::missRatios(const ReuseCounts &counts) const
+{
+    // A cache of 2^i lines misses on all the distances in the bins
+    // above i, so accumulate the bins from the top
+    std::vector<double> ratios(curveBins, 0);
+    if (!counts.accesses)
+        return ratios;
+
+    uint64_t misses = counts.bins[curveBins];
+    for (int i = curveBins - 1; i >= 0; --i) {
+        ratios[i] = (double)misses / counts.accesses;
+        misses += counts.bins[i];
+    }
+    return ratios;
+}
+
+void
+StackDistProbe::updateCurves()
+{
+    std::vector<double> ratios(missRatios(allReuse));
+    for (unsigned i = 0; i < curveBins; ++i)
+        missRatio[i] = ratios[i];
+
+    for (unsigned r = 0; r < regions.size(); ++r) {
+        ratios = missRatios(regionReuse[r]);
+        for (unsigned i = 0; i < curveBins; ++i)
+            regionMissRatio[r][i] = ratios[i];
+    }
+
+    if (!pcCurves)
+        return;
+
+    // Report the PCs with the most accesses
+    std::vector<std::pair<uint64_t, Addr>> top;
+    top.reserve(pcReuse.size());
+    for (const auto &pc_reuse : pcReuse)
+        top.emplace_back(pc_reuse.second.accesses, pc_reuse.first);
+    unsigned count = std::min<size_t>(pcCurves, top.size());
+    std::partial_sort(top.begin(), top.begin() + count, top.end(),
+                      std::greater<std::pair<uint64_t, Addr>>());
+
+    for (unsigned row = 0; row < pcCurves; ++row) {
+        if (row < count) {
+            pcs[row] = top[row].second;
+            pcAccesses[row] = top[row].first;
+            ratios = missRatios(pcReuse.find(top[row].second)->second);
+        } else {
+            pcs[row] = 0;
+            pcAccesses[row] = 0;
+            ratios.assign(curveBins, 0);
+        }
+        for (unsigned i = 0; i < curveBins; ++i)
+            pcMissRatio[row][i] = ratios[i];
+    }
+}
+
+void
+StackDistProbe::resetCurves()
+{
+    std::fill(allReuse.bins.begin(), allReuse.bins.end(), 0);
+    allReuse.accesses = 0;
+    for (auto &counts : regionReuse) {
+        std::fill(counts.bins.begin(), counts.bins.end(), 0);
+        counts.accesses = 0;
+    }
+    pcReuse.clear();
 }
 
 void
@@ -104,8 +246,30 @@ StackDistProbe::handleRequest(const ProbePoints::PacketInfo &pkt_info)
     // Align the address to a cache line size
     const Addr aligned_addr(roundDown(pkt_info.addr, lineSize));
 
-    // Calculate the stack distance
-    const uint64_t sd(calc.calcStackDistAndUpdate(aligned_addr).first);
+    // With sampling, only track the lines whose hash is below the
+    // threshold, which keeps every access to a tracked line
+    const uint64_t line_hash((aligned_addr / lineSize) *
+                             0x9e3779b97f4a7c15ULL >> 32);
+    if (line_hash >= sampleThreshold)
+        return;
+
+    // Calculate the stack distance, scaled up to the whole stream
+    uint64_t sd(calc.calcStackDistAndUpdate(aligned_addr).first);
+    if (sd != StackDistCalc::Infinity && sampleScale != 1.0)
+        sd = sd * sampleScale;
+
+    // Count it for the miss-ratio curves
+    const unsigned bin(sd == StackDistCalc::Infinity ? curveBins :
+                       sd == 0 ? 0 :
+                       std::min<unsigned>(floorLog2(sd) + 1, curveBins));
+    countReuse(allReuse, bin);
+    for (unsigned r = 0; r < regions.size(); ++r) {
+        if (regions[r].contains(pkt_info.addr))
+            countReuse(regionReuse[r], bin);
+    }
+    if (pcCurves && pkt_info.pc)
+        countReuse(pcReuse[pkt_info.pc], bin);
+
     if (sd == StackDistCalc::Infinity) {
         infiniteSD++;
         return;
@@ -38,6 +38,10 @@
 #ifndef __MEM_PROBES_STACK_DIST_HH__
 #define __MEM_PROBES_STACK_DIST_HH__
 
+#include <vector>
+
+#include "base/addr_range.hh"
+#include "base/flat_hash_map.hh"
 #include "mem/packet.hh"
 #include "mem/probes/base.hh"
 #include "mem/stack_dist_calc.hh"
@@ -55,6 +59,44 @@ class StackDistProbe : public BaseMemProbe
   protected:
     void handleRequest(const ProbePoints::PacketInfo &pkt_info) override;
 
+    /**
+     * Reuse counts of a stream of accesses, from which its miss-ratio
+     * curve is derived. Bin 0 counts the distances of 0, and bin i the
+     * distances in [2^(i-1), 2^i). The last bin counts everything
+     * beyond, including the infinite distances, as they miss in every
+     * cache size of the curve.
+     */
+    struct ReuseCounts
+    {
+        std::vector<uint64_t> bins;
+        uint64_t accesses;
+
+        ReuseCounts() : accesses(0) {}
+    };
+
+    /**
+     * Count a stack distance in the reuse counts of a stream.
+     *
+     * @param counts Reuse counts of the stream
+     * @param bin Bin of the stack distance
+     */
+    void countReuse(ReuseCounts &counts, unsigned bin);
+
+    /**
+     * Get the miss ratios of fully associative LRU caches of 2^i lines
+     * from the reuse counts of a stream.
+     *
+     * @param counts Reuse counts of the stream
+     * @return The miss ratio of each cache size
+     */
+    std::vector<double> missRatios(const ReuseCounts &counts) const;
+
+    /** Compute the miss-ratio curve stats before they are dumped. */
+    void updateCurves();
+
+    /** Clear the reuse counts when the stats are reset. */
+    void resetCurves();
+
   protected:
     // Cache line size to simulate
     const unsigned lineSize;
@@ -65,6 +107,26 @@ class StackDistProbe : public BaseMemProbe
     // Disable the logarithmic histograms
     const bool disableLogHists;
 
+    // Number of points in the miss-ratio curves
+    const unsigned curveBins;
+
+    // Lines are tracked if the top bits of their hash are below this
+    const uint64_t sampleThreshold;
+
+    // Scale of the distances of the sampled lines
+    const double sampleScale;
+
+    // Address ranges with separate miss-ratio curves
+    const std::vector<AddrRange> regions;
+
+    // Number of PCs with separate miss-ratio curves
+    const unsigned pcCurves;
+
+    // Reuse counts of the whole stream, of each region and of each PC
+    ReuseCounts allReuse;
+    std::vector<ReuseCounts> regionReuse;
+    FlatHashMap<Addr, ReuseCounts> pcReuse;
+
   protected:
     // Reads linear histogram
     Stats::Histogram readLinearHist;
@@ -81,6 +143,19 @@ class StackDistProbe : public BaseMemProbe
     // Writes logarithmic histogram
     Stats::Scalar infiniteSD;
 
+    // Miss ratio of each cache size, for all accesses
+    Stats::Vector missRatio;
+
+    // Miss ratio of each cache size, for the accesses to each region
+    Stats::Vector2d regionMissRatio;
+
+    // Miss ratio of each cache size, for the PCs with the most accesses
+    Stats::Vector2d pcMissRatio;
+
+    // PC and number of accesses of each row of pcMissRatio
+    Stats::Vector pcs;
+    Stats::Vector pcAccesses;
+
   protected:
     StackDistCalc calc;
 };
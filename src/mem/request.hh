@@ -50,10 +50,13 @@
 
 #include <cassert>
 #include <climits>
+#include <memory>
+#include <utility>
 
 #include "base/amo.hh"
 #include "base/flags.hh"
 #include "base/logging.hh"
+#include "base/pool_alloc.hh"
 #include "base/types.hh"
 #include "cpu/inst_seq.hh"
 #include "mem/htm.hh"
@@ -463,6 +466,21 @@ class Request
 
     ~Request() {}
 
+    /**
+     * Create a request with the given constructor arguments. This is
+     * equivalent to std::make_shared<Request>(args...), but the request
+     * and its reference count come from per-thread free lists, so
+     * creating requests on the memory access path does not reach
+     * malloc in steady state.
+     */
+    template <typename ...Args>
+    static RequestPtr
+    create(Args&&... args)
+    {
+        return std::allocate_shared<Request>(PoolAllocator<Request>(),
+                                             std::forward<Args>(args)...);
+    }
+
     /**
      * Set up Context numbers.
      */
@@ -536,8 +554,8 @@ class Request
         assert(privateFlags.isSet(VALID_VADDR));
         assert(privateFlags.noneSet(VALID_PADDR));
         assert(split_addr > _vaddr && split_addr < _vaddr + _size);
-        req1 = std::make_shared<Request>(*this);
-        req2 = std::make_shared<Request>(*this);
+        req1 = create(*this);
+        req2 = create(*this);
         req1->_size = split_addr - _vaddr;
         req2->_vaddr = split_addr;
         req2->_size = _size - req1->_size;
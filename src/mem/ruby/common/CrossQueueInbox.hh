@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Deterministic delivery of items (messages, flits) between Ruby
+ * objects simulated on different event queues.
+ *
+ * The sender pushes items from its own thread together with their
+ * arrival time. The inbox is drained by the thread owning the
+ * receiver's event queue at every global barrier, i.e., at the end of
+ * every simulation quantum, while all threads are stopped between the
+ * two halves of the barrier. The inbox then holds exactly the items
+ * sent since the previous barrier. The items are handed to the
+ * receiver sorted by arrival time, then by sending event queue and
+ * then in the order they were sent, so the receiver sees the same
+ * sequence regardless of how the host threads were interleaved.
+ *
+ * For this to be correct, an item must arrive after the end of the
+ * quantum it was sent in, as the barrier runs after the other events
+ * of that tick. Senders must therefore use a latency (the lookahead)
+ * longer than the simulation quantum.
+ */
+
+#ifndef __MEM_RUBY_COMMON_CROSSQUEUEINBOX_HH__
+#define __MEM_RUBY_COMMON_CROSSQUEUEINBOX_HH__
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "base/logging.hh"
+#include "base/types.hh"
+#include "sim/eventq.hh"
+
+template <class T>
+class CrossQueueInbox
+{
+  public:
+    typedef std::function<void(T &, Tick)> DeliverFunc;
+
+    /**
+     * @param _name Name used in error messages.
+     * @param receiver_eq Event queue of the receiving object.
+     * @param _deliver Called on the receiver's thread for every item.
+     */
+    CrossQueueInbox(const std::string &_name, EventQueue *receiver_eq,
+                    const DeliverFunc &_deliver)
+        : _name(_name), receiverQueue(receiver_eq), deliver(_deliver),
+          pending(numMainEventQueues)
+    {
+        receiverQueue->registerSyncCallback([this]{ drain(); });
+    }
+
+    /**
+     * True if the calling thread has to go through the inbox to reach
+     * the receiver, i.e., if we are simulating in parallel and the
+     * receiver lives on another event queue.
+     */
+    bool
+    isRemote() const
+    {
+        return inParallelMode && curEventQueue() != receiverQueue;
+    }
+
+    /**
+     * Post an item from the sender's thread.
+     *
+     * @param item The item to deliver.
+     * @param arrival Tick at which the receiver may consume the item.
+     * @param lookahead Latency between sending and arrival.
+     */
+    void
+    push(const T &item, Tick arrival, Tick lookahead)
+    {
+        if (lookahead <= simQuantum) {
+            fatal("%s: cross event queue latency (%d ticks) must be "
+                  "longer than the simulation quantum (%d ticks).\n",
+                  _name, lookahead, simQuantum);
+        }
+
+        const uint32_t src = senderIndex();
+        std::lock_guard<std::mutex> lock(mutex);
+        pending[src].push_back(Entry(item, arrival));
+        empty = false;
+    }
+
+  private:
+    struct Entry
+    {
+        T item;
+        Tick arrival;
+
+        Entry(const T &_item, Tick _arrival)
+            : item(_item), arrival(_arrival)
+        {}
+    };
+
+    uint32_t
+    senderIndex() const
+    {
+        EventQueue *eq = curEventQueue();
+        for (uint32_t i = 0; i < numMainEventQueues; ++i) {
+            if (mainEventQueue[i] == eq)
+                return i;
+        }
+        panic("%s: sender is not on a main event queue\n", _name);
+    }
+
+    /** Hand all pending items to the receiver, on its own thread. */
+    void
+    drain()
+    {
+        std::vector<Entry> items;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (empty)
+                return;
+
+            // Concatenating in event queue order followed by a stable
+            // sort on the arrival time gives a deterministic order.
+            for (auto &from_queue : pending) {
+                items.insert(items.end(), from_queue.begin(),
+                             from_queue.end());
+                from_queue.clear();
+            }
+            empty = true;
+        }
+
+        std::stable_sort(items.begin(), items.end(),
+                         [](const Entry &l, const Entry &r)
+                         { return l.arrival < r.arrival; });
+
+        for (auto &entry : items) {
+            assert(entry.arrival > receiverQueue->getCurTick());
+            deliver(entry.item, entry.arrival);
+        }
+    }
+
+    const std::string _name;
+    EventQueue *const receiverQueue;
+    const DeliverFunc deliver;
+
+    std::mutex mutex;
+    //! Items pushed since the last drain, indexed by sending queue.
+    std::vector<std::vector<Entry>> pending;
+    bool empty = true;
+};
+
+#endif // __MEM_RUBY_COMMON_CROSSQUEUEINBOX_HH__
@@ -43,6 +43,7 @@ class DataBlock
     DataBlock()
     {
         alloc();
+        clear();
     }
 
     DataBlock(const DataBlock &cp);
@@ -70,9 +71,19 @@ class DataBlock
     void print(std::ostream& out) const;
 
   private:
+    /**
+     * Lines of up to this many bytes are stored in the block itself, so
+     * creating or copying a block, e.g. as part of a message, does not
+     * allocate. Larger lines are allocated on the heap.
+     */
+    static const int InlineBytes = 64;
+
+    /** Point m_data at storage for a line; does not initialise it. */
     void alloc();
+
     uint8_t *m_data;
     bool m_alloc;
+    uint8_t m_inline[InlineBytes];
 };
 
 inline void
@@ -77,12 +77,34 @@ MessageBuffer::MessageBuffer(const Params *p)
     m_dequeue_callback = nullptr;
 }
 
+void
+MessageBuffer::setConsumer(Consumer* consumer)
+{
+    DPRINTF(RubyQueue, "Setting consumer: %s\n", *consumer);
+    if (m_consumer != NULL) {
+        fatal("Trying to connect %s to MessageBuffer %s. \
+              \n%s already connected. Check the cntrl_id's.\n",
+              *consumer, *this, *m_consumer);
+    }
+    m_consumer = consumer;
+
+    // Senders may live on another event queue than the consumer, in
+    // which case their messages go through the inbox.
+    if (numMainEventQueues > 1) {
+        m_remote_inbox.reset(new CrossQueueInbox<MsgPtr>(
+            name(), consumer->getObject()->eventQueue(),
+            [this](MsgPtr &message, Tick arrival_time) {
+                insertMessage(message, curTick(), arrival_time);
+            }));
+    }
+}
+
 unsigned int
 MessageBuffer::getSize(Tick curTime)
 {
     if (m_time_last_time_size_checked != curTime) {
         m_time_last_time_size_checked = curTime;
-        m_size_last_time_size_checked = m_prio_heap.size();
+        m_size_last_time_size_checked = m_wheel.size();
     }
 
     return m_size_last_time_size_checked;
@@ -105,8 +127,8 @@ MessageBuffer::areNSlotsAvailable(unsigned int n, Tick current_time)
     unsigned int current_stall_size = 0;
 
     if (m_time_last_time_pop < current_time) {
-        // no pops this cycle - heap and stall queue size is correct
-        current_size = m_prio_heap.size();
+        // no pops this cycle - wheel and stall queue size is correct
+        current_size = m_wheel.size();
         current_stall_size = m_stall_map_size;
     } else {
         if (m_time_last_time_enqueue < current_time) {
@@ -126,10 +148,10 @@ MessageBuffer::areNSlotsAvailable(unsigned int n, Tick current_time)
     if (current_size + current_stall_size + n <= m_max_size) {
         return true;
     } else {
-        DPRINTF(RubyQueue, "n: %d, current_size: %d, heap size: %d, "
+        DPRINTF(RubyQueue, "n: %d, current_size: %d, wheel size: %d, "
                 "m_max_size: %d\n",
                 n, current_size + current_stall_size,
-                m_prio_heap.size(), m_max_size);
+                m_wheel.size(), m_max_size);
         m_not_avail_count++;
         return false;
     }
@@ -139,7 +161,7 @@ const Message*
 MessageBuffer::peek() const
 {
     DPRINTF(RubyQueue, "Peeking at head of queue.\n");
-    const Message* msg_ptr = m_prio_heap.front().get();
+    const Message* msg_ptr = m_wheel.front().get();
     assert(msg_ptr);
 
     DPRINTF(RubyQueue, "Message: %s\n", (*msg_ptr));
@@ -161,15 +183,11 @@ random_time()
 void
 MessageBuffer::enqueue(MsgPtr message, Tick current_time, Tick delta)
 {
-    // record current time incase we have a pop that also adjusts my size
-    if (m_time_last_time_enqueue < current_time) {
-        m_msgs_this_cycle = 0;  // first msg this cycle
-        m_time_last_time_enqueue = current_time;
+    if (m_remote_inbox && m_remote_inbox->isRemote()) {
+        enqueueRemote(message, current_time, delta);
+        return;
     }
 
-    m_msg_counter++;
-    m_msgs_this_cycle++;
-
     // Calculate the arrival time of the message, that is, the first
     // cycle the message can be dequeued.
     assert(delta > 0);
@@ -194,11 +212,64 @@ MessageBuffer::enqueue(MsgPtr message, Tick current_time, Tick delta)
 
     // Check the arrival time
     assert(arrival_time > current_time);
+
+    // compute the delay cycles
+    Message* msg_ptr = message.get();
+    assert(msg_ptr != NULL);
+
+    assert(current_time >= msg_ptr->getLastEnqueueTime() &&
+           "ensure we aren't dequeued early");
+
+    msg_ptr->updateDelayedTicks(current_time);
+
+    insertMessage(message, current_time, arrival_time);
+}
+
+void
+MessageBuffer::enqueueRemote(MsgPtr message, Tick current_time, Tick delta)
+{
+    // The size and the randomization state of the buffer belong to the
+    // consumer's thread, so neither can be used by the sender.
+    if (m_max_size != 0) {
+        fatal("%s: MessageBuffers connecting different event queues "
+              "must have an infinite size.\n", name());
+    }
+    if (RubySystem::getRandomization() || m_randomization) {
+        fatal("%s: MessageBuffers connecting different event queues "
+              "do not support randomization.\n", name());
+    }
+
+    assert(delta > 0);
+    Tick arrival_time = current_time + delta;
+
+    assert(current_time >= message->getLastEnqueueTime() &&
+           "ensure we aren't dequeued early");
+    message->updateDelayedTicks(current_time);
+
+    DPRINTF(RubyQueue, "Remote enqueue arrival_time: %lld, Message: %s\n",
+            arrival_time, *(message.get()));
+
+    m_remote_inbox->push(message, arrival_time, delta);
+}
+
+void
+MessageBuffer::insertMessage(MsgPtr message, Tick current_time,
+                             Tick arrival_time)
+{
+    // record current time incase we have a pop that also adjusts my size
+    if (m_time_last_time_enqueue < current_time) {
+        m_msgs_this_cycle = 0;  // first msg this cycle
+        m_time_last_time_enqueue = current_time;
+    }
+
+    m_msg_counter++;
+    m_msgs_this_cycle++;
+
     if (m_strict_fifo) {
         if (arrival_time < m_last_arrival_time) {
             panic("FIFO ordering violated: %s name: %s current time: %d "
-                  "delta: %d arrival_time: %d last arrival_time: %d\n",
-                  *this, name(), current_time, delta, arrival_time,
+                  "arrival_time: %d last arrival_time: %d\n",
+                  *this, name(), current_time, arrival_time,
                   m_last_arrival_time);
         }
     }
@@ -208,20 +279,13 @@ MessageBuffer::enqueue(MsgPtr message, Tick current_time, Tick delta)
         m_last_arrival_time = arrival_time;
     }
 
-    // compute the delay cycles and set enqueue time
+    // set enqueue time
     Message* msg_ptr = message.get();
-    assert(msg_ptr != NULL);
-
-    assert(current_time >= msg_ptr->getLastEnqueueTime() &&
-           "ensure we aren't dequeued early");
-
-    msg_ptr->updateDelayedTicks(current_time);
     msg_ptr->setLastEnqueueTime(arrival_time);
     msg_ptr->setMsgCounter(m_msg_counter);
 
-    // Insert the message into the priority heap
-    m_prio_heap.push_back(message);
-    push_heap(m_prio_heap.begin(), m_prio_heap.end(), greater<MsgPtr>());
+    // Insert the message into the timing wheel
+    m_wheel.push(message);
     // Increment the number of messages statistic
     m_buf_msgs++;
 
@@ -241,7 +305,7 @@ MessageBuffer::dequeue(Tick current_time, bool decrement_messages)
     assert(isReady(current_time));
 
     // get MsgPtr of the message about to be dequeued
-    MsgPtr message = m_prio_heap.front();
+    MsgPtr message = m_wheel.front();
 
     // get the delay cycles
     message->updateDelayedTicks(current_time);
@@ -252,13 +316,12 @@ MessageBuffer::dequeue(Tick current_time, bool decrement_messages)
     // record previous size and time so the current buffer size isn't
     // adjusted until schd cycle
     if (m_time_last_time_pop < current_time) {
-        m_size_at_cycle_start = m_prio_heap.size();
+        m_size_at_cycle_start = m_wheel.size();
         m_stalled_at_cycle_start = m_stall_map_size;
         m_time_last_time_pop = current_time;
     }
 
-    pop_heap(m_prio_heap.begin(), m_prio_heap.end(), greater<MsgPtr>());
-    m_prio_heap.pop_back();
+    m_wheel.pop();
     if (decrement_messages) {
         // If the message will be removed from the queue, decrement the
         // number of message in the queue.
@@ -288,7 +351,7 @@ MessageBuffer::unregisterDequeueCallback()
 void
 MessageBuffer::clear()
 {
-    m_prio_heap.clear();
+    m_wheel.clear();
 
     m_msg_counter = 0;
     m_time_last_time_enqueue = 0;
@@ -303,14 +366,13 @@ MessageBuffer::recycle(Tick current_time, Tick recycle_latency)
 {
     DPRINTF(RubyQueue, "Recycling.\n");
     assert(isReady(current_time));
-    MsgPtr node = m_prio_heap.front();
-    pop_heap(m_prio_heap.begin(), m_prio_heap.end(), greater<MsgPtr>());
+    MsgPtr node = m_wheel.front();
+    m_wheel.pop();
 
     Tick future_time = current_time + recycle_latency;
     node->setLastEnqueueTime(future_time);
 
-    m_prio_heap.back() = node;
-    push_heap(m_prio_heap.begin(), m_prio_heap.end(), greater<MsgPtr>());
+    m_wheel.push(node);
     m_consumer->scheduleEventAbsolute(future_time);
 }
 
@@ -321,9 +383,7 @@ MessageBuffer::reanalyzeList(list<MsgPtr> &lt, Tick schdTick)
         MsgPtr m = lt.front();
         assert(m->getLastEnqueueTime() <= schdTick);
 
-        m_prio_heap.push_back(m);
-        push_heap(m_prio_heap.begin(), m_prio_heap.end(),
-                  greater<MsgPtr>());
+        m_wheel.push(m);
 
         m_consumer->scheduleEventAbsolute(schdTick);
 
@@ -342,7 +402,7 @@ MessageBuffer::reanalyzeMessages(Addr addr, Tick current_time)
 
     //
     // Put all stalled messages associated with this address back on the
-    // prio heap.  The reanalyzeList call will make sure the consumer is
+    // wheel.  The reanalyzeList call will make sure the consumer is
     // scheduled for the current cycle so that the previously stalled messages
     // will be observed before any younger messages that may arrive this cycle
     //
@@ -359,7 +419,7 @@ MessageBuffer::reanalyzeAllMessages(Tick current_time)
 
     //
     // Put all stalled messages associated with this address back on the
-    // prio heap.  The reanalyzeList call will make sure the consumer is
+    // wheel.  The reanalyzeList call will make sure the consumer is
     // scheduled for the current cycle so that the previously stalled messages
     // will be observed before any younger messages that may arrive this cycle.
     //
@@ -378,7 +438,7 @@ MessageBuffer::stallMessage(Addr addr, Tick current_time)
     DPRINTF(RubyQueue, "Stalling due to %#x\n", addr);
     assert(isReady(current_time));
     assert(getOffset(addr) == 0);
-    MsgPtr message = m_prio_heap.front();
+    MsgPtr message = m_wheel.front();
 
     // Since the message will just be moved to stall map, indicate that the
     // buffer should not decrement the m_buf_msgs statistic
@@ -438,16 +498,17 @@ MessageBuffer::print(ostream& out) const
         ccprintf(out, " consumer-yes ");
     }
 
-    vector<MsgPtr> copy(m_prio_heap);
-    sort_heap(copy.begin(), copy.end(), greater<MsgPtr>());
+    vector<MsgPtr> copy;
+    copy.reserve(m_wheel.size());
+    m_wheel.forEach([&copy](const MsgPtr &m) { copy.push_back(m); });
     ccprintf(out, "%s] %s", copy, name());
 }
 
 bool
 MessageBuffer::isReady(Tick current_time) const
 {
-    return ((m_prio_heap.size() > 0) &&
-        (m_prio_heap.front()->getLastEnqueueTime() <= current_time));
+    return (!m_wheel.empty() &&
+        (m_wheel.front()->getLastEnqueueTime() <= current_time));
 }
 
 void
@@ -493,15 +554,19 @@ MessageBuffer::functionalAccess(Packet *pkt, bool is_read)
 
     uint32_t num_functional_accesses = 0;
 
-    // Check the priority heap and write any messages that may
+    // Check the timing wheel and write any messages that may
     // correspond to the address in the packet.
-    for (unsigned int i = 0; i < m_prio_heap.size(); ++i) {
-        Message *msg = m_prio_heap[i].get();
-        if (is_read && msg->functionalRead(pkt))
-            return 1;
-        else if (!is_read && msg->functionalWrite(pkt))
+    bool read_done = false;
+    m_wheel.forEach([&](const MsgPtr &m) {
+        if (read_done)
+            return;
+        if (is_read && m->functionalRead(pkt))
+            read_done = true;
+        else if (!is_read && m->functionalWrite(pkt))
             num_functional_accesses++;
-    }
+    });
+    if (read_done)
+        return 1;
 
     // Check the stall queue and write any messages that may
     // correspond to the address in the packet.
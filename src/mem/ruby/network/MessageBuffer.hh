@@ -50,6 +50,7 @@
 #include <cassert>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -60,6 +61,8 @@
 #include "mem/port.hh"
 #include "mem/ruby/common/Address.hh"
 #include "mem/ruby/common/Consumer.hh"
+#include "mem/ruby/common/CrossQueueInbox.hh"
+#include "mem/ruby/network/MessageWheel.hh"
 #include "mem/ruby/network/dummy_port.hh"
 #include "mem/ruby/slicc_interface/Message.hh"
 #include "params/MessageBuffer.hh"
@@ -83,26 +86,15 @@ class MessageBuffer : public SimObject
     void
     delayHead(Tick current_time, Tick delta)
     {
-        MsgPtr m = m_prio_heap.front();
-        std::pop_heap(m_prio_heap.begin(), m_prio_heap.end(),
-                      std::greater<MsgPtr>());
-        m_prio_heap.pop_back();
+        MsgPtr m = m_wheel.front();
+        m_wheel.pop();
         enqueue(m, current_time, delta);
     }
 
     bool areNSlotsAvailable(unsigned int n, Tick curTime);
     int getPriority() { return m_priority_rank; }
     void setPriority(int rank) { m_priority_rank = rank; }
-    void setConsumer(Consumer* consumer)
-    {
-        DPRINTF(RubyQueue, "Setting consumer: %s\n", *consumer);
-        if (m_consumer != NULL) {
-            fatal("Trying to connect %s to MessageBuffer %s. \
-                  \n%s already connected. Check the cntrl_id's.\n",
-                  *consumer, *this, *m_consumer);
-        }
-        m_consumer = consumer;
-    }
+    void setConsumer(Consumer* consumer);
 
     Consumer* getConsumer() { return m_consumer; }
 
@@ -112,7 +104,7 @@ class MessageBuffer : public SimObject
     //! message queue.  The function assumes that the queue is nonempty.
     const Message* peek() const;
 
-    const MsgPtr &peekMsgPtr() const { return m_prio_heap.front(); }
+    const MsgPtr &peekMsgPtr() const { return m_wheel.front(); }
 
     void enqueue(MsgPtr message, Tick curTime, Tick delta);
 
@@ -136,7 +128,7 @@ class MessageBuffer : public SimObject
     void unregisterDequeueCallback();
 
     void recycle(Tick current_time, Tick recycle_latency);
-    bool isEmpty() const { return m_prio_heap.size() == 0; }
+    bool isEmpty() const { return m_wheel.empty(); }
     bool isStallMapEmpty() { return m_stall_msg_map.size() == 0; }
     unsigned int getStallMapSize() { return m_stall_msg_map.size(); }
 
@@ -177,13 +169,30 @@ class MessageBuffer : public SimObject
   private:
     void reanalyzeList(std::list<MsgPtr> &, Tick);
 
+    //! Insert a message whose arrival time is known into the wheel and
+    //! wake up the consumer when it arrives.
+    void insertMessage(MsgPtr message, Tick current_time, Tick arrival_time);
+
+    //! Post a message enqueued by a sender on another event queue.
+    void enqueueRemote(MsgPtr message, Tick current_time, Tick delta);
+
     uint32_t functionalAccess(Packet *pkt, bool is_read);
 
   private:
     // Data Members (m_ prefix)
     //! Consumer to signal a wakeup(), can be NULL
     Consumer* m_consumer;
-    std::vector<MsgPtr> m_prio_heap;
+
+    //! Messages ordered by arrival time, then by message counter.
+    MessageWheel<MsgPtr> m_wheel;
+
+    /**
+     * Messages enqueued by senders simulated on another event queue
+     * than the consumer. They are moved to m_wheel by the
+     * consumer's thread at the end of every simulation quantum. Only
+     * allocated when simulating with multiple event queues.
+     */
+    std::unique_ptr<CrossQueueInbox<MsgPtr>> m_remote_inbox;
 
     std::function<void()> m_dequeue_callback;
 
@@ -194,14 +203,14 @@ class MessageBuffer : public SimObject
     /**
      * A map from line addresses to lists of stalled messages for that line.
      * If this buffer allows the receiver to stall messages, on a stall
-     * request, the stalled message is removed from the m_prio_heap and placed
+     * request, the stalled message is removed from the m_wheel and placed
      * in the m_stall_msg_map. Messages are held there until the receiver
      * requests they be reanalyzed, at which point they are moved back to
-     * m_prio_heap.
+     * m_wheel.
      *
      * NOTE: The stall map holds messages in the order in which they were
      * initially received, and when a line is unblocked, the messages are
-     * moved back to the m_prio_heap in the same order. This prevents starving
+     * moved back to the m_wheel in the same order. This prevents starving
      * older requests with younger ones.
      */
     StallMsgMapType m_stall_msg_map;
@@ -218,7 +227,7 @@ class MessageBuffer : public SimObject
      * Current size of the stall map.
      * Track the number of messages held in stall map lists. This is used to
      * ensure that if the buffer is finite-sized, it blocks further requests
-     * when the m_prio_heap and m_stall_msg_map contain m_max_size messages.
+     * when the m_wheel and m_stall_msg_map contain m_max_size messages.
      */
     int m_stall_map_size;
 
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The time-ordered store of a MessageBuffer. Messages are kept in
+ * buckets, one per distinct arrival tick, and the buckets form a ring
+ * ordered by tick, i.e. a timing wheel whose slots are only created for
+ * ticks that actually have messages. Within a bucket messages are kept
+ * in message counter order, which makes the order identical to that of
+ * a heap ordered by (arrival tick, counter).
+ *
+ * Nearly every enqueue lands a few cycles after the current tick, in
+ * the last bucket or one of the last few, and usually carries the
+ * largest counter so far, so insertion is a short walk back from the end
+ * plus an append. Looking at, and removing, the head is O(1). Messages
+ * put back by reanalysis or recycling are placed by the same walk.
+ */
+
+#ifndef __MEM_RUBY_NETWORK_MESSAGEWHEEL_HH__
+#define __MEM_RUBY_NETWORK_MESSAGEWHEEL_HH__
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <iterator>
+#include <vector>
+
+#include "base/types.hh"
+
+/**
+ * @tparam Ptr A pointer to a message; the message provides
+ *             getLastEnqueueTime() and getMsgCounter(), which must not
+ *             change while it is stored in the wheel.
+ */
+template <class Ptr>
+class MessageWheel
+{
+  public:
+    MessageWheel() : m_size(0) {}
+
+    bool empty() const { return m_size == 0; }
+    size_t size() const { return m_size; }
+
+    /** The message with the lowest (arrival tick, counter). */
+    const Ptr &
+    front() const
+    {
+        assert(!empty());
+        const Bucket &bucket = m_buckets.front();
+        return bucket.msgs[bucket.head];
+    }
+
+    void
+    push(const Ptr &msg)
+    {
+        const Tick time = msg->getLastEnqueueTime();
+
+        // Find the first bucket later than the message.
+        auto it = m_buckets.end();
+        while (it != m_buckets.begin() && std::prev(it)->time > time)
+            --it;
+
+        if (it != m_buckets.begin() && std::prev(it)->time == time) {
+            insert(*std::prev(it), msg);
+        } else {
+            it = m_buckets.insert(it, Bucket(time, takeSpare()));
+            it->msgs.push_back(msg);
+        }
+        ++m_size;
+    }
+
+    void
+    pop()
+    {
+        assert(!empty());
+        Bucket &bucket = m_buckets.front();
+        bucket.msgs[bucket.head++] = Ptr();
+        if (bucket.head == bucket.msgs.size()) {
+            bucket.msgs.clear();
+            m_spare.push_back(std::move(bucket.msgs));
+            m_buckets.pop_front();
+        }
+        --m_size;
+    }
+
+    void
+    clear()
+    {
+        m_buckets.clear();
+        m_size = 0;
+    }
+
+    /** Call f on every message, in order. */
+    template <class F>
+    void
+    forEach(F f) const
+    {
+        for (const Bucket &bucket : m_buckets) {
+            for (size_t i = bucket.head; i < bucket.msgs.size(); ++i)
+                f(bucket.msgs[i]);
+        }
+    }
+
+  private:
+    struct Bucket
+    {
+        Bucket(Tick t, std::vector<Ptr> &&m)
+            : time(t), msgs(std::move(m)), head(0)
+        {}
+
+        Tick time;
+        /** Messages in counter order; those before head were popped. */
+        std::vector<Ptr> msgs;
+        size_t head;
+    };
+
+    static bool
+    counterLess(const Ptr &lhs, const Ptr &rhs)
+    {
+        return lhs->getMsgCounter() < rhs->getMsgCounter();
+    }
+
+    void
+    insert(Bucket &bucket, const Ptr &msg)
+    {
+        if (!counterLess(msg, bucket.msgs.back())) {
+            bucket.msgs.push_back(msg);
+        } else {
+            auto pos = std::upper_bound(bucket.msgs.begin() + bucket.head,
+                                        bucket.msgs.end(), msg, counterLess);
+            bucket.msgs.insert(pos, msg);
+        }
+    }
+
+    /** Get an empty vector, reusing the storage of a retired bucket. */
+    std::vector<Ptr>
+    takeSpare()
+    {
+        if (m_spare.empty())
+            return std::vector<Ptr>();
+        std::vector<Ptr> msgs(std::move(m_spare.back()));
+        m_spare.pop_back();
+        return msgs;
+    }
+
+    std::deque<Bucket> m_buckets;
+    std::vector<std::vector<Ptr>> m_spare;
+    size_t m_size;
+};
+
+#endif // __MEM_RUBY_NETWORK_MESSAGEWHEEL_HH__
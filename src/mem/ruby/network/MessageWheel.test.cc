@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "mem/ruby/network/MessageWheel.hh"
+
+namespace
+{
+
+struct FakeMsg
+{
+    FakeMsg(Tick t, uint64_t c) : time(t), counter(c) {}
+
+    Tick getLastEnqueueTime() const { return time; }
+    uint64_t getMsgCounter() const { return counter; }
+
+    Tick time;
+    uint64_t counter;
+};
+
+typedef std::shared_ptr<FakeMsg> FakePtr;
+
+/** The heap ordering MessageBuffer used before the wheel. */
+bool
+operator>(const FakePtr &lhs, const FakePtr &rhs)
+{
+    if (lhs->time == rhs->time)
+        return lhs->counter > rhs->counter;
+    return lhs->time > rhs->time;
+}
+
+class ReferenceHeap
+{
+  public:
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+    const FakePtr &front() const { return heap.front(); }
+
+    void
+    push(const FakePtr &msg)
+    {
+        heap.push_back(msg);
+        std::push_heap(heap.begin(), heap.end(), std::greater<FakePtr>());
+    }
+
+    void
+    pop()
+    {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<FakePtr>());
+        heap.pop_back();
+    }
+
+  private:
+    std::vector<FakePtr> heap;
+};
+
+} // anonymous namespace
+
+TEST(MessageWheelTest, Empty)
+{
+    MessageWheel<FakePtr> wheel;
+    ASSERT_TRUE(wheel.empty());
+    ASSERT_EQ(wheel.size(), 0);
+}
+
+/** Messages come out by tick, then by counter within a tick. */
+TEST(MessageWheelTest, Order)
+{
+    MessageWheel<FakePtr> wheel;
+    wheel.push(std::make_shared<FakeMsg>(30, 1));
+    wheel.push(std::make_shared<FakeMsg>(10, 3));
+    wheel.push(std::make_shared<FakeMsg>(20, 4));
+    wheel.push(std::make_shared<FakeMsg>(10, 2));
+    wheel.push(std::make_shared<FakeMsg>(10, 5));
+    ASSERT_EQ(wheel.size(), 5);
+
+    const std::pair<Tick, uint64_t> expected[] = {
+        {10, 2}, {10, 3}, {10, 5}, {20, 4}, {30, 1} };
+    for (const auto &e : expected) {
+        ASSERT_FALSE(wheel.empty());
+        EXPECT_EQ(wheel.front()->time, e.first);
+        EXPECT_EQ(wheel.front()->counter, e.second);
+        wheel.pop();
+    }
+    ASSERT_TRUE(wheel.empty());
+}
+
+/** A message older than everything in the wheel goes to the front. */
+TEST(MessageWheelTest, LateInsert)
+{
+    MessageWheel<FakePtr> wheel;
+    wheel.push(std::make_shared<FakeMsg>(100, 10));
+    wheel.push(std::make_shared<FakeMsg>(200, 11));
+    wheel.push(std::make_shared<FakeMsg>(50, 2));
+    EXPECT_EQ(wheel.front()->time, 50);
+    wheel.pop();
+    EXPECT_EQ(wheel.front()->time, 100);
+}
+
+/** forEach visits the messages in the order they would be popped. */
+TEST(MessageWheelTest, ForEach)
+{
+    MessageWheel<FakePtr> wheel;
+    wheel.push(std::make_shared<FakeMsg>(20, 1));
+    wheel.push(std::make_shared<FakeMsg>(10, 2));
+    wheel.push(std::make_shared<FakeMsg>(10, 1));
+    wheel.pop();
+
+    std::vector<uint64_t> counters;
+    wheel.forEach([&counters](const FakePtr &m) {
+        counters.push_back(m->counter);
+    });
+    EXPECT_EQ(counters, std::vector<uint64_t>({2, 1}));
+}
+
+/**
+ * Drive the wheel and the reference heap through the same long random
+ * sequence of MessageBuffer operations (enqueue with a mix of delays,
+ * dequeue, stall and reanalyze, recycle, and counter resets as done by
+ * clearStats) and check they always agree on the head of the queue.
+ */
+TEST(MessageWheelTest, StressMatchesHeap)
+{
+    const Tick period = 500;
+    std::mt19937 rng(0x5eed);
+    MessageWheel<FakePtr> wheel;
+    ReferenceHeap heap;
+    std::list<FakePtr> stalled;
+
+    // Counters restart after a reset, but keep the number of resets in
+    // their low bits so no two messages ever share a (tick, counter) key,
+    // for which the order of the heap would be arbitrary.
+    const uint64_t max_resets = 1024;
+    uint64_t resets = 0;
+    uint64_t counter = 0;
+
+    Tick now = 0;
+    uint64_t popped = 0;
+
+    for (int step = 0; step < 200000; ++step) {
+        const unsigned op = rng() % 100;
+        if (op < 45) {
+            // Enqueue, usually a few cycles ahead, sometimes much later.
+            Tick delay = period * (1 + rng() % 4);
+            if (rng() % 16 == 0)
+                delay = period * (10 + rng() % 100);
+            auto msg = std::make_shared<FakeMsg>(
+                now + delay, ++counter * max_resets + resets);
+            wheel.push(msg);
+            heap.push(msg);
+        } else if (op < 80) {
+            // Dequeue everything that is ready, as a consumer would.
+            while (!heap.empty() && heap.front()->time <= now) {
+                ASSERT_EQ(wheel.front(), heap.front());
+                wheel.pop();
+                heap.pop();
+                ++popped;
+            }
+        } else if (op < 86) {
+            // Stall the head.
+            if (!heap.empty() && heap.front()->time <= now) {
+                ASSERT_EQ(wheel.front(), heap.front());
+                stalled.push_back(heap.front());
+                wheel.pop();
+                heap.pop();
+            }
+        } else if (op < 90) {
+            // Reanalyze: stalled messages go back with their old times.
+            for (auto &msg : stalled) {
+                wheel.push(msg);
+                heap.push(msg);
+            }
+            stalled.clear();
+        } else if (op < 94) {
+            // Recycle the head to a later tick, keeping its counter.
+            if (!heap.empty() && heap.front()->time <= now) {
+                ASSERT_EQ(wheel.front(), heap.front());
+                FakePtr msg = heap.front();
+                wheel.pop();
+                heap.pop();
+                msg->time = now + period * (1 + rng() % 8);
+                wheel.push(msg);
+                heap.push(msg);
+            }
+        } else if (op < 95) {
+            // clearStats resets the counter with messages in flight.
+            if (rng() % 64 == 0 && resets + 1 < max_resets) {
+                counter = 0;
+                ++resets;
+            }
+        } else {
+            now += period;
+        }
+
+        ASSERT_EQ(wheel.size(), heap.size());
+        if (!heap.empty()) {
+            ASSERT_EQ(wheel.front(), heap.front());
+        }
+    }
+
+    while (!heap.empty()) {
+        ASSERT_EQ(wheel.front(), heap.front());
+        wheel.pop();
+        heap.pop();
+        ++popped;
+    }
+    ASSERT_TRUE(wheel.empty());
+    EXPECT_GT(popped, 10000);
+    EXPECT_GT(resets, 0);
+}
@@ -534,6 +534,36 @@ GarnetNetwork::collateStats()
     for (int i = 0; i < m_routers.size(); i++) {
         m_routers[i]->collateStats();
     }
+
+    // Sum the traffic that the NIs counted
+    for (int j = 0; j < m_virtual_networks; j++) {
+        NetworkInterface::VnetStats total;
+        for (int i = 0; i < m_nis.size(); i++) {
+            const NetworkInterface::VnetStats &ni = m_nis[i]->getVnetStats(j);
+            total.packetsInjected += ni.packetsInjected;
+            total.packetsReceived += ni.packetsReceived;
+            total.packetNetworkLatency += ni.packetNetworkLatency;
+            total.packetQueueingLatency += ni.packetQueueingLatency;
+            total.flitsInjected += ni.flitsInjected;
+            total.flitsReceived += ni.flitsReceived;
+            total.flitNetworkLatency += ni.flitNetworkLatency;
+            total.flitQueueingLatency += ni.flitQueueingLatency;
+        }
+        m_packets_injected[j] = total.packetsInjected;
+        m_packets_received[j] = total.packetsReceived;
+        m_packet_network_latency[j] = total.packetNetworkLatency;
+        m_packet_queueing_latency[j] = total.packetQueueingLatency;
+        m_flits_injected[j] = total.flitsInjected;
+        m_flits_received[j] = total.flitsReceived;
+        m_flit_network_latency[j] = total.flitNetworkLatency;
+        m_flit_queueing_latency[j] = total.flitQueueingLatency;
+    }
+
+    Counter total_hops = 0;
+    for (int i = 0; i < m_nis.size(); i++) {
+        total_hops += m_nis[i]->getTotalHops();
+    }
+    m_total_hops = total_hops;
 }
 
 void
@@ -548,6 +578,9 @@ GarnetNetwork::resetStats()
     for (int i = 0; i < m_creditlinks.size(); i++) {
         m_creditlinks[i]->resetStats();
     }
+    for (int i = 0; i < m_nis.size(); i++) {
+        m_nis[i]->resetStats();
+    }
 }
 
 void
@@ -105,43 +105,6 @@ class GarnetNetwork : public Network
     void resetStats();
     void print(std::ostream& out) const;
 
-    // increment counters
-    void increment_injected_packets(int vnet) { m_packets_injected[vnet]++; }
-    void increment_received_packets(int vnet) { m_packets_received[vnet]++; }
-
-    void
-    increment_packet_network_latency(Tick latency, int vnet)
-    {
-        m_packet_network_latency[vnet] += latency;
-    }
-
-    void
-    increment_packet_queueing_latency(Tick latency, int vnet)
-    {
-        m_packet_queueing_latency[vnet] += latency;
-    }
-
-    void increment_injected_flits(int vnet) { m_flits_injected[vnet]++; }
-    void increment_received_flits(int vnet) { m_flits_received[vnet]++; }
-
-    void
-    increment_flit_network_latency(Tick latency, int vnet)
-    {
-        m_flit_network_latency[vnet] += latency;
-    }
-
-    void
-    increment_flit_queueing_latency(Tick latency, int vnet)
-    {
-        m_flit_queueing_latency[vnet] += latency;
-    }
-
-    void
-    increment_total_hops(int hops)
-    {
-        m_total_hops += hops;
-    }
-
   protected:
     // Configuration
     int m_num_rows;
@@ -32,6 +32,7 @@
 
 #include "mem/ruby/network/garnet/NetworkInterface.hh"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 
@@ -49,7 +50,8 @@ NetworkInterface::NetworkInterface(const Params *p)
     m_virtual_networks(p->virt_nets), m_vc_per_vnet(0),
     m_vc_allocator(m_virtual_networks, 0),
     m_deadlock_threshold(p->garnet_deadlock_threshold),
-    vc_busy_counter(m_virtual_networks, 0)
+    vc_busy_counter(m_virtual_networks, 0),
+    m_vnet_stats(m_virtual_networks), m_total_hops(0)
 {
     m_stall_count.resize(m_virtual_networks);
     niOutVcs.resize(0);
@@ -146,10 +148,10 @@ NetworkInterface::dequeueCallback()
 void
 NetworkInterface::incrementStats(flit *t_flit)
 {
-    int vnet = t_flit->get_vnet();
+    VnetStats &stats = m_vnet_stats[t_flit->get_vnet()];
 
     // Latency
-    m_net_ptr->increment_received_flits(vnet);
+    stats.flitsReceived++;
     Tick network_delay =
         t_flit->get_dequeue_time() -
         t_flit->get_enqueue_time() - cyclesToTicks(Cycles(1));
@@ -157,17 +159,24 @@ NetworkInterface::incrementStats(flit *t_flit)
     Tick dest_queueing_delay = (curTick() - t_flit->get_dequeue_time());
     Tick queueing_delay = src_queueing_delay + dest_queueing_delay;
 
-    m_net_ptr->increment_flit_network_latency(network_delay, vnet);
-    m_net_ptr->increment_flit_queueing_latency(queueing_delay, vnet);
+    stats.flitNetworkLatency += network_delay;
+    stats.flitQueueingLatency += queueing_delay;
 
     if (t_flit->get_type() == TAIL_ || t_flit->get_type() == HEAD_TAIL_) {
-        m_net_ptr->increment_received_packets(vnet);
-        m_net_ptr->increment_packet_network_latency(network_delay, vnet);
-        m_net_ptr->increment_packet_queueing_latency(queueing_delay, vnet);
+        stats.packetsReceived++;
+        stats.packetNetworkLatency += network_delay;
+        stats.packetQueueingLatency += queueing_delay;
     }
 
     // Hops
-    m_net_ptr->increment_total_hops(t_flit->get_route().hops_traversed);
+    m_total_hops += t_flit->get_route().hops_traversed;
+}
+
+void
+NetworkInterface::resetStats()
+{
+    std::fill(m_vnet_stats.begin(), m_vnet_stats.end(), VnetStats());
+    m_total_hops = 0;
 }
 
 /*
@@ -427,9 +436,9 @@ NetworkInterface::flitisizeMessage(MsgPtr msg_ptr, int vnet)
         // so that the first router increments it to 0
         route.hops_traversed = -1;
 
-        m_net_ptr->increment_injected_packets(vnet);
+        m_vnet_stats[vnet].packetsInjected++;
         for (int i = 0; i < num_flits; i++) {
-            m_net_ptr->increment_injected_flits(vnet);
+            m_vnet_stats[vnet].flitsInjected++;
             flit *fl = new flit(i, vc, vnet, route, num_flits, new_msg_ptr,
                 m_net_ptr->MessageSizeType_to_int(
                 net_msg_ptr->getMessageSize()),
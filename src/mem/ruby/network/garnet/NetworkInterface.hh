@@ -73,6 +73,32 @@ class NetworkInterface : public ClockedObject, public Consumer
 
     void scheduleFlit(flit *t_flit);
 
+    /**
+     * Traffic that went through the NI on a virtual network. The NI
+     * counts it itself, rather than in GarnetNetwork's stats, since NIs
+     * may be simulated by different event queues in parallel.
+     * GarnetNetwork::collateStats() sums it over all NIs.
+     */
+    struct VnetStats
+    {
+        Counter packetsInjected = 0;
+        Counter packetsReceived = 0;
+        Tick packetNetworkLatency = 0;
+        Tick packetQueueingLatency = 0;
+        Counter flitsInjected = 0;
+        Counter flitsReceived = 0;
+        Tick flitNetworkLatency = 0;
+        Tick flitQueueingLatency = 0;
+    };
+
+    const VnetStats &
+    getVnetStats(int vnet) const
+    {
+        return m_vnet_stats[vnet];
+    }
+    Counter getTotalHops() const { return m_total_hops; }
+    void resetStats();
+
     int get_router_id(int vnet)
     {
         OutputPort *oPort = getOutportForVnet(vnet);
@@ -270,6 +296,10 @@ class NetworkInterface : public ClockedObject, public Consumer
 
     std::vector<int> m_stall_count;
 
+    // Stats, see VnetStats
+    std::vector<VnetStats> m_vnet_stats;
+    Counter m_total_hops;
+
     // Input Flit Buffers
     // The flit buffers which will serve the Consumer
     std::vector<flitBuffer>  niOutVcs;
@@ -55,6 +55,15 @@ void
 NetworkLink::setLinkConsumer(Consumer *consumer)
 {
     link_consumer = consumer;
+
+    if (numMainEventQueues > 1) {
+        m_remote_inbox.reset(new CrossQueueInbox<flit *>(
+            name(), consumer->getObject()->eventQueue(),
+            [this](flit *&t_flit, Tick arrival) {
+                linkBuffer.insert(t_flit);
+                link_consumer->scheduleEventAbsolute(arrival);
+            }));
+    }
 }
 
 void
@@ -89,8 +98,13 @@ NetworkLink::wakeup()
                 (mVnets.size() == 0));
         }
         t_flit->set_time(clockEdge(m_latency));
-        linkBuffer.insert(t_flit);
-        link_consumer->scheduleEventAbsolute(clockEdge(m_latency));
+        if (m_remote_inbox && m_remote_inbox->isRemote()) {
+            m_remote_inbox->push(t_flit, clockEdge(m_latency),
+                                 cyclesToTicks(m_latency));
+        } else {
+            linkBuffer.insert(t_flit);
+            link_consumer->scheduleEventAbsolute(clockEdge(m_latency));
+        }
         m_link_utilized++;
         m_vc_load[t_flit->get_vc()]++;
     }
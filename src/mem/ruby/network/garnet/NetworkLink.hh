@@ -34,9 +34,11 @@
 #define __MEM_RUBY_NETWORK_GARNET_0_NETWORKLINK_HH__
 
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "mem/ruby/common/Consumer.hh"
+#include "mem/ruby/common/CrossQueueInbox.hh"
 #include "mem/ruby/network/garnet/CommonTypes.hh"
 #include "mem/ruby/network/garnet/flitBuffer.hh"
 #include "params/NetworkLink.hh"
@@ -95,6 +97,10 @@ class NetworkLink : public ClockedObject, public Consumer
     Consumer *link_consumer;
     flitBuffer *link_srcQueue;
 
+    // Flits in flight to a consumer simulated on another event queue.
+    // The link itself runs on the event queue of its source.
+    std::unique_ptr<CrossQueueInbox<flit *>> m_remote_inbox;
+
 };
 
 #endif // __MEM_RUBY_NETWORK_GARNET_0_NETWORKLINK_HH__
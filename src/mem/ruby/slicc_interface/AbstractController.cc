@@ -317,7 +317,7 @@ AbstractController::recvTimingResp(PacketPtr pkt)
     assert(getMemRespQueue());
     assert(pkt->isResponse());
 
-    std::shared_ptr<MemoryMsg> msg = std::make_shared<MemoryMsg>(clockEdge());
+    std::shared_ptr<MemoryMsg> msg = makeMessage<MemoryMsg>(clockEdge());
     (*msg).m_addr = pkt->getAddr();
     (*msg).m_Sender = m_machineID;
 
@@ -32,7 +32,9 @@
 #include <iostream>
 #include <memory>
 #include <stack>
+#include <utility>
 
+#include "base/pool_alloc.hh"
 #include "mem/packet.hh"
 #include "mem/ruby/common/NetDest.hh"
 #include "mem/ruby/protocol/MessageSizeType.hh"
@@ -134,4 +136,16 @@ operator<<(std::ostream& out, const Message& obj)
     return out;
 }
 
+/**
+ * Create a message of type T. The message and its shared_ptr control
+ * block come from a single block of the pool allocator.
+ */
+template <class T, class... Args>
+std::shared_ptr<T>
+makeMessage(Args&&... args)
+{
+    return std::allocate_shared<T>(PoolAllocator<T>(),
+                                   std::forward<Args>(args)...);
+}
+
 #endif // __MEM_RUBY_SLICC_INTERFACE_MESSAGE_HH__
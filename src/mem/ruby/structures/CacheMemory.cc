@@ -82,6 +82,7 @@ CacheMemory::CacheMemory(const Params *p)
     m_is_instruction_only_cache = p->is_icache;
     m_resource_stalls = p->resourceStalls;
     m_block_size = p->block_size;  // may be 0 at this point. Updated in init()
+    m_flat_tags = p->flat_tag_array;
     m_use_occupancy = dynamic_cast<WeightedLRUPolicy*>(
                                     m_replacementPolicy_ptr) ? true : false;
 }
@@ -101,6 +102,10 @@ CacheMemory::init()
                     std::vector<AbstractCacheEntry*>(m_cache_assoc, nullptr));
     replacement_data.resize(m_cache_num_sets,
                                std::vector<ReplData>(m_cache_assoc, nullptr));
+    if (m_flat_tags) {
+        m_tags.init(m_cache_num_sets, m_cache_assoc,
+                    m_start_index_bit + m_cache_num_set_bits);
+    }
     // instantiate all the replacement_data here
     for (int i = 0; i < m_cache_num_sets; i++) {
         for ( int j = 0; j < m_cache_assoc; j++) {
@@ -135,14 +140,14 @@ CacheMemory::addressToCacheSet(Addr address) const
 int
 CacheMemory::findTagInSet(int64_t cacheSet, Addr tag) const
 {
-    assert(tag == makeLineAddress(tag));
-    // search the set for the tags
-    auto it = m_tag_index.find(tag);
-    if (it != m_tag_index.end())
-        if (m_cache[cacheSet][it->second]->m_Permission !=
-            AccessPermission_NotPresent)
-            return it->second;
-    return -1; // Not found
+    int loc = findTagInSetIgnorePermissions(cacheSet, tag);
+    if (loc == -1)
+        return -1; // Not found
+    const AbstractCacheEntry *entry = m_flat_tags ?
+        m_tags.getData(cacheSet, loc) : m_cache[cacheSet][loc];
+    if (entry->m_Permission == AccessPermission_NotPresent)
+        return -1;
+    return loc;
 }
 
 // Given a cache index: returns the index of the tag in a set.
@@ -152,6 +157,8 @@ CacheMemory::findTagInSetIgnorePermissions(int64_t cacheSet,
                                            Addr tag) const
 {
     assert(tag == makeLineAddress(tag));
+    if (m_flat_tags)
+        return m_tags.findWay(cacheSet, tag);
     // search the set for the tags
     auto it = m_tag_index.find(tag);
     if (it != m_tag_index.end())
@@ -291,7 +298,11 @@ CacheMemory::allocate(Addr address, AbstractCacheEntry *entry)
             DPRINTF(RubyCache, "Allocate clearing lock for addr: %x\n",
                     address);
             set[i]->m_locked = -1;
-            m_tag_index[address] = i;
+            if (m_flat_tags) {
+                m_tags.insert(cacheSet, i, address, entry);
+            } else {
+                m_tag_index[address] = i;
+            }
             set[i]->setPosition(cacheSet, i);
             set[i]->replacementData = replacement_data[cacheSet][i];
             set[i]->setLastAccess(curTick());
@@ -317,7 +328,11 @@ CacheMemory::deallocate(Addr address)
     uint32_t way = entry->getWay();
     delete entry;
     m_cache[cache_set][way] = NULL;
-    m_tag_index.erase(address);
+    if (m_flat_tags) {
+        m_tags.invalidate(cache_set, way);
+    } else {
+        m_tag_index.erase(address);
+    }
 }
 
 // Returns with the physical address of the conflicting cache line
@@ -345,6 +360,8 @@ CacheMemory::lookup(Addr address)
     int64_t cacheSet = addressToCacheSet(address);
     int loc = findTagInSet(cacheSet, address);
     if (loc == -1) return NULL;
+    if (m_flat_tags)
+        return m_tags.getData(cacheSet, loc);
     return m_cache[cacheSet][loc];
 }
 
@@ -356,6 +373,8 @@ CacheMemory::lookup(Addr address) const
     int64_t cacheSet = addressToCacheSet(address);
     int loc = findTagInSet(cacheSet, address);
     if (loc == -1) return NULL;
+    if (m_flat_tags)
+        return m_tags.getData(cacheSet, loc);
     return m_cache[cacheSet][loc];
 }
 
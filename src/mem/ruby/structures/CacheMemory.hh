@@ -56,6 +56,7 @@
 #include "mem/ruby/slicc_interface/AbstractCacheEntry.hh"
 #include "mem/ruby/slicc_interface/RubySlicc_ComponentMapping.hh"
 #include "mem/ruby/structures/BankedArray.hh"
+#include "mem/ruby/structures/FlatTagArray.hh"
 #include "mem/ruby/system/CacheRecorder.hh"
 #include "params/RubyCache.hh"
 #include "sim/sim_object.hh"
@@ -200,6 +201,14 @@ class CacheMemory : public SimObject
     std::unordered_map<Addr, int> m_tag_index;
     std::vector<std::vector<AbstractCacheEntry*> > m_cache;
 
+    /**
+     * When set, tags are looked up in a contiguous per-set array, which
+     * also holds the entry pointers, instead of m_tag_index and m_cache.
+     * m_cache is still kept up to date for everything but lookups.
+     */
+    bool m_flat_tags;
+    FlatTagArray<AbstractCacheEntry*> m_tags;
+
     /**
      * We use BaseReplacementPolicy from Classic system here, hence we can use
      * different replacement policies from Classic system in Ruby system.
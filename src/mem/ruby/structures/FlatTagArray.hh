@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * A flat tag store for Ruby caches. Every way of a set has a 16-bit
+ * partial tag, and the partial tags of a set are packed next to each
+ * other, four to a 64-bit word, so the ways of a 16- or 32-way set are
+ * compared a word at a time within a single host cache line. The full
+ * tags, together with a small payload such as the entry pointer, live
+ * in a parallel array and are only read for the (usually single) way
+ * whose partial tag matches.
+ * Compared to a hash map from address to way this avoids the hash probe
+ * and the node pointer chase on every lookup, and a miss normally
+ * touches nothing but the partial tags.
+ */
+
+#ifndef __MEM_RUBY_STRUCTURES_FLATTAGARRAY_HH__
+#define __MEM_RUBY_STRUCTURES_FLATTAGARRAY_HH__
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "base/bitfield.hh"
+#include "base/types.hh"
+
+template <class T>
+class FlatTagArray
+{
+  public:
+    /** Tag of an unused way; never a valid line address. */
+    static const Addr InvalidTag = MaxAddr;
+
+    FlatTagArray() : m_num_sets(0), m_assoc(0), m_words(0), m_shift(0) {}
+
+    /**
+     * @param num_sets Number of sets.
+     * @param assoc Number of ways per set.
+     * @param tag_shift Lowest address bit above the set index; the
+     *                  partial tags are made of the bits above it.
+     */
+    void
+    init(int num_sets, int assoc, int tag_shift)
+    {
+        m_num_sets = num_sets;
+        m_assoc = assoc;
+        m_words = (assoc + LanesPerWord - 1) / LanesPerWord;
+        m_shift = tag_shift;
+        m_partial.assign((size_t)num_sets * m_words, 0);
+        m_ways.assign((size_t)num_sets * m_words * LanesPerWord, Way());
+    }
+
+    /**
+     * Find the way holding a tag. The partial tags are compared four at
+     * a time with plain 64-bit arithmetic: after XORing in the key, a
+     * matching lane is zero, and subtracting one from every lane sets
+     * the top bit of each zero lane. A borrow can also flag the lane
+     * above a zero lane, but every candidate is checked against its full
+     * tag, so such false positives only cost a compare.
+     *
+     * @return The way, or -1 if the tag is not in the set.
+     */
+    int
+    findWay(int64_t set, Addr tag) const
+    {
+        assert(set < m_num_sets);
+        assert(tag != InvalidTag);
+        const uint64_t *row = &m_partial[set * m_words];
+        const Way *ways = &m_ways[set * m_words * LanesPerWord];
+        const uint64_t key = partialTag(tag) * LaneOnes;
+        for (int word = 0; word < m_words; ++word) {
+            const uint64_t diff = row[word] ^ key;
+            uint64_t hits = (diff - LaneOnes) & ~diff & (LaneOnes << 15);
+            while (hits) {
+                int way = word * LanesPerWord + ctz64(hits) / 16;
+                if (ways[way].tag == tag)
+                    return way;
+                hits &= hits - 1;
+            }
+        }
+        return -1;
+    }
+
+    /** The data stored with a way, e.g. its cache entry. */
+    const T &
+    getData(int64_t set, int way) const
+    {
+        assert(set < m_num_sets && way < m_assoc);
+        return m_ways[set * m_words * LanesPerWord + way].data;
+    }
+
+    void
+    insert(int64_t set, int way, Addr tag, const T &data)
+    {
+        assert(set < m_num_sets && way < m_assoc);
+        assert(tag != InvalidTag);
+        Way &w = m_ways[set * m_words * LanesPerWord + way];
+        w.tag = tag;
+        w.data = data;
+        setPartial(set, way, partialTag(tag));
+    }
+
+    void
+    invalidate(int64_t set, int way)
+    {
+        assert(set < m_num_sets && way < m_assoc);
+        m_ways[set * m_words * LanesPerWord + way] = Way();
+        setPartial(set, way, 0);
+    }
+
+  private:
+    /** Number of 16-bit partial tags packed in each 64-bit word. */
+    static const int LanesPerWord = 4;
+
+    /** A one in the lowest bit of every lane. */
+    static const uint64_t LaneOnes = 0x0001000100010001ULL;
+
+    /**
+     * Fold the bits above the set index into 15 bits. The top bit marks
+     * the way as valid, so an unused way (0) never matches.
+     */
+    uint64_t
+    partialTag(Addr tag) const
+    {
+        Addr t = tag >> m_shift;
+        t ^= t >> 15;
+        t ^= t >> 30;
+        return 0x8000 | (t & 0x7fff);
+    }
+
+    void
+    setPartial(int64_t set, int way, uint64_t partial)
+    {
+        uint64_t &word = m_partial[set * m_words + way / LanesPerWord];
+        const int shift = (way % LanesPerWord) * 16;
+        word = (word & ~(uint64_t(0xffff) << shift)) | (partial << shift);
+    }
+
+    int m_num_sets;
+    int m_assoc;
+    /** Number of words of partial tags per set. */
+    int m_words;
+    int m_shift;
+
+    /**
+     * A full tag and its data, kept together so that a hit reads a
+     * single host cache line after the partial tag search.
+     */
+    struct Way
+    {
+        Way() : tag(InvalidTag), data() {}
+        Addr tag;
+        T data;
+    };
+
+    std::vector<uint64_t> m_partial;
+    std::vector<Way> m_ways;
+};
+
+#endif // __MEM_RUBY_STRUCTURES_FLATTAGARRAY_HH__
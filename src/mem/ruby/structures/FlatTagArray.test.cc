@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <gtest/gtest.h>
+
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "mem/ruby/structures/FlatTagArray.hh"
+
+namespace
+{
+
+/** Block offset and set index bits of the caches under test. */
+const int BlockBits = 6;
+const int SetBits = 6;
+const int NumSets = 1 << SetBits;
+const int TagShift = BlockBits + SetBits;
+
+/**
+ * The lookup CacheMemory uses without a flat tag array: a map from
+ * line address to way, next to the tags of every way.
+ */
+class MapTags
+{
+  public:
+    MapTags(int num_sets, int assoc)
+        : tags(num_sets, std::vector<Addr>(assoc, MaxAddr)),
+          data(num_sets, std::vector<int>(assoc, 0))
+    {}
+
+    int
+    findWay(int64_t set, Addr tag) const
+    {
+        auto it = index.find(tag);
+        return it == index.end() ? -1 : it->second;
+    }
+
+    int getData(int64_t set, int way) const { return data[set][way]; }
+
+    bool
+    valid(int64_t set, int way) const
+    {
+        return tags[set][way] != MaxAddr;
+    }
+
+    void
+    insert(int64_t set, int way, Addr tag, int value)
+    {
+        tags[set][way] = tag;
+        data[set][way] = value;
+        index[tag] = way;
+    }
+
+    void
+    invalidate(int64_t set, int way)
+    {
+        index.erase(tags[set][way]);
+        tags[set][way] = MaxAddr;
+        data[set][way] = 0;
+    }
+
+  private:
+    std::unordered_map<Addr, int> index;
+    std::vector<std::vector<Addr>> tags;
+    std::vector<std::vector<int>> data;
+};
+
+/** Line address of a set with the given bits above the set index. */
+Addr
+lineAddr(int64_t set, Addr high)
+{
+    return (high << TagShift) | (set << BlockBits);
+}
+
+/**
+ * Flipping these bits above the set index keeps the partial tag, as the
+ * array folds bit 15 onto bit 0.
+ */
+const Addr AliasBits = 0x8001;
+
+/**
+ * High bits of the tags used in a set: small ones, ones aliasing them
+ * in the partial tags, and ones at the top of the address space.
+ */
+std::vector<Addr>
+tagPool(int64_t set, int count)
+{
+    std::vector<Addr> pool;
+    const Addr top = (MaxAddr >> TagShift) - 1;
+    for (int i = 0; i < count; ++i) {
+        pool.push_back(lineAddr(set, i));
+        pool.push_back(lineAddr(set, i ^ AliasBits));
+        pool.push_back(lineAddr(set, top - i));
+    }
+    return pool;
+}
+
+} // anonymous namespace
+
+TEST(FlatTagArrayTest, AliasingTags)
+{
+    FlatTagArray<int> flat;
+    flat.init(NumSets, 8, TagShift);
+
+    const Addr a = lineAddr(3, 0x1234);
+    const Addr b = lineAddr(3, 0x1234 ^ AliasBits);
+    const Addr top = lineAddr(3, (MaxAddr >> TagShift) - 1);
+
+    flat.insert(3, 0, a, 10);
+    EXPECT_EQ(flat.findWay(3, a), 0);
+    EXPECT_EQ(flat.findWay(3, b), -1);
+    EXPECT_EQ(flat.findWay(4, a), -1);
+
+    flat.insert(3, 5, b, 11);
+    flat.insert(3, 7, top, 12);
+    EXPECT_EQ(flat.findWay(3, a), 0);
+    EXPECT_EQ(flat.findWay(3, b), 5);
+    EXPECT_EQ(flat.findWay(3, top), 7);
+    EXPECT_EQ(flat.getData(3, 5), 11);
+    EXPECT_EQ(flat.getData(3, 7), 12);
+
+    flat.invalidate(3, 0);
+    EXPECT_EQ(flat.findWay(3, a), -1);
+    EXPECT_EQ(flat.findWay(3, b), 5);
+
+    // Replacing a way drops its old tag
+    flat.insert(3, 5, a, 13);
+    EXPECT_EQ(flat.findWay(3, a), 5);
+    EXPECT_EQ(flat.findWay(3, b), -1);
+    EXPECT_EQ(flat.getData(3, 5), 13);
+}
+
+TEST(FlatTagArrayTest, MatchesMapLookup)
+{
+    for (int assoc : { 1, 3, 4, 8, 16, 17, 32 }) {
+        SCOPED_TRACE(assoc);
+        std::mt19937 rng(assoc);
+
+        FlatTagArray<int> flat;
+        flat.init(NumSets, assoc, TagShift);
+        MapTags map(NumSets, assoc);
+
+        std::vector<std::vector<Addr>> pools;
+        for (int set = 0; set < NumSets; ++set)
+            pools.push_back(tagPool(set, assoc + 1));
+
+        for (int step = 0; step < 20000; ++step) {
+            const int64_t set = rng() % NumSets;
+            const int way = rng() % assoc;
+            const auto &pool = pools[set];
+            const Addr tag = pool[rng() % pool.size()];
+
+            switch (rng() % 3) {
+              case 0:
+                // Insert, replacing the way if it is in use. A cache
+                // never holds the same line twice.
+                if (map.findWay(set, tag) != -1)
+                    break;
+                if (map.valid(set, way)) {
+                    flat.invalidate(set, way);
+                    map.invalidate(set, way);
+                }
+                flat.insert(set, way, tag, step);
+                map.insert(set, way, tag, step);
+                break;
+              case 1:
+                if (map.valid(set, way)) {
+                    flat.invalidate(set, way);
+                    map.invalidate(set, way);
+                }
+                break;
+              default:
+                break;
+            }
+
+            const int found = flat.findWay(set, tag);
+            ASSERT_EQ(found, map.findWay(set, tag)) << "step " << step;
+            if (found != -1)
+                ASSERT_EQ(flat.getData(set, found), map.getData(set, found));
+        }
+
+        for (int set = 0; set < NumSets; ++set) {
+            for (Addr tag : pools[set]) {
+                const int found = flat.findWay(set, tag);
+                ASSERT_EQ(found, map.findWay(set, tag));
+                if (found != -1) {
+                    ASSERT_EQ(flat.getData(set, found),
+                              map.getData(set, found));
+                }
+            }
+        }
+    }
+}
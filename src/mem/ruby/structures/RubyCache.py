@@ -45,4 +45,6 @@ class RubyCache(SimObject):
     dataAccessLatency = Param.Cycles(1, "cycles for a data array access")
     tagAccessLatency = Param.Cycles(1, "cycles for a tag array access")
     resourceStalls = Param.Bool(False, "stall if there is a resource failure")
+    flat_tag_array = Param.Bool(True, "look tags up in a contiguous "
+        "per-set array instead of a hash map")
     ruby_system = Param.RubySystem(Parent.any, "")
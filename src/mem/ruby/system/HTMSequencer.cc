@@ -147,9 +147,9 @@ HTMSequencer::htmCallback(Addr address,
         assert(address == makeLineAddress(address));
         assert(m_RequestTable.find(address) != m_RequestTable.end());
 
-        auto &seq_req_list = m_RequestTable[address];
-        while (!seq_req_list.empty()) {
-            SequencerRequest &request = seq_req_list.front();
+        auto *seq_req_list = &m_RequestTable[address];
+        while (!seq_req_list->empty()) {
+            SequencerRequest &request = seq_req_list->front();
 
             PacketPtr pkt = request.pkt;
             markRemoved();
@@ -170,10 +170,13 @@ HTMSequencer::htmCallback(Addr address,
             rubyHtmCallback(pkt, htm_return_code);
             testDrainComplete();
             pkt = nullptr;
-            seq_req_list.pop_front();
+            // The callback may have issued new requests, which moves the
+            // entries of the request table
+            seq_req_list = &m_RequestTable[address];
+            seq_req_list->pop_front();
         }
         // free all outstanding requests corresponding to this address
-        if (seq_req_list.empty()) {
+        if (seq_req_list->empty()) {
             m_RequestTable.erase(address);
         }
     } else {
@@ -355,7 +355,7 @@ Sequencer::writeCallback(Addr address, DataBlock& data,
     //
     assert(address == makeLineAddress(address));
     assert(m_RequestTable.find(address) != m_RequestTable.end());
-    auto &seq_req_list = m_RequestTable[address];
+    auto *seq_req_list = &m_RequestTable[address];
 
     // Perform hitCallback on every cpu request made to this cache block while
     // ruby request was outstanding. Since only 1 ruby request was made,
@@ -363,8 +363,8 @@ Sequencer::writeCallback(Addr address, DataBlock& data,
     bool ruby_request = true;
     int aliased_stores = 0;
     int aliased_loads = 0;
-    while (!seq_req_list.empty()) {
-        SequencerRequest &seq_req = seq_req_list.front();
+    while (!seq_req_list->empty()) {
+        SequencerRequest &seq_req = seq_req_list->front();
         if (ruby_request) {
             assert(seq_req.m_type != RubyRequestType_LD);
             assert(seq_req.m_type != RubyRequestType_Load_Linked);
@@ -426,11 +426,14 @@ Sequencer::writeCallback(Addr address, DataBlock& data,
                         initialRequestTime, forwardRequestTime,
                         firstResponseTime);
         }
-        seq_req_list.pop_front();
+        // The callback may have issued new requests, which moves the
+        // entries of the request table
+        seq_req_list = &m_RequestTable[address];
+        seq_req_list->pop_front();
     }
 
     // free all outstanding requests corresponding to this address
-    if (seq_req_list.empty()) {
+    if (seq_req_list->empty()) {
         m_RequestTable.erase(address);
     }
 }
@@ -448,15 +451,15 @@ Sequencer::readCallback(Addr address, DataBlock& data,
     //
     assert(address == makeLineAddress(address));
     assert(m_RequestTable.find(address) != m_RequestTable.end());
-    auto &seq_req_list = m_RequestTable[address];
+    auto *seq_req_list = &m_RequestTable[address];
 
     // Perform hitCallback on every cpu request made to this cache block while
     // ruby request was outstanding. Since only 1 ruby request was made,
     // profile the ruby latency once.
     bool ruby_request = true;
     int aliased_loads = 0;
-    while (!seq_req_list.empty()) {
-        SequencerRequest &seq_req = seq_req_list.front();
+    while (!seq_req_list->empty()) {
+        SequencerRequest &seq_req = seq_req_list->front();
         if (ruby_request) {
             assert((seq_req.m_type == RubyRequestType_LD) ||
                    (seq_req.m_type == RubyRequestType_Load_Linked) ||
@@ -481,11 +484,14 @@ Sequencer::readCallback(Addr address, DataBlock& data,
         hitCallback(&seq_req, data, true, mach, externalHit,
                     initialRequestTime, forwardRequestTime,
                     firstResponseTime);
-        seq_req_list.pop_front();
+        // The callback may have issued new requests, which moves the
+        // entries of the request table
+        seq_req_list = &m_RequestTable[address];
+        seq_req_list->pop_front();
     }
 
     // free all outstanding requests corresponding to this address
-    if (seq_req_list.empty()) {
+    if (seq_req_list->empty()) {
         m_RequestTable.erase(address);
     }
 }
@@ -708,12 +714,12 @@ Sequencer::issueRequest(PacketPtr pkt, RubyRequestType secondary_type)
     // check if the packet has data as for example prefetch and flush
     // requests do not
     std::shared_ptr<RubyRequest> msg =
-        std::make_shared<RubyRequest>(clockEdge(), pkt->getAddr(),
-                                      pkt->isFlush() ?
-                                      nullptr : pkt->getPtr<uint8_t>(),
-                                      pkt->getSize(), pc, secondary_type,
-                                      RubyAccessMode_Supervisor, pkt,
-                                      PrefetchBit_No, proc_id, core_id);
+        makeMessage<RubyRequest>(clockEdge(), pkt->getAddr(),
+                                 pkt->isFlush() ?
+                                 nullptr : pkt->getPtr<uint8_t>(),
+                                 pkt->getSize(), pc, secondary_type,
+                                 RubyAccessMode_Supervisor, pkt,
+                                 PrefetchBit_No, proc_id, core_id);
 
     DPRINTFR(ProtocolTrace, "%15s %3s %10s%20s %6s>%-6s %#x %s\n",
             curTick(), m_version, "Seq", "Begin", "", "",
@@ -738,7 +744,7 @@ Sequencer::issueRequest(PacketPtr pkt, RubyRequestType secondary_type)
 
 template <class KEY, class VALUE>
 std::ostream &
-operator<<(ostream &out, const std::unordered_map<KEY, VALUE> &map)
+operator<<(ostream &out, const FlatHashMap<KEY, VALUE> &map)
 {
     for (const auto &table_entry : map) {
         out << "[ " << table_entry.first << " =";
@@ -43,8 +43,8 @@
 
 #include <iostream>
 #include <list>
-#include <unordered_map>
 
+#include "base/flat_hash_map.hh"
 #include "mem/ruby/common/Address.hh"
 #include "mem/ruby/protocol/MachineType.hh"
 #include "mem/ruby/protocol/RubyRequestType.hh"
@@ -199,8 +199,10 @@ class Sequencer : public RubyPort
     Sequencer& operator=(const Sequencer& obj);
 
   protected:
-    // RequestTable contains both read and write requests, handles aliasing
-    std::unordered_map<Addr, std::list<SequencerRequest>> m_RequestTable;
+    // RequestTable contains both read and write requests, handles aliasing.
+    // Insertions and removals move the entries of the table, so references
+    // to them must not be held across anything that may issue requests.
+    FlatHashMap<Addr, std::list<SequencerRequest>> m_RequestTable;
 
     Cycles m_deadlock_threshold;
 
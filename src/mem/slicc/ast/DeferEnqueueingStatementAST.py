@@ -62,7 +62,7 @@ class DeferEnqueueingStatementAST(StatementAST):
 
         # Declare message
         code("std::shared_ptr<${{msg_type.c_ident}}> out_msg = "\
-             "std::make_shared<${{msg_type.c_ident}}>(clockEdge());")
+             "makeMessage<${{msg_type.c_ident}}>(clockEdge());")
 
         # The other statements
         t = self.statements.generate(code, None)
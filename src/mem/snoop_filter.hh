@@ -44,9 +44,9 @@
 #define __MEM_SNOOP_FILTER_HH__
 
 #include <bitset>
-#include <unordered_map>
 #include <utility>
 
+#include "base/flat_hash_map.hh"
 #include "mem/packet.hh"
 #include "mem/port.hh"
 #include "mem/qport.hh"
@@ -215,9 +215,10 @@ class SnoopFilter : public SimObject {
         SnoopMask holder;
     };
     /**
-     * HashMap of SnoopItems indexed by line address
+     * HashMap of SnoopItems indexed by line address. Note that any
+     * insertion or removal invalidates all iterators into the map.
      */
-    typedef std::unordered_map<Addr, SnoopItem> SnoopFilterCache;
+    typedef FlatHashMap<Addr, SnoopItem> SnoopFilterCache;
 
     /**
      * Simple factory methods for standard return values.
@@ -267,7 +268,11 @@ class SnoopFilter : public SimObject {
      * This structure keeps track of the state previous to such changes.
      */
     struct ReqLookupResult {
-        /** Iterator used to store the result from lookupRequest. */
+        /**
+         * Iterator used to store the result from lookupRequest. The
+         * snoop filter must not be updated until finishRequest is
+         * called, as that would invalidate the iterator.
+         */
         SnoopFilterCache::iterator it;
 
         /**
@@ -39,36 +39,41 @@
 #define __MEM_STACK_DIST_CALC_HH__
 
 #include <limits>
-#include <map>
+#include <utility>
 #include <vector>
 
+#include "base/flat_hash_map.hh"
 #include "base/types.hh"
 
 /**
   * The stack distance calculator is a passive object that merely
-  * observes the addresses pass to it. It calculates stack distances
-  * of incoming addresses based on the partial sum hierarchy tree
-  * algorithm described by Alamasi et al.
-  * http://doi.acm.org/10.1145/773039.773043.
+  * observes the addresses pass to it. It calculates the LRU stack
+  * distance of each incoming address, i.e. the number of distinct
+  * addresses seen since the previous access to the same address.
   *
-  * A tree structure is maintained and updated at each transaction
-  * (unique or non-unique). The tree is implemented as an STL vector
-  * with layers of the form <map> Each layer in this tree is an
-  * ordered map <uint64_t, Node*>. Nodes are structs which take form
-  * of leaf, intermediate and root nodes. For example, in a tree with 3
-  * layers, tree[0][5] gives a leaf node pointer for key=5 tree[1][1]
-  * gives an intermediate node pointer for key=1 tree[2][0] gives the
-  * root node in the tree.
+  * Every address in the stack is stamped with the value of a counter
+  * when it is last accessed, and the stamps in use are kept as ones in
+  * a Fenwick (binary indexed) tree. The stack distance of an address
+  * is the number of stamps after its own, which the tree gives as a
+  * prefix sum in O(log n) time. The tree is a flat array indexed by
+  * the stamp, so an access costs a hash map lookup and two walks over
+  * at most log2(n) array elements, without allocating.
+  *
+  * Stamps only grow, so when the tree is full the addresses still in
+  * the stack are renumbered in stamp order and the tree is rebuilt,
+  * doubling its size if more than half of it was in use. This keeps
+  * the amortized cost of an access logarithmic in the number of
+  * distinct addresses.
   *
   * At every transaction a hash-map (aiMap) is looked up to check if
   * the address was already encountered before. Based on this lookup a
   * transaction can be termed as unique or non-unique.
   *
   * In addition to the normal stack distance calculation, a feature to
-  * mark an old node in the tree is added. This is useful if it is
+  * mark an old entry in the stack is added. This is useful if it is
   * required to see the reuse pattern. For example, BackInvalidates
   * from a lower level (e.g. membus to L2), can be marked (isMarked
-  * flag of Node set to True). Then later if this same address is
+  * flag of the entry set to True). Then later if this same address is
   * accessed (by L1), the value of the isMarked flag would be
   * True. This would give some insight on how the BackInvalidates
   * policy of the lower level affect the read/write accesses in an
@@ -77,40 +82,32 @@
   * There are two functions provided to interface with the calculator:
   * 1. pair<uint64_t, bool> calcStackDistAndUpdate(Addr r_address,
   *                                                bool addNewNode)
-  * At every unique transaction a new leaf node is added at tree[0](leaf layer)
-  * and linked to the layer above (if addNewNode is True). The sums of all
-  * the intermediate nodes is updated till the root. The stack-distance is
-  * returned as a Constant representing INFINITY.
+  * At every unique transaction the address is pushed on the stack (if
+  * addNewNode is True) and the stack-distance is returned as a
+  * Constant representing INFINITY.
   *
-  * At every non-unique transaction the tree is traversed from the
-  * leaf at the returned index to the root, the old node is deleted
-  * from the tree, and the sums (to the right are collected) and
-  * decremented. The collected sum represets the stack distance of the
-  * found node. If this node was marked then a bool flag set to True
-  * is returned with the stack_distance. During this operation a node
-  * is discarded at the leaf layer always. Moreover during the
-  * traversal upwards using the updateSum() method, if an intermediate
-  * node is found with no children connected to it, then that is
-  * discarded too.
+  * At every non-unique transaction the stack distance of the old
+  * entry is counted, and the entry is removed from the stack. If it
+  * was marked then a bool flag set to True is returned with the
+  * stack_distance. If addNewNode is True the address is then pushed
+  * on the top of the stack again, unmarked.
   *
   * The return value of this function is a pair representing the
   * stack_distance and the value of the marked flag.
   *
   * 2. pair<uint64_t , bool> calcStackDist(Addr r_address, bool mark)
   * This is a stripped down version of the above function which is used to
-  * just inspect the tree, and mark a leaf node (if mark flag is set). The
-  * functionality to add a new node is removed.
+  * just inspect the stack, and mark an entry (if mark flag is set). The
+  * functionality to add a new entry is removed.
   *
   * At every unique transaction the stack-distance is returned as a constant
   * representing INFINITY.
   *
-  * At every non-unique transaction the tree is traversed from the
-  * leaf at the returned index to the root, and the sums (to the right)
-  * are collected. The collected sum represets the stack distance of
-  * the found node.
+  * At every non-unique transaction the stack distance of the old
+  * entry is counted and returned.
   *
-  * This function does NOT Modify the stack. (No node is added or
-  * deleted).  It is just used to mark a node already created and get
+  * This function does NOT Modify the stack. (No entry is added or
+  * deleted).  It is just used to mark an entry already created and get
   * its stack distance.
   *
   * The return value of this function is a pair representing the stack
@@ -136,7 +133,7 @@
   *  *I: stack-distance = infinity,
   *  *SD: Stack Distance
   *  *r_address: address to be added, *prevMark: value of isMarked flag
-  *                                                              of the Node)
+  *                                                              of the entry)
   *
   * Invalidates refer to a type of packet that removes something from
   * a cache, either autonoumously (due-to cache's own replacement
@@ -148,15 +145,6 @@
   * Delete Old Entry |calcStackDistAndUpdate|Writebacks/Cleanevicts|
   * Dist.of Old entry|calcStackDist         |Cleanevicts/Invalidate|
   *
-  * Node Balancing: The tree structure is maintained by an
-  * updateTree() operation called when an intermediate node is
-  * required. The update operation is roughly categorized as a root
-  * update or intermediate layer update. When number of leaf nodes
-  * grow over a power of 2 then a new layer is added at the top of the
-  * tree and a new root node is initialized. The old node at the lower
-  * layer is connected to this.  In an intermediate node update
-  * operation a new intermediate node is added to the required layer.
-  *
   * Debugging: Debugging can be enabled by setting the verifyStack flag
   * true. Debugging is implemented using a dummy stack that behaves in
   * a naive way, using STL vectors (i.e each unique address is pushed
@@ -173,111 +161,76 @@ class StackDistCalc
 
   private:
 
-    struct Node;
-
-    typedef std::map<uint64_t, Node*> IndexNodeMap;
-    typedef std::map<Addr, uint64_t> AddressIndexMap;
-    typedef std::vector<IndexNodeMap> TreeType;
-
     /**
-     * Gets sum from the node upwards recursively till the root.  This
-     * function is called first by getSumsLeavesToRoot, and then
-     * recursively calls itself.
-     *
-     * @param node pointer to the node which is updated
-     * @param from_left variable which says that the request arrived
-     *        from the left
-     * @param sum_from_below Sum of left and right children below
-     * @param level level in the tree the calling node is located
-     * @param stack_dist stack distance of the node below
-     * @return The stack distance of the current address.
-     *
+     * Stack entry of an address.
      */
-    uint64_t getSum(Node* node, bool from_left, uint64_t sum_from_below,
-                    uint64_t stack_dist, uint64_t level) const;
+    struct Entry
+    {
+        /** Stamp of the last access, and position in the tree */
+        uint64_t stamp;
+
+        /**
+         * Flag to indicate if this address is marked. Used in case
+         * where stack distance of a touched address is required.
+         */
+        bool isMarked;
+    };
+
+    typedef FlatHashMap<Addr, Entry> AddressEntryMap;
+
+    /** Number of stamps in the tree before it first has to grow */
+    static const uint64_t InitialStamps = 1 << 16;
 
     /**
-     * Gets the sum from the leaf node specified. This function
-     * is called by calcStackDist.
-     *
-     * @param node pointer to the node which is updated
-     * @return The stack distance of the current address.
+     * Add delta to the count of a stamp, and to the partial sums
+     * covering it.
      *
+     * @param stamp Stamp to update
+     * @param delta 1 when the stamp is taken, -1 when it is freed
      */
-    uint64_t getSumsLeavesToRoot(Node* node) const;
+    void updateTree(uint64_t stamp, int delta);
 
     /**
-     * Updates the nodes upwards recursively till the root.
-     * This function is first called by updateSumsLeavesToRoot,
-     * and then it recursively calls itself.
-     *
-     * @param node pointer to the node which is updated
-     * @param from_left variable which says that the request arrived
-     * from the left
-     * @param sum_from_below Sum of left and right children below
-     * @param level level in the tree the calling node is located
-     * @param stack_dist stack distance of the node below
-     * @param discard_node whether the calling node was discarded or not
-     * @return The stack distance of the current address.
+     * Count the stamps in use up to and including the given one.
      *
+     * @param stamp Last stamp to count
+     * @return Number of stamps in use
      */
-    uint64_t updateSum(Node* node,
-                       bool from_left, uint64_t sum_from_below, uint64_t level,
-                       uint64_t stack_dist, bool discard_node);
+    uint64_t prefixSum(uint64_t stamp) const;
 
     /**
-     * Updates the leaf nodes and nodes above. This function is
-     * called by the calcStackDistAndUpdate.
-     *
-     * @param node pointer to the node which is updated
-     * @param is_new_leaf is true if this is a newly added node
-     * @return The stack distance of the current address.
+     * Get the stack distance of an entry, i.e. the number of stamps
+     * after its own that are in use.
      *
+     * @param entry Entry in the stack
+     * @return The stack distance of the entry
      */
-    uint64_t updateSumsLeavesToRoot(Node* node, bool is_new_leaf);
+    uint64_t stackDist(const Entry &entry) const
+    {
+        return inUse - prefixSum(entry.stamp);
+    }
 
     /**
-     * updateTree is a tree balancing operation, which maintains the
-     * binary tree structure.
-     * This method is called whenever index%2 == 0 (i.e. every
-     * alternate cycle) The two main operation are :
-     * OP1. Moving the root node one layer up if index counter
-     *       crosses power of 2
-     * OP2. Addition of intermediate nodes as and when required
-     *      and linking them to their parents in the layer above.
+     * Renumber the entries in the stack in stamp order and rebuild
+     * the tree, growing it if more than half of it is in use.
      */
-    void updateTree();
+    void compactTree();
 
     /**
-     * This method is used for verification purposes
-     * It recursively traverses upwards from the given node till
-     * the root to check if the ultimate parent node (root-node) points
-     * to null.
-     *
-     * @param node pointer to the node whose sanity is being checked
-     * @param level the level at which this node is located in the tree
-     *
+     * This method is used for verification purposes. It checks that
+     * the tree counts exactly the entries in the stack.
      */
-    void sanityCheckTree(const Node* node, uint64_t level = 0) const;
+    void sanityCheckTree() const;
 
     /**
      * Return the counter for address accesses (unique and
      * non-unique). This is further used to dump stats at
      * regular intervals.
      *
-     * @return The stack distance of the current address.
+     * @return The number of addresses pushed on the stack.
      */
     uint64_t getIndex() const { return index; }
 
-    /**
-     * Query depth of the tree (tree[0] represents leaf layer while
-     * tree[treeDepth] represents the root layer, all layers in
-     * between contain intermediate nodes)
-     *
-     * @return Tree depth
-     */
-    uint64_t getTreeDepth() const { return tree.size() - 1; }
-
     /**
      * Print the last n items on the stack.
      * This method prints top n entries in the tree based implementation as
@@ -290,7 +243,8 @@ class StackDistCalc
      * This is an alternative implementation of the stack-distance
      * in a naive way. It uses simple STL vector to represent the stack.
      * It can be used in parallel for debugging purposes.
-     * It is 10x slower than the tree based implemenation.
+     * It is orders of magnitude slower than the tree based
+     * implementation.
      *
      * @param r_address The current address to process
      * @param update_stack Flag to indicate if stack should be updated
@@ -304,8 +258,6 @@ class StackDistCalc
   public:
     StackDistCalc(bool verify_stack = false);
 
-    ~StackDistCalc();
-
     /**
      * A convenient way of refering to infinity.
      */
@@ -314,7 +266,7 @@ class StackDistCalc
 
     /**
      * Process the given address. If Mark is true then set the
-     * mark flag of the leaf node.
+     * mark flag of the entry.
      * This function returns the stack distance of the incoming
      * address and the previous status of the mark flag.
      *
@@ -327,14 +279,14 @@ class StackDistCalc
 
     /**
      * Process the given address:
-     *  - Lookup the tree for the given address
-     *  - delete old node if found in tree
-     *  - add a new node (if addNewNode flag is set)
+     *  - Lookup the stack for the given address
+     *  - delete old entry if found in the stack
+     *  - push a new entry (if addNewNode flag is set)
      * This function returns the stack distance of the incoming
      * address and the status of the mark flag.
      *
      * @param r_address The current address to process
-     * @param addNewNode If true, a new node is added to the tree
+     * @param addNewNode If true, a new entry is pushed on the stack
      * @return The stack distance of the current address and the mark flag.
      */
     std::pair<uint64_t, bool> calcStackDistAndUpdate(const Addr r_address,
@@ -343,65 +295,26 @@ class StackDistCalc
   private:
 
     /**
-     * Node which takes form of Leaf, INode or Root
+     * Internal counter for address accesses (unique and non-unique)
+     * This counter increments everytime an address is pushed on the
+     * stack.
      */
-    struct Node{
-        // Sum of the left children
-        uint64_t sumLeft;
-
-        // Sum of the right children
-        uint64_t sumRight;
-
-        // Flag to indicate that sumLeft has gone from non-zero value to 0
-        bool discardLeft;
-
-        // Flag to indicate that sumRight has gone from non-zero value to 0
-        bool discardRight;
-
-        // Index of the current element in the Map
-        uint64_t nodeIndex;
-
-        // Pointer to the parent
-        Node* parent;
-
-        // Flag to mark the node as the right/left child
-        bool isLeftNode;
+    uint64_t index;
 
-        /**
-         * Flag to indicate if this address is marked. Used in case
-         * where stack distance of a touched address is required.
-         */
-        bool isMarked;
+    /** Next stamp to hand out, the tree is full when it is reached */
+    uint64_t nextStamp;
 
-        /**
-         * The discard flags are false by default they become true if
-         * the node is reached again in a future lookup.
-         */
-        Node() : sumLeft(0), sumRight(0), discardLeft(false),
-                 discardRight(false), nodeIndex(0),
-                 parent(nullptr), isLeftNode(true), isMarked(false)
-        { }
-    };
+    /** Number of stamps in use, i.e. the depth of the stack */
+    uint64_t inUse;
 
     /**
-     * Internal counter for address accesses (unique and non-unique)
-     * This counter increments everytime the calcStackDist() method is
-     * called. This counter is used as a key for the hash- map at the
-     * leaf layer. Practically at every call to the calculator this
-     * counter is incremented and a new leaf node is added in the tree
-     * at the leaf layer using this counter value as the key.
+     * Fenwick tree of partial sums over the stamps. Element i (from
+     * 1) holds the number of stamps in use in (i - lsb(i), i].
      */
-    uint64_t index;
-
-    // Binary tree of partial sums
-    TreeType tree;
-
-    // Hash map which returns last seen index of each address
-    AddressIndexMap aiMap;
+    std::vector<uint32_t> tree;
 
-    // Keeps count of number of the next unique index for each
-    // level in the tree
-    std::vector<uint64_t> nextIndex;
+    // Hash map which returns the stack entry of each address
+    AddressEntryMap aiMap;
 
     // Dummy Stack for verification
     std::vector<uint64_t> stack;
@@ -37,18 +37,154 @@
 
 #include "proto/protoio.hh"
 
+#include <zlib.h>
+
+#include <algorithm>
+#include <iterator>
+
 #include "base/logging.hh"
 
 using namespace std;
 using namespace google::protobuf;
 
+namespace
+{
+
+/**
+ * The headers and the index of a chunked trace are stored little
+ * endian, independent of the host.
+ */
+void
+putLE(char* buf, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+        buf[i] = (char)(value >> (8 * i));
+}
+
+uint64_t
+getLE(const char* buf, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i)
+        value |= (uint64_t)(uint8_t)buf[i] << (8 * i);
+    return value;
+}
+
+/** Map small negative and positive differences to small numbers. */
+uint64_t
+zigZag(uint64_t delta)
+{
+    return (delta << 1) ^ (0 - (delta >> 63));
+}
+
+uint64_t
+unZigZag(uint64_t value)
+{
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+} // anonymous namespace
+
+bool
+ProtoStream::isChunked(const string& filename)
+{
+    const string suffix = ".ctr";
+    return filename.size() >= suffix.size() &&
+        filename.compare(filename.size() - suffix.size(), suffix.size(),
+                         suffix) == 0;
+}
+
+const vector<const FieldDescriptor*>&
+ProtoStream::DeltaCoder::fields(const Message& msg)
+{
+    // Traces hold long runs of the same message type, so remembering
+    // the fields of the last type is enough
+    const Descriptor* desc = msg.GetDescriptor();
+    if (desc != descriptor) {
+        descriptor = desc;
+        deltaFields.clear();
+        for (int i = 0; i < desc->field_count(); ++i) {
+            const FieldDescriptor* field = desc->field(i);
+            if (!field->is_repeated() &&
+                field->cpp_type() == FieldDescriptor::CPPTYPE_UINT64) {
+                deltaFields.push_back(field);
+                if ((size_t)field->number() >= last.size())
+                    last.resize(field->number() + 1, 0);
+            }
+        }
+    }
+    return deltaFields;
+}
+
+void
+ProtoStream::DeltaCoder::encode(Message& msg)
+{
+    const Reflection* refl = msg.GetReflection();
+    for (auto field : fields(msg)) {
+        if (!refl->HasField(msg, field))
+            continue;
+        uint64_t value = refl->GetUInt64(msg, field);
+        uint64_t& prev = last[field->number()];
+        refl->SetUInt64(&msg, field, zigZag(value - prev));
+        prev = value;
+    }
+}
+
+void
+ProtoStream::DeltaCoder::decode(Message& msg)
+{
+    const Reflection* refl = msg.GetReflection();
+    for (auto field : fields(msg)) {
+        if (!refl->HasField(msg, field))
+            continue;
+        uint64_t& prev = last[field->number()];
+        prev += unZigZag(refl->GetUInt64(msg, field));
+        refl->SetUInt64(&msg, field, prev);
+    }
+}
+
+void
+ProtoStream::DeltaCoder::reset()
+{
+    fill(last.begin(), last.end(), 0);
+}
+
+bool
+ProtoStream::DeltaCoder::key(const Message& msg, uint64_t& key)
+{
+    const Descriptor* desc = msg.GetDescriptor();
+    const FieldDescriptor* field = desc->FindFieldByName("tick");
+    if (field == NULL)
+        field = desc->FindFieldByNumber(1);
+    if (field == NULL || field->is_repeated() ||
+        field->cpp_type() != FieldDescriptor::CPPTYPE_UINT64)
+        return false;
+
+    const Reflection* refl = msg.GetReflection();
+    if (!refl->HasField(msg, field))
+        return false;
+    key = refl->GetUInt64(msg, field);
+    return true;
+}
+
 ProtoOutputStream::ProtoOutputStream(const string& filename) :
     fileStream(filename.c_str(), ios::out | ios::binary | ios::trunc),
+    chunked(isChunked(filename)), chunkMessages(0), chunkKey(0),
+    chunkHasKey(false), messages(0),
     wrappedFileStream(NULL), gzipStream(NULL), zeroCopyStream(NULL)
 {
     if (!fileStream.good())
         panic("Could not open %s for writing\n", filename);
 
+    if (chunked) {
+        // A chunked trace has its own magic number, and does all its
+        // compression per chunk
+        char magic[4];
+        putLE(magic, chunkedMagicNumber, sizeof(magic));
+        fileStream.write(magic, sizeof(magic));
+        return;
+    }
+
     // Wrap the output file in a zero copy stream, that in turn is
     // wrapped in a gzip stream if the filename ends with .gz. The
     // latter stream is in turn wrapped in a coded stream
@@ -71,6 +207,11 @@ ProtoOutputStream::ProtoOutputStream(const string& filename) :
 
 ProtoOutputStream::~ProtoOutputStream()
 {
+    if (chunked) {
+        flushChunk();
+        writeIndex();
+    }
+
     // As the compression is optional, see if the stream exists
     if (gzipStream != NULL)
         delete gzipStream;
@@ -81,6 +222,11 @@ ProtoOutputStream::~ProtoOutputStream()
 void
 ProtoOutputStream::write(const Message& msg)
 {
+    if (chunked) {
+        writeChunked(msg);
+        return;
+    }
+
     // Due to the byte limit of the coded stream we create it for
     // every single mesage (based on forum discussions around the size
     // limitation)
@@ -98,24 +244,131 @@ ProtoOutputStream::write(const Message& msg)
     msg.SerializeWithCachedSizes(&codedStream);
 }
 
+void
+ProtoOutputStream::writeChunked(const Message& msg)
+{
+    uint64_t key;
+    if (!chunkHasKey && DeltaCoder::key(msg, key)) {
+        chunkKey = key;
+        chunkHasKey = true;
+    }
+
+    // Delta code a copy of the message, reusing the copy as long as
+    // the type of the messages does not change
+    if (!scratch || scratch->GetDescriptor() != msg.GetDescriptor())
+        scratch.reset(msg.New());
+    scratch->CopyFrom(msg);
+    deltaCoder.encode(*scratch);
+
+    // Append the size and the message to the chunk
+#   if GOOGLE_PROTOBUF_VERSION < 3001000
+        size_t msg_size = scratch->ByteSize();
+#   else
+        size_t msg_size = scratch->ByteSizeLong();
+#   endif
+    size_t pos = chunkData.size();
+    chunkData.resize(pos + io::CodedOutputStream::VarintSize32(msg_size) +
+                     msg_size);
+    uint8_t* data = (uint8_t*)&chunkData[pos];
+    data = io::CodedOutputStream::WriteVarint32ToArray(msg_size, data);
+    scratch->SerializeWithCachedSizesToArray(data);
+
+    ++chunkMessages;
+    ++messages;
+
+    // The header goes in a chunk of its own
+    if (messages == 1 || chunkData.size() >= ChunkSize)
+        flushChunk();
+}
+
+void
+ProtoOutputStream::flushChunk()
+{
+    if (chunkMessages == 0)
+        return;
+
+    // Keep the chunk uncompressed if zlib does not make it smaller
+    uLongf compressed_size = compressBound(chunkData.size());
+    vector<Bytef> compressed(compressed_size);
+    const char* payload = chunkData.data();
+    size_t payload_size = chunkData.size();
+    ChunkCodec codec = CodecRaw;
+    if (compress(compressed.data(), &compressed_size,
+                 (const Bytef*)chunkData.data(), chunkData.size()) == Z_OK &&
+        compressed_size < chunkData.size()) {
+        payload = (const char*)compressed.data();
+        payload_size = compressed_size;
+        codec = CodecZlib;
+    }
+
+    // Chunks without a key inherit the key of the previous chunk to
+    // keep the index sorted
+    index.push_back({ (uint64_t)fileStream.tellp(), chunkKey, chunkHasKey });
+
+    char header[ChunkHeaderSize];
+    putLE(header, chunkMessages, 4);
+    putLE(header + 4, chunkData.size(), 4);
+    putLE(header + 8, payload_size, 4);
+    putLE(header + 12, codec, 1);
+    putLE(header + 13, chunkHasKey, 1);
+    putLE(header + 14, chunkKey, 8);
+    fileStream.write(header, sizeof(header));
+    fileStream.write(payload, payload_size);
+
+    chunkData.clear();
+    chunkMessages = 0;
+    chunkHasKey = false;
+    deltaCoder.reset();
+}
+
+void
+ProtoOutputStream::writeIndex()
+{
+    uint64_t index_offset = fileStream.tellp();
+    for (const auto& entry : index) {
+        char buf[IndexEntrySize];
+        putLE(buf, entry.offset, 8);
+        putLE(buf + 8, entry.firstKey, 8);
+        putLE(buf + 16, entry.hasKey, 1);
+        fileStream.write(buf, sizeof(buf));
+    }
+
+    char trailer[IndexTrailerSize];
+    putLE(trailer, index_offset, 8);
+    putLE(trailer + 8, index.size(), 4);
+    putLE(trailer + 12, indexMagicNumber, 4);
+    fileStream.write(trailer, sizeof(trailer));
+}
+
 ProtoInputStream::ProtoInputStream(const string& filename) :
     fileStream(filename.c_str(), ios::in | ios::binary), fileName(filename),
-    useGzip(false),
+    useGzip(false), chunked(false), dataEnd(0), chunkPos(0),
+    chunkRemaining(0),
     wrappedFileStream(NULL), gzipStream(NULL), zeroCopyStream(NULL)
 {
     if (!fileStream.good())
         panic("Could not open %s for reading\n", filename);
 
-    // check the magic number to see if this is a gzip stream
-    unsigned char bytes[2];
-    fileStream.read((char*) bytes, 2);
-    useGzip = fileStream.good() && bytes[0] == 0x1f && bytes[1] == 0x8b;
+    // check the magic number to see if this is a gzip stream or a
+    // chunked trace
+    char bytes[4];
+    fileStream.read(bytes, 2);
+    useGzip = fileStream.good() && (uint8_t)bytes[0] == 0x1f &&
+        (uint8_t)bytes[1] == 0x8b;
+    fileStream.read(bytes + 2, 2);
+    chunked = fileStream.good() &&
+        getLE(bytes, sizeof(bytes)) == chunkedMagicNumber;
 
     // seek to the start of the input file and clear any flags
     fileStream.clear();
     fileStream.seekg(0, ifstream::beg);
 
-    createStreams();
+    if (chunked) {
+        loadIndex();
+        fileStream.seekg(sizeof(bytes), ifstream::beg);
+    } else {
+        createStreams();
+    }
 }
 
 void
@@ -169,6 +422,14 @@ ProtoInputStream::~ProtoInputStream()
 void
 ProtoInputStream::reset()
 {
+    if (chunked) {
+        // skip the magic number and drop the current chunk
+        fileStream.clear();
+        fileStream.seekg(sizeof(chunkedMagicNumber), ifstream::beg);
+        chunkRemaining = 0;
+        return;
+    }
+
     destroyStreams();
     // seek to the start of the input file and clear any flags
     fileStream.clear();
@@ -179,6 +440,9 @@ ProtoInputStream::reset()
 bool
 ProtoInputStream::read(Message& msg)
 {
+    if (chunked)
+        return readChunked(msg);
+
     // Read a message from the stream by getting the size, using it as
     // a limit when parsing the message, then popping the limit again
     uint32_t size;
@@ -202,3 +466,153 @@ ProtoInputStream::read(Message& msg)
 
     return false;
 }
+
+bool
+ProtoInputStream::readChunked(Message& msg)
+{
+    while (chunkRemaining == 0) {
+        if (!loadChunk())
+            return false;
+    }
+
+    // Parse the message the same way as read() does, but from the
+    // decompressed chunk
+    io::CodedInputStream codedStream(
+        (const uint8_t*)chunkData.data() + chunkPos,
+        chunkData.size() - chunkPos);
+    uint32_t size;
+    if (!codedStream.ReadVarint32(&size))
+        panic("Unable to read message size from chunk in %s\n", fileName);
+    io::CodedInputStream::Limit limit = codedStream.PushLimit(size);
+    if (!msg.ParseFromCodedStream(&codedStream))
+        panic("Unable to read message from chunk in %s\n", fileName);
+    codedStream.PopLimit(limit);
+
+    chunkPos += codedStream.CurrentPosition();
+    --chunkRemaining;
+    deltaCoder.decode(msg);
+    return true;
+}
+
+bool
+ProtoInputStream::loadChunk()
+{
+    if (!fileStream.good())
+        return false;
+    uint64_t offset = fileStream.tellg();
+    if (offset + ChunkHeaderSize > dataEnd)
+        return false;
+
+    char header[ChunkHeaderSize];
+    fileStream.read(header, sizeof(header));
+    uint32_t messages = getLE(header, 4);
+    uint32_t raw_size = getLE(header + 4, 4);
+    uint32_t stored_size = getLE(header + 8, 4);
+    uint8_t codec = getLE(header + 12, 1);
+    if (offset + ChunkHeaderSize + stored_size > dataEnd)
+        return false;
+
+    if (codec == CodecRaw) {
+        chunkData.resize(stored_size);
+        fileStream.read(&chunkData[0], stored_size);
+    } else if (codec == CodecZlib) {
+        vector<char> compressed(stored_size);
+        fileStream.read(compressed.data(), stored_size);
+        chunkData.resize(raw_size);
+        uLongf size = raw_size;
+        if (uncompress((Bytef*)&chunkData[0], &size,
+                       (const Bytef*)compressed.data(), stored_size) != Z_OK ||
+            size != raw_size)
+            panic("Unable to decompress chunk at %d in %s\n", offset,
+                  fileName);
+    } else {
+        panic("Unknown codec %d for chunk at %d in %s\n", codec, offset,
+              fileName);
+    }
+    if (!fileStream.good())
+        panic("Unable to read chunk at %d in %s\n", offset, fileName);
+
+    chunkPos = 0;
+    chunkRemaining = messages;
+    deltaCoder.reset();
+    return true;
+}
+
+void
+ProtoInputStream::loadIndex()
+{
+    fileStream.seekg(0, ifstream::end);
+    uint64_t file_size = fileStream.tellg();
+    index.clear();
+
+    // Use the index at the end of the file if it is there
+    if (file_size >= sizeof(chunkedMagicNumber) + IndexTrailerSize) {
+        char trailer[IndexTrailerSize];
+        fileStream.seekg(file_size - IndexTrailerSize, ifstream::beg);
+        fileStream.read(trailer, sizeof(trailer));
+        uint64_t index_offset = getLE(trailer, 8);
+        uint32_t entries = getLE(trailer + 8, 4);
+        if (fileStream.good() &&
+            getLE(trailer + 12, 4) == indexMagicNumber &&
+            index_offset + entries * IndexEntrySize + IndexTrailerSize ==
+            file_size) {
+            fileStream.seekg(index_offset, ifstream::beg);
+            index.resize(entries);
+            for (auto& entry : index) {
+                char buf[IndexEntrySize];
+                fileStream.read(buf, sizeof(buf));
+                entry.offset = getLE(buf, 8);
+                entry.firstKey = getLE(buf + 8, 8);
+                entry.hasKey = getLE(buf + 16, 1);
+            }
+            dataEnd = index_offset;
+            if (fileStream.good())
+                return;
+            index.clear();
+        }
+    }
+
+    // The trace was not closed properly, so walk the chunk headers
+    // and stop at the first incomplete chunk
+    warn("No chunk index in %s, scanning the chunks\n", fileName);
+    fileStream.clear();
+    uint64_t offset = sizeof(chunkedMagicNumber);
+    while (offset + ChunkHeaderSize <= file_size) {
+        char header[ChunkHeaderSize];
+        fileStream.seekg(offset, ifstream::beg);
+        fileStream.read(header, sizeof(header));
+        uint64_t next = offset + ChunkHeaderSize + getLE(header + 8, 4);
+        if (!fileStream.good() || next > file_size)
+            break;
+        index.push_back({ offset, getLE(header + 14, 8),
+                          getLE(header + 13, 1) != 0 });
+        offset = next;
+    }
+    dataEnd = offset;
+    fileStream.clear();
+}
+
+bool
+ProtoInputStream::seek(uint64_t key)
+{
+    if (!chunked)
+        return false;
+
+    // Chunks are written in key order, so find the last one starting
+    // before the key, as messages with the key itself may already be
+    // at its end, and move on to the first chunk with a key if that
+    // lands on the header
+    auto it = lower_bound(index.begin(), index.end(), key,
+                          [](const ChunkIndexEntry& entry, uint64_t k)
+                          { return entry.firstKey < k; });
+    if (it != index.begin())
+        --it;
+    while (it != index.end() && !it->hasKey)
+        ++it;
+
+    fileStream.clear();
+    fileStream.seekg(it == index.end() ? dataEnd : it->offset,
+                     ifstream::beg);
+    chunkRemaining = 0;
+    return true;
+}
@@ -50,19 +50,131 @@
 #include <google/protobuf/message.h>
 
 #include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
 
 /**
  * A ProtoStream provides the shared functionality of the input and
- * output streams. At the moment this is limited to magic number.
+ * output streams: the magic numbers, and the layout of the chunked
+ * format.
+ *
+ * A chunked trace is selected by giving the output file a .ctr
+ * suffix. Instead of one gzip stream, the messages are grouped in
+ * chunks of roughly ChunkSize bytes, each compressed on its own and
+ * preceded by a small header with the number of messages and the key
+ * of the first one. The key of a message is its tick field, or its
+ * first field if there is no tick and that field is a uint64 (the
+ * sequence number of an elastic trace record). An index of the chunks
+ * is appended when the stream is closed, making it possible to seek
+ * to a key without decompressing what comes before it. Within a chunk
+ * every singular uint64 field is stored as the zig-zag encoded
+ * difference to the same field of the previous message, which turns
+ * ticks and addresses into small numbers that compress well.
+ *
+ * The first message of a stream is the trace header, and it is always
+ * kept in a chunk of its own so that a seek never lands on it.
  */
 class ProtoStream
 {
 
+  public:
+
+    /**
+     * Check if a file name asks for the chunked format.
+     *
+     * @param filename Path to check the suffix of
+     * @return True if the file name ends with .ctr
+     */
+    static bool isChunked(const std::string& filename);
+
   protected:
 
     /// Use the ASCII characters gem5 as our magic number
     static const uint32_t magicNumber = 0x356d6567;
 
+    /// The ASCII characters g5ct start a chunked trace instead
+    static const uint32_t chunkedMagicNumber = 0x74633567;
+
+    /// The ASCII characters g5ix end the index of a chunked trace
+    static const uint32_t indexMagicNumber = 0x78693567;
+
+    /// Amount of uncompressed message data to gather in a chunk
+    static const size_t ChunkSize = 256 * 1024;
+
+    /// How the payload of a chunk is stored
+    enum ChunkCodec : uint8_t {
+        CodecRaw = 0,
+        CodecZlib = 1
+    };
+
+    /// Size of the header preceding every chunk in the file
+    static const size_t ChunkHeaderSize = 22;
+
+    /// Size of one entry in the index of a chunked trace
+    static const size_t IndexEntrySize = 17;
+
+    /// Size of the trailer that locates the index
+    static const size_t IndexTrailerSize = 16;
+
+    /**
+     * Location of a chunk in the file, as recorded in the index.
+     */
+    struct ChunkIndexEntry
+    {
+        /// Offset of the chunk header from the start of the file
+        uint64_t offset;
+        /// Key of the first message in the chunk
+        uint64_t firstKey;
+        /// False if no message in the chunk has a key
+        bool hasKey;
+    };
+
+    /**
+     * Transforms the singular uint64 fields of the messages in a
+     * chunk to and from their difference with the previous value of
+     * the same field. Both sides see the same sequence of message
+     * types, so the previous values are simply kept per field number.
+     */
+    class DeltaCoder
+    {
+      public:
+
+        /** Replace the delta coded fields by their encoded deltas. */
+        void encode(google::protobuf::Message& msg);
+
+        /** Undo encode() on a message that was just parsed. */
+        void decode(google::protobuf::Message& msg);
+
+        /** Forget the previous values, done at every chunk boundary. */
+        void reset();
+
+        /**
+         * Get the key of a message, used to index the chunks.
+         *
+         * @param msg Message to get the key of
+         * @param key Set to the key if the message has one
+         * @return True if the message has a key
+         */
+        static bool key(const google::protobuf::Message& msg,
+                        uint64_t& key);
+
+      private:
+
+        /** Look up the delta coded fields of a message type. */
+        const std::vector<const google::protobuf::FieldDescriptor*>&
+        fields(const google::protobuf::Message& msg);
+
+        /// Message type the cached field list belongs to
+        const google::protobuf::Descriptor* descriptor = nullptr;
+
+        /// Singular uint64 fields of the cached message type
+        std::vector<const google::protobuf::FieldDescriptor*> deltaFields;
+
+        /// Previous value of each delta coded field, by field number
+        std::vector<uint64_t> last;
+    };
+
     /**
      * Create a ProtoStream.
      */
@@ -85,7 +197,8 @@ class ProtoStream
  * stream is done to enable interaction with the file on a per-message
  * basis to avoid having to deal with huge data structures. The latter
  * is made possible by encoding the length of each message in the
- * stream.
+ * stream. A file name ending with .ctr selects the chunked format
+ * described in ProtoStream.
  */
 class ProtoOutputStream : public ProtoStream
 {
@@ -94,7 +207,8 @@ class ProtoOutputStream : public ProtoStream
 
     /**
      * Create an output stream for a given file name. If the filename
-     * ends with .gz then the file will be compressed accordinly.
+     * ends with .gz then the file will be compressed accordinly, and
+     * if it ends with .ctr then the file will be chunked.
      *
      * @param filename Path to the file to create or truncate
      */
@@ -116,9 +230,53 @@ class ProtoOutputStream : public ProtoStream
 
   private:
 
+    /**
+     * Append a message to the current chunk of a chunked stream.
+     *
+     * @param msg Message to append
+     */
+    void writeChunked(const google::protobuf::Message& msg);
+
+    /**
+     * Compress the current chunk, if any, and write it to the file.
+     */
+    void flushChunk();
+
+    /**
+     * Write the chunk index and its trailer at the end of the file.
+     */
+    void writeIndex();
+
     /// Underlying file output stream
     std::ofstream fileStream;
 
+    /// Boolean flag to remember whether we use the chunked format
+    const bool chunked;
+
+    /// Serialized messages of the chunk being gathered
+    std::string chunkData;
+
+    /// Number of messages in the chunk being gathered
+    uint32_t chunkMessages;
+
+    /// Key of the first keyed message in the chunk being gathered
+    uint64_t chunkKey;
+
+    /// True once a message with a key has been added to the chunk
+    bool chunkHasKey;
+
+    /// Number of messages written so far
+    uint64_t messages;
+
+    /// Scratch copy of a message, to delta code it before writing
+    std::unique_ptr<google::protobuf::Message> scratch;
+
+    /// Delta state of the chunk being gathered
+    DeltaCoder deltaCoder;
+
+    /// Location of every chunk written so far
+    std::vector<ChunkIndexEntry> index;
+
     /// Zero Copy stream wrapping the STL output stream
     google::protobuf::io::OstreamOutputStream* wrappedFileStream;
 
@@ -132,10 +290,12 @@ class ProtoOutputStream : public ProtoStream
 
 /**
  * A ProtoInputStream wraps a coded stream, potentially with
- * decompression, based on looking at the file name. Reading from the
- * stream is done on a per-message basis to avoid having to deal with
- * huge data structures. The latter assumes the length of each message
- * is encoded in the stream when it is written.
+ * decompression, based on looking at the start of the file. Reading
+ * from the stream is done on a per-message basis to avoid having to
+ * deal with huge data structures. The latter assumes the length of
+ * each message is encoded in the stream when it is written. Chunked
+ * traces are recognised by their magic number, and they can also be
+ * positioned with seek().
  */
 class ProtoInputStream : public ProtoStream
 {
@@ -143,8 +303,8 @@ class ProtoInputStream : public ProtoStream
   public:
 
     /**
-     * Create an input stream for a given file name. If the filename
-     * ends with .gz then the file will be decompressed accordingly.
+     * Create an input stream for a given file name. If the file is
+     * gzipped or chunked it will be decompressed accordingly.
      *
      * @param filename Path to the file to read from
      */
@@ -169,8 +329,42 @@ class ProtoInputStream : public ProtoStream
      */
     void reset();
 
+    /**
+     * Position a chunked stream so that no message with the given key
+     * or a later one is skipped, by moving to the start of the chunk
+     * holding the first of them. Any message before the requested key
+     * in that chunk still has to be skipped by the caller. Keys before
+     * the first chunk seek to the first chunk after the header.
+     *
+     * @param key Key, usually a tick, to seek to
+     * @return False if the stream is not chunked and cannot seek
+     */
+    bool seek(uint64_t key);
+
   private:
 
+    /**
+     * Read a message from a chunked stream.
+     *
+     * @param msg Message read from the stream
+     * @return True if a message was read, false at the end of the trace
+     */
+    bool readChunked(google::protobuf::Message& msg);
+
+    /**
+     * Read and decompress the chunk at the current file position.
+     *
+     * @return False if there are no more chunks
+     */
+    bool loadChunk();
+
+    /**
+     * Load the index of a chunked trace from the end of the file, or
+     * rebuild it from the chunk headers if the trace was not closed
+     * properly.
+     */
+    void loadIndex();
+
     /**
      * Create the internal streams that are wrapping the input file.
      */
@@ -190,6 +384,27 @@ class ProtoInputStream : public ProtoStream
     /// Boolean flag to remember whether we use gzip or not
     bool useGzip;
 
+    /// Boolean flag to remember whether we use the chunked format
+    bool chunked;
+
+    /// Offset where the chunks of a chunked trace end
+    uint64_t dataEnd;
+
+    /// Location of every chunk of a chunked trace
+    std::vector<ChunkIndexEntry> index;
+
+    /// Uncompressed messages of the current chunk
+    std::string chunkData;
+
+    /// Offset of the next message in the current chunk
+    size_t chunkPos;
+
+    /// Messages left to read in the current chunk
+    uint32_t chunkRemaining;
+
+    /// Delta state of the current chunk
+    DeltaCoder deltaCoder;
+
     /// Zero Copy stream wrapping the STL input stream
     google::protobuf::io::IstreamInputStream* wrappedFileStream;
 
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "proto/packet.pb.h"
+#include "proto/protoio.hh"
+
+namespace {
+
+/** Path of a scratch trace, removed when the test is done. */
+class TempTrace
+{
+  public:
+    TempTrace(const std::string &suffix)
+        : path(::testing::TempDir() + "protoio_test." +
+               std::to_string(getpid()) + suffix)
+    { }
+
+    ~TempTrace() { std::remove(path.c_str()); }
+
+    const std::string path;
+};
+
+/** The i-th packet of a test trace, four of them per tick. */
+ProtoMessage::Packet
+makePacket(uint64_t i)
+{
+    ProtoMessage::Packet pkt;
+    pkt.set_tick(i / 4 * 500);
+    pkt.set_cmd(i % 2 ? 1 : 4);
+    // Jump back and forth to get negative deltas
+    pkt.set_addr(i % 3 ? 0x80000000 + i * 64 : 0x1000 + i);
+    pkt.set_size(64);
+    if (i % 5 == 0)
+        pkt.set_flags(i);
+    return pkt;
+}
+
+/** Get i back from the address of makePacket(i). */
+uint64_t
+packetIndex(const ProtoMessage::Packet &pkt)
+{
+    return pkt.addr() >= 0x80000000 ? (pkt.addr() - 0x80000000) / 64 :
+        pkt.addr() - 0x1000;
+}
+
+void
+writeTrace(const std::string &path, uint64_t packets)
+{
+    ProtoOutputStream out(path);
+    ProtoMessage::PacketHeader header;
+    header.set_obj_id("test");
+    header.set_tick_freq(1000000000000ULL);
+    out.write(header);
+    for (uint64_t i = 0; i < packets; ++i)
+        out.write(makePacket(i));
+}
+
+/**
+ * Read the packets left in a trace, or the given number of them, and
+ * check them against makePacket.
+ */
+uint64_t
+readPackets(ProtoInputStream &in, uint64_t first, uint64_t limit = -1)
+{
+    ProtoMessage::Packet pkt;
+    uint64_t i = first;
+    while (i - first < limit && in.read(pkt)) {
+        ProtoMessage::Packet expected = makePacket(i);
+        EXPECT_EQ(pkt.tick(), expected.tick()) << "packet " << i;
+        EXPECT_EQ(pkt.cmd(), expected.cmd()) << "packet " << i;
+        EXPECT_EQ(pkt.addr(), expected.addr()) << "packet " << i;
+        EXPECT_EQ(pkt.size(), expected.size()) << "packet " << i;
+        EXPECT_EQ(pkt.has_flags(), expected.has_flags()) << "packet " << i;
+        EXPECT_EQ(pkt.flags(), expected.flags()) << "packet " << i;
+        EXPECT_FALSE(pkt.has_pkt_id());
+        ++i;
+    }
+    return i - first;
+}
+
+void
+readHeader(ProtoInputStream &in)
+{
+    ProtoMessage::PacketHeader header;
+    ASSERT_TRUE(in.read(header));
+    EXPECT_EQ(header.obj_id(), "test");
+    EXPECT_EQ(header.tick_freq(), 1000000000000ULL);
+}
+
+/** Enough packets to fill several chunks. */
+const uint64_t NumPackets = 200000;
+
+} // anonymous namespace
+
+TEST(ProtoIOTest, IsChunked)
+{
+    EXPECT_TRUE(ProtoStream::isChunked("trace.ctr"));
+    EXPECT_FALSE(ProtoStream::isChunked("trace.ctr.gz"));
+    EXPECT_FALSE(ProtoStream::isChunked("ctr"));
+}
+
+TEST(ProtoIOTest, RoundTrip)
+{
+    for (auto suffix : { ".trc", ".trc.gz", ".ctr" }) {
+        TempTrace trace(suffix);
+        writeTrace(trace.path, NumPackets);
+
+        ProtoInputStream in(trace.path);
+        readHeader(in);
+        EXPECT_EQ(readPackets(in, 0), NumPackets) << suffix;
+
+        // Play the trace again from the start
+        in.reset();
+        readHeader(in);
+        EXPECT_EQ(readPackets(in, 0), NumPackets) << suffix;
+    }
+}
+
+TEST(ProtoIOTest, DeltaCodingCompresses)
+{
+    // Ticks and addresses that grow steadily turn into constant deltas,
+    // which compress far better than the values themselves
+    TempTrace plain(".trc.gz");
+    TempTrace chunked(".ctr");
+    for (auto path : { plain.path, chunked.path }) {
+        ProtoOutputStream out(path);
+        ProtoMessage::Packet pkt;
+        for (uint64_t i = 0; i < NumPackets; ++i) {
+            pkt.set_tick(1000000000 + i * 1337);
+            pkt.set_cmd(1);
+            pkt.set_addr(0x123456789 + i * 192);
+            pkt.set_size(64);
+            out.write(pkt);
+        }
+    }
+
+    FILE *f = fopen(plain.path.c_str(), "rb");
+    ASSERT_NE(f, nullptr);
+    fseek(f, 0, SEEK_END);
+    long plain_size = ftell(f);
+    fclose(f);
+    f = fopen(chunked.path.c_str(), "rb");
+    ASSERT_NE(f, nullptr);
+    fseek(f, 0, SEEK_END);
+    long chunked_size = ftell(f);
+    fclose(f);
+    EXPECT_LT(chunked_size * 4, plain_size);
+
+    ProtoInputStream in(chunked.path);
+    ProtoMessage::Packet pkt;
+    for (uint64_t i = 0; i < NumPackets; ++i) {
+        ASSERT_TRUE(in.read(pkt));
+        EXPECT_EQ(pkt.tick(), 1000000000 + i * 1337);
+        EXPECT_EQ(pkt.addr(), 0x123456789 + i * 192);
+    }
+    EXPECT_FALSE(in.read(pkt));
+}
+
+TEST(ProtoIOTest, Seek)
+{
+    TempTrace trace(".ctr");
+    writeTrace(trace.path, NumPackets);
+    ProtoInputStream in(trace.path);
+
+    // A seek lands on the start of a chunk, so collect them
+    const uint64_t last_tick = (NumPackets - 1) / 4 * 500;
+    std::set<uint64_t> chunk_starts;
+    for (uint64_t tick = 0; tick <= last_tick; tick += 500 * 97) {
+        ASSERT_TRUE(in.seek(tick));
+        ProtoMessage::Packet pkt;
+        ASSERT_TRUE(in.read(pkt));
+        EXPECT_LE(pkt.tick(), tick);
+        chunk_starts.insert(packetIndex(pkt));
+    }
+    EXPECT_GT(chunk_starts.size(), 4);
+
+    // Every packet with the requested tick or a later one comes after
+    // the seek, also when the chunk starts in the middle of the tick
+    int split_ticks = 0;
+    for (auto start : chunk_starts) {
+        uint64_t tick = makePacket(start).tick();
+        uint64_t first = start / 4 * 4;
+        split_ticks += first != start;
+
+        ASSERT_TRUE(in.seek(tick));
+        ProtoMessage::Packet pkt;
+        do {
+            ASSERT_TRUE(in.read(pkt));
+        } while (pkt.tick() < tick);
+        EXPECT_EQ(packetIndex(pkt), first) << "tick " << tick;
+        EXPECT_EQ(readPackets(in, first + 1, 1000),
+                  std::min<uint64_t>(1000, NumPackets - first - 1));
+    }
+    EXPECT_GT(split_ticks, 0);
+
+    // Seeking before the first packet skips the header
+    ASSERT_TRUE(in.seek(0));
+    EXPECT_EQ(readPackets(in, 0), NumPackets);
+
+    // Seeking past the end leaves at most the last chunk to read
+    ASSERT_TRUE(in.seek(last_tick + 1));
+    ProtoMessage::Packet pkt;
+    while (in.read(pkt))
+        EXPECT_LE(pkt.tick(), last_tick);
+
+    // Other formats can't seek
+    TempTrace plain(".trc");
+    writeTrace(plain.path, 16);
+    ProtoInputStream plain_in(plain.path);
+    EXPECT_FALSE(plain_in.seek(0));
+}
+
+TEST(ProtoIOTest, IndexRebuild)
+{
+    TempTrace trace(".ctr");
+    writeTrace(trace.path, NumPackets);
+
+    // Cut off the index and part of the last chunk, as if the
+    // simulator had died while writing the trace
+    FILE *f = fopen(trace.path.c_str(), "rb");
+    ASSERT_NE(f, nullptr);
+    unsigned char trailer[16];
+    fseek(f, -(long)sizeof(trailer), SEEK_END);
+    ASSERT_EQ(fread(trailer, 1, sizeof(trailer), f), sizeof(trailer));
+    fclose(f);
+    uint64_t index_offset = 0;
+    for (int i = 0; i < 8; ++i)
+        index_offset |= (uint64_t)trailer[i] << (8 * i);
+    ASSERT_EQ(truncate(trace.path.c_str(), index_offset - 100), 0);
+
+    ProtoInputStream in(trace.path);
+    readHeader(in);
+    uint64_t packets = readPackets(in, 0);
+    EXPECT_GT(packets, 0);
+    EXPECT_LT(packets, NumPackets);
+
+    // The rebuilt index still allows seeking
+    ASSERT_TRUE(in.seek(packets / 2 / 4 * 500));
+    ProtoMessage::Packet pkt;
+    ASSERT_TRUE(in.read(pkt));
+    EXPECT_LE(pkt.tick(), packets / 2 / 4 * 500);
+    EXPECT_GT(pkt.tick(), 0);
+}
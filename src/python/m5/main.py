@@ -139,13 +139,19 @@ def parse_options():
     option("--debug-help", action='store_true',
         help="Print help on debug flags")
     option("--debug-flags", metavar="FLAG[,FLAG]", action='append', split=',',
-        help="Sets the flags for debug output (-FLAG disables a flag)")
+        help="Sets the flags for debug output (-FLAG disables a flag, "
+             "FLAG@EXPR only enables it for the sim objects matching EXPR)")
     option("--debug-start", metavar="TICK", type='int',
         help="Start debug output at TICK")
     option("--debug-end", metavar="TICK", type='int',
         help="End debug output at TICK")
-    option("--debug-file", metavar="FILE", default="cout",
-        help="Sets the output file for debug [Default: %default]")
+    option("--debug-file", metavar="FILE", default=None,
+        help="Sets the output file for debug [Default: cout, or trace.bin "
+             "with --debug-format=binary]")
+    option("--debug-format", metavar="{text,binary}",
+        choices=["text", "binary"], default="text",
+        help="Format of the debug output; binary output is decoded with "
+             "util/decode_debug_trace.py [Default: %default]")
     option("--debug-ignore", metavar="EXPR", action='append', split=':',
         help="Ignore EXPR sim objects")
     option("--remote-gdb-port", type='int', default=7000,
@@ -398,12 +404,18 @@ def main(*args):
                 flag = flag[1:]
                 off = True
 
+            objects = None
+            if '@' in flag:
+                flag, objects = flag.split('@', 1)
+
             if flag not in debug.flags:
                 print("invalid debug flag '%s'" % flag, file=sys.stderr)
                 sys.exit(1)
 
             if off:
                 debug.flags[flag].disable()
+            elif objects:
+                debug.flags[flag].enableFor(objects)
             else:
                 debug.flags[flag].enable()
 
@@ -419,7 +431,16 @@ def main(*args):
         e = event.create(trace.disable, event.Event.Debug_Enable_Pri)
         event.mainq.schedule(e, options.debug_end)
 
-    trace.output(options.debug_file)
+    if options.debug_format == "binary":
+        if options.debug_file is None:
+            options.debug_file = "trace.bin"
+        elif options.debug_file in ("cout", "stdout", "cerr", "stderr"):
+            fatal("--debug-format=binary needs a file for --debug-file")
+        trace.outputBinary(options.debug_file)
+    else:
+        if options.debug_file is None:
+            options.debug_file = "cout"
+        trace.output(options.debug_file)
 
     for ignore in options.debug_ignore:
         _check_tracing()
@@ -41,7 +41,9 @@ from __future__ import print_function
 
 import atexit
 import os
+import pickle
 import sys
+import traceback
 
 # import the wrapped C++ functions
 import _m5.drain
@@ -51,11 +53,12 @@ from _m5.stats import updateEvents as updateStatEvents
 from . import stats
 from . import SimObject
 from . import ticks
+from . import trace
 from . import objects
 from m5.util.dot_writer import do_dot, do_dvfs_dot
 from m5.util.dot_writer_ruby import do_ruby_dot
 
-from .util import fatal
+from .util import fatal, warn
 from .util import attrdict
 
 # define a MaxTick parameter, unsigned 64 bit
@@ -353,8 +356,18 @@ def fork(simout="%(parent)s.f%(fork_seq)i"):
     if not _m5.core.listenersDisabled():
         raise RuntimeError("Can not fork a simulator with listeners enabled")
 
+    # The elastic trace decoder of a TraceCPU runs on a thread of its
+    # own, which the child would not have
+    trace_cpu = getattr(objects, "TraceCPU", None)
+    if trace_cpu and any(isinstance(obj, trace_cpu) for obj in
+                         objects.Root.getInstance().descendants()):
+        raise RuntimeError("Can not fork a simulator with a TraceCPU")
+
     drain()
 
+    # Don't leave buffered debug output for both processes to write
+    trace.flush()
+
     try:
         pid = os.fork()
     except OSError as e:
@@ -372,11 +385,123 @@ def fork(simout="%(parent)s.f%(fork_seq)i"):
                 "pid" : os.getpid(),
                 }
         _m5.core.setOutputDir(options.outdir)
+        # A binary trace can't be shared, as its records refer to the
+        # strings defined before them, so start a new one
+        if options.debug_format == "binary":
+            trace.outputBinary(options.debug_file)
     else:
         fork_count += 1
 
     return pid
 
+# Forked regions that have not been joined yet, as (pid, fd,
+# merge_stats) tuples
+_regions = []
+def forkRegion(region, simout="%(parent)s.r%(fork_seq)i", merge_stats=True):
+    """Simulate a region in a forked child simulator.
+
+    This function forks the simulator with fork() and calls region()
+    in the child, which then exits. Whatever region() returns is
+    pickled and sent back to the parent, which keeps simulating and
+    collects it later with joinRegions(). A simulation that has been
+    warmed up once can this way hand out detailed regions to as many
+    host cores as there are children, sharing its memory copy on write
+    instead of writing and restoring checkpoints.
+
+    The child never returns from this function, even if region()
+    raises an exception; it then reports no result. The stats of the
+    child are dumped to its own output directory when it exits. The
+    child also sends back what its stats counted during region(), and
+    joinRegions() adds that to the stats of the parent (see
+    m5.stats.merge()).
+
+    Arguments:
+      region -- Function to call in the child.
+
+    Keyword Arguments:
+      simout -- New simulation output directory, see fork().
+      merge_stats -- Add the stats of the region to the parent's.
+
+    Return Value:
+      pid of the child process.
+    """
+    read_fd, write_fd = os.pipe()
+    pid = fork(simout)
+
+    if pid == 0:
+        # The child only reports its own result, and must not return
+        # into the code of the parent whatever region() does
+        status = 1
+        try:
+            os.close(read_fd)
+            for _, fd, _ in _regions:
+                os.close(fd)
+            del _regions[:]
+
+            base = stats.snapshot() if merge_stats else None
+            result = region()
+            dump = stats.snapshot() if merge_stats else None
+            with os.fdopen(write_fd, "wb") as f:
+                pickle.dump((result, base, dump), f)
+            status = 0
+        except SystemExit as e:
+            status = e.code if isinstance(e.code, int) else 1
+        except BaseException:
+            traceback.print_exc()
+        finally:
+            # Exit like the simulator normally does, dumping the stats
+            try:
+                atexit._run_exitfuncs()
+            finally:
+                sys.stdout.flush()
+                sys.stderr.flush()
+                os._exit(status)
+
+    os.close(write_fd)
+    _regions.append((pid, read_fd, merge_stats))
+    return pid
+
+def joinRegions(max_running=0):
+    """Wait for regions started with forkRegion() to finish.
+
+    Regions are joined in the order they were forked until at most
+    max_running of them are still running, which makes it easy to keep
+    a fixed number of children busy. The stats of each joined region
+    are added to those of this simulator, unless it was forked with
+    merge_stats=False.
+
+    Keyword Arguments:
+      max_running -- Number of regions to leave running.
+
+    Return Value:
+      List of (pid, result) tuples for the joined regions. The result
+      is None if the child did not return one.
+    """
+    results = []
+    while len(_regions) > max_running:
+        pid, read_fd, merge_stats = _regions.pop(0)
+        with os.fdopen(read_fd, "rb") as f:
+            data = f.read()
+        _, status = os.waitpid(pid, 0)
+        if os.WIFSIGNALED(status):
+            warn("Forked region %d was killed by signal %d" %
+                 (pid, os.WTERMSIG(status)))
+        elif os.WIFEXITED(status) and os.WEXITSTATUS(status) != 0:
+            warn("Forked region %d exited with status %d" %
+                 (pid, os.WEXITSTATUS(status)))
+
+        result = None
+        if data:
+            result, base, dump = pickle.loads(data)
+            if merge_stats:
+                unmerged = stats.merge(dump, base)
+                if unmerged:
+                    warn("%d stats of forked region %d could not be "
+                         "merged, e.g., %s" %
+                         (len(unmerged), pid, unmerged[0]))
+        results.append((pid, result))
+    return results
+
 from _m5.core import disableAllListeners, listenersDisabled
 from _m5.core import listenersLoopbackOnly
 from _m5.core import curTick
@@ -149,6 +149,28 @@ def _textFactory(fn, desc=True, spaces=True):
 
     return _m5.stats.initText(fn, desc, spaces)
 
+@_url_factory([ "bin", ])
+def _binaryFactory(fn, desc=True):
+    """Output stats in a compact binary format.
+
+    Binary stat files describe the stats once and then append every
+    dump as a flat array of doubles, which makes frequent dumps of
+    large systems much cheaper than with the text or HDF5 formats. Use
+    m5.stats.binary (which can also be run as a script) to read them.
+
+    Known limitations:
+      * Sparse histograms currently unsupported.
+
+    Parameters:
+      * desc (bool): Output stat descriptions (default: True)
+
+    Example:
+      bin://stats.bin?desc=False
+
+    """
+
+    return _m5.stats.initBinary(fn, desc)
+
 @_url_factory([ "h5", ], enable=hasattr(_m5.stats, "initHDF5"))
 def _hdf5Factory(fn, chunking=10, desc=True, formulas=True):
     """Output stats in HDF5 format.
@@ -405,6 +427,113 @@ def reset():
 
     _m5.stats.processResetQueue()
 
+def snapshot():
+    '''Take a snapshot of the values of all stats.
+
+    The snapshot is an m5.stats.binary.Dump. It can be pickled, e.g.,
+    to send it from a forked simulator to its parent, which adds it to
+    its own stats with merge().'''
+
+    import os
+    import tempfile
+    from m5.stats import binary
+
+    fd, path = tempfile.mkstemp(suffix=".bin")
+    os.close(fd)
+    try:
+        output = _m5.stats.initBinary(path, False)
+        prepare()
+        output.begin()
+        _dump_to_visitor(output)
+        output.end()
+        return next(iter(binary.StatFile(path)))
+    finally:
+        os.remove(path)
+
+def _difference(stat, values, base):
+    '''The values of a stat in a dump less those in a base dump, or None
+    if the two can't be compared.'''
+
+    from m5.stats import binary
+
+    if stat.name not in base.schema:
+        return None
+    base_stat = base.schema[stat.name]
+    if base_stat.kind != stat.kind or base_stat.size != stat.size:
+        return None
+    base_values = base.values[base_stat.offset:
+                              base_stat.offset + base_stat.size]
+
+    if stat.kind not in (binary.KIND_DIST, binary.KIND_VECTOR_DIST):
+        return [ v - b for v, b in zip(values, base_values) ]
+
+    # Distributions keep their configuration and extrema
+    fields = binary.DIST_FIELDS
+    keep = [ fields.index(f) for f in ("min", "max", "bucket_size") ]
+    extrema = [ fields.index(f) for f in ("min_val", "max_val") ]
+    step = len(fields) + stat.buckets
+    diff = []
+    for start in range(0, len(values), step):
+        dist = values[start:start + step]
+        base_dist = base_values[start:start + step]
+        if any(dist[i] != base_dist[i] for i in keep):
+            return None
+        diff += [ v if i in keep or i in extrema else v - b
+                  for i, (v, b) in enumerate(zip(dist, base_dist)) ]
+    return diff
+
+def merge(dump, base=None):
+    '''Add the stats of another simulator to those of this one.
+
+    dump is a snapshot() that the other simulator took. If base is
+    given, only what changed between base and dump is added; for a
+    simulator forked from this one, a snapshot taken right after the
+    fork leaves what the child simulated. Formulas follow the stats
+    they are computed from, and values, e.g., sim_ticks, keep following
+    this simulator. Averages over time can't be merged.
+
+    Return Value:
+      Names of the stats that changed but could not be merged.
+    '''
+
+    from m5.stats import binary
+
+    infos = dict((stat.name, stat) for stat in stats_list)
+    def add_group(prefix, group):
+        for stat in group.getStats():
+            infos[prefix + stat.name] = stat
+        for name, child in group.getStatGroups().items():
+            add_group(prefix + name + ".", child)
+    add_group("", Root.getInstance())
+
+    unmerged = []
+    for name, stat in dump.schema.items():
+        if stat.kind == binary.KIND_FORMULA:
+            continue
+
+        values = list(dump.values[stat.offset:stat.offset + stat.size])
+        if base is not None:
+            values = _difference(stat, values, base)
+            if values is None:
+                unmerged.append(name)
+                continue
+
+        if stat.kind in (binary.KIND_DIST, binary.KIND_VECTOR_DIST):
+            samples = binary.DIST_FIELDS.index("samples")
+            step = len(binary.DIST_FIELDS) + stat.buckets
+            changed = any(values[i] for i in
+                          range(samples, len(values), step))
+        else:
+            changed = any(values)
+        if not changed:
+            continue
+
+        info = infos.get(name)
+        if info is None or not info.merge(values):
+            unmerged.append(name)
+
+    return unmerged
+
 flags = attrdict({
     'none'    : 0x0000,
     'init'    : 0x0001,
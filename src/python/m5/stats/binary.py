@@ -0,0 +1,318 @@
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Reader for the binary stats format (bin://stats.bin).
+
+The file is a magic string and a version followed by schema blocks,
+describing the stats in a dump, and dump blocks, holding the values of
+all stats as a flat array of doubles (see src/base/stats/binary.hh).
+
+This module does not depend on the rest of gem5, so it can also be
+used outside of a simulation, either by importing it or as a script:
+
+    python3 src/python/m5/stats/binary.py m5out/stats.bin
+
+Example:
+
+    from m5.stats.binary import StatFile
+
+    for dump in StatFile("m5out/stats.bin"):
+        print(dump["system.cpu.numCycles"])
+"""
+
+from __future__ import print_function
+from __future__ import absolute_import
+
+import array
+import struct
+import sys
+
+MAGIC = b"gem5stat"
+VERSION = 1
+
+KIND_SCALAR, KIND_VECTOR, KIND_DIST, KIND_VECTOR_DIST, KIND_VECTOR2D, \
+    KIND_FORMULA = range(6)
+
+DIST_DEVIATION, DIST_DIST, DIST_HIST = range(3)
+
+DIST_FIELDS = ("min", "max", "bucket_size", "samples", "sum", "squares",
+               "logs", "min_val", "max_val", "underflow", "overflow")
+
+class Stat(object):
+    """Description of a stat, as recorded in a schema.
+
+    Attributes:
+      * name: Full name of the stat
+      * kind: One of the KIND_* constants
+      * desc: Description, empty if descriptions were disabled
+      * flags: Stat flags (see m5.stats.flags)
+      * offset: Index of the first value of the stat in a dump
+      * size: Number of values the stat has in a dump
+
+    Depending on the kind, a stat also has subnames, y_subnames, x, y,
+    count, dist_type, buckets and formula attributes.
+    """
+
+    def __init__(self, kind, name, desc, flags, offset, size):
+        self.kind = kind
+        self.name = name
+        self.desc = desc
+        self.flags = flags
+        self.offset = offset
+        self.size = size
+
+    def decode(self, values):
+        """Turn the values of this stat in a dump into Python values"""
+
+        raw = values[self.offset:self.offset + self.size]
+        if self.kind == KIND_SCALAR:
+            return raw[0]
+        elif self.kind in (KIND_VECTOR, KIND_FORMULA):
+            return list(raw)
+        elif self.kind == KIND_VECTOR2D:
+            return [ list(raw[i * self.y:(i + 1) * self.y])
+                     for i in range(self.x) ]
+        elif self.kind == KIND_DIST:
+            return _decode_dist(raw)
+        elif self.kind == KIND_VECTOR_DIST:
+            step = len(DIST_FIELDS) + self.buckets
+            return [ _decode_dist(raw[i * step:(i + 1) * step])
+                     for i in range(self.count) ]
+        else:
+            raise ValueError("Unknown stat kind %d" % self.kind)
+
+def _decode_dist(raw):
+    nfields = len(DIST_FIELDS)
+    dist = dict(zip(DIST_FIELDS, raw[:nfields]))
+    dist["buckets"] = list(raw[nfields:])
+    return dist
+
+class Dump(object):
+    """Values of all stats in one dump.
+
+    A dump behaves like a read-only dictionary from stat names to
+    values. Values are decoded on access: scalars are floats, vectors
+    and formulas are lists, 2d vectors are lists of rows, and
+    distributions are dictionaries with one key per field in
+    DIST_FIELDS and a list of buckets.
+    """
+
+    def __init__(self, index, schema, values):
+        self.index = index
+        self.schema = schema
+        self.values = values
+
+    def __getitem__(self, name):
+        return self.schema[name].decode(self.values)
+
+    def __contains__(self, name):
+        return name in self.schema
+
+    def __iter__(self):
+        return iter(self.schema)
+
+    def __len__(self):
+        return len(self.schema)
+
+    def keys(self):
+        return self.schema.keys()
+
+    def items(self):
+        for name, stat in self.schema.items():
+            yield name, stat.decode(self.values)
+
+class _Buffer(object):
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def unpack(self, fmt):
+        fmt = "=" + fmt
+        size = struct.calcsize(fmt)
+        if self.pos + size > len(self.data):
+            raise EOFError()
+        values = struct.unpack_from(fmt, self.data, self.pos)
+        self.pos += size
+        return values
+
+    def u8(self):
+        return self.unpack("B")[0]
+
+    def u32(self):
+        return self.unpack("I")[0]
+
+    def u64(self):
+        return self.unpack("Q")[0]
+
+    def string(self):
+        length = self.u32()
+        if self.pos + length > len(self.data):
+            raise EOFError()
+        value = self.data[self.pos:self.pos + length]
+        self.pos += length
+        return value.decode("utf-8", "replace")
+
+    def strings(self):
+        return [ self.string() for i in range(self.u32()) ]
+
+    def doubles(self, count):
+        end = self.pos + count * 8
+        if end > len(self.data):
+            raise EOFError()
+        values = array.array("d")
+        chunk = self.data[self.pos:end]
+        if hasattr(values, "frombytes"):
+            values.frombytes(chunk)
+        else:
+            values.fromstring(chunk)
+        self.pos = end
+        return values
+
+class StatFile(object):
+    """A binary stats file; iterating over it yields Dump objects.
+
+    A file that is still being written, or that was cut short by a
+    crash, reads up to its last complete dump.
+    """
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self._buf = _Buffer(f.read())
+
+        magic = self._buf.data[:len(MAGIC)]
+        if magic != MAGIC:
+            raise ValueError("%s is not a binary stats file" % path)
+        self._buf.pos = len(MAGIC)
+        version = self._buf.u32()
+        if version != VERSION:
+            raise ValueError("%s has unsupported version %d" % (
+                path, version))
+
+    def _read_schema(self):
+        from collections import OrderedDict
+
+        buf = self._buf
+        schema = OrderedDict()
+        offset = 0
+        for i in range(buf.u32()):
+            kind = buf.u8()
+            name = buf.string()
+            desc = buf.string()
+            flags = buf.u32()
+            size = buf.u32()
+            stat = Stat(kind, name, desc, flags, offset, size)
+            if kind in (KIND_VECTOR, KIND_FORMULA):
+                stat.subnames = buf.strings()
+                if kind == KIND_FORMULA:
+                    stat.formula = buf.string()
+            elif kind == KIND_VECTOR2D:
+                stat.x = buf.u32()
+                stat.y = buf.u32()
+                stat.subnames = buf.strings()
+                stat.y_subnames = buf.strings()
+            elif kind == KIND_DIST:
+                stat.dist_type = buf.u8()
+                stat.buckets = buf.u32()
+            elif kind == KIND_VECTOR_DIST:
+                stat.count = buf.u32()
+                stat.dist_type = buf.u8()
+                stat.buckets = buf.u32()
+                stat.subnames = buf.strings()
+            elif kind != KIND_SCALAR:
+                raise ValueError("Unknown stat kind %d" % kind)
+            schema[name] = stat
+            offset += size
+        return schema
+
+    def __iter__(self):
+        buf = self._buf
+        buf.pos = len(MAGIC) + 4
+        schema = None
+        index = 0
+        while buf.pos < len(buf.data):
+            try:
+                tag = buf.data[buf.pos:buf.pos + 1]
+                buf.pos += 1
+                if tag == b"S":
+                    schema = self._read_schema()
+                elif tag == b"D":
+                    values = buf.doubles(buf.u64())
+                    if schema is None:
+                        raise ValueError("Dump without a schema")
+                    yield Dump(index, schema, values)
+                    index += 1
+                else:
+                    raise ValueError("Unknown block %r" % tag)
+            except EOFError:
+                return
+
+def _format(stat, value):
+    if stat.kind == KIND_SCALAR:
+        return [ (stat.name, value) ]
+    elif stat.kind in (KIND_VECTOR, KIND_FORMULA):
+        return [ ("%s::%s" % (stat.name,
+                              stat.subnames[i] if i < len(stat.subnames) and
+                              stat.subnames[i] else i), v)
+                 for i, v in enumerate(value) ]
+    elif stat.kind == KIND_VECTOR2D:
+        return [ ("%s::%d::%d" % (stat.name, i, j), v)
+                 for i, row in enumerate(value) for j, v in enumerate(row) ]
+    else:
+        dists = value if stat.kind == KIND_VECTOR_DIST else [ value ]
+        lines = []
+        for i, dist in enumerate(dists):
+            prefix = stat.name if len(dists) == 1 and \
+                stat.kind == KIND_DIST else "%s::%d" % (stat.name, i)
+            lines += [ ("%s::%s" % (prefix, f), dist[f])
+                       for f in DIST_FIELDS ]
+            lines += [ ("%s::bucket%d" % (prefix, b), v)
+                       for b, v in enumerate(dist["buckets"]) ]
+        return lines
+
+def main(argv=None):
+    import argparse
+
+    parser = argparse.ArgumentParser(
+        description="Print the dumps in a binary gem5 stats file")
+    parser.add_argument("file", help="Binary stats file")
+    parser.add_argument("--dump", type=int, default=None,
+                        help="Only print this dump")
+    parser.add_argument("--stat", action="append", default=[],
+                        help="Only print stats starting with this name")
+    args = parser.parse_args(argv)
+
+    for dump in StatFile(args.file):
+        if args.dump is not None and dump.index != args.dump:
+            continue
+        print("---------- Dump %d ----------" % dump.index)
+        for name, stat in dump.schema.items():
+            if args.stat and not any(name.startswith(s) for s in args.stat):
+                continue
+            for line_name, value in _format(stat, stat.decode(dump.values)):
+                print("%-60s %s" % (line_name, repr(value)))
+
+if __name__ == "__main__":
+    main()
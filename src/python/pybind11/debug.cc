@@ -67,6 +67,17 @@ output(const char *filename)
     Trace::setDebugLogger(new Trace::OstreamLogger(*file_stream->stream()));
 }
 
+static void
+outputBinary(const char *filename)
+{
+    OutputStream *file_stream = simout.find(filename);
+
+    if (!file_stream)
+        file_stream = simout.create(filename, true);
+
+    Trace::setDebugLogger(new Trace::BinaryLogger(*file_stream->stream()));
+}
+
 static void
 ignore(const char *expr)
 {
@@ -94,6 +105,7 @@ pybind_init_debug(py::module &m_native)
         .def_property_readonly("desc", &Debug::Flag::desc)
         .def("enable", &Debug::Flag::enable)
         .def("disable", &Debug::Flag::disable)
+        .def("enableFor", &Debug::Flag::enableFor)
         .def_property("status",
                       [](const Debug::Flag *flag) {
                           return flag->status();
@@ -119,6 +131,8 @@ pybind_init_debug(py::module &m_native)
     py::module m_trace = m_native.def_submodule("trace");
     m_trace
         .def("output", &output)
+        .def("outputBinary", &outputBinary)
+        .def("flush", &Trace::flush)
         .def("ignore", &ignore)
         .def("enable", &Trace::enable)
         .def("disable", &Trace::disable)
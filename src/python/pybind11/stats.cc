@@ -44,6 +44,7 @@
 #include "pybind11/stl.h"
 
 #include "base/statistics.hh"
+#include "base/stats/binary.hh"
 #include "base/stats/text.hh"
 #if USE_HDF5
 #include "base/stats/hdf5.hh"
@@ -99,6 +100,7 @@ pybind_init_stats(py::module &m_native)
     m
         .def("initSimStats", &Stats::initSimStats)
         .def("initText", &Stats::initText, py::return_value_policy::reference)
+        .def("initBinary", &Stats::initBinary)
 #if USE_HDF5
         .def("initHDF5", &Stats::initHDF5)
 #endif
@@ -137,6 +139,7 @@ pybind_init_stats(py::module &m_native)
         .def("reset", &Stats::Info::reset)
         .def("zero", &Stats::Info::zero)
         .def("visit", &Stats::Info::visit)
+        .def("merge", &Stats::Info::merge)
         ;
 
     py::class_<Stats::ScalarInfo, Stats::Info,
@@ -30,6 +30,8 @@ from m5.SimObject import SimObject
 from m5.params import *
 from m5.util import fatal
 
+class EventQueueBackend(Enum): vals = ['List', 'Calendar']
+
 class Root(SimObject):
 
     _the_instance = None
@@ -66,6 +68,17 @@ class Root(SimObject):
     # Needs to be set explicitly for a multi-eventq simulation.
     sim_quantum = Param.Tick(0, "simulation quantum")
 
+    # Storage used by the main event queues. The calendar queue scales
+    # better with the number of pending events (e.g., large Ruby
+    # systems), the list is cheaper for small systems.
+    eventq_backend = Param.EventQueueBackend('List',
+        "storage backend of the main event queues")
+
+    # Measure the host time spent in the events of each SimObject and
+    # write it to eventprof.json on every stats dump.
+    profile_events = Param.Bool(False,
+        "profile the host time spent processing events")
+
     full_system = Param.Bool("if this is a full system simulation")
 
     # Time syncing prevents the simulation from running faster than real time.
@@ -48,6 +48,8 @@ from m5.objects.SimpleMemory import *
 class MemoryMode(Enum): vals = ['invalid', 'atomic', 'timing',
                                 'atomic_noncaching']
 
+class MemCheckpointFormat(Enum): vals = ['gzip', 'chunked']
+
 if buildEnv['TARGET_ISA'] in ('sparc', 'power'):
     default_byte_order = 'big'
 else:
@@ -87,6 +89,24 @@ class System(SimObject):
         "use to directly address the backstore from another host-OS process. "
         "Leave this empty to unset the MAP_SHARED flag.")
 
+    # The chunked format only stores the pages that are in use,
+    # compresses them on several threads, and can store only the pages
+    # that changed since the previous checkpoint taken by the same
+    # simulation. A delta checkpoint finds its parent relative to its own
+    # directory, so checkpoints can only be moved together.
+    checkpoint_mem_format = Param.MemCheckpointFormat('gzip',
+        "File format of the physical memory in checkpoints")
+    checkpoint_mem_delta = Param.Bool(False, "Only store the memory pages "
+        "that changed since the previous checkpoint (chunked format only)")
+    checkpoint_mem_threads = Param.Unsigned(0, "Threads used to compress "
+        "and decompress chunked memory checkpoints, 0 for one per host core")
+    # On Linux hosts with userfaultfd, a chunked checkpoint can instead
+    # be restored on demand, so that a short simulation from a large
+    # checkpoint only inflates the memory it touches. A shared backstore
+    # is always restored up front.
+    checkpoint_mem_lazy_restore = Param.Bool(False, "Restore chunked "
+        "memory checkpoints on first access rather than up front")
+
     cache_line_size = Param.Unsigned(64, "Cache line size in bytes")
 
     byte_order = Param.ByteOrder(default_byte_order,
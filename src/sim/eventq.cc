@@ -30,12 +30,19 @@
 
 #include "sim/eventq.hh"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "base/intmath.hh"
 #include "base/logging.hh"
 #include "base/trace.hh"
 #include "cpu/smt.hh"
@@ -56,6 +63,116 @@ uint32_t numMainEventQueues = 0;
 vector<EventQueue *> mainEventQueue;
 __thread EventQueue *_curEventQueue = NULL;
 bool inParallelMode = false;
+static EventQueueBackend eventQueueBackend = EventQueueBackend::List;
+
+static bool eventProfiling = false;
+
+void
+setEventQueueBackend(EventQueueBackend backend)
+{
+    eventQueueBackend = backend;
+    for (auto eq : mainEventQueue)
+        eq->backend(backend);
+}
+
+/**
+ * Read a cheap host timer for the event profile: the time stamp
+ * counter where there is one, and a monotonic clock in nanoseconds
+ * otherwise.
+ */
+static inline uint64_t
+hostCycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void
+setEventProfiling(bool enable)
+{
+    eventProfiling = enable;
+}
+
+/**
+ * Write a string as a JSON string literal.
+ */
+static void
+jsonString(ostream &os, const string &str)
+{
+    os << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\')
+            os << '\\' << c;
+        else if ((unsigned char)c < 0x20)
+            ccprintf(os, "\\u%04x", (unsigned char)c);
+        else
+            os << c;
+    }
+    os << '"';
+}
+
+void
+dumpEventProfile(ostream &os)
+{
+    // Merge the queues, as a SimObject may have events on several
+    unordered_map<string, EventProfile> merged;
+    uint64_t total_cycles = 0;
+    for (auto eq : mainEventQueue) {
+        for (const auto &name_profile : eq->profile()) {
+            EventProfile &entry = merged[name_profile.first];
+            entry.description = name_profile.second.description;
+            entry.count += name_profile.second.count;
+            entry.hostCycles += name_profile.second.hostCycles;
+            total_cycles += name_profile.second.hostCycles;
+        }
+    }
+
+    vector<pair<const string *, const EventProfile *>> sorted;
+    sorted.reserve(merged.size());
+    for (const auto &name_profile : merged)
+        sorted.emplace_back(&name_profile.first, &name_profile.second);
+    sort(sorted.begin(), sorted.end(),
+         [](const pair<const string *, const EventProfile *> &a,
+            const pair<const string *, const EventProfile *> &b)
+         { return a.second->hostCycles > b.second->hostCycles; });
+
+    // Wrapped function events are named after their SimObject
+    const string wrapped(".wrapped_function_event");
+
+    ccprintf(os, "{\"tick\": %d, \"hostCycles\": %d, \"events\": [",
+             curTick(), total_cycles);
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        const string &name = *sorted[i].first;
+        const EventProfile &entry = *sorted[i].second;
+        string object(name);
+        if (object.size() > wrapped.size() &&
+            object.compare(object.size() - wrapped.size(), wrapped.size(),
+                           wrapped) == 0)
+            object.resize(object.size() - wrapped.size());
+
+        os << (i ? ", " : "") << "{\"name\": ";
+        jsonString(os, name);
+        os << ", \"object\": ";
+        jsonString(os, object);
+        os << ", \"type\": ";
+        jsonString(os, entry.description);
+        ccprintf(os, ", \"count\": %d, \"hostCycles\": %d, "
+                 "\"share\": %.4f}", entry.count, entry.hostCycles,
+                 total_cycles ? (double)entry.hostCycles / total_cycles : 0);
+    }
+    os << "]}" << endl;
+}
+
+void
+resetEventProfile()
+{
+    for (auto eq : mainEventQueue)
+        eq->resetProfile();
+}
 
 EventQueue *
 getEventQueue(uint32_t index)
@@ -73,6 +190,9 @@ getEventQueue(uint32_t index)
 Counter Event::instanceCounter = 0;
 #endif
 
+const size_t EventQueue::Calendar::MinBuckets;
+const size_t EventQueue::Calendar::WidthSamples;
+
 Event::~Event()
 {
     assert(!scheduled());
@@ -110,6 +230,11 @@ Event::insertBefore(Event *event, Event *curr)
 void
 EventQueue::insert(Event *event)
 {
+    if (_backend == EventQueueBackend::Calendar) {
+        calendarInsert(event);
+        return;
+    }
+
     // Deal with the head case
     if (!head || *event <= *head) {
         head = Event::insertBefore(event, head);
@@ -169,6 +294,11 @@ EventQueue::remove(Event *event)
 
     assert(event->queue == this);
 
+    if (_backend == EventQueueBackend::Calendar) {
+        calendarRemove(event);
+        return;
+    }
+
     // deal with an event on the head's 'in bin' list (event has the same
     // time as the head)
     if (*head == *event) {
@@ -198,10 +328,11 @@ EventQueue::serviceOne()
 {
     std::lock_guard<EventQueue> lock(*this);
     Event *event = head;
-    Event *next = head->nextInBin;
     event->flags.clear(Event::Scheduled);
 
-    if (next) {
+    if (_backend == EventQueueBackend::Calendar) {
+        calendarPopHead();
+    } else if (Event *next = head->nextInBin) {
         // update the next bin pointer since it could be stale
         next->nextBin = head->nextBin;
 
@@ -219,7 +350,10 @@ EventQueue::serviceOne()
         setCurTick(event->when());
         if (DTRACE(Event))
             event->trace("executed");
-        event->process();
+        if (eventProfiling)
+            processProfiled(event);
+        else
+            event->process();
         if (event->isExitEvent()) {
             assert(!event->flags.isSet(Event::Managed) ||
                    !event->flags.isSet(Event::IsMainQueue)); // would be silly
@@ -234,6 +368,35 @@ EventQueue::serviceOne()
     return NULL;
 }
 
+void
+EventQueue::processProfiled(Event *event)
+{
+    // Find the entry before processing, as the event may be gone by
+    // the time process() returns. An event freed and replaced by one
+    // of the same type at the same address continues its entry.
+    const char *description = event->description();
+    const bool auto_delete = event->flags.isSet(Event::AutoDelete);
+    EventProfile *&slot = _profileIndex[auto_delete ?
+        static_cast<const void *>(description) : event];
+    if (!slot || slot->description != description) {
+        slot = &_profile[auto_delete ? string(description) : event->name()];
+        slot->description = description;
+    }
+    EventProfile *entry = slot;
+
+    const uint64_t start = hostCycles();
+    event->process();
+    entry->hostCycles += hostCycles() - start;
+    ++entry->count;
+
+    // Only clear the profile now that no entry is in use
+    if (_profileResetPending.load(std::memory_order_relaxed) &&
+        _profileResetPending.exchange(false)) {
+        _profileIndex.clear();
+        _profile.clear();
+    }
+}
+
 void
 Event::serialize(CheckpointOut &cp) const
 {
@@ -294,15 +457,12 @@ EventQueue::dump() const
     if (empty())
         cprintf("<No Events>\n");
     else {
-        Event *nextBin = head;
-        while (nextBin) {
+        for (auto nextBin : sortedBins()) {
             Event *nextInBin = nextBin;
             while (nextInBin) {
                 nextInBin->dump();
                 nextInBin = nextInBin->nextInBin;
             }
-
-            nextBin = nextBin->nextBin;
         }
     }
 
@@ -315,10 +475,28 @@ EventQueue::debugVerify() const
     std::unordered_map<long, bool> map;
 
     Tick time = 0;
-    short priority = 0;
+    short priority = Event::Minimum_Pri;
+
+    if (_backend == EventQueueBackend::Calendar) {
+        // Every bin must hash to the bucket it is on and buckets must
+        // be sorted. The order across buckets is checked below.
+        for (size_t i = 0; i < calendar.buckets.size(); ++i) {
+            for (Event *bin = calendar.buckets[i]; bin; bin = bin->nextBin) {
+                if (calendar.bucketOf(bin->when()) != i) {
+                    cprintf("bin in the wrong bucket!");
+                    bin->dump();
+                    return false;
+                }
+                if (bin->nextBin && !(*bin < *bin->nextBin)) {
+                    cprintf("bucket out of order!");
+                    bin->dump();
+                    return false;
+                }
+            }
+        }
+    }
 
-    Event *nextBin = head;
-    while (nextBin) {
+    for (auto nextBin : sortedBins()) {
         Event *nextInBin = nextBin;
         while (nextInBin) {
             if (nextInBin->when() < time) {
@@ -344,8 +522,6 @@ EventQueue::debugVerify() const
 
             nextInBin = nextInBin->nextInBin;
         }
-
-        nextBin = nextBin->nextBin;
     }
 
     return true;
@@ -354,11 +530,233 @@ EventQueue::debugVerify() const
 Event*
 EventQueue::replaceHead(Event* s)
 {
-    Event* t = head;
-    head = s;
+    Event* t = detachBins();
+    attachBins(s);
     return t;
 }
 
+void
+EventQueue::backend(EventQueueBackend new_backend)
+{
+    if (new_backend == _backend)
+        return;
+
+    Event *bins = detachBins();
+    _backend = new_backend;
+    calendar = Calendar();
+    attachBins(bins);
+}
+
+std::vector<Event *>
+EventQueue::sortedBins() const
+{
+    std::vector<Event *> bins;
+    if (_backend == EventQueueBackend::Calendar) {
+        bins.reserve(calendar.numBins);
+        for (auto bucket : calendar.buckets) {
+            for (Event *bin = bucket; bin; bin = bin->nextBin)
+                bins.push_back(bin);
+        }
+        std::sort(bins.begin(), bins.end(),
+                  [](const Event *l, const Event *r) { return *l < *r; });
+    } else {
+        for (Event *bin = head; bin; bin = bin->nextBin)
+            bins.push_back(bin);
+    }
+    return bins;
+}
+
+Event *
+EventQueue::detachBins()
+{
+    if (_backend != EventQueueBackend::Calendar) {
+        Event *list = head;
+        head = NULL;
+        return list;
+    }
+
+    std::vector<Event *> bins = sortedBins();
+    for (size_t i = 0; i + 1 < bins.size(); ++i)
+        bins[i]->nextBin = bins[i + 1];
+    if (!bins.empty())
+        bins.back()->nextBin = NULL;
+
+    std::fill(calendar.buckets.begin(), calendar.buckets.end(), nullptr);
+    calendar.numBins = 0;
+    head = NULL;
+
+    return bins.empty() ? NULL : bins.front();
+}
+
+void
+EventQueue::attachBins(Event *list)
+{
+    assert(empty());
+
+    if (_backend != EventQueueBackend::Calendar) {
+        head = list;
+        return;
+    }
+
+    while (list) {
+        Event *next = list->nextBin;
+        calendarInsertBin(list);
+        list = next;
+    }
+}
+
+void
+EventQueue::calendarInsertBin(Event *top)
+{
+    Event **link = &calendar.buckets[calendar.bucketOf(top->when())];
+    while (*link && **link < *top)
+        link = &(*link)->nextBin;
+
+    assert(!*link || **link != *top);
+    top->nextBin = *link;
+    *link = top;
+
+    if (!head || *top < *head)
+        head = top;
+
+    if (++calendar.numBins > 2 * calendar.buckets.size())
+        calendarResize(2 * calendar.buckets.size());
+}
+
+void
+EventQueue::calendarInsert(Event *event)
+{
+    // Find the bin on the event's bucket, the bucket is normally
+    // short so this is a constant time operation.
+    Event **link = &calendar.buckets[calendar.bucketOf(event->when())];
+    while (*link && **link < *event)
+        link = &(*link)->nextBin;
+
+    *link = Event::insertBefore(event, *link);
+
+    // The event is now the top of its bin, which is the head bin if
+    // it has the same time and priority as the old head.
+    if (!head || *event <= *head)
+        head = event;
+
+    // insertBefore() only leaves nextInBin empty if it started a new bin
+    if (!event->nextInBin &&
+        ++calendar.numBins > 2 * calendar.buckets.size()) {
+        calendarResize(2 * calendar.buckets.size());
+    }
+}
+
+void
+EventQueue::calendarRemove(Event *event)
+{
+    Event **link = &calendar.buckets[calendar.bucketOf(event->when())];
+    while (*link && **link < *event)
+        link = &(*link)->nextBin;
+
+    if (!*link || **link != *event)
+        panic("event not found!");
+
+    Event *top = *link;
+    bool bin_removed = event == top && !top->nextInBin;
+    *link = Event::removeItem(event, top);
+
+    if (event == head)
+        head = bin_removed ? calendarFindHead(event->when()) : *link;
+
+    if (bin_removed && --calendar.numBins < calendar.buckets.size() / 2 &&
+        calendar.buckets.size() > Calendar::MinBuckets) {
+        calendarResize(calendar.buckets.size() / 2);
+    }
+}
+
+void
+EventQueue::calendarPopHead()
+{
+    Event *event = head;
+    Event *&bucket = calendar.buckets[calendar.bucketOf(event->when())];
+    // The head bin is the earliest bin, so it is first on its bucket
+    assert(bucket == event);
+
+    if (Event *next = event->nextInBin) {
+        next->nextBin = event->nextBin;
+        bucket = next;
+        head = next;
+        return;
+    }
+
+    bucket = event->nextBin;
+    head = calendarFindHead(event->when());
+
+    if (--calendar.numBins < calendar.buckets.size() / 2 &&
+        calendar.buckets.size() > Calendar::MinBuckets) {
+        calendarResize(calendar.buckets.size() / 2);
+    }
+}
+
+Event *
+EventQueue::calendarFindHead(Tick from) const
+{
+    if (calendar.numBins == 0)
+        return NULL;
+
+    // No bin is earlier than 'from', so the first bucket (starting
+    // from the one holding 'from') whose first bin falls in the
+    // current pass over the calendar holds the earliest bin.
+    const size_t num_buckets = calendar.buckets.size();
+    Tick slot = from >> calendar.bucketShift;
+    for (size_t i = 0; i < num_buckets; ++i, ++slot) {
+        Event *top = calendar.buckets[slot & (num_buckets - 1)];
+        if (top && (top->when() >> calendar.bucketShift) == slot)
+            return top;
+    }
+
+    // Nothing is due within a full pass, fall back to a direct search
+    // of the bucket heads.
+    Event *min = NULL;
+    for (auto top : calendar.buckets) {
+        if (top && (!min || *top < *min))
+            min = top;
+    }
+    return min;
+}
+
+void
+EventQueue::calendarResize(size_t num_buckets)
+{
+    std::vector<Event *> bins = sortedBins();
+
+    // Size the buckets to about three times the average separation of
+    // the earliest bins, ignoring outliers more than twice the
+    // average apart (e.g., events scheduled far into the future).
+    const size_t samples = std::min(bins.size(), Calendar::WidthSamples);
+    if (samples > 1) {
+        Tick span = bins[samples - 1]->when() - bins[0]->when();
+        Tick avg = span / (samples - 1);
+        Tick sum = 0;
+        size_t count = 0;
+        for (size_t i = 1; i < samples; ++i) {
+            Tick gap = bins[i]->when() - bins[i - 1]->when();
+            if (gap <= 2 * avg) {
+                sum += gap;
+                ++count;
+            }
+        }
+        if (count && sum) {
+            calendar.bucketShift =
+                ceilLog2(std::max<Tick>(3 * sum / count, 1));
+        }
+    }
+
+    // Insert the bins in reverse order so that every bucket is built
+    // by prepending.
+    calendar.buckets.assign(num_buckets, nullptr);
+    for (auto it = bins.rbegin(); it != bins.rend(); ++it) {
+        Event *&bucket = calendar.buckets[calendar.bucketOf((*it)->when())];
+        (*it)->nextBin = bucket;
+        bucket = *it;
+    }
+}
+
 void
 dumpMainQueue()
 {
@@ -419,7 +817,8 @@ Event::dump() const
 }
 
 EventQueue::EventQueue(const string &n)
-    : objName(n), head(NULL), _curTick(0)
+    : objName(n), head(NULL), _curTick(0), _backend(eventQueueBackend),
+      _profileResetPending(false)
 {
 }
 
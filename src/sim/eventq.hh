@@ -36,6 +36,7 @@
 #define __SIM_EVENTQ_HH__
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <climits>
 #include <functional>
@@ -43,6 +44,8 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "base/debug.hh"
 #include "base/flags.hh"
@@ -74,6 +77,41 @@ extern __thread EventQueue *_curEventQueue;
 //! Current mode of execution: parallel / serial
 extern bool inParallelMode;
 
+//! Storage backend used by newly created main event queues. Existing
+//! queues are migrated when the backend is changed through
+//! setEventQueueBackend().
+enum class EventQueueBackend {
+    List,       //!< Sorted linked list of bins (the classic queue)
+    Calendar,   //!< Calendar queue of bins hashed by tick
+};
+
+void setEventQueueBackend(EventQueueBackend backend);
+
+//! Number of events processed and host time spent processing them,
+//! for one entry of the event profile.
+struct EventProfile
+{
+    const char *description;
+    uint64_t count;
+    uint64_t hostCycles;
+
+    EventProfile() : description(nullptr), count(0), hostCycles(0) {}
+};
+
+//! Enable or disable the event profile. While enabled, the host time
+//! spent in Event::process() is measured and attributed to the name
+//! of each event, which normally starts with the name of its
+//! SimObject. Auto-deleted events are attributed to their description
+//! instead, as their names usually identify a single instance.
+void setEventProfiling(bool enable);
+
+//! Write the merged profile of all main event queues as a single line
+//! JSON object, sorted by host time.
+void dumpEventProfile(std::ostream &os);
+
+//! Clear the profile of all main event queues.
+void resetEventProfile();
+
 //! Function for returning eventq queue for the provided
 //! index. The function allocates a new queue in case one
 //! does not exist for the index, provided that the index
@@ -257,6 +295,10 @@ class Event : public EventBase, public Serializable
     // linear/constant, and the lookup/removal in 'nextInBin' is
     // constant/constant.  Hopefully this is a significant improvement
     // over the current fully linear insertion.
+    //
+    // When the owning queue uses the calendar backend, 'nextBin'
+    // chains the bins that hash to the same calendar bucket rather
+    // than all the bins in the queue.
     Event *nextBin;
     Event *nextInBin;
 
@@ -621,12 +663,82 @@ class EventQueue
     Event *head;
     Tick _curTick;
 
+    //! Storage backend of this queue.
+    EventQueueBackend _backend;
+
+    /**
+     * State of the calendar backend.
+     *
+     * Bins (see Event::nextBin) are hashed into buckets of
+     * 2^bucketShift ticks, wrapping around every buckets.size()
+     * buckets. Each bucket keeps its bins sorted, so the first bin of
+     * the bucket holding the current tick is normally the next one to
+     * run and events scheduled for the same or the next few cycles are
+     * inserted without walking the rest of the queue. The number of
+     * buckets and their width are adapted as the number of bins grows
+     * and shrinks.
+     */
+    struct Calendar
+    {
+        std::vector<Event *> buckets;
+        unsigned bucketShift;
+        size_t numBins;
+
+        Calendar() : buckets(MinBuckets, nullptr), bucketShift(9),
+                     numBins(0)
+        {}
+
+        static const size_t MinBuckets = 64;
+        //! Number of leading bins sampled to pick the bucket width.
+        static const size_t WidthSamples = 32;
+
+        size_t
+        bucketOf(Tick when) const
+        {
+            return (when >> bucketShift) & (buckets.size() - 1);
+        }
+    } calendar;
+
+    //! Calendar backend helpers, see eventq.cc.
+    void calendarInsertBin(Event *top);
+    void calendarInsert(Event *event);
+    void calendarRemove(Event *event);
+    void calendarPopHead();
+    Event *calendarFindHead(Tick from) const;
+    void calendarResize(size_t num_buckets);
+
+    //! Collect the top event of every bin in time order.
+    std::vector<Event *> sortedBins() const;
+    //! Unlink all bins and return them as a bin list sorted in time
+    //! order, leaving the queue empty.
+    Event *detachBins();
+    //! Add all bins of a sorted bin list to an empty queue.
+    void attachBins(Event *list);
+
     //! Mutex to protect async queue.
     std::mutex async_queue_mutex;
 
     //! List of events added by other threads to this event queue.
     std::list<Event*> async_queue;
 
+    //! Callbacks run by the owning thread at every global barrier,
+    //! while all other threads are stopped.
+    std::vector<std::function<void()>> syncCallbacks;
+
+    //! Host time spent in the events of this queue, by event name.
+    std::unordered_map<std::string, EventProfile> _profile;
+
+    //! Entries of the profile by event, or by description for
+    //! auto-deleted events, so that names are only built once.
+    std::unordered_map<const void *, EventProfile *> _profileIndex;
+
+    //! Set by resetProfile(); the profile is cleared by the owning
+    //! thread once the event being processed has finished.
+    std::atomic<bool> _profileResetPending;
+
+    //! Process an event, adding its host time to the profile.
+    void processProfiled(Event *event);
+
     /**
      * Lock protecting event handling.
      *
@@ -748,6 +860,14 @@ class EventQueue
     void name(const std::string &st) { objName = st; }
     /** @}*/ //end of api_eventq group
 
+    EventQueueBackend backend() const { return _backend; }
+
+    /**
+     * Change the storage backend of this queue. Scheduled events are
+     * moved to the new backend and keep their relative order.
+     */
+    void backend(EventQueueBackend new_backend);
+
     /**
      * Schedule the given event on this queue. Safe to call from any thread.
      *
@@ -900,11 +1020,56 @@ class EventQueue
 
     bool debugVerify() const;
 
+    /**
+     * Host time spent in the events of this queue, by event name,
+     * collected while event profiling is enabled.
+     */
+    const std::unordered_map<std::string, EventProfile> &
+    profile() const
+    {
+        static const std::unordered_map<std::string, EventProfile> empty;
+        return _profileResetPending ? empty : _profile;
+    }
+
+    /**
+     * Clear the event profile of this queue. This may be called from
+     * an event, e.g., a stats reset, or from another thread, so the
+     * profile is only cleared after the current event.
+     */
+    void resetProfile() { _profileResetPending = true; }
+
     /**
      * Function for moving events from the async_queue to the main queue.
      */
     void handleAsyncInsertions();
 
+    /**
+     * Register a callback to run on the thread owning this queue at
+     * every global barrier, e.g., at the end of every simulation
+     * quantum. The other threads are all stopped at the barrier, so
+     * objects can use this to deterministically accept work posted by
+     * other threads since the previous barrier. Callbacks run in
+     * registration order and must be registered before simulation
+     * starts.
+     */
+    void
+    registerSyncCallback(const std::function<void()> &callback)
+    {
+        syncCallbacks.push_back(callback);
+    }
+
+    /**
+     * Run the sync callbacks. Called by every thread between the two
+     * barriers of a global event.
+     */
+    void
+    handleSyncCallbacks()
+    {
+        assert(this == curEventQueue());
+        for (auto &callback : syncCallbacks)
+            callback();
+    }
+
     /**
      *  Function to signal that the event loop should be woken up because
      *  an event has been scheduled by an agent outside the gem5 event
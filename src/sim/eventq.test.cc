@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "sim/eventq.hh"
+
+namespace {
+
+typedef std::vector<std::pair<int, Tick>> EventLog;
+
+/** Records its id and the tick it ran at. */
+class LogEvent : public Event
+{
+  public:
+    LogEvent(EventLog &log, int id, Priority p)
+        : Event(p), log(log), id(id)
+    {}
+
+    void process() override { log.emplace_back(id, when()); }
+    const char *description() const override { return "LogEvent"; }
+
+  private:
+    EventLog &log;
+    const int id;
+};
+
+/**
+ * Run a random mix of schedule, deschedule, reschedule and service
+ * operations on a queue and return the order the events ran in. The
+ * operations only depend on the seed and on which events are
+ * scheduled, so two correct backends see the same operations.
+ *
+ * @param switch_at Step at which to switch to the other backend, if
+ *        smaller than steps.
+ */
+EventLog
+runSchedule(EventQueueBackend backend, unsigned seed, int steps,
+            int switch_at)
+{
+    static const Event::Priority priorities[] = {
+        Event::Minimum_Pri, -1, Event::Default_Pri, 1, Event::Maximum_Pri,
+    };
+    const int num_events = 256;
+
+    EventLog log;
+    EventQueue eq("test");
+    eq.backend(backend);
+
+    std::mt19937 rng(seed);
+    std::vector<std::unique_ptr<LogEvent>> events;
+    for (int i = 0; i < num_events; ++i) {
+        events.emplace_back(new LogEvent(log, i,
+                                         priorities[rng() % 5]));
+    }
+
+    auto delay = [&rng]() -> Tick {
+        switch (rng() % 5) {
+          case 0: return 0;                         // same tick
+          case 1: return rng() % 4;                 // same bin soon
+          case 2: return rng() % 2000;              // neighbouring bins
+          case 3: return rng() % (1ULL << 20);      // wraps the calendar
+          default: return (Tick)rng() << 16;        // far in the future
+        }
+    };
+
+    for (int step = 0; step < steps; ++step) {
+        if (step == switch_at) {
+            eq.backend(backend == EventQueueBackend::List ?
+                       EventQueueBackend::Calendar :
+                       EventQueueBackend::List);
+        }
+
+        LogEvent *event = events[rng() % num_events].get();
+        const unsigned op = rng() % 10;
+        if (op < 4) {
+            if (!event->scheduled())
+                eq.schedule(event, eq.getCurTick() + delay());
+        } else if (op < 5) {
+            if (event->scheduled())
+                eq.deschedule(event);
+        } else if (op < 6) {
+            eq.reschedule(event, eq.getCurTick() + delay(), true);
+        } else if (!eq.empty()) {
+            eq.serviceOne();
+        }
+        if (step % 64 == 0)
+            EXPECT_TRUE(eq.debugVerify());
+    }
+    EXPECT_TRUE(eq.debugVerify());
+
+    while (!eq.empty())
+        eq.serviceOne();
+
+    return log;
+}
+
+/** Clears the profile of its queue, like a stats reset does. */
+class ResetProfileEvent : public Event
+{
+  public:
+    ResetProfileEvent(EventQueue &eq) : eq(eq) {}
+
+    void process() override { eq.resetProfile(); }
+    const std::string name() const override { return "reset"; }
+    const char *description() const override { return "ResetEvent"; }
+
+  private:
+    EventQueue &eq;
+};
+
+} // anonymous namespace
+
+TEST(EventQueueTest, CalendarMatchesList)
+{
+    for (unsigned seed = 1; seed <= 8; ++seed) {
+        const EventLog list = runSchedule(EventQueueBackend::List,
+                                          seed, 20000, -1);
+        const EventLog calendar = runSchedule(EventQueueBackend::Calendar,
+                                              seed, 20000, -1);
+        ASSERT_GT(list.size(), 1000);
+        EXPECT_EQ(list, calendar) << "seed " << seed;
+    }
+}
+
+TEST(EventQueueTest, SwitchBackend)
+{
+    for (unsigned seed = 1; seed <= 4; ++seed) {
+        const EventLog list = runSchedule(EventQueueBackend::List,
+                                          seed, 20000, -1);
+        EXPECT_EQ(list, runSchedule(EventQueueBackend::List,
+                                    seed, 20000, 10000))
+            << "seed " << seed;
+        EXPECT_EQ(list, runSchedule(EventQueueBackend::Calendar,
+                                    seed, 20000, 10000))
+            << "seed " << seed;
+    }
+}
+
+TEST(EventQueueTest, SameTickOrder)
+{
+    // Lower priorities first, then the order within a priority that
+    // the list backend has always used
+    for (auto backend : { EventQueueBackend::List,
+                          EventQueueBackend::Calendar }) {
+        EventLog log;
+        EventQueue eq("test");
+        eq.backend(backend);
+        LogEvent a(log, 0, Event::Default_Pri);
+        LogEvent b(log, 1, Event::Default_Pri);
+        LogEvent c(log, 2, Event::Minimum_Pri);
+        LogEvent d(log, 3, Event::Maximum_Pri);
+        LogEvent e(log, 4, Event::Default_Pri);
+        eq.schedule(&a, 100);
+        eq.schedule(&d, 100);
+        eq.schedule(&b, 100);
+        eq.schedule(&c, 100);
+        eq.schedule(&e, 50);
+        while (!eq.empty())
+            eq.serviceOne();
+        const EventLog expected = {
+            { 4, 50 }, { 2, 100 }, { 1, 100 }, { 0, 100 }, { 3, 100 },
+        };
+        EXPECT_EQ(log, expected);
+    }
+}
+
+TEST(EventQueueTest, ProfileReset)
+{
+    EventLog log;
+    EventQueue eq("test");
+    LogEvent a(log, 0, Event::Default_Pri);
+    LogEvent b(log, 1, Event::Default_Pri);
+    ResetProfileEvent reset(eq);
+
+    setEventProfiling(true);
+    eq.schedule(&a, 10);
+    eq.schedule(&reset, 20);
+    eq.schedule(&b, 30);
+
+    eq.serviceOne();
+    ASSERT_EQ(eq.profile().size(), 1);
+    EXPECT_EQ(eq.profile().begin()->second.count, 1);
+
+    // The reset takes effect once the event that requested it is done
+    eq.serviceOne();
+    EXPECT_TRUE(eq.profile().empty());
+
+    eq.schedule(&a, 40);
+    eq.serviceOne();
+    eq.serviceOne();
+    setEventProfiling(false);
+
+    ASSERT_EQ(eq.profile().size(), 2);
+    for (const auto &name_profile : eq.profile()) {
+        EXPECT_EQ(name_profile.second.count, 1);
+        EXPECT_STREQ(name_profile.second.description, "LogEvent");
+    }
+    EXPECT_EQ(eq.profile().count("reset"), 0);
+}
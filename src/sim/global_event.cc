@@ -131,6 +131,10 @@ GlobalEvent::BarrierEvent::process()
         _globalEvent->process();
     }
 
+    // no thread is simulating between the two barriers, so work posted
+    // by other threads can be accepted in a deterministic order
+    curEventQueue()->handleSyncCallbacks();
+
     // second barrier to force all queues to wait for event processing
     // to finish before continuing
     globalBarrier();
@@ -145,6 +149,9 @@ GlobalSyncEvent::BarrierEvent::process()
         _globalEvent->process();
     }
 
+    // see GlobalEvent::BarrierEvent::process()
+    curEventQueue()->handleSyncCallbacks();
+
     // second barrier to force all queues to wait for event processing
     // to finish before continuing
     globalBarrier();
@@ -28,6 +28,8 @@
  */
 
 #include "base/logging.hh"
+#include "base/output.hh"
+#include "base/statistics.hh"
 #include "base/trace.hh"
 #include "config/the_isa.hh"
 #include "debug/TimeSync.hh"
@@ -112,6 +114,19 @@ Root::Root(RootParams *p)
     lastTime.setTimer();
 
     simQuantum = p->sim_quantum;
+    setEventQueueBackend(p->eventq_backend == Enums::Calendar ?
+                         EventQueueBackend::Calendar :
+                         EventQueueBackend::List);
+
+    if (p->profile_events) {
+        setEventProfiling(true);
+        // One JSON line per stats dump, since the last stats reset
+        OutputStream *os = simout.findOrCreate("eventprof.json");
+        Stats::registerDumpCallback([os]() {
+            dumpEventProfile(*os->stream());
+        });
+        Stats::registerResetCallback(resetEventProfile);
+    }
 }
 
 void
@@ -73,92 +73,6 @@ std::stack<std::string> Serializable::path;
 
 /////////////////////////////
 
-/// Container for serializing global variables (not associated with
-/// any serialized object).
-class Globals : public Serializable
-{
-  public:
-    Globals()
-        : unserializedCurTick(0) {}
-
-    void serialize(CheckpointOut &cp) const override;
-    void unserialize(CheckpointIn &cp) override;
-
-    Tick unserializedCurTick;
-};
-
-/// The one and only instance of the Globals class.
-Globals globals;
-
-/// The version tags for this build of the simulator, to be stored in the
-/// Globals section during serialization and compared upon unserialization.
-extern std::set<std::string> version_tags;
-
-void
-Globals::serialize(CheckpointOut &cp) const
-{
-    paramOut(cp, "curTick", curTick());
-    SERIALIZE_CONTAINER(version_tags);
-}
-
-void
-Globals::unserialize(CheckpointIn &cp)
-{
-    paramIn(cp, "curTick", unserializedCurTick);
-
-    const std::string &section(Serializable::currentSection());
-    std::string str;
-    if (!cp.find(section, "version_tags", str)) {
-        warn("**********************************************************\n");
-        warn("!!!! Checkpoint uses an old versioning scheme.        !!!!\n");
-        warn("Run the checkpoint upgrader (util/cpt_upgrader.py) on your "
-             "checkpoint\n");
-        warn("**********************************************************\n");
-        return;
-    }
-
-    std::set<std::string> cpt_tags;
-    arrayParamIn(cp, "version_tags", cpt_tags); // UNSERIALIZE_CONTAINER
-
-    bool err = false;
-    for (const auto& t : version_tags) {
-        if (cpt_tags.find(t) == cpt_tags.end()) {
-            // checkpoint is missing tag that this binary has
-            if (!err) {
-                warn("*****************************************************\n");
-                warn("!!!! Checkpoint is missing the following version tags:\n");
-                err = true;
-            }
-            warn("  %s\n", t);
-        }
-    }
-    if (err) {
-        warn("You might experience some issues when restoring and should run "
-             "the checkpoint upgrader (util/cpt_upgrader.py) on your "
-             "checkpoint\n");
-        warn("**********************************************************\n");
-    }
-
-    err = false;
-    for (const auto& t : cpt_tags) {
-        if (version_tags.find(t) == version_tags.end()) {
-            // gem5 binary is missing tag that this checkpoint has
-            if (!err) {
-                warn("*****************************************************\n");
-                warn("!!!! gem5 is missing the following version tags:\n");
-                err = true;
-            }
-            warn("  %s\n", t);
-        }
-    }
-    if (err) {
-        warn("Running a checkpoint with incompatible version tags is not "
-             "supported. While it might work, you may experience incorrect "
-             "behavior or crashes.\n");
-        warn("**********************************************************\n");
-     }
-}
-
 Serializable::Serializable()
 {
 }
@@ -181,34 +95,6 @@ Serializable::unserializeSection(CheckpointIn &cp, const char *name)
     unserialize(cp);
 }
 
-void
-Serializable::serializeAll(const string &cpt_dir)
-{
-    string dir = CheckpointIn::setDir(cpt_dir);
-    if (mkdir(dir.c_str(), 0775) == -1 && errno != EEXIST)
-            fatal("couldn't mkdir %s\n", dir);
-
-    string cpt_file = dir + CheckpointIn::baseFilename;
-    ofstream outstream(cpt_file.c_str());
-    time_t t = time(NULL);
-    if (!outstream.is_open())
-        fatal("Unable to open file %s for writing\n", cpt_file.c_str());
-    outstream << "## checkpoint generated: " << ctime(&t);
-
-    globals.serializeSection(outstream, "Globals");
-
-    SimObject::serializeAll(outstream);
-}
-
-void
-Serializable::unserializeGlobals(CheckpointIn &cp)
-{
-    globals.unserializeSection(cp, "Globals");
-
-    for (uint32_t i = 0; i < numMainEventQueues; ++i)
-        mainEventQueue[i]->setCurTick(globals.unserializedCurTick);
-}
-
 Serializable::ScopedCheckpointSection::~ScopedCheckpointSection()
 {
     assert(!path.empty());
@@ -344,9 +230,3 @@ objParamIn(CheckpointIn &cp, const string &name, SimObject * &param)
         fatal("Can't unserialize '%s:%s'\n", section, name);
     }
 }
-
-void
-debug_serialize(const string &cpt_dir)
-{
-    Serializable::serializeAll(cpt_dir);
-}
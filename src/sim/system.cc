@@ -215,7 +215,10 @@ System::System(Params *p)
       kvmVM(nullptr),
 #endif
       physmem(name() + ".physmem", p->memories, p->mmap_using_noreserve,
-              p->shared_backstore),
+              p->shared_backstore,
+              p->checkpoint_mem_format == Enums::chunked,
+              p->checkpoint_mem_delta, p->checkpoint_mem_threads,
+              p->checkpoint_mem_lazy_restore),
       memoryMode(p->mem_mode),
       _cacheLineSize(p->cache_line_size),
       workItemsBegin(0),
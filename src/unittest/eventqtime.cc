@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Event queue microbenchmark. A number of periodic objects reschedule
+ * themselves with a mix of clock periods, similar to the clocked
+ * controllers, routers and CPUs of a large Ruby system, and the event
+ * rate of each event queue backend is reported for a growing number of
+ * pending events.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "base/cprintf.hh"
+#include "sim/eventq.hh"
+
+using namespace std;
+
+class PeriodicEvent : public Event
+{
+  private:
+    EventQueue &eq;
+    const Tick period;
+
+  public:
+    PeriodicEvent(EventQueue &_eq, Tick _period, Priority p)
+        : Event(p), eq(_eq), period(_period)
+    {}
+
+    void process() override { eq.schedule(this, eq.getCurTick() + period); }
+};
+
+static uint64_t
+run(EventQueueBackend backend, unsigned num_objects, uint64_t num_events)
+{
+    EventQueue eq("eventqtime");
+    eq.backend(backend);
+    curEventQueue(&eq);
+
+    // Periods of 1, 2 and 4 cycles at 500 ticks (2 GHz), plus a few
+    // slow objects, with the usual tie-breaking priorities.
+    const Tick periods[] = { 500, 500, 500, 1000, 1000, 2000, 100000 };
+    const Event::Priority prios[] = {
+        Event::Default_Pri, Event::Default_Pri, Event::CPU_Tick_Pri,
+        Event::Delayed_Writeback_Pri };
+
+    mt19937 rng(num_objects);
+    vector<unique_ptr<PeriodicEvent>> events;
+    for (unsigned i = 0; i < num_objects; ++i) {
+        Tick period = periods[rng() % (sizeof(periods) / sizeof(Tick))];
+        Event::Priority prio = prios[rng() % 4];
+        events.emplace_back(new PeriodicEvent(eq, period, prio));
+        eq.schedule(events.back().get(), rng() % period);
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (uint64_t i = 0; i < num_events; ++i)
+        eq.serviceOne();
+    chrono::duration<double> secs = chrono::steady_clock::now() - start;
+
+    for (auto &event : events)
+        eq.deschedule(event.get());
+
+    return num_events / secs.count();
+}
+
+int
+main()
+{
+    const uint64_t num_events = 1000000;
+
+    cprintf("%10s %15s %15s\n", "objects", "list ev/s", "calendar ev/s");
+    for (unsigned num_objects = 16; num_objects <= 16384; num_objects *= 4) {
+        cprintf("%10d %15d %15d\n", num_objects,
+                run(EventQueueBackend::List, num_objects, num_events),
+                run(EventQueueBackend::Calendar, num_objects, num_events));
+    }
+
+    return 0;
+}
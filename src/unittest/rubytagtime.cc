@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2020 The Regents of the University of California
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met: redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer;
+ * redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution;
+ * neither the name of the copyright holders nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Ruby tag lookup microbenchmark. A cache is filled with random lines
+ * and then probed with a mix of hits and misses, once with the layout
+ * CacheMemory has always used (a hash map from line address to way, then
+ * a check of the entry's permission) and once with the flat per-set tag
+ * array, which keeps the entry pointers next to the full tags. The
+ * lookup rate of each layout is reported for a few typical cache
+ * geometries.
+ */
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "base/cprintf.hh"
+#include "base/intmath.hh"
+#include "mem/ruby/structures/FlatTagArray.hh"
+
+using namespace std;
+
+struct Entry
+{
+    Addr address;
+    bool present;
+};
+
+struct Cache
+{
+    int numSets;
+    int assoc;
+    vector<vector<Entry *>> sets;
+    vector<unique_ptr<Entry>> entries;
+
+    int64_t setOf(Addr line) const { return (line >> 6) & (numSets - 1); }
+};
+
+struct MapTags
+{
+    const Cache &cache;
+    unordered_map<Addr, int> index;
+
+    MapTags(const Cache &c) : cache(c) {}
+    void insert(int64_t set, int way, Addr line) { index[line] = way; }
+
+    bool
+    lookup(Addr line) const
+    {
+        auto it = index.find(line);
+        return it != index.end() &&
+            cache.sets[cache.setOf(line)][it->second]->present;
+    }
+};
+
+struct FlatTags
+{
+    const Cache &cache;
+    FlatTagArray<Entry *> tags;
+
+    FlatTags(const Cache &c) : cache(c)
+    {
+        tags.init(c.numSets, c.assoc, 6 + floorLog2(c.numSets));
+    }
+
+    void
+    insert(int64_t set, int way, Addr line)
+    {
+        tags.insert(set, way, line, cache.sets[set][way]);
+    }
+
+    bool
+    lookup(Addr line) const
+    {
+        int64_t set = cache.setOf(line);
+        int way = tags.findWay(set, line);
+        return way != -1 && tags.getData(set, way)->present;
+    }
+};
+
+template <class Tags>
+static uint64_t
+run(const Cache &cache, const vector<Addr> &probes, uint64_t num_lookups,
+    uint64_t &hits)
+{
+    Tags tags(cache);
+    for (int set = 0; set < cache.numSets; ++set) {
+        for (int way = 0; way < cache.assoc; ++way)
+            tags.insert(set, way, cache.sets[set][way]->address);
+    }
+
+    // Make every probe depend on the outcome of the previous one, as in
+    // a controller where a lookup is followed by the work it triggers,
+    // so the loop measures lookup latency rather than how many
+    // independent lookups the host can overlap.
+    hits = 0;
+    size_t next = 0;
+    auto start = chrono::steady_clock::now();
+    for (uint64_t i = 0; i < num_lookups; ++i) {
+        bool hit = tags.lookup(probes[next]);
+        hits += hit;
+        next = (next + 1 + hit) % probes.size();
+    }
+    chrono::duration<double> secs = chrono::steady_clock::now() - start;
+
+    return num_lookups / secs.count();
+}
+
+static void
+bench(const char *name, int size, int assoc, uint64_t num_lookups)
+{
+    Cache cache;
+    cache.assoc = assoc;
+    cache.numSets = size / assoc / 64;
+    cache.sets.resize(cache.numSets, vector<Entry *>(assoc));
+
+    // Fill every way with a random line of the right set.
+    mt19937_64 rng(size + assoc);
+    vector<Addr> resident;
+    for (int set = 0; set < cache.numSets; ++set) {
+        for (int way = 0; way < assoc; ++way) {
+            Addr line = ((rng() >> 24) * cache.numSets + set) << 6;
+            cache.entries.emplace_back(new Entry{line, true});
+            cache.sets[set][way] = cache.entries.back().get();
+            resident.push_back(line);
+        }
+    }
+
+    // Three hits for every miss, in random order.
+    vector<Addr> probes;
+    for (int i = 0; i < (1 << 20); ++i) {
+        if (i % 4) {
+            probes.push_back(resident[rng() % resident.size()]);
+        } else {
+            Addr line = (rng() >> 6) << 6;
+            probes.push_back(line | (Addr(1) << 62));
+        }
+    }
+
+    uint64_t map_hits, flat_hits;
+    uint64_t map_rate = run<MapTags>(cache, probes, num_lookups, map_hits);
+    uint64_t flat_rate = run<FlatTags>(cache, probes, num_lookups, flat_hits);
+    if (map_hits != flat_hits)
+        cprintf("%s: hit counts differ (%d vs %d)\n", name, map_hits,
+                flat_hits);
+
+    cprintf("%10s %8d %6d %15d %15d\n", name, size / 1024, assoc,
+            map_rate, flat_rate);
+}
+
+int
+main()
+{
+    const uint64_t num_lookups = 5000000;
+
+    cprintf("%10s %8s %6s %15s %15s\n", "cache", "KiB", "assoc",
+            "map lookup/s", "flat lookup/s");
+    bench("L1", 32 * 1024, 8, num_lookups);
+    bench("L2", 1024 * 1024, 16, num_lookups);
+    bench("LLC", 8 * 1024 * 1024, 16, num_lookups);
+    bench("LLC-wide", 8 * 1024 * 1024, 32, num_lookups);
+
+    return 0;
+}
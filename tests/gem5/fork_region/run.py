@@ -0,0 +1,94 @@
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+'''
+Simulates the first part of a program in the parent, forks the rest into a
+region with m5.forkRegion() and checks that joining it adds the cycles the
+child simulated to the stats of the parent. The parent then exits without
+simulating any further, so its final stats must match the child's.
+'''
+
+import argparse
+
+import m5
+from m5.objects import *
+from m5.util import fatal
+
+parser = argparse.ArgumentParser()
+parser.add_argument('binary', type=str)
+parser.add_argument('--fork-tick', type=int, default=100000000)
+args = parser.parse_args()
+
+system = System()
+system.clk_domain = SrcClockDomain(clock='1GHz',
+                                   voltage_domain=VoltageDomain())
+system.mem_mode = 'atomic'
+system.mem_ranges = [AddrRange('512MB')]
+
+system.cpu = AtomicSimpleCPU()
+system.membus = SystemXBar()
+system.cpu.icache_port = system.membus.slave
+system.cpu.dcache_port = system.membus.slave
+system.cpu.createInterruptController()
+if buildEnv['TARGET_ISA'] == 'x86':
+    system.cpu.interrupts[0].pio = system.membus.master
+    system.cpu.interrupts[0].int_master = system.membus.slave
+    system.cpu.interrupts[0].int_slave = system.membus.master
+
+system.mem_ctrl = SimpleMemory(range=system.mem_ranges[0])
+system.mem_ctrl.port = system.membus.master
+system.system_port = system.membus.slave
+
+system.cpu.workload = Process(cmd=[args.binary])
+system.cpu.createThreads()
+
+root = Root(full_system=False, system=system)
+m5.disableAllListeners()
+m5.instantiate()
+
+exit_event = m5.simulate(args.fork_tick)
+if exit_event.getCause() != 'simulate() limit reached':
+    fatal('The program ended before the fork, at tick %d' % m5.curTick())
+
+num_cycles = m5.stats.stats_dict['system.cpu.numCycles']
+before = num_cycles.value()
+
+def region():
+    start = num_cycles.value()
+    exit_event = m5.simulate()
+    return exit_event.getCause(), num_cycles.value() - start
+
+m5.forkRegion(region)
+results = m5.joinRegions()
+if len(results) != 1 or results[0][1] is None:
+    fatal('The forked region did not report a result')
+
+cause, cycles = results[0][1]
+print('Forked region exited because %s after %d cycles' % (cause, cycles))
+if cycles == 0 or num_cycles.value() != before + cycles:
+    fatal('Expected %d + %d cycles after merging the region, got %d' %
+             (before, cycles, num_cycles.value()))
+print('Merged the stats of the forked region')
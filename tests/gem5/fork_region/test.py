@@ -0,0 +1,91 @@
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+'''
+Forks a region of a program with m5.forkRegion() and checks that joining it
+merges the stats of the child into the parent (see run.py). Since the
+parent does not simulate after the fork, its counters must then match the
+child's, which this test compares in the two stats files.
+'''
+import sys
+
+from testlib import *
+from testlib import test_util
+from testlib.helper import log_call
+
+binary = joinpath(config.base_dir, 'tests', 'test-progs', 'hello', 'bin',
+                  'x86', 'linux', 'hello')
+
+# Counters of the CPU, the bus and the memory
+counters = (
+    'system.cpu.numCycles',
+    'system.cpu.committedInsts',
+    'system.membus.pkt_count::total',
+    'system.mem_ctrl.bytes_read::total',
+)
+
+def _stats(path):
+    values = {}
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) > 1 and fields[0] in counters:
+                values[fields[0]] = float(fields[1])
+    return values
+
+def test_run(params):
+    tempdir = params.fixtures[constants.tempdir_fixture_name].path
+    gem5 = params.fixtures[constants.gem5_binary_fixture_name].path
+    command = [
+        gem5,
+        '-d', joinpath(tempdir, 'm5out'),
+        '-re',
+        joinpath(config.base_dir, 'tests', 'gem5', 'fork_region', 'run.py'),
+        binary,
+    ]
+    log_call(params.log, command, stdout=sys.stdout, stderr=sys.stderr)
+
+def test_compare_stats(params):
+    tempdir = params.fixtures[constants.tempdir_fixture_name].path
+    parent = _stats(joinpath(tempdir, 'm5out',
+                             constants.gem5_simulation_stats))
+    child = _stats(joinpath(tempdir, 'm5out.r0',
+                            constants.gem5_simulation_stats))
+    for name in counters:
+        if name not in child:
+            test_util.fail('%s is missing from the stats of the child' % name)
+        if parent.get(name) != child[name]:
+            test_util.fail('%s is %s in the parent but %s in the child' %
+                           (name, parent.get(name), child[name]))
+
+for opt in constants.supported_variants:
+    name = 'fork-region-stats-X86-%s' % opt
+    TestSuite(
+        name=name,
+        fixtures=[Gem5Fixture('X86', opt), TempdirFixture()],
+        tags=['X86', opt, constants.quick_tag, constants.host_x86_64_tag],
+        tests=[TestFunction(test_run, name=name + '-run'),
+               TestFunction(test_compare_stats, name=name + '-stats')])
@@ -0,0 +1,117 @@
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+'''
+Runs a partitioned Ruby simulation twice, with the simple and the Garnet
+network, and checks that both runs produce the same statistics, i.e., that
+messages crossing event queues are delivered deterministically. The Garnet
+runs also check that the traffic counted by the network interfaces of all
+event queues adds up in the network's stats.
+'''
+import re
+import sys
+
+from testlib import *
+from testlib import test_util
+from testlib.helper import log_call, diff_out_file
+
+binary = joinpath(config.base_dir, 'tests', 'test-progs', 'hello', 'bin',
+                  'x86', 'linux', 'hello')
+
+config_args = [
+    '--ruby', '--ruby-eventqs', '2', '--num-cpus', '2',
+    '--cmd', '%s;%s' % (binary, binary),
+]
+
+networks = ('simple', 'garnet')
+runs = ('run1', 'run2')
+
+# Host performance varies from run to run
+ignore_regex = (re.compile(r'^host_'),)
+
+def _create_run(network, run):
+    def test_run(params):
+        tempdir = params.fixtures[constants.tempdir_fixture_name].path
+        gem5 = params.fixtures[constants.gem5_binary_fixture_name].path
+        command = [
+            gem5,
+            '-d', joinpath(tempdir, network, run),
+            '-re',
+            joinpath(config.base_dir, 'configs', 'example', 'se.py'),
+        ]
+        command.extend(config_args)
+        command.extend(['--network', network])
+        log_call(params.log, command, stdout=sys.stdout, stderr=sys.stderr)
+    return test_run
+
+def _create_compare_stats(network):
+    def test_compare_stats(params):
+        tempdir = params.fixtures[constants.tempdir_fixture_name].path
+        stats = [joinpath(tempdir, network, run,
+                          constants.gem5_simulation_stats)
+                 for run in runs]
+        diff = diff_out_file(stats[0], stats[1], ignore_regexes=ignore_regex,
+                             logger=params.log)
+        if diff is not None:
+            test_util.fail('Stats differ between runs:\n%s\nSee %s for full '
+                           'results' % (diff, tempdir))
+    return test_compare_stats
+
+def _stat(path, name):
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if fields and fields[0] == name:
+                return float(fields[1])
+    test_util.fail('%s is missing from %s' % (name, path))
+
+def test_garnet_traffic(params):
+    tempdir = params.fixtures[constants.tempdir_fixture_name].path
+    stats = joinpath(tempdir, 'garnet', runs[0],
+                     constants.gem5_simulation_stats)
+    injected = _stat(stats, 'system.ruby.network.flits_injected::total')
+    received = _stat(stats, 'system.ruby.network.flits_received::total')
+    if injected == 0 or received == 0:
+        test_util.fail('Garnet counted no traffic: %d flits injected, %d '
+                       'received' % (injected, received))
+
+for opt in constants.supported_variants:
+    for network in networks:
+        name = 'ruby-partition-deterministic-%s-X86-%s' % (network, opt)
+        tests = [TestFunction(_create_run(network, run),
+                              name='%s-%s' % (name, run))
+                 for run in runs]
+        tests.append(TestFunction(_create_compare_stats(network),
+                                  name=name + '-stats'))
+        if network == 'garnet':
+            tests.append(TestFunction(test_garnet_traffic,
+                                      name=name + '-traffic'))
+        TestSuite(
+            name=name,
+            fixtures=[Gem5Fixture('X86', opt), TempdirFixture()],
+            tags=['X86', opt, constants.long_tag,
+                  constants.host_x86_64_tag],
+            tests=tests)
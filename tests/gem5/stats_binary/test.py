@@ -0,0 +1,169 @@
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+'''
+Tests for the binary stats format: the reader (m5.stats.binary) decodes a
+small file generated here, and the files gem5 writes for --stats-file
+bin://stats.bin.
+'''
+import struct
+import sys
+
+from testlib import *
+from testlib import test_util
+from testlib.helper import log_call
+
+reader_path = joinpath(config.base_dir, 'src', 'python', 'm5', 'stats',
+                       'binary.py')
+
+binary = joinpath(config.base_dir, 'tests', 'test-progs', 'hello', 'bin',
+                  'x86', 'linux', 'hello')
+
+def _load_reader():
+    # Importing m5.stats would need the gem5 binary; the reader itself
+    # is a standalone module.
+    try:
+        from importlib.util import spec_from_file_location, module_from_spec
+    except ImportError:
+        import imp
+        return imp.load_source('stats_binary', reader_path)
+    spec = spec_from_file_location('stats_binary', reader_path)
+    module = module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+def _string(value):
+    value = value.encode('utf-8')
+    return struct.pack('=I', len(value)) + value
+
+def _strings(values):
+    return struct.pack('=I', len(values)) + \
+        b''.join(_string(v) for v in values)
+
+def _entry(kind, name, desc, size):
+    return struct.pack('=B', kind) + _string(name) + _string(desc) + \
+        struct.pack('=II', 0x3, size)
+
+def _dump(values):
+    return b'D' + struct.pack('=Q%dd' % len(values), len(values), *values)
+
+def _check(cond, msg):
+    if not cond:
+        test_util.fail(msg)
+
+def test_read_generated(params):
+    binary_stats = _load_reader()
+    tempdir = params.fixtures[constants.tempdir_fixture_name].path
+    path = joinpath(tempdir, 'stats.bin')
+
+    dist_size = len(binary_stats.DIST_FIELDS) + 2
+    schema = b'S' + struct.pack('=I', 4) + \
+        _entry(binary_stats.KIND_SCALAR, 'system.scalar', 'A scalar', 1) + \
+        _entry(binary_stats.KIND_VECTOR, 'system.vector', '', 2) + \
+        _strings(['x', 'y']) + \
+        _entry(binary_stats.KIND_DIST, 'system.dist', '', dist_size) + \
+        struct.pack('=BI', binary_stats.DIST_DIST, 2) + \
+        _entry(binary_stats.KIND_VECTOR2D, 'system.v2d', '', 4) + \
+        struct.pack('=II', 2, 2) + _strings(['r0', 'r1']) + \
+        _strings(['c0', 'c1'])
+    dist = [0, 1, 1, 2, 20, 200, 0, 10, 11, 0, 1, 10, 11]
+    first = [3, 1, 2] + dist + [1, 2, 3, 4]
+    second = [4, 5, 6] + dist + [5, 6, 7, 8]
+    subset = b'S' + struct.pack('=I', 1) + \
+        _entry(binary_stats.KIND_SCALAR, 'system.scalar', 'A scalar', 1)
+
+    with open(path, 'wb') as f:
+        f.write(b'gem5stat' + struct.pack('=I', binary_stats.VERSION))
+        f.write(schema + _dump(first) + _dump(second))
+        f.write(subset + _dump([7]))
+        # A dump that was cut short, e.g., by a crash
+        f.write(_dump([8])[:-3])
+
+    dumps = list(binary_stats.StatFile(path))
+    _check(len(dumps) == 3, 'Expected 3 dumps, got %d' % len(dumps))
+
+    d = dumps[0]
+    _check(list(d.keys()) == ['system.scalar', 'system.vector',
+                              'system.dist', 'system.v2d'],
+           'Unexpected stats %s' % list(d.keys()))
+    _check(d.schema['system.scalar'].desc == 'A scalar',
+           'Wrong description')
+    _check(d.schema['system.vector'].subnames == ['x', 'y'],
+           'Wrong subnames')
+    _check(d['system.scalar'] == 3, 'Wrong scalar %r' % d['system.scalar'])
+    _check(d['system.vector'] == [1, 2],
+           'Wrong vector %r' % d['system.vector'])
+    _check(d['system.dist']['samples'] == 2 and
+           d['system.dist']['buckets'] == [10, 11],
+           'Wrong distribution %r' % d['system.dist'])
+    _check(d['system.v2d'] == [[1, 2], [3, 4]],
+           'Wrong 2d vector %r' % d['system.v2d'])
+
+    _check(dumps[1]['system.vector'] == [5, 6],
+           'Wrong vector in second dump')
+    _check(list(dumps[2].keys()) == ['system.scalar'] and
+           dumps[2]['system.scalar'] == 7, 'Wrong subset dump')
+
+    with open(path, 'wb') as f:
+        f.write(b'gem5text')
+    try:
+        binary_stats.StatFile(path)
+    except ValueError:
+        pass
+    else:
+        test_util.fail('Accepted a file without the magic string')
+
+TestSuite(
+    name='stats-binary-reader',
+    fixtures=[TempdirFixture()],
+    tags=[constants.quick_tag],
+    tests=[TestFunction(test_read_generated)])
+
+def test_gem5_stats(params):
+    binary_stats = _load_reader()
+    tempdir = params.fixtures[constants.tempdir_fixture_name].path
+    gem5 = params.fixtures[constants.gem5_binary_fixture_name].path
+    command = [
+        gem5,
+        '-d', tempdir,
+        '--stats-file', 'bin://stats.bin',
+        joinpath(config.base_dir, 'configs', 'example', 'se.py'),
+        '--cmd', binary,
+    ]
+    log_call(params.log, command, stdout=sys.stdout, stderr=sys.stderr)
+
+    dumps = list(binary_stats.StatFile(joinpath(tempdir, 'stats.bin')))
+    _check(len(dumps) == 1, 'Expected 1 dump, got %d' % len(dumps))
+    _check(dumps[0]['sim_ticks'] > 0, 'No simulated ticks')
+    _check(dumps[0]['system.cpu.numCycles'] > 0, 'No CPU cycles')
+
+for opt in constants.supported_variants:
+    TestSuite(
+        name='stats-binary-X86-%s' % opt,
+        fixtures=[Gem5Fixture('X86', opt), TempdirFixture()],
+        tags=['X86', opt, constants.quick_tag, constants.host_x86_64_tag],
+        tests=[TestFunction(test_gem5_stats,
+                            name='stats-binary-X86-%s' % opt)])
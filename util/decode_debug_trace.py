@@ -0,0 +1,482 @@
+#!/usr/bin/env python
+
+# Copyright (c) 2020 The Regents of the University of California
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met: redistributions of source code must retain the above copyright
+# notice, this list of conditions and the following disclaimer;
+# redistributions in binary form must reproduce the above copyright
+# notice, this list of conditions and the following disclaimer in the
+# documentation and/or other materials provided with the distribution;
+# neither the name of the copyright holders nor the names of its
+# contributors may be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+# A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+# OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+# DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+# THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""Decode a binary debug trace written with --debug-format=binary.
+
+The trace holds the format string and raw arguments of every DPRINTF
+(see src/base/trace_record.hh). This script formats them the way
+cprintf would have and prints the same lines as a text trace:
+
+    util/decode_debug_trace.py m5out/trace.bin trace.txt
+
+Use --flags and --no-ticks where the simulation would have used the
+FmtFlag and FmtTicksOff debug flags.
+"""
+
+from __future__ import print_function
+
+import argparse
+import io
+import struct
+import sys
+
+MAGIC = b'gem5dbg\0'
+VERSION = 1
+MAX_TICK = 2**64 - 1
+
+class Format(object):
+    """A conversion spec, as parsed by cp::Print::process_flag"""
+    def __init__(self):
+        self.alternate_form = False
+        self.flush_left = False
+        self.print_sign = False
+        self.fill_zero = False
+        self.uppercase = False
+        self.base = 'dec'
+        self.format = None
+        self.float_format = 'best'
+        self.precision = -1
+        self.width = 0
+        self.get_precision = False
+        self.get_width = False
+
+def _pad(text, width, fill, left):
+    if len(text) >= width:
+        return text
+    if left:
+        return text + fill * (width - len(text))
+    return fill * (width - len(text)) + text
+
+def _int_text(value, size, signed, base, showbase, showpos, uppercase):
+    """Print an integer like std::ostream does"""
+    if base == 'dec':
+        text = str(value)
+        if showpos and signed and value >= 0:
+            text = '+' + text
+        return text
+
+    value &= (1 << (8 * size)) - 1
+    if base == 'hex':
+        text = '%x' % value
+        if showbase and value:
+            text = '0x' + text
+    else:
+        text = '%o' % value
+        if showbase and value:
+            text = '0' + text
+    return text.upper() if uppercase else text
+
+def _float_text(value, conv, precision, showpos, uppercase):
+    spec = '%' + ('+' if showpos else '') + '.*' + conv
+    text = spec % (precision, value)
+    return text.upper() if uppercase else text
+
+class Arg(object):
+    """A raw argument: kind is 'int', 'bool', 'char', 'float' or 'str'"""
+    def __init__(self, kind, value, size=8, signed=True):
+        self.kind = kind
+        self.value = value
+        self.size = size
+        self.signed = signed
+
+    def number(self):
+        """The value used for a '*' width or precision"""
+        if self.kind == 'int' and self.size == 4 and self.signed:
+            return self.value
+        return 0
+
+class Printer(object):
+    """Formats arguments against a format string like cp::Print"""
+    def __init__(self, fmt):
+        self.fmt = fmt
+        self.ptr = 0
+        self.cont = False
+        self.out = []
+        self.spec = Format()
+        # The stream precision is not restored between conversions
+        self.precision = 6
+
+    def _char(self, offset=0):
+        pos = self.ptr + offset
+        return self.fmt[pos] if pos < len(self.fmt) else '\0'
+
+    def _text(self):
+        """Copy text up to the next conversion; False at the end"""
+        while self.ptr < len(self.fmt):
+            c = self.fmt[self.ptr]
+            if c == '%':
+                if self._char(1) != '%':
+                    return True
+                self.out.append('%')
+                self.ptr += 2
+            elif c == '\r':
+                self.ptr += 1
+                if self._char() != '\n':
+                    self.out.append('\n')
+            else:
+                end = self.ptr
+                while end < len(self.fmt) and self.fmt[end] not in '%\r':
+                    end += 1
+                self.out.append(self.fmt[self.ptr:end])
+                self.ptr = end
+        return False
+
+    def _process(self):
+        self.spec = Format()
+        if self._text():
+            self._process_flag()
+
+    def _process_flag(self):
+        spec = self.spec
+        done = False
+        end_number = False
+        have_precision = False
+        number = 0
+
+        while not done:
+            self.ptr += 1
+            c = self._char()
+            if '0' <= c <= '9':
+                if end_number:
+                    continue
+            elif number > 0:
+                end_number = True
+
+            if c == 's':
+                spec.format = 'string'
+                done = True
+            elif c == 'c':
+                spec.format = 'character'
+                done = True
+            elif c == 'l':
+                continue
+            elif c == 'p':
+                spec.format = 'integer'
+                spec.base = 'hex'
+                spec.alternate_form = True
+                done = True
+            elif c in 'xX':
+                spec.uppercase = c == 'X'
+                spec.base = 'hex'
+                spec.format = 'integer'
+                done = True
+            elif c == 'o':
+                spec.base = 'oct'
+                spec.format = 'integer'
+                done = True
+            elif c in 'diu':
+                spec.format = 'integer'
+                done = True
+            elif c in 'gG':
+                spec.uppercase = c == 'G'
+                spec.format = 'floating'
+                spec.float_format = 'best'
+                done = True
+            elif c in 'eE':
+                spec.uppercase = c == 'E'
+                spec.format = 'floating'
+                spec.float_format = 'scientific'
+                done = True
+            elif c == 'f':
+                spec.format = 'floating'
+                spec.float_format = 'fixed'
+                done = True
+            elif c == 'n':
+                self.out.append("we don't do %n!!!\n")
+                done = True
+            elif c == '#':
+                spec.alternate_form = True
+            elif c == '-':
+                spec.flush_left = True
+            elif c == '+':
+                spec.print_sign = True
+            elif c == ' ':
+                pass
+            elif c == '.':
+                spec.width = number
+                spec.precision = 0
+                have_precision = True
+                number = 0
+                end_number = False
+            elif c == '0' and number == 0:
+                spec.fill_zero = True
+            elif '0' <= c <= '9':
+                number = number * 10 + int(c)
+            elif c == '*':
+                if have_precision:
+                    spec.get_precision = True
+                else:
+                    spec.get_width = True
+            else:
+                done = True
+
+            if end_number:
+                if have_precision:
+                    spec.precision = number
+                else:
+                    spec.width = number
+                end_number = False
+                number = 0
+
+            if done:
+                if spec.format == 'integer' and have_precision:
+                    spec.width = spec.precision
+                    spec.fill_zero = True
+                elif (spec.format == 'floating' and not have_precision and
+                      spec.fill_zero):
+                    spec.precision = spec.width
+
+        self.ptr += 1
+
+    def add(self, arg):
+        if not self.cont:
+            self._process()
+
+        spec = self.spec
+        if spec.get_width:
+            spec.get_width = False
+            self.cont = True
+            spec.width = arg.number()
+            return
+        if spec.get_precision:
+            spec.get_precision = False
+            self.cont = True
+            spec.precision = arg.number()
+            return
+
+        if spec.format == 'character':
+            self._format_char(arg)
+        elif spec.format == 'integer':
+            self._format_integer(arg)
+        elif spec.format == 'floating':
+            self._format_float(arg)
+        elif spec.format == 'string':
+            self._format_string(arg)
+        else:
+            self.out.append('<bad format>')
+
+    def end(self):
+        while self.ptr < len(self.fmt):
+            if self._text():
+                if self._char(1) != '%':
+                    self.out.append('<extra arg>')
+                self.out.append('%')
+                self.ptr += 2
+        return ''.join(self.out)
+
+    def _plain(self, arg):
+        """Print an argument with cleared stream flags"""
+        if arg.kind == 'float':
+            return _float_text(arg.value, 'g', self.precision, False, False)
+        if arg.kind == 'bool':
+            return str(int(arg.value))
+        if arg.kind == 'char':
+            return chr(arg.value & 0xff)
+        return str(arg.value)
+
+    def _format_char(self, arg):
+        if arg.kind in ('char', 'int'):
+            self.out.append(chr(arg.value & 0xff))
+        else:
+            self.out.append('<bad arg type for char format>')
+
+    def _format_integer(self, arg):
+        spec = self.spec
+        showbase = False
+        if spec.alternate_form:
+            if not spec.fill_zero:
+                showbase = True
+            elif spec.base == 'hex':
+                self.out.append('0x')
+                spec.width -= 2
+            elif spec.base == 'oct':
+                self.out.append('0')
+                spec.width -= 1
+
+        uppercase = spec.uppercase
+        if arg.kind == 'int':
+            text = _int_text(arg.value, arg.size, arg.signed, spec.base,
+                             showbase, spec.print_sign, uppercase)
+        elif arg.kind == 'bool':
+            text = _int_text(int(arg.value), 8, True, spec.base,
+                             showbase, spec.print_sign, uppercase)
+        elif arg.kind == 'char':
+            text = _int_text(arg.value, 4, True, spec.base,
+                             showbase, spec.print_sign, uppercase)
+        elif arg.kind == 'float':
+            text = _float_text(arg.value, 'g', self.precision,
+                               spec.print_sign, uppercase)
+        else:
+            text = arg.value
+
+        fill = '0' if spec.fill_zero else ' '
+        left = spec.flush_left and not spec.fill_zero
+        self.out.append(_pad(text, spec.width, fill, left))
+
+    def _format_float(self, arg):
+        spec = self.spec
+        if arg.kind != 'float':
+            self.out.append('<bad arg type for float format>')
+            return
+
+        conv = 'g'
+        if spec.float_format == 'scientific':
+            if spec.precision != -1:
+                if spec.precision == 0:
+                    spec.precision = 1
+                else:
+                    conv = 'e'
+                self.precision = spec.precision
+        elif spec.float_format == 'fixed':
+            if spec.precision != -1:
+                conv = 'f'
+                self.precision = spec.precision
+        elif spec.precision != -1:
+            self.precision = spec.precision
+
+        # Like cprintf, only honour upper case in scientific notation
+        uppercase = spec.uppercase and spec.float_format == 'scientific'
+        text = _float_text(arg.value, conv, self.precision, False, uppercase)
+        fill = '0' if spec.fill_zero else ' '
+        self.out.append(_pad(text, spec.width, fill, False))
+
+    def _format_string(self, arg):
+        spec = self.spec
+        text = arg.value if arg.kind == 'str' else self._plain(arg)
+        self.out.append(_pad(text, spec.width, ' ', spec.flush_left))
+
+def cformat(fmt, args):
+    """Format a list of Args like ccprintf"""
+    printer = Printer(fmt)
+    for arg in args:
+        printer.add(arg)
+    return printer.end()
+
+class TraceFile(object):
+    """Reads the messages of a binary debug trace"""
+    def __init__(self, stream):
+        self.stream = stream
+        self.strings = {}
+
+        magic = self._read(len(MAGIC))
+        if magic != MAGIC:
+            raise ValueError("Not a binary debug trace")
+        version, = self._unpack('<I')
+        if version != VERSION:
+            raise ValueError("Unsupported trace version %d" % version)
+
+    def _read(self, size):
+        data = self.stream.read(size)
+        if len(data) != size:
+            raise EOFError("Truncated trace")
+        return data
+
+    def _unpack(self, fmt):
+        return struct.unpack(fmt, self._read(struct.calcsize(fmt)))
+
+    def _string(self):
+        size, = self._unpack('<I')
+        return self._read(size).decode('latin-1')
+
+    def _arg(self):
+        kind = self._read(1)
+        if kind in b'iu':
+            size, = self._unpack('<B')
+            value = self._int(self._read(size), kind == b'i')
+            return Arg('int', value, size, kind == b'i')
+        if kind == b'b':
+            return Arg('bool', bool(self._unpack('<B')[0]))
+        if kind in b'cC':
+            fmt = '<b' if kind == b'c' else '<B'
+            return Arg('char', self._unpack(fmt)[0], 1, kind == b'c')
+        if kind == b'f':
+            return Arg('float', self._unpack('<d')[0])
+        if kind == b's':
+            return Arg('str', self._string())
+        raise ValueError("Unknown argument type %r" % kind)
+
+    @staticmethod
+    def _int(data, signed):
+        """Decode a little endian integer"""
+        data = bytearray(data)
+        value = 0
+        for byte in reversed(data):
+            value = (value << 8) | byte
+        if signed and data and data[-1] & 0x80:
+            value -= 1 << (8 * len(data))
+        return value
+
+    def __iter__(self):
+        """Yield (tick, name, flag, message) for every message"""
+        while True:
+            kind = self.stream.read(1)
+            if not kind:
+                return
+            if kind == b'S':
+                ident, = self._unpack('<I')
+                self.strings[ident] = self._string()
+            elif kind == b'M':
+                tick, name, flag, fmt, nargs = self._unpack('<QIIIB')
+                args = [ self._arg() for i in range(nargs) ]
+                yield (tick, self.strings[name], self.strings[flag],
+                       cformat(self.strings[fmt], args))
+            elif kind == b'L':
+                tick, name, flag = self._unpack('<QII')
+                yield (tick, self.strings[name], self.strings[flag],
+                       self._string())
+            else:
+                raise ValueError("Unknown record type %r" % kind)
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Decode a binary gem5 debug trace")
+    parser.add_argument("input", help="binary trace file")
+    parser.add_argument("output", nargs='?', help="text output [stdout]")
+    parser.add_argument("--flags", action='store_true',
+                        help="print the flag of each message (FmtFlag)")
+    parser.add_argument("--no-ticks", action='store_true',
+                        help="do not print ticks (FmtTicksOff)")
+    args = parser.parse_args()
+
+    out = io.open(args.output, 'w', encoding='latin-1', newline='') \
+        if args.output else \
+        io.open(sys.stdout.fileno(), 'w', encoding='latin-1', newline='',
+                closefd=False)
+
+    with io.open(args.input, 'rb') as stream, out:
+        for tick, name, flag, message in TraceFile(stream):
+            if not args.no_ticks and tick != MAX_TICK:
+                out.write(u'%7d: ' % tick)
+            if args.flags and flag:
+                out.write(flag + u': ')
+            if name:
+                out.write(name + u': ')
+            out.write(message)
+
+if __name__ == '__main__':
+    main()